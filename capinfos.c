@@ -96,6 +96,13 @@
 
 #include "svnversion.h"
 
+/* Number of records to read from Wiretap at a time */
+#define N_BATCH_RECS 64
+
+/* Number of files handed to the scanning threads at a time with -j;
+ * each thread opens and closes the files it scans */
+#define FILES_PER_THREAD 16
+
 /*
  * By default capinfos now continues processing
  * the next filename if and when wiretap detects
@@ -116,6 +123,8 @@ static gboolean long_report = TRUE;         /* By default generate long report
 static gchar table_report_header = TRUE;    /* Generate column header by default     */
 static gchar field_separator = '\t';        /* Use TAB as field separator by default */
 static gchar quote_char = '\0';             /* Do NOT quote fields by default        */
+static gboolean headers_only = FALSE;       /* Skip packet data if possible (-F)     */
+static int scan_threads = 1;                /* Files scanned in parallel (-j)        */
 
 /*
  * capinfos has the ability to report on a number of
@@ -306,8 +315,60 @@ typedef struct _capture_info {
   order_t       order;
 
   int          *encap_counts;           /* array of per_packet encap counts; array has one entry per wtap_encap type */
+
+  gboolean      headers_only;           /* packet data were skipped, not read */
 } capture_info;
 
+static void
+append_stat_name(GString *names, const gchar *name)
+{
+  if (names->len != 0)
+    g_string_append(names, ", ");
+  g_string_append(names, name);
+}
+
+/*
+ * Return the names of the reported infos that needed the whole file,
+ * packet data included, to be read: the hashes always do, and the infos
+ * taken from the records do unless only the record headers were read.
+ */
+static GString *
+full_scan_stats(capture_info *cf_info)
+{
+  GString *names = g_string_new("");
+
+  if (!cf_info->headers_only) {
+    if (cap_file_encap && cf_info->file_encap == WTAP_ENCAP_PER_PACKET)
+                          append_stat_name(names, "File encapsulation");
+    if (cap_snaplen)      append_stat_name(names, "Packet size limit (inferred)");
+    if (cap_packet_count) append_stat_name(names, "Number of packets");
+    if (cap_data_size)    append_stat_name(names, "Data size");
+    if (cap_duration)     append_stat_name(names, "Capture duration");
+    if (cap_start_time)   append_stat_name(names, "Start time");
+    if (cap_end_time)     append_stat_name(names, "End time");
+    if (cap_data_rate_byte) append_stat_name(names, "Data byte rate");
+    if (cap_data_rate_bit)  append_stat_name(names, "Data bit rate");
+    if (cap_packet_size)  append_stat_name(names, "Average packet size");
+    if (cap_packet_rate)  append_stat_name(names, "Average packet rate");
+    if (cap_order)        append_stat_name(names, "Strict time order");
+  }
+#ifdef HAVE_LIBGCRYPT
+  if (cap_file_hashes)    append_stat_name(names, "Hashes");
+#endif
+  return names;
+}
+
+/* A capture file to scan, possibly in another thread, and the results */
+typedef struct _cap_file_job {
+  const char   *filename;
+  wtap         *wth;
+  capture_info  cf_info;
+  int           err;                    /* 0 if the scan succeeded */
+  gchar        *err_info;
+  gboolean      open_failed;            /* err is from opening the file */
+  gboolean      size_failed;            /* err is from getting the file size */
+} cap_file_job;
+
 
 static void
 enable_all_infos(void)
@@ -501,6 +562,15 @@ print_stats(const gchar *filename, capture_info *cf_info)
   }
 #endif /* HAVE_LIBGCRYPT */
   if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
+  if (headers_only) {
+    GString *names = full_scan_stats(cf_info);
+
+                          printf     ("Packet data:         %s\n",
+                                      cf_info->headers_only ? "skipped (record headers only)" : "read (full scan)");
+                          printf     ("Full scan needed by: %s\n",
+                                      names->len != 0 ? names->str : "none");
+    g_string_free(names, TRUE);
+  }
 }
 
 static void
@@ -554,6 +624,8 @@ print_stats_table_header(void)
   }
 #endif /* HAVE_LIBGCRYPT */
   if (cap_order)          print_stats_table_header_label("Strict time order");
+  if (headers_only)       print_stats_table_header_label("Packet data");
+  if (headers_only)       print_stats_table_header_label("Full scan needed by");
 
   printf("\n");
 }
@@ -734,23 +806,41 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     putquote();
   }
 
+  if (headers_only) {
+    GString *names = full_scan_stats(cf_info);
+
+    putsep();
+    putquote();
+    printf("%s", cf_info->headers_only ? "skipped" : "read");
+    putquote();
+
+    putsep();
+    putquote();
+    printf("%s", names->len != 0 ? names->str : "none");
+    putquote();
+    g_string_free(names, TRUE);
+  }
+
   printf("\n");
 }
 
-static int
-process_cap_file(wtap *wth, const char *filename)
+/* Read the records of a file and fill in job->cf_info */
+static void
+scan_cap_file(cap_file_job *job)
 {
+  wtap                  *wth = job->wth;
   int                   err;
   gchar                 *err_info;
   gint64                size;
-  gint64                data_offset;
+  struct wtap_batch_rec recs[N_BATCH_RECS];
+  int                   n_recs, i;
 
   guint32               packet = 0;
   gint64                bytes  = 0;
   guint32               snaplen_min_inferred = 0xffffffff;
   guint32               snaplen_max_inferred =          0;
   const struct wtap_pkthdr *phdr;
-  capture_info          cf_info;
+  capture_info          *cf_info = &job->cf_info;
   gboolean		have_times = TRUE;
   double                start_time = 0;
   double                stop_time  = 0;
@@ -759,143 +849,214 @@ process_cap_file(wtap *wth, const char *filename)
   gboolean		know_order = FALSE;
   order_t		order = IN_ORDER;
 
-  cf_info.encap_counts = g_malloc0(WTAP_NUM_ENCAP_TYPES * sizeof(int));
+  job->err = 0;
+  job->err_info = NULL;
+  job->size_failed = FALSE;
+  cf_info->encap_counts = g_malloc0(WTAP_NUM_ENCAP_TYPES * sizeof(int));
+
+  /* Skip the packet data if we don't need them and the file allows it */
+  cf_info->headers_only = headers_only && wtap_set_headers_only(wth);
 
   /* Tally up data that we need to parse through the file to find */
-  while (wtap_read(wth, &err, &err_info, &data_offset))  {
-    phdr = wtap_phdr(wth);
-    if (phdr->presence_flags & WTAP_HAS_TS) {
-      prev_time = cur_time;
-      cur_time = secs_nsecs(&phdr->ts);
-      if(packet==0) {
-        start_time = cur_time;
-        stop_time = cur_time;
+  while ((n_recs = wtap_read_batch(wth, recs, N_BATCH_RECS, &err, &err_info)) > 0)  {
+    for (i = 0; i < n_recs; i++) {
+      phdr = &recs[i].phdr;
+      if (phdr->presence_flags & WTAP_HAS_TS) {
         prev_time = cur_time;
+        cur_time = secs_nsecs(&phdr->ts);
+        if(packet==0) {
+          start_time = cur_time;
+          stop_time = cur_time;
+          prev_time = cur_time;
+        }
+        if (cur_time < prev_time) {
+          order = NOT_IN_ORDER;
+        }
+        if (cur_time < start_time) {
+          start_time = cur_time;
+        }
+        if (cur_time > stop_time) {
+          stop_time = cur_time;
+        }
+      } else {
+        have_times = FALSE; /* at least one packet has no time stamp */
+        if (order != NOT_IN_ORDER)
+          order = ORDER_UNKNOWN;
       }
-      if (cur_time < prev_time) {
-        order = NOT_IN_ORDER;
-      }
-      if (cur_time < start_time) {
-        start_time = cur_time;
-      }
-      if (cur_time > stop_time) {
-        stop_time = cur_time;
+
+      bytes+=phdr->len;
+      packet++;
+
+      /* If caplen < len for a rcd, then presumably           */
+      /* 'Limit packet capture length' was done for this rcd. */
+      /* Keep track as to the min/max actual snapshot lengths */
+      /*  seen for this file.                                 */
+      if (phdr->caplen < phdr->len) {
+        if (phdr->caplen < snaplen_min_inferred)
+          snaplen_min_inferred = phdr->caplen;
+        if (phdr->caplen > snaplen_max_inferred)
+          snaplen_max_inferred = phdr->caplen;
       }
-    } else {
-      have_times = FALSE; /* at least one packet has no time stamp */
-      if (order != NOT_IN_ORDER)
-        order = ORDER_UNKNOWN;
-    }
 
-    bytes+=phdr->len;
-    packet++;
-
-    /* If caplen < len for a rcd, then presumably           */
-    /* 'Limit packet capture length' was done for this rcd. */
-    /* Keep track as to the min/max actual snapshot lengths */
-    /*  seen for this file.                                 */
-    if (phdr->caplen < phdr->len) {
-      if (phdr->caplen < snaplen_min_inferred)
-        snaplen_min_inferred = phdr->caplen;
-      if (phdr->caplen > snaplen_max_inferred)
-        snaplen_max_inferred = phdr->caplen;
-    }
+      /* Per-packet encapsulation */
+      if (wtap_file_encap(wth) == WTAP_ENCAP_PER_PACKET) {
+          if ((phdr->pkt_encap > 0) && (phdr->pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
+              cf_info->encap_counts[phdr->pkt_encap] += 1;
+          } else {
+              fprintf(stderr, "capinfos: Unknown per-packet encapsulation: %d [frame number: %d]\n", phdr->pkt_encap, packet);
+          }
+      }
 
-    /* Per-packet encapsulation */
-    if (wtap_file_encap(wth) == WTAP_ENCAP_PER_PACKET) {
-        if ((phdr->pkt_encap > 0) && (phdr->pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-            cf_info.encap_counts[phdr->pkt_encap] += 1;
-        } else {
-            fprintf(stderr, "capinfos: Unknown per-packet encapsulation: %d [frame number: %d]\n", phdr->pkt_encap, packet);
-        }
     }
-
   } /* while */
 
-  if (err != 0) {
-    fprintf(stderr,
-            "capinfos: An error occurred after reading %u packets from \"%s\": %s.\n",
-            packet, filename, wtap_strerror(err));
-    switch (err) {
+  /* # of packets, also reported with errors */
+  cf_info->packet_count = packet;
 
-    case WTAP_ERR_UNSUPPORTED:
-    case WTAP_ERR_UNSUPPORTED_ENCAP:
-    case WTAP_ERR_BAD_FILE:
-    case WTAP_ERR_DECOMPRESS:
-      fprintf(stderr, "(%s)\n", err_info);
-      g_free(err_info);
-      break;
-    }
-    g_free(cf_info.encap_counts);
-    return 1;
+  if (err != 0) {
+    job->err = err;
+    job->err_info = err_info;
+    return;
   }
 
   /* File size */
   size = wtap_file_size(wth, &err);
   if (size == -1) {
-    fprintf(stderr,
-            "capinfos: Can't get size of \"%s\": %s.\n",
-            filename, g_strerror(err));
-    g_free(cf_info.encap_counts);
-    return 1;
+    job->err = err;
+    job->size_failed = TRUE;
+    return;
   }
 
-  cf_info.filesize = size;
+  cf_info->filesize = size;
 
   /* File Type */
-  cf_info.file_type = wtap_file_type(wth);
-  cf_info.iscompressed = wtap_iscompressed(wth);
+  cf_info->file_type = wtap_file_type(wth);
+  cf_info->iscompressed = wtap_iscompressed(wth);
 
   /* File Encapsulation */
-  cf_info.file_encap = wtap_file_encap(wth);
+  cf_info->file_encap = wtap_file_encap(wth);
 
   /* Packet size limit (snaplen) */
-  cf_info.snaplen = wtap_snapshot_length(wth);
-  if(cf_info.snaplen > 0)
-    cf_info.snap_set = TRUE;
+  cf_info->snaplen = wtap_snapshot_length(wth);
+  if(cf_info->snaplen > 0)
+    cf_info->snap_set = TRUE;
   else
-    cf_info.snap_set = FALSE;
-
-  cf_info.snaplen_min_inferred = snaplen_min_inferred;
-  cf_info.snaplen_max_inferred = snaplen_max_inferred;
+    cf_info->snap_set = FALSE;
 
-  /* # of packets */
-  cf_info.packet_count = packet;
+  cf_info->snaplen_min_inferred = snaplen_min_inferred;
+  cf_info->snaplen_max_inferred = snaplen_max_inferred;
 
   /* File Times */
-  cf_info.times_known = have_times;
-  cf_info.start_time = start_time;
-  cf_info.stop_time = stop_time;
-  cf_info.duration = stop_time-start_time;
-  cf_info.know_order = know_order;
-  cf_info.order = order;
+  cf_info->times_known = have_times;
+  cf_info->start_time = start_time;
+  cf_info->stop_time = stop_time;
+  cf_info->duration = stop_time-start_time;
+  cf_info->know_order = know_order;
+  cf_info->order = order;
 
   /* Number of packet bytes */
-  cf_info.packet_bytes = bytes;
+  cf_info->packet_bytes = bytes;
 
-  cf_info.data_rate   = 0.0;
-  cf_info.packet_rate = 0.0;
-  cf_info.packet_size = 0.0;
+  cf_info->data_rate   = 0.0;
+  cf_info->packet_rate = 0.0;
+  cf_info->packet_size = 0.0;
 
   if (packet > 0) {
-    if (cf_info.duration > 0.0) {
-      cf_info.data_rate   = (double)bytes  / (stop_time-start_time); /* Data rate per second */
-      cf_info.packet_rate = (double)packet / (stop_time-start_time); /* packet rate per second */
+    if (cf_info->duration > 0.0) {
+      cf_info->data_rate   = (double)bytes  / (stop_time-start_time); /* Data rate per second */
+      cf_info->packet_rate = (double)packet / (stop_time-start_time); /* packet rate per second */
+    }
+    cf_info->packet_size = (double)bytes / packet;                  /* Avg packet size      */
+  }
+
+}
+
+static void
+report_cap_open_failure(const char *filename, int err, gchar *err_info)
+{
+  fprintf(stderr, "capinfos: Can't open %s: %s\n", filename,
+    wtap_strerror(err));
+  switch (err) {
+
+  case WTAP_ERR_UNSUPPORTED:
+  case WTAP_ERR_UNSUPPORTED_ENCAP:
+  case WTAP_ERR_BAD_FILE:
+    fprintf(stderr, "(%s)\n", err_info);
+    g_free(err_info);
+    break;
+  }
+}
+
+/* Open, scan and close a file in one of the -j threads */
+static void
+scan_cap_file_thread(gpointer data, gpointer user_data _U_)
+{
+  cap_file_job *job = (cap_file_job *)data;
+
+  job->err_info = NULL;
+  job->wth = wtap_open_offline(job->filename, &job->err, &job->err_info, FALSE);
+  if (job->wth == NULL) {
+    job->open_failed = TRUE;
+    return;
+  }
+  job->open_failed = FALSE;
+  scan_cap_file(job);
+  wtap_close(job->wth);
+  job->wth = NULL;
+}
+
+/* Report the results of scanning a file; returns 1 if it failed */
+static int
+report_cap_file(cap_file_job *job)
+{
+  if (job->size_failed) {
+    fprintf(stderr,
+            "capinfos: Can't get size of \"%s\": %s.\n",
+            job->filename, g_strerror(job->err));
+    g_free(job->cf_info.encap_counts);
+    return 1;
+  }
+
+  if (job->err != 0) {
+    fprintf(stderr,
+            "capinfos: An error occurred after reading %u packets from \"%s\": %s.\n",
+            job->cf_info.packet_count, job->filename, wtap_strerror(job->err));
+    switch (job->err) {
+
+    case WTAP_ERR_UNSUPPORTED:
+    case WTAP_ERR_UNSUPPORTED_ENCAP:
+    case WTAP_ERR_BAD_FILE:
+    case WTAP_ERR_DECOMPRESS:
+      fprintf(stderr, "(%s)\n", job->err_info);
+      g_free(job->err_info);
+      break;
     }
-    cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
+    g_free(job->cf_info.encap_counts);
+    return 1;
   }
 
   if(long_report) {
-    print_stats(filename, &cf_info);
+    print_stats(job->filename, &job->cf_info);
   } else {
-    print_stats_table(filename, &cf_info);
+    print_stats_table(job->filename, &job->cf_info);
   }
 
-  g_free(cf_info.encap_counts);
+  g_free(job->cf_info.encap_counts);
 
   return 0;
 }
 
+static int
+process_cap_file(wtap *wth, const char *filename)
+{
+  cap_file_job job;
+
+  job.filename = filename;
+  job.wth = wth;
+  scan_cap_file(&job);
+  return report_cap_file(&job);
+}
+
 static void
 usage(gboolean is_error)
 {
@@ -965,6 +1126,10 @@ usage(gboolean is_error)
   fprintf(output, "  -h display this help and exit\n");
   fprintf(output, "  -C cancel processing if file open fails (default is to continue)\n");
   fprintf(output, "  -A generate all infos (default)\n");
+  fprintf(output, "  -F skip the packet data if the file allows it, and report whether\n");
+  fprintf(output, "     they had to be read and which infos needed them (faster, for\n");
+  fprintf(output, "     infos other than hashes)\n");
+  fprintf(output, "  -j <threads> scan that many files in parallel (default 1)\n");
   fprintf(output, "\n");
   fprintf(output, "Options are processed from left to right order with later options superceeding\n");
   fprintf(output, "or adding to earlier options.\n");
@@ -1008,6 +1173,10 @@ main(int argc, char *argv[])
   gchar *err_info;
   int    opt;
   int    overall_error_status;
+  char  *p;
+  GThreadPool  *pool;
+  cap_file_job *jobs;
+  int    n_jobs, chunk_start, j;
 
   int status = 0;
 #ifdef HAVE_PLUGINS
@@ -1090,7 +1259,7 @@ main(int argc, char *argv[])
   g_option_context_free(ctx);
 
 #endif /* USE_GOPTION */
-  while ((opt = getopt(argc, argv, "tEcs" FILE_HASH_OPT "dluaeyizvhxoCALTRrSNqQBmb")) !=-1) {
+  while ((opt = getopt(argc, argv, "tEcs" FILE_HASH_OPT "dluaeyizvhxoCALTRrSNqQBmbFj:")) !=-1) {
 
     switch (opt) {
 
@@ -1223,6 +1392,19 @@ main(int argc, char *argv[])
       field_separator = ' ';
       break;
 
+    case 'F':
+      headers_only = TRUE;
+      break;
+
+    case 'j':
+      scan_threads = (int)strtol(optarg, &p, 10);
+      if (p == optarg || *p != '\0' || scan_threads < 1) {
+        fprintf(stderr, "capinfos: \"%s\" isn't a valid number of threads\n",
+                optarg);
+        exit(1);
+      }
+      break;
+
     case 'h':
       usage(FALSE);
       exit(1);
@@ -1258,6 +1440,53 @@ main(int argc, char *argv[])
 
   overall_error_status = 0;
 
+#ifdef HAVE_LIBGCRYPT
+  /* The hashes are computed as files are opened, one at a time */
+  if (cap_file_hashes)
+    scan_threads = 1;
+#endif
+
+  if (scan_threads > 1) {
+    /*
+     * Open and scan the files in a pool of threads, a batch at a time,
+     * and report on them in order once they're all done; only as many
+     * files as there are threads are open at once.
+     */
+#if !GLIB_CHECK_VERSION(2,31,0)
+    g_thread_init(NULL);
+#endif
+    jobs = (cap_file_job *)g_malloc(scan_threads * FILES_PER_THREAD * sizeof (cap_file_job));
+    for (chunk_start = optind; chunk_start < argc; chunk_start += scan_threads * FILES_PER_THREAD) {
+      pool = g_thread_pool_new(scan_cap_file_thread, NULL, scan_threads, TRUE, NULL);
+      n_jobs = 0;
+      for (opt = chunk_start; opt < argc && opt < chunk_start + scan_threads * FILES_PER_THREAD; opt++) {
+        jobs[n_jobs].filename = argv[opt];
+        jobs[n_jobs].wth = NULL;
+        g_thread_pool_push(pool, &jobs[n_jobs], NULL);
+        n_jobs++;
+      }
+      /* Wait for the scans to finish */
+      g_thread_pool_free(pool, FALSE, TRUE);
+
+      for (j = 0; j < n_jobs; j++) {
+        if (jobs[j].open_failed) {
+          report_cap_open_failure(jobs[j].filename, jobs[j].err, jobs[j].err_info);
+          overall_error_status = 1; /* remember that an error has occurred */
+          if(!continue_after_wtap_open_offline_failure)
+            exit(1); /* error status */
+          continue;
+        }
+        if ((chunk_start > optind || j > 0) && (long_report))
+          printf("\n");
+        status = report_cap_file(&jobs[j]);
+        if (status)
+          overall_error_status = status; /* report the other files anyway */
+      }
+    }
+    g_free(jobs);
+    return overall_error_status;
+  }
+
   for (opt = optind; opt < argc; opt++) {
 
 #ifdef HAVE_LIBGCRYPT
@@ -1284,17 +1513,7 @@ main(int argc, char *argv[])
     wth = wtap_open_offline(argv[opt], &err, &err_info, FALSE);
 
     if (!wth) {
-      fprintf(stderr, "capinfos: Can't open %s: %s\n", argv[opt],
-        wtap_strerror(err));
-      switch (err) {
-
-      case WTAP_ERR_UNSUPPORTED:
-      case WTAP_ERR_UNSUPPORTED_ENCAP:
-      case WTAP_ERR_BAD_FILE:
-        fprintf(stderr, "(%s)\n", err_info);
-        g_free(err_info);
-        break;
-      }
+      report_cap_open_failure(argv[opt], err, err_info);
       overall_error_status = 1; /* remember that an error has occurred */
       if(!continue_after_wtap_open_offline_failure)
         exit(1); /* error status */
@@ -1307,7 +1526,7 @@ main(int argc, char *argv[])
 
       wtap_close(wth);
       if (status)
-        exit(status);
+        overall_error_status = status; /* report the other files anyway */
     }
   }
   return overall_error_status;
@@ -728,6 +728,9 @@ usage(gboolean is_error)
   fprintf(output, "  -T <encap type>        set the output file encapsulation type;\n");
   fprintf(output, "                         default is the same as the input file.\n");
   fprintf(output, "                         an empty \"-T\" option will list the encapsulation types.\n");
+  fprintf(output, "  -z <threads>           write the output file(s) compressed with gzip, using\n");
+  fprintf(output, "                         <threads> threads to compress them, or with\n");
+  fprintf(output, "                         Zstandard if <outfile> ends in \".zst\".\n");
   fprintf(output, "\n");
   fprintf(output, "Miscellaneous:\n");
   fprintf(output, "  -h                     display this help and exit.\n");
@@ -843,6 +846,7 @@ main(int argc, char *argv[])
   gchar *fprefix = NULL;
   gchar *fsuffix = NULL;
   char appname[100];
+  int compress_threads = 0;             /* Don't compress output  */
 
 #ifdef HAVE_PLUGINS
   char* init_progfile_dir_error;
@@ -869,7 +873,7 @@ main(int argc, char *argv[])
 #endif
 
   /* Process the options */
-  while ((opt = getopt(argc, argv, "A:B:c:C:dD:E:F:hrs:i:t:S:T:vw:")) !=-1) {
+  while ((opt = getopt(argc, argv, "A:B:c:C:dD:E:F:hrs:i:t:S:T:vw:z:")) !=-1) {
 
     switch (opt) {
 
@@ -1000,6 +1004,15 @@ main(int argc, char *argv[])
       verbose = !verbose;  /* Just invert */
       break;
 
+    case 'z':
+      compress_threads = strtol(optarg, &p, 10);
+      if (p == optarg || *p != '\0' || compress_threads <= 0) {
+        fprintf(stderr, "editcap: \"%s\" isn't a valid number of threads\n",
+            optarg);
+        exit(1);
+      }
+      break;
+
     case 'i': /* break capture file based on time interval */
       secs_per_block = atoi(optarg);
       if(secs_per_block <= 0) {
@@ -1080,6 +1093,20 @@ main(int argc, char *argv[])
     exit(1);
   }
 
+  if (compress_threads > 1) {
+#if !GLIB_CHECK_VERSION(2,31,0)
+    g_thread_init(NULL);
+#endif
+    wtap_dump_set_compression_threads(compress_threads);
+  }
+  if (compress_threads > 0 && (argc - optind) >= 2 &&
+      g_str_has_suffix(argv[optind+1], ".zst")) {
+    if (!wtap_dump_set_compression_type(WTAP_ZSTD_COMPRESSED)) {
+      fprintf(stderr, "editcap: this version can't write Zstandard-compressed files\n");
+      exit(1);
+    }
+  }
+
   wth = wtap_open_offline(argv[optind], &err, &err_info, FALSE);
 
   if (!wth) {
@@ -1154,7 +1181,7 @@ main(int argc, char *argv[])
 
         pdh = wtap_dump_open_ng(filename, out_file_type, out_frame_type,
           snaplen ? MIN(snaplen, wtap_snapshot_length(wth)) : wtap_snapshot_length(wth),
-          FALSE /* compressed */, shb_hdr, idb_inf, &err);
+          compress_threads > 0, shb_hdr, idb_inf, &err);
 
         if (pdh == NULL) {
           fprintf(stderr, "editcap: Can't open or create %s: %s\n", filename,
@@ -1186,7 +1213,7 @@ main(int argc, char *argv[])
 
           pdh = wtap_dump_open_ng(filename, out_file_type, out_frame_type,
             snaplen ? MIN(snaplen, wtap_snapshot_length(wth)) : wtap_snapshot_length(wth),
-            FALSE /* compressed */, shb_hdr, idb_inf, &err);
+            compress_threads > 0, shb_hdr, idb_inf, &err);
 
           if (pdh == NULL) {
             fprintf(stderr, "editcap: Can't open or create %s: %s\n", filename,
@@ -1217,7 +1244,7 @@ main(int argc, char *argv[])
 
           pdh = wtap_dump_open_ng(filename, out_file_type, out_frame_type,
             snaplen ? MIN(snaplen, wtap_snapshot_length(wth)) : wtap_snapshot_length(wth),
-            FALSE /* compressed */, shb_hdr, idb_inf, &err);
+            compress_threads > 0, shb_hdr, idb_inf, &err);
           if (pdh == NULL) {
             fprintf(stderr, "editcap: Can't open or create %s: %s\n", filename,
                 wtap_strerror(err));
@@ -1509,7 +1536,7 @@ main(int argc, char *argv[])
 
       pdh = wtap_dump_open_ng(filename, out_file_type, out_frame_type,
         snaplen ? MIN(snaplen, wtap_snapshot_length(wth)): wtap_snapshot_length(wth),
-        FALSE /* compressed */, shb_hdr, idb_inf, &err);
+        compress_threads > 0, shb_hdr, idb_inf, &err);
       if (pdh == NULL) {
         fprintf(stderr, "editcap: Can't open or create %s: %s\n", filename,
         wtap_strerror(err));
@@ -61,6 +61,7 @@ col_setup(column_info *cinfo, const gint num_cols)
   cinfo->col_custom_occurrence = g_new(gint, num_cols);
   cinfo->col_custom_field_id = g_new(int, num_cols);
   cinfo->col_custom_dfilter = g_new(dfilter_t*, num_cols);
+  cinfo->col_custom_value = g_new0(col_custom_value_t, num_cols);
   cinfo->col_data   = (const gchar **)g_new(gchar*, num_cols);
   cinfo->col_buf    = g_new(gchar*, num_cols);
   cinfo->col_fence  = g_new(int, num_cols);
@@ -87,6 +88,7 @@ col_cleanup(column_info *cinfo)
   g_free(cinfo->col_custom_occurrence);
   g_free(cinfo->col_custom_field_id);
   g_free(cinfo->col_custom_dfilter);
+  g_free(cinfo->col_custom_value);
   /*
    * XXX - MSVC doesn't correctly handle the "const" qualifier; it thinks
    * "const XXX **" means "pointer to const pointer to XXX", i.e. that
@@ -236,6 +238,82 @@ have_custom_cols(column_info *cinfo)
   return HAVE_CUSTOM_COLS(cinfo);
 }
 
+/* Fill in the typed value of a custom column from the field it shows, if
+   it shows exactly one value that can be compared without its text. */
+static void
+col_custom_set_value(col_custom_value_t *value, field_info *finfo)
+{
+  header_field_info *hfinfo;
+  guint8 *bytes;
+
+  value->type = COL_CUSTOM_VALUE_NONE;
+  if (finfo == NULL)
+    return;
+
+  hfinfo = finfo->hfinfo;
+  switch (hfinfo->type) {
+
+  case FT_UINT8:
+  case FT_UINT16:
+  case FT_UINT24:
+  case FT_UINT32:
+  case FT_FRAMENUM:
+  case FT_INT8:
+  case FT_INT16:
+  case FT_INT24:
+  case FT_INT32:
+  case FT_UINT64:
+  case FT_INT64:
+  case FT_BOOLEAN:
+    /* Values shown as strings sort by their text. */
+    if (hfinfo->strings != NULL ||
+        (hfinfo->display & BASE_DISPLAY_E_MASK) == BASE_CUSTOM)
+      return;
+    if (IS_FT_INT(hfinfo->type)) {
+      value->type = COL_CUSTOM_VALUE_INT;
+      if (hfinfo->type == FT_INT64)
+        value->value.sinteger = (gint64)fvalue_get_integer64(&finfo->value);
+      else
+        value->value.sinteger = fvalue_get_sinteger(&finfo->value);
+    } else {
+      value->type = COL_CUSTOM_VALUE_UINT;
+      if (hfinfo->type == FT_UINT64)
+        value->value.uinteger = fvalue_get_integer64(&finfo->value);
+      else
+        value->value.uinteger = fvalue_get_uinteger(&finfo->value);
+    }
+    break;
+
+  case FT_FLOAT:
+  case FT_DOUBLE:
+    value->type = COL_CUSTOM_VALUE_DOUBLE;
+    value->value.floating = fvalue_get_floating(&finfo->value);
+    break;
+
+  case FT_ABSOLUTE_TIME:
+  case FT_RELATIVE_TIME:
+    value->type = COL_CUSTOM_VALUE_TIME;
+    value->value.time = *(nstime_t *)fvalue_get(&finfo->value);
+    break;
+
+  case FT_IPv4:
+    value->type = COL_CUSTOM_VALUE_UINT;
+    value->value.uinteger = g_ntohl(ipv4_get_net_order_addr((ipv4_addr *)fvalue_get(&finfo->value)));
+    break;
+
+  case FT_IPv6:
+  case FT_ETHER:
+    bytes = (guint8 *)fvalue_get(&finfo->value);
+    value->type = COL_CUSTOM_VALUE_BYTES;
+    value->value.bytes.len = (hfinfo->type == FT_IPv6) ? 16 : 6;
+    memcpy(value->value.bytes.data, bytes, value->value.bytes.len);
+    break;
+
+  default:
+    break;
+  }
+}
+
 /* search in edt tree custom fields */
 void col_custom_set_edt(epan_dissect_t *edt, column_info *cinfo)
 {
@@ -246,6 +324,7 @@ void col_custom_set_edt(epan_dissect_t *edt, column_info *cinfo)
 
   for (i = cinfo->col_first[COL_CUSTOM];
        i <= cinfo->col_last[COL_CUSTOM]; i++) {
+    cinfo->col_custom_value[i].type = COL_CUSTOM_VALUE_NONE;
     if (cinfo->fmt_matx[i][COL_CUSTOM] &&
         cinfo->col_custom_field[i] &&
         cinfo->col_custom_field_id[i] != -1) {
@@ -255,10 +334,53 @@ void col_custom_set_edt(epan_dissect_t *edt, column_info *cinfo)
                                      cinfo->col_buf[i],
                                      cinfo->col_expr.col_expr_val[i],
                                      COL_MAX_LEN);
+       col_custom_set_value(&cinfo->col_custom_value[i],
+                            proto_custom_get_finfo(edt->tree,
+                                                   cinfo->col_custom_field_id[i],
+                                                   cinfo->col_custom_occurrence[i]));
     }
   }
 }
 
+/* Compare the typed values of a custom column; returns 0 if either
+   has no typed value, in which case the column text has to be compared. */
+gint
+col_custom_value_compare(const col_custom_value_t *a, const col_custom_value_t *b)
+{
+  gint ret;
+
+  if (a->type != b->type || a->type == COL_CUSTOM_VALUE_NONE)
+    return 0;
+
+  switch (a->type) {
+
+  case COL_CUSTOM_VALUE_UINT:
+    return (a->value.uinteger < b->value.uinteger) ? -1 :
+           (a->value.uinteger > b->value.uinteger) ? 1 : 0;
+
+  case COL_CUSTOM_VALUE_INT:
+    return (a->value.sinteger < b->value.sinteger) ? -1 :
+           (a->value.sinteger > b->value.sinteger) ? 1 : 0;
+
+  case COL_CUSTOM_VALUE_DOUBLE:
+    return (a->value.floating < b->value.floating) ? -1 :
+           (a->value.floating > b->value.floating) ? 1 : 0;
+
+  case COL_CUSTOM_VALUE_TIME:
+    return nstime_cmp(&a->value.time, &b->value.time);
+
+  case COL_CUSTOM_VALUE_BYTES:
+    ret = memcmp(a->value.bytes.data, b->value.bytes.data,
+                 MIN(a->value.bytes.len, b->value.bytes.len));
+    if (ret == 0)
+      ret = a->value.bytes.len - b->value.bytes.len;
+    return ret;
+
+  default:
+    return 0;
+  }
+}
+
 void
 col_custom_prime_edt(epan_dissect_t *edt, column_info *cinfo)
 {
@@ -1858,6 +1980,7 @@ col_fill_in_error(column_info *cinfo, frame_data *fdata, const gboolean fill_col
        * result of the dissection, so....
        */
       cinfo->col_data[i] = "???";
+      cinfo->col_custom_value[i].type = COL_CUSTOM_VALUE_NONE;
       break;
     }
   }
@@ -162,6 +162,12 @@ void col_custom_prime_edt(epan_dissect_t *edt, column_info *cinfo);
 
 /** For internal Wireshark use only.  Not to be called from dissectors. */
 gboolean have_custom_cols(column_info *cinfo);
+/** Compare the typed values of a custom column, as filled in by
+ *  col_custom_set_edt().  For internal Wireshark use only.
+ *
+ * @return <0, 0 or >0 as for strcmp(); 0 also if either value has no
+ *         type, in which case the column text has to be compared */
+gint col_custom_value_compare(const col_custom_value_t *a, const col_custom_value_t *b);
 /** For internal Wireshark use only.  Not to be called from dissectors. */
 gboolean col_has_time_fmt(column_info *cinfo, const gint col);
 /** For internal Wireshark use only.  Not to be called from dissectors. */
@@ -26,6 +26,7 @@
 #define __COLUMN_INFO_H__
 
 #include <glib.h>
+#include "nstime.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,6 +45,32 @@ typedef struct {
   gchar      **col_expr_val;  /**< Value for filter expression */
 } col_expr_t;
 
+/** Kind of typed value kept for a custom column */
+typedef enum {
+  COL_CUSTOM_VALUE_NONE,      /**< No typed value; the column text must be used */
+  COL_CUSTOM_VALUE_UINT,      /**< Unsigned integer, or IPv4 address in host byte order */
+  COL_CUSTOM_VALUE_INT,       /**< Signed integer */
+  COL_CUSTOM_VALUE_DOUBLE,    /**< Floating point number */
+  COL_CUSTOM_VALUE_TIME,      /**< Absolute or relative time */
+  COL_CUSTOM_VALUE_BYTES      /**< Up to 16 bytes, compared bytewise (IPv6 or MAC address) */
+} col_custom_value_type_e;
+
+/** Typed value of a custom column, kept alongside the column text so
+ *  that the column can be sorted without parsing the text */
+typedef struct {
+  col_custom_value_type_e type;
+  union {
+    guint64   uinteger;
+    gint64    sinteger;
+    gdouble   floating;
+    nstime_t  time;
+    struct {
+      guint8  len;
+      guint8  data[16];
+    } bytes;
+  } value;
+} col_custom_value_t;
+
 /** Column info */
 typedef struct _column_info {
   gint                num_cols;             /**< Number of columns */
@@ -56,6 +83,7 @@ typedef struct _column_info {
   gint               *col_custom_occurrence;/**< Custom column field occurrence */
   gint               *col_custom_field_id;  /**< Custom column field id */
   struct _dfilter_t **col_custom_dfilter;   /**< Compiled custom column field */
+  col_custom_value_t *col_custom_value;     /**< Typed value of custom column */
   const gchar       **col_data;             /**< Column data */
   gchar             **col_buf;              /**< Buffer into which to copy data for column */
   int                *col_fence;            /**< Stuff in column buffer before this index is immutable */
@@ -973,6 +973,8 @@ proto_register_bittorrent(void)
 void
 proto_reg_handoff_bittorrent(void)
 {
+   static const guint8 bittorrent_handshake[] = "\x13" "BitTorrent protocol";
+
    dissector_handle = find_dissector("bittorrent.tcp");
 #if 0
    dissector_add_uint("tcp.port", 6881, dissector_handle);
@@ -985,7 +987,8 @@ proto_reg_handoff_bittorrent(void)
    dissector_add_uint("tcp.port", 6888, dissector_handle);
    dissector_add_uint("tcp.port", 6889, dissector_handle);
 #endif
-   heur_dissector_add("tcp", test_bittorrent_packet, proto_bittorrent);
+   heur_dissector_add_with_prefilter("tcp", test_bittorrent_packet, proto_bittorrent,
+                                     bittorrent_handshake, sizeof bittorrent_handshake - 1);
 }
 
 /*
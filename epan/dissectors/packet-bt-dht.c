@@ -555,7 +555,8 @@ proto_reg_handoff_bt_dht(void)
    *  Heuristic dissection in disabled by default since the heuristic is quite weak.
    */
   if (!prefs_initialized) {
-    heur_dissector_add("udp", dissect_bt_dht_heur, proto_bt_dht);
+    heur_dissector_add_with_prefilter("udp", dissect_bt_dht_heur, proto_bt_dht,
+                                      (const guint8 *)"d", 1);
 
     bt_dht_handle = new_create_dissector_handle(dissect_bt_dht, proto_bt_dht);
     dissector_add_handle("udp.port", bt_dht_handle);   /* for "decode_as" */
@@ -625,7 +625,7 @@ dns_type_name (guint type)
   return val_to_str(type, dns_types, "Unknown (%u)");
 }
 
-static char *
+static const char *
 dns_type_description (guint type)
 {
   static const char *type_names[] = {
@@ -692,6 +692,7 @@ dns_type_description (guint type)
   };
   const char *short_name;
   const char *long_name;
+  char desc[128];
 
   short_name = dns_type_name(type);
   if (short_name == NULL) {
@@ -733,9 +734,11 @@ dns_type_description (guint type)
   }
 
   if (long_name != NULL) {
-    return ep_strdup_printf("%s (%s)", short_name, long_name);
+    /* There are only so many of these; don't build one for every record. */
+    g_snprintf(desc, sizeof desc, "%s (%s)", short_name, long_name);
+    return ep_strintern(desc);
   } else {
-    return ep_strdup(short_name);
+    return short_name;
   }
 }
 
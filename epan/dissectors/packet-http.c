@@ -2033,7 +2033,7 @@ is_http_request_or_reply(const gchar *data, int linelen, http_type_t *type,
 			*reqresp_dissector = basic_request_dissector;
 
 			stat_info->request_method = ep_strndup(data, indx+1);
-			conv_data->request_method = se_strndup(data, indx+1);
+			conv_data->request_method = se_strnintern(data, indx+1);
 		}
 
 
@@ -2050,6 +2050,7 @@ typedef struct {
 	const char	*name;
 	gint		*hf;
 	int		special;
+	gboolean	intern;		/* values from a small fixed set; intern them */
 } header_info;
 
 #define HDR_NO_SPECIAL		0
@@ -2063,35 +2064,35 @@ typedef struct {
 #define HDR_UPGRADE		8
 
 static const header_info headers[] = {
-	{ "Authorization", &hf_http_authorization, HDR_AUTHORIZATION },
-	{ "Proxy-Authorization", &hf_http_proxy_authorization, HDR_AUTHORIZATION },
-	{ "Proxy-Authenticate", &hf_http_proxy_authenticate, HDR_AUTHENTICATE },
-	{ "WWW-Authenticate", &hf_http_www_authenticate, HDR_AUTHENTICATE },
-	{ "Content-Type", &hf_http_content_type, HDR_CONTENT_TYPE },
-	{ "Content-Length", &hf_http_content_length_header, HDR_CONTENT_LENGTH },
-	{ "Content-Encoding", &hf_http_content_encoding, HDR_CONTENT_ENCODING },
-	{ "Transfer-Encoding", &hf_http_transfer_encoding, HDR_TRANSFER_ENCODING },
-	{ "Upgrade", &hf_http_upgrade, HDR_UPGRADE },
-	{ "User-Agent",	&hf_http_user_agent, HDR_NO_SPECIAL },
-	{ "Host", &hf_http_host, HDR_HOST },
-	{ "Connection", &hf_http_connection, HDR_NO_SPECIAL },
-	{ "Cookie", &hf_http_cookie, HDR_NO_SPECIAL },
-	{ "Accept", &hf_http_accept, HDR_NO_SPECIAL },
-	{ "Referer", &hf_http_referer, HDR_NO_SPECIAL },
-	{ "Accept-Language", &hf_http_accept_language, HDR_NO_SPECIAL },
-	{ "Accept-Encoding", &hf_http_accept_encoding, HDR_NO_SPECIAL },
-	{ "Date", &hf_http_date, HDR_NO_SPECIAL },
-	{ "Cache-Control", &hf_http_cache_control, HDR_NO_SPECIAL },
-	{ "Server", &hf_http_server, HDR_NO_SPECIAL },
-	{ "Location", &hf_http_location, HDR_NO_SPECIAL },
-	{ "Sec-WebSocket-Accept", &hf_http_sec_websocket_accept, HDR_NO_SPECIAL },
-	{ "Sec-WebSocket-Extensions", &hf_http_sec_websocket_extensions, HDR_NO_SPECIAL },
-	{ "Sec-WebSocket-Key", &hf_http_sec_websocket_key, HDR_NO_SPECIAL },
-	{ "Sec-WebSocket-Protocol", &hf_http_sec_websocket_protocol, HDR_NO_SPECIAL },
-	{ "Sec-WebSocket-Version", &hf_http_sec_websocket_version, HDR_NO_SPECIAL },
-	{ "Set-Cookie", &hf_http_set_cookie, HDR_NO_SPECIAL },
-	{ "Last-Modified", &hf_http_last_modified, HDR_NO_SPECIAL },
-	{ "X-Forwarded-For", &hf_http_x_forwarded_for, HDR_NO_SPECIAL },
+	{ "Authorization", &hf_http_authorization, HDR_AUTHORIZATION, FALSE },
+	{ "Proxy-Authorization", &hf_http_proxy_authorization, HDR_AUTHORIZATION, FALSE },
+	{ "Proxy-Authenticate", &hf_http_proxy_authenticate, HDR_AUTHENTICATE, FALSE },
+	{ "WWW-Authenticate", &hf_http_www_authenticate, HDR_AUTHENTICATE, FALSE },
+	{ "Content-Type", &hf_http_content_type, HDR_CONTENT_TYPE, FALSE },
+	{ "Content-Length", &hf_http_content_length_header, HDR_CONTENT_LENGTH, FALSE },
+	{ "Content-Encoding", &hf_http_content_encoding, HDR_CONTENT_ENCODING, TRUE },
+	{ "Transfer-Encoding", &hf_http_transfer_encoding, HDR_TRANSFER_ENCODING, TRUE },
+	{ "Upgrade", &hf_http_upgrade, HDR_UPGRADE, TRUE },
+	{ "User-Agent",	&hf_http_user_agent, HDR_NO_SPECIAL, FALSE },
+	{ "Host", &hf_http_host, HDR_HOST, FALSE },
+	{ "Connection", &hf_http_connection, HDR_NO_SPECIAL, TRUE },
+	{ "Cookie", &hf_http_cookie, HDR_NO_SPECIAL, FALSE },
+	{ "Accept", &hf_http_accept, HDR_NO_SPECIAL, FALSE },
+	{ "Referer", &hf_http_referer, HDR_NO_SPECIAL, FALSE },
+	{ "Accept-Language", &hf_http_accept_language, HDR_NO_SPECIAL, FALSE },
+	{ "Accept-Encoding", &hf_http_accept_encoding, HDR_NO_SPECIAL, FALSE },
+	{ "Date", &hf_http_date, HDR_NO_SPECIAL, FALSE },
+	{ "Cache-Control", &hf_http_cache_control, HDR_NO_SPECIAL, FALSE },
+	{ "Server", &hf_http_server, HDR_NO_SPECIAL, FALSE },
+	{ "Location", &hf_http_location, HDR_NO_SPECIAL, FALSE },
+	{ "Sec-WebSocket-Accept", &hf_http_sec_websocket_accept, HDR_NO_SPECIAL, FALSE },
+	{ "Sec-WebSocket-Extensions", &hf_http_sec_websocket_extensions, HDR_NO_SPECIAL, FALSE },
+	{ "Sec-WebSocket-Key", &hf_http_sec_websocket_key, HDR_NO_SPECIAL, FALSE },
+	{ "Sec-WebSocket-Protocol", &hf_http_sec_websocket_protocol, HDR_NO_SPECIAL, FALSE },
+	{ "Sec-WebSocket-Version", &hf_http_sec_websocket_version, HDR_NO_SPECIAL, TRUE },
+	{ "Set-Cookie", &hf_http_set_cookie, HDR_NO_SPECIAL, FALSE },
+	{ "Last-Modified", &hf_http_last_modified, HDR_NO_SPECIAL, FALSE },
+	{ "X-Forwarded-For", &hf_http_x_forwarded_for, HDR_NO_SPECIAL, FALSE },
 };
 
 /*
@@ -2188,7 +2189,7 @@ process_header(tvbuff_t *tvb, int offset, int next_offset,
 	len = next_offset - offset;
 	line_end_offset = offset + linelen;
 	header_len = colon_offset - offset;
-	header_name = se_strndup(&line[0], header_len);
+	header_name = ep_strndup(&line[0], header_len);
 	hf_index = find_header_hf_value(tvb, offset, header_len);
 
 	/*
@@ -2247,7 +2248,8 @@ process_header(tvbuff_t *tvb, int offset, int next_offset,
 			default:
 				hdr_item = proto_tree_add_string_format(tree,
 				    *headers[hf_index].hf, tvb, offset, len,
-				    value, "%s", format_text(line, len));
+				    headers[hf_index].intern ? ep_strintern(value) : value,
+				    "%s", format_text(line, len));
 			}
 		} else
 			hdr_item = NULL;
@@ -40,7 +40,7 @@ typedef struct _http_info_value_t {
 /* Used for HTTP Export Object feature */
 typedef struct _http_eo_t {
 	guint32  pkt_num;
-	gchar   *hostname;
+	const gchar *hostname;
 	gchar   *filename;
 	gchar   *content_type;
 	guint32  payload_len;
@@ -50,8 +50,8 @@ typedef struct _http_eo_t {
 /* Conversation data - used for the http_payload_subdissector() function. */
 typedef struct _http_conv_t {
 	guint    response_code;
-	gchar   *http_host;
-	gchar   *request_method;
+	const gchar *http_host;
+	const gchar *request_method;
 	gchar   *request_uri;
 	guint8   upgrade;
 	guint32	startframe;	/* First frame of proxied connection */
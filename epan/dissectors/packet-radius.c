@@ -946,8 +946,9 @@ void dissect_attribute_value_pairs(proto_tree *tree, packet_info *pinfo, tvbuff_
 
 	GHashTable* vsa_buffer_table = NULL;
 
-	/* Forces load of header fields, if not already done so */
-	DISSECTOR_ASSERT(proto_registrar_get_byname("radius.code"));
+	/* Other dissectors call this directly rather than through our
+	 * handle, so register the header fields if not already done so */
+	proto_initialize_protocol_prefix(find_protocol_by_id(proto_radius));
 
 	/*
 	 * In case we throw an exception, clean up whatever stuff we've
@@ -1395,9 +1396,6 @@ dissect_radius(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _
 
 	if (tree)
 	{
-		/* Forces load of header fields, if not already done so */
-		DISSECTOR_ASSERT(proto_registrar_get_byname("radius.code"));
-
 		ti = proto_tree_add_item(tree,proto_radius, tvb, 0, rh.rh_pktlength, ENC_NA);
 		radius_tree = proto_item_add_subtree(ti, ett_radius);
 		proto_tree_add_uint(radius_tree,hf_radius_code, tvb, 0, 1, rh.rh_code);
@@ -3772,9 +3772,13 @@ dissect_create_file_request(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 static int
 dissect_close_file_request(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, int offset, proto_tree *smb_tree _U_)
 {
+	smb_info_t *si = pinfo->private_data;
+	smb_eo_t   *eo_info;
 	guint8  wc;
 	guint16 bc, fid;
 
+	DISSECTOR_ASSERT(si);
+
 	WORD_COUNT;
 
 	/* fid */
@@ -3782,6 +3786,17 @@ dissect_close_file_request(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 	dissect_smb_fid(tvb, pinfo, tree, offset, 2, fid, FALSE, TRUE, FALSE);
 	offset += 2;
 
+	/* tell the export object tap listener that the file is complete */
+	if (have_tap_listener(smb_eo_tap)) {
+		eo_info = ep_alloc0(sizeof(smb_eo_t));
+		eo_info->cmd = SMB_COM_CLOSE;
+		eo_info->tid = si->tid;
+		eo_info->uid = si->uid;
+		eo_info->fid = fid;
+		eo_info->fid_type = SMB_FID_TYPE_UNKNOWN;
+		tap_queue_packet(smb_eo_tap, pinfo, eo_info);
+	}
+
 	/* last write time */
 	offset = dissect_smb_UTIME(tvb, tree, offset, hf_smb_last_write_time);
 
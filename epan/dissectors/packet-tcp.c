@@ -802,30 +802,174 @@ tcp_analyze_get_acked_struct(guint32 frame, guint32 seq, guint32 ack, gboolean c
 }
 
 
-/* fwd contains a list of all segments processed but not yet ACKed in the
+/* The segments that haven't been ACKed yet are kept in a treap: a binary
+ * search tree ordered by seq, which is also a heap ordered by a priority
+ * hashed from the frame number, so that it stays balanced (O(log n) deep)
+ * whatever order the segments come in.  Each node also has the highest
+ * nextseq in its subtree, which makes it an interval tree over sequence
+ * space.
+ *
+ * With a long fat pipe (10 Gbit/s with a 100 ms RTT is about 85000 full
+ * sized segments in flight) walking a list of them for every ACK made the
+ * analysis quadratic.  Now an ACK splits off the segments starting before
+ * it, which are the only ones it can concern, and the bytes in flight are
+ * the root's maxnextseq less the leftmost segment's seq.
+ *
+ * The seqs are compared with LT_SEQ()/GT_SEQ(), so the order survives the
+ * sequence numbers wrapping around, as long as the segments in flight
+ * span less than 2GB of sequence space, which TCP guarantees anyway.
+ */
+static guint32
+tcp_unacked_priority(guint32 frame)
+{
+    /* the MurmurHash3 finalizer; frame numbers themselves are sorted */
+    frame ^= frame >> 16;
+    frame *= 0x85ebca6b;
+    frame ^= frame >> 13;
+    frame *= 0xc2b2ae35;
+    frame ^= frame >> 16;
+    return frame;
+}
+
+static void
+tcp_unacked_update(tcp_unacked_t *ual)
+{
+    ual->maxnextseq = ual->nextseq;
+    if (ual->left && GT_SEQ(ual->left->maxnextseq, ual->maxnextseq)) {
+        ual->maxnextseq = ual->left->maxnextseq;
+    }
+    if (ual->right && GT_SEQ(ual->right->maxnextseq, ual->maxnextseq)) {
+        ual->maxnextseq = ual->right->maxnextseq;
+    }
+}
+
+/* Split a treap into the segments starting before seq and the rest */
+static void
+tcp_unacked_split(tcp_unacked_t *ual, guint32 seq, tcp_unacked_t **before, tcp_unacked_t **rest)
+{
+    if (!ual) {
+        *before = NULL;
+        *rest = NULL;
+        return;
+    }
+    if (LT_SEQ(ual->seq, seq)) {
+        tcp_unacked_split(ual->right, seq, &ual->right, rest);
+        *before = ual;
+    } else {
+        tcp_unacked_split(ual->left, seq, before, &ual->left);
+        *rest = ual;
+    }
+    tcp_unacked_update(ual);
+}
+
+/* Join two treaps, where no segment in low starts after any in high */
+static tcp_unacked_t *
+tcp_unacked_merge(tcp_unacked_t *low, tcp_unacked_t *high)
+{
+    if (!low) {
+        return high;
+    }
+    if (!high) {
+        return low;
+    }
+    if (low->priority > high->priority) {
+        low->right = tcp_unacked_merge(low->right, high);
+        tcp_unacked_update(low);
+        return low;
+    }
+    high->left = tcp_unacked_merge(low, high->left);
+    tcp_unacked_update(high);
+    return high;
+}
+
+static tcp_unacked_t *
+tcp_unacked_insert(tcp_unacked_t *root, tcp_unacked_t *ual)
+{
+    tcp_unacked_t *before, *rest;
+
+    ual->left = NULL;
+    ual->right = NULL;
+    ual->priority = tcp_unacked_priority(ual->frame);
+    tcp_unacked_update(ual);
+
+    tcp_unacked_split(root, ual->seq, &before, &rest);
+    return tcp_unacked_merge(tcp_unacked_merge(before, ual), rest);
+}
+
+/* Go through the segments starting before ack: free the ones it ACKs
+ * completely, and return the ones it ACKs part of, trimmed to start at
+ * ack, merged into kept.  The oldest segment that ends exactly at ack,
+ * if any, is left in *match for the RTT.
+ */
+static tcp_unacked_t *
+tcp_unacked_ack(tcp_unacked_t *ual, guint32 ack, tcp_unacked_t *kept, tcp_unacked_t *match, struct tcp_analysis *tcpd)
+{
+    tcp_unacked_t *left, *right;
+
+    if (!ual) {
+        return kept;
+    }
+    left = ual->left;
+    right = ual->right;
+    kept = tcp_unacked_ack(left, ack, kept, match, tcpd);
+    kept = tcp_unacked_ack(right, ack, kept, match, tcpd);
+
+    /* If this acknowledges part of the segment, adjust the segment info for the acked part */
+    if (GT_SEQ(ual->nextseq, ack)) {
+        ual->seq = ack;
+        ual->left = NULL;
+        ual->right = NULL;
+        tcp_unacked_update(ual);
+        return tcp_unacked_merge(kept, ual);
+    }
+
+    /* If this ack matches the segment, remember it for the RTT */
+    if (ack == ual->nextseq && (!match->frame || ual->frame < match->frame)) {
+        match->frame = ual->frame;
+        match->ts = ual->ts;
+    }
+
+    if (tcpd->rev->scps_capable) {
+      /* Track largest segment successfully sent for SNACK analysis*/
+      if ((ual->nextseq - ual->seq) > tcpd->fwd->maxsizeacked) {
+        tcpd->fwd->maxsizeacked = (ual->nextseq - ual->seq);
+      }
+    }
+
+    TCP_UNACKED_FREE(ual);
+    return kept;
+}
+
+#if 0
+static void
+tcp_unacked_print(tcp_unacked_t *ual)
+{
+    if (ual) {
+        tcp_unacked_print(ual->left);
+        printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+        tcp_unacked_print(ual->right);
+    }
+}
+#endif
+
+/* fwd contains all segments processed but not yet ACKed in the
  *     same direction as the current segment.
- * rev contains a list of all segments received but not yet ACKed in the
+ * rev contains all segments received but not yet ACKed in the
  *     opposite direction to the current segment.
  *
- * New segments are always added to the head of the fwd/rev lists.
- *
  */
 static void
 tcp_analyze_sequence_number(packet_info *pinfo, guint32 seq, guint32 ack, guint32 seglen, guint16 flags, guint32 window, struct tcp_analysis *tcpd)
 {
     tcp_unacked_t *ual=NULL;
-    tcp_unacked_t *prevual=NULL;
     guint32 nextseq;
-    int ackcount;
 
 #if 0
     printf("\nanalyze_sequence numbers   frame:%u\n",pinfo->fd->num);
     printf("FWD list lastflags:0x%04x base_seq:%u:\n",tcpd->fwd->lastsegmentflags,tcpd->fwd->base_seq);
-    for(ual=tcpd->fwd->segments; ual; ual=ual->next)
-            printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+    tcp_unacked_print(tcpd->fwd->segments);
     printf("REV list lastflags:0x%04x base_seq:%u:\n",tcpd->rev->lastsegmentflags,tcpd->rev->base_seq);
-    for(ual=tcpd->rev->segments; ual; ual=ual->next)
-            printf("Frame:%d Seq:%u Nextseq:%u\n",ual->frame,ual->seq,ual->nextseq);
+    tcp_unacked_print(tcpd->rev->segments);
 #endif
 
     if (!tcpd) {
@@ -1119,10 +1263,8 @@ finished_checking_retransmission_type:
 
     nextseq = seq+seglen;
     if (seglen || flags&(TH_SYN|TH_FIN)) {
-        /* add this new sequence number to the fwd list */
+        /* add this new sequence number to the fwd segments */
         TCP_UNACKED_NEW(ual);
-        ual->next=tcpd->fwd->segments;
-        tcpd->fwd->segments=ual;
         ual->frame=pinfo->fd->num;
         ual->seq=seq;
         ual->ts=pinfo->fd->abs_ts;
@@ -1132,6 +1274,7 @@ finished_checking_retransmission_type:
             nextseq+=1;
         }
         ual->nextseq=nextseq;
+        tcpd->fwd->segments=tcp_unacked_insert(tcpd->fwd->segments, ual);
     }
 
     /* Store the highest number seen so far for nextseq so we can detect
@@ -1177,50 +1320,18 @@ finished_checking_retransmission_type:
 
     /* remove all segments this ACKs and we don't need to keep around any more
      */
-    ackcount=0;
-    prevual = NULL;
-    ual = tcpd->rev->segments;
-    while(ual) {
-        tcp_unacked_t *tmpual;
-
-        /* If this ack matches the segment, process accordingly */
-        if(ack==ual->nextseq) {
-            tcp_analyze_get_acked_struct(pinfo->fd->num, seq, ack, TRUE, tcpd);
-            tcpd->ta->frame_acked=ual->frame;
-            nstime_delta(&tcpd->ta->ts, &pinfo->fd->abs_ts, &ual->ts);
-        }
-        /* If this acknowledges part of the segment, adjust the segment info for the acked part */
-        else if (GT_SEQ(ack, ual->seq) && LE_SEQ(ack, ual->nextseq)) {
-            ual->seq = ack;
-            continue;
-        }
-        /* If this acknowledges a segment prior to this one, leave this segment alone and move on */
-        else if (GT_SEQ(ual->nextseq,ack)) {
-            prevual = ual;
-            ual = ual->next;
-            continue;
-        }
-
-        /* This segment is old, or an exact match.  Delete the segment from the list */
-        ackcount++;
-        tmpual=ual->next;
+    {
+        tcp_unacked_t *acked, *rest, match;
 
-        if (tcpd->rev->scps_capable) {
-          /* Track largest segment successfully sent for SNACK analysis*/
-          if ((ual->nextseq - ual->seq) > tcpd->fwd->maxsizeacked) {
-            tcpd->fwd->maxsizeacked = (ual->nextseq - ual->seq);
-          }
-        }
+        tcp_unacked_split(tcpd->rev->segments, ack, &acked, &rest);
+        match.frame = 0;
+        acked = tcp_unacked_ack(acked, ack, NULL, &match, tcpd);
+        tcpd->rev->segments = tcp_unacked_merge(acked, rest);
 
-        if (!prevual) {
-            tcpd->rev->segments = tmpual;
-            TCP_UNACKED_FREE(ual);
-            ual = tmpual;
-        }
-        else{
-            prevual->next = tmpual;
-            TCP_UNACKED_FREE(ual);
-            ual = tmpual;
+        if (match.frame) {
+            tcp_analyze_get_acked_struct(pinfo->fd->num, seq, ack, TRUE, tcpd);
+            tcpd->ta->frame_acked=match.frame;
+            nstime_delta(&tcpd->ta->ts, &pinfo->fd->abs_ts, &match.ts);
         }
     }
 
@@ -1231,17 +1342,11 @@ finished_checking_retransmission_type:
     if (tcp_track_bytes_in_flight && seglen!=0 && ual && tcpd->fwd->valid_bif) {
         guint32 first_seq, last_seq, in_flight;
 
-        first_seq = ual->seq - tcpd->fwd->base_seq;
-        last_seq = ual->nextseq - tcpd->fwd->base_seq;
-        while (ual) {
-            if ((ual->nextseq-tcpd->fwd->base_seq)>last_seq) {
-                last_seq = ual->nextseq-tcpd->fwd->base_seq;
-            }
-            if ((ual->seq-tcpd->fwd->base_seq)<first_seq) {
-                first_seq = ual->seq-tcpd->fwd->base_seq;
-            }
-            ual = ual->next;
+        last_seq = ual->maxnextseq;
+        while (ual->left) {
+            ual = ual->left;
         }
+        first_seq = ual->seq;
         in_flight = last_seq-first_seq;
 
         if (in_flight>0 && in_flight<2000000000) {
@@ -4694,6 +4799,19 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
                             pinfo->srcport,
                             pinfo->destport);
         }
+        if( follow_all_tcp_active() && !pinfo->fd->flags.visited ) {
+            follow_all_tcp_segment( tcpd->stream,
+                                    tcph->th_seq,
+                                    tcph->th_ack,
+                                    tcph->th_seglen,
+                                    (gchar*)tvb_get_ptr(tvb, offset, length_remaining),
+                                    length_remaining,
+                                    ( tcph->th_flags & TH_SYN ),
+                                    &pinfo->net_src,
+                                    &pinfo->net_dst,
+                                    pinfo->srcport,
+                                    pinfo->destport);
+        }
     }
 
     /* handle TCP seq# analysis, print any extra SEQ/ACK data for this segment*/
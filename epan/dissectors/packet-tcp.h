@@ -110,8 +110,12 @@ tcp_dissect_pdus(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 extern struct tcp_multisegment_pdu *
 pdu_store_sequencenumber_of_next_pdu(packet_info *pinfo, guint32 seq, guint32 nxtpdu, emem_tree_t *multisegment_pdus);
 
+/* A segment that hasn't been ACKed yet; these form a treap ordered by seq */
 typedef struct _tcp_unacked_t {
-	struct _tcp_unacked_t *next;
+	struct _tcp_unacked_t *left;	/* segments starting before this one */
+	struct _tcp_unacked_t *right;	/* segments starting at or after this one */
+	guint32 priority;		/* heap order, keeps the treap balanced */
+	guint32 maxnextseq;		/* highest nextseq in this subtree */
 	guint32 frame;
 	guint32	seq;
 	guint32	nextseq;
@@ -148,7 +152,7 @@ typedef struct _tcp_flow_t {
 	guint32 base_seq;		/* base seq number (used by relative sequence numbers)
 							 * or 0 if not yet known.
 							 */
-	tcp_unacked_t *segments;
+	tcp_unacked_t *segments;	/* root of the treap of unacked segments */
 	guint32 lastack;		/* last seen ack */
 	nstime_t lastacktime;	/* Time of the last ack packet */
 	guint32 lastnondupack;	/* frame number of last seen non dupack */
@@ -171,6 +171,24 @@ static emem_pool_t se_packet_mem;
  */
 static gboolean debug_use_memory_scrubber = FALSE;
 
+/* What has been allocated so far; see emem_get_stats(). */
+static emem_stats_t emem_stats;
+
+/*
+ * The interned strings.  They're never freed, so the table only takes
+ * strings of up to INTERN_MAX_LEN characters, and only until it has
+ * filled INTERN_MAX_BLOCKS blocks; after that the strings are copied
+ * the usual way.  Dissection is single-threaded, so there's no locking.
+ */
+#define INTERN_MAX_LEN		128
+#define INTERN_BLOCK_SIZE	(256 * 1024)
+#define INTERN_MAX_BLOCKS	16
+
+static GHashTable *intern_table = NULL;
+static gchar *intern_blocks[INTERN_MAX_BLOCKS];
+static guint intern_nblocks = 0;
+static gsize intern_block_used = 0;
+
 #if defined (_WIN32)
 static SYSTEM_INFO sysinfo;
 static OSVERSIONINFO versinfo;
@@ -880,6 +898,9 @@ emem_alloc(size_t size, emem_pool_t *mem)
 void *
 ep_alloc(size_t size)
 {
+	emem_stats.ep_allocs++;
+	emem_stats.ep_bytes += size;
+
 	return emem_alloc(size, &ep_packet_mem);
 }
 
@@ -889,6 +910,9 @@ ep_alloc(size_t size)
 void *
 se_alloc(size_t size)
 {
+	emem_stats.se_allocs++;
+	emem_stats.se_bytes += size;
+
 	return emem_alloc(size, &se_packet_mem);
 }
 
@@ -968,6 +992,7 @@ emem_strdup(const gchar *src, void *allocator(size_t))
 	if(!src)
 		return "<NULL>";
 
+	emem_stats.strdups++;
 	len = (guint) strlen(src);
 	dst = memcpy(allocator(len+1), src, len+1);
 
@@ -992,6 +1017,7 @@ emem_strndup(const gchar *src, size_t len, void *allocator(size_t))
 	gchar *dst = allocator(len+1);
 	guint i;
 
+	emem_stats.strdups++;
 	for (i = 0; (i < len) && src[i]; i++)
 		dst[i] = src[i];
 
@@ -1026,6 +1052,120 @@ se_memdup(const void* src, size_t len)
 	return memcpy(se_alloc(len), src, len);
 }
 
+/* Look up, or add, a NUL-terminated string of "len" characters; returns
+ * NULL if the table is full. */
+static const gchar *
+emem_intern_lookup(const gchar *src, size_t len)
+{
+	gchar *dst;
+
+	emem_stats.intern_lookups++;
+	if (intern_table == NULL)
+		intern_table = g_hash_table_new(g_str_hash, g_str_equal);
+
+	dst = g_hash_table_lookup(intern_table, src);
+	if (dst != NULL) {
+		emem_stats.intern_hits++;
+		return dst;
+	}
+
+	if (intern_nblocks == 0 || intern_block_used + len + 1 > INTERN_BLOCK_SIZE) {
+		if (intern_nblocks == INTERN_MAX_BLOCKS)
+			return NULL;
+		intern_blocks[intern_nblocks++] = g_malloc(INTERN_BLOCK_SIZE);
+		intern_block_used = 0;
+	}
+	dst = intern_blocks[intern_nblocks - 1] + intern_block_used;
+	memcpy(dst, src, len + 1);
+	intern_block_used += len + 1;
+
+	g_hash_table_insert(intern_table, dst, dst);
+	emem_stats.intern_strings++;
+	emem_stats.intern_bytes += len + 1;
+
+	return dst;
+}
+
+static const gchar *
+emem_strintern(const gchar *src, void *allocator(size_t))
+{
+	const gchar *dst;
+	size_t len;
+
+	if(!src)
+		return "<NULL>";
+
+	len = strlen(src);
+	if (len <= INTERN_MAX_LEN && (dst = emem_intern_lookup(src, len)) != NULL)
+		return dst;
+
+	return emem_strdup(src, allocator);
+}
+
+static const gchar *
+emem_strnintern(const gchar *src, size_t len, void *allocator(size_t))
+{
+	gchar buf[INTERN_MAX_LEN + 1];
+	const gchar *dst;
+	size_t i;
+
+	for (i = 0; (i < len) && src[i]; i++)
+		;
+	len = i;
+
+	if (len <= INTERN_MAX_LEN) {
+		memcpy(buf, src, len);
+		buf[len] = '\0';
+		if ((dst = emem_intern_lookup(buf, len)) != NULL)
+			return dst;
+	}
+
+	return emem_strndup(src, len, allocator);
+}
+
+const gchar *
+ep_strintern(const gchar *src)
+{
+	return emem_strintern(src, ep_alloc);
+}
+
+const gchar *
+se_strintern(const gchar *src)
+{
+	return emem_strintern(src, se_alloc);
+}
+
+const gchar *
+ep_strnintern(const gchar *src, size_t len)
+{
+	return emem_strnintern(src, len, ep_alloc);
+}
+
+const gchar *
+se_strnintern(const gchar *src, size_t len)
+{
+	return emem_strnintern(src, len, se_alloc);
+}
+
+gboolean
+emem_is_interned(const void *ptr)
+{
+	const gchar *cptr = ptr;
+	guint i;
+
+	for (i = 0; i < intern_nblocks; i++) {
+		if (cptr >= intern_blocks[i] && cptr < intern_blocks[i] + INTERN_BLOCK_SIZE)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+void
+emem_get_stats(emem_stats_t *stats)
+{
+	*stats = emem_stats;
+}
+
 static gchar *
 emem_strdup_vprintf(const gchar *fmt, va_list ap, void *allocator(size_t))
 {
@@ -161,6 +161,50 @@ gchar* se_strdup_printf(const gchar* fmt, ...)
 /** release all memory allocated */
 void se_free_all(void);
 
+/* Interned strings.
+ * These return the same copy of a string every time they're called with
+ * an equal string; that copy is never freed, so it can be kept in a
+ * field value or passed to col_set_str() without being copied again.
+ * As the copies are never freed, only use these for strings from a small
+ * fixed set, such as protocol keywords, method names or header values
+ * with a few defined tokens; values the traffic can make up (host names,
+ * user agents, ...) would just fill the table.  Strings that are too
+ * long, or that no longer fit in the table, are copied with the lifetime
+ * scope of the ep_ or se_ variant instead, so the result is always valid
+ * for at least that long.
+ * The result must not be modified.
+ */
+
+/** Intern a string, or duplicate it with a packet lifetime scope */
+const gchar* ep_strintern(const gchar* src);
+
+/** Intern at most n characters of a string, or duplicate them with a packet lifetime scope */
+const gchar* ep_strnintern(const gchar* src, size_t len);
+
+/** Intern a string, or duplicate it with a capture lifetime scope */
+const gchar* se_strintern(const gchar* src);
+
+/** Intern at most n characters of a string, or duplicate them with a capture lifetime scope */
+const gchar* se_strnintern(const gchar* src, size_t len);
+
+/** Returns TRUE if ptr points into an interned string */
+gboolean emem_is_interned(const void *ptr);
+
+/** Counts of the allocations made so far, for "tshark -z mem,stat" */
+typedef struct _emem_stats_t {
+	guint64 ep_allocs;
+	guint64 ep_bytes;
+	guint64 se_allocs;
+	guint64 se_bytes;
+	guint64 strdups;		/* ep_/se_strdup() and strndup() copies */
+	guint64 intern_lookups;
+	guint64 intern_hits;
+	guint64 intern_strings;		/* strings in the table */
+	guint64 intern_bytes;
+} emem_stats_t;
+
+void emem_get_stats(emem_stats_t *stats);
+
 /**************************************************************
  * slab allocator
  **************************************************************/
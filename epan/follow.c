@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -36,20 +37,66 @@
 #include <glib.h>
 #include <epan/packet.h>
 #include <epan/ipproto.h>
+#include <epan/to_str.h>
 #include <epan/dissectors/packet-tcp.h>
 #include "follow.h"
 #include <epan/conversation.h>
 
+#include <wsutil/file_util.h>
+
 #define MAX_IPADDR_LEN  16
 
 typedef struct _tcp_frag {
   gulong              seq;
   gulong              len;
   gulong              data_len;
-  gchar              *data;
+  gchar              *data;           /* NULL if the data was spilled to disk */
+  gint64              spill_offset;   /* where the data is in the spill file */
   struct _tcp_frag   *next;
 } tcp_frag;
 
+/* Reassembly state of one stream. The single stream followed through
+   reassemble_tcp() uses one of these; follow_all_t keeps one for each
+   stream in the capture. */
+typedef struct _follow_stream {
+  tcp_frag           *frags[2];
+  gulong              seq[2];
+  guint8              src_addr[2][MAX_IPADDR_LEN];
+  guint               src_port[2];
+  gboolean            incomplete;
+
+  /* The rest is only used when following all streams */
+  follow_all_t       *all;
+  const char         *proto;
+  guint32             index;
+  address_type        addr_type;
+  int                 addr_len;
+  FILE               *out[2];
+  gboolean            created[2];
+  guint64             bytes_written[2];
+  guint64             bytes_missing[2];
+  guint               dropped;        /* UDP datagrams from a third endpoint */
+  guint64             bytes_dropped;
+  GList               open_link;      /* link in all->open_files */
+} follow_stream_t;
+
+struct _follow_all {
+  gchar              *dir;
+  GHashTable         *tcp_streams;    /* tcp.stream -> follow_stream_t */
+  GHashTable         *udp_streams;    /* conversation index -> follow_stream_t */
+  GQueue              open_files;     /* streams with open files, least recently written first */
+  gsize               mem_limit;
+  gsize               frag_bytes;     /* out of order data held in memory */
+  FILE               *spill;
+  gint64              spill_size;
+  gchar              *spill_buf;
+  gulong              spill_buf_len;
+  int                 err;
+};
+
+/* Keep at most this many streams' files open at once */
+#define FOLLOW_ALL_MAX_OPEN_STREAMS  128
+
 FILE* data_out_file = NULL;
 
 gboolean empty_tcp_stream;
@@ -61,8 +108,11 @@ static guint   port[2];
 static guint   bytes_written[2];
 static gboolean is_ipv6 = FALSE;
 
-static int check_fragments( int, tcp_stream_chunk *, gulong );
-static void write_packet_data( int, tcp_stream_chunk *, const char * );
+static follow_all_t *follow_all_active = NULL;
+
+static int check_fragments( follow_stream_t *, int, tcp_stream_chunk *, gulong );
+static void write_packet_data( follow_stream_t *, int, tcp_stream_chunk *, const char * );
+static void follow_all_write( follow_stream_t *, int, const char *, guint32 );
 
 void
 follow_stats(follow_stats_t* stats)
@@ -201,46 +251,118 @@ follow_tcp_index(guint32 index)
    session. We will try and handle duplicates, TCP fragments, and out
    of order packets in a smart way. */
 
-static tcp_frag *frags[2] = { 0, 0 };
-static gulong seq[2];
-static guint8 src_addr[2][MAX_IPADDR_LEN];
-static guint src_port[2] = { 0, 0 };
+static follow_stream_t follow_stream;
 
-void
-reassemble_tcp( guint32 tcp_stream, gulong sequence, gulong acknowledgement,
-                gulong length, const char* data, gulong data_length, 
-                int synflag, address *net_src, address *net_dst, 
-                guint srcport, guint dstport) {
-  guint8 srcx[MAX_IPADDR_LEN], dstx[MAX_IPADDR_LEN];
-  int src_index, j, first = 0, len;
-  gulong newseq;
-  tcp_frag *tmp_frag;
-  tcp_stream_chunk sc;
+static tcp_frag *
+new_fragment( follow_stream_t *stream, gulong sequence, gulong length,
+              const char *data, gulong data_length )
+{
+  follow_all_t *all = stream->all;
+  tcp_frag *frag;
+
+  frag = (tcp_frag *)g_malloc( sizeof( tcp_frag ) );
+  frag->seq = sequence;
+  frag->len = length;
+  frag->data_len = data_length;
+  frag->data = NULL;
+  frag->spill_offset = -1;
+
+  /* When following all streams, out of order data beyond the memory
+     limit goes to a temporary file instead. */
+  if ( all && all->frag_bytes + data_length > all->mem_limit ) {
+    if ( all->spill == NULL ) {
+      all->spill = tmpfile();
+    }
+    if ( all->spill != NULL &&
+         ws_fseek64( all->spill, all->spill_size, SEEK_SET ) == 0 &&
+         fwrite( data, 1, data_length, all->spill ) == data_length ) {
+      frag->spill_offset = all->spill_size;
+      all->spill_size += data_length;
+      return frag;
+    }
+  }
 
-  src_index = -1;
+  frag->data = (gchar *)g_malloc( data_length );
+  memcpy( frag->data, data, data_length );
+  if ( all ) {
+    all->frag_bytes += data_length;
+  }
+  return frag;
+}
 
-  /* First, check if this packet should be processed. */
-  if (find_tcp_index) {
-    if ((port[0] == srcport && port[1] == dstport &&
-         ADDRESSES_EQUAL(&tcp_addr[0], net_src) &&
-         ADDRESSES_EQUAL(&tcp_addr[1], net_dst))
-        ||
-        (port[1] == srcport && port[0] == dstport &&
-         ADDRESSES_EQUAL(&tcp_addr[1], net_src) &&
-         ADDRESSES_EQUAL(&tcp_addr[0], net_dst))) {
-      find_tcp_index = FALSE;
-      tcp_stream_to_follow = tcp_stream;
+/* get a fragment's data, reading it back from the spill file if need be */
+static const gchar *
+fragment_data( follow_stream_t *stream, tcp_frag *frag )
+{
+  follow_all_t *all = stream->all;
+
+  if ( frag->data != NULL || frag->spill_offset < 0 ) {
+    return frag->data;
+  }
+
+  if ( all->spill_buf_len < frag->data_len ) {
+    all->spill_buf = (gchar *)g_realloc( all->spill_buf, frag->data_len );
+    all->spill_buf_len = frag->data_len;
+  }
+  if ( ws_fseek64( all->spill, frag->spill_offset, SEEK_SET ) != 0 ||
+       fread( all->spill_buf, 1, frag->data_len, all->spill ) != frag->data_len ) {
+    if ( all->err == 0 ) {
+      all->err = errno ? errno : EIO;
     }
-    else {
-      return;
+    return NULL;
+  }
+  return all->spill_buf;
+}
+
+static void
+free_fragment( follow_stream_t *stream, tcp_frag *frag )
+{
+  if ( stream->all && frag->data != NULL ) {
+    stream->all->frag_bytes -= frag->data_len;
+  }
+  g_free( frag->data );
+  g_free( frag );
+}
+
+static void
+free_fragments( follow_stream_t *stream )
+{
+  tcp_frag *current, *next;
+  int i;
+
+  for( i=0; i<2; i++ ) {
+    current = stream->frags[i];
+    while( current ) {
+      next = current->next;
+      free_fragment( stream, current );
+      current = next;
     }
+    stream->frags[i] = NULL;
   }
-  else if ( tcp_stream != tcp_stream_to_follow )
-    return;
+}
 
-  if ((net_src->type != AT_IPv4 && net_src->type != AT_IPv6) ||
-      (net_dst->type != AT_IPv4 && net_dst->type != AT_IPv6))
-    return;
+static void
+write_stream_data( follow_stream_t *stream, int idx, tcp_stream_chunk *sc, const char *data )
+{
+  if ( stream->all ) {
+    follow_all_write( stream, idx, data, sc->dlen );
+  } else {
+    write_packet_data( stream, idx, sc, data );
+  }
+}
+
+/* add one segment to the reassembly of a stream */
+static void
+follow_tcp_segment( follow_stream_t *stream, gulong sequence, gulong acknowledgement,
+                    gulong length, const char* data, gulong data_length,
+                    int synflag, const address *net_src, const address *net_dst,
+                    guint srcport, guint dstport) {
+  guint8 srcx[MAX_IPADDR_LEN], dstx[MAX_IPADDR_LEN];
+  int src_index, j, first = 0, len;
+  gulong newseq;
+  tcp_stream_chunk sc;
+
+  src_index = -1;
 
   if (net_src->type == AT_IPv4)
     len = 4;
@@ -250,20 +372,11 @@ reassemble_tcp( guint32 tcp_stream, gulong sequence, gulong acknowledgement,
   memcpy(srcx, net_src->data, len);
   memcpy(dstx, net_dst->data, len);
 
-  /* follow_tcp_index() needs to learn address/port pairs */
-  if (find_tcp_addr) {
-    find_tcp_addr = FALSE;
-    memcpy(ip_address[0], net_src->data, net_src->len);
-    port[0] = srcport;
-    memcpy(ip_address[1], net_dst->data, net_dst->len);
-    port[1] = dstport;
-  }
-
   /* Check to see if we have seen this source IP and port before.
      (Yes, we have to check both source IP and port; the connection
      might be between two different ports on the same machine.) */
   for( j=0; j<2; j++ ) {
-    if (memcmp(src_addr[j], srcx, len) == 0 && src_port[j] == srcport ) {
+    if (memcmp(stream->src_addr[j], srcx, len) == 0 && stream->src_port[j] == srcport ) {
       src_index = j;
     }
   }
@@ -271,9 +384,9 @@ reassemble_tcp( guint32 tcp_stream, gulong sequence, gulong acknowledgement,
   if( src_index < 0 ) {
     /* assign it to a src_index and get going */
     for( j=0; j<2; j++ ) {
-      if( src_port[j] == 0 ) {
-	memcpy(src_addr[j], srcx, len);
-	src_port[j] = srcport;
+      if( stream->src_port[j] == 0 ) {
+	memcpy(stream->src_addr[j], srcx, len);
+	stream->src_port[j] = srcport;
 	src_index = j;
 	first = 1;
 	break;
@@ -286,7 +399,7 @@ reassemble_tcp( guint32 tcp_stream, gulong sequence, gulong acknowledgement,
   }
 
   if( data_length < length ) {
-    incomplete_tcp_stream = TRUE;
+    stream->incomplete = TRUE;
   }
 
   /* Before adding data for this flow to the data_out_file, check whether
@@ -294,11 +407,11 @@ reassemble_tcp( guint32 tcp_stream, gulong sequence, gulong acknowledgement,
    * frames are not in the capture file, but were actually seen by the 
    * receiving host (Fixes bug 592).
    */
-  if( frags[1-src_index] ) {
+  if( stream->frags[1-src_index] ) {
     memcpy(sc.src_addr, dstx, len);
     sc.src_port = dstport;
     sc.dlen     = 0;        /* Will be filled in in check_fragments */
-    while ( check_fragments( 1-src_index, &sc, acknowledgement ) )
+    while ( check_fragments( stream, 1-src_index, &sc, acknowledgement ) )
       ;
   }
 
@@ -311,84 +424,124 @@ reassemble_tcp( guint32 tcp_stream, gulong sequence, gulong acknowledgement,
      figured out */
   if( first ) {
     /* this is the first time we have seen this src's sequence number */
-    seq[src_index] = sequence + length;
+    stream->seq[src_index] = sequence + length;
     if( synflag ) {
-      seq[src_index]++;
+      stream->seq[src_index]++;
     }
     /* write out the packet data */
-    write_packet_data( src_index, &sc, data );
+    write_stream_data( stream, src_index, &sc, data );
     return;
   }
   /* if we are here, we have already seen this src, let's
      try and figure out if this packet is in the right place */
-  if( sequence < seq[src_index] ) {
+  if( sequence < stream->seq[src_index] ) {
     /* this sequence number seems dated, but
        check the end to make sure it has no more
        info than we have already seen */
     newseq = sequence + length;
-    if( newseq > seq[src_index] ) {
+    if( newseq > stream->seq[src_index] ) {
       gulong new_len;
 
       /* this one has more than we have seen. let's get the
 	 payload that we have not seen. */
 
-      new_len = seq[src_index] - sequence;
+      new_len = stream->seq[src_index] - sequence;
 
       if ( data_length <= new_len ) {
 	data = NULL;
 	data_length = 0;
-	incomplete_tcp_stream = TRUE;
+	stream->incomplete = TRUE;
       } else {
 	data += new_len;
 	data_length -= new_len;
       }
       sc.dlen = data_length;
-      sequence = seq[src_index];
-      length = newseq - seq[src_index];
+      sequence = stream->seq[src_index];
+      length = newseq - stream->seq[src_index];
 
       /* this will now appear to be right on time :) */
     }
   }
-  if ( sequence == seq[src_index] ) {
+  if ( sequence == stream->seq[src_index] ) {
     /* right on time */
-    seq[src_index] += length;
-    if( synflag ) seq[src_index]++;
+    stream->seq[src_index] += length;
+    if( synflag ) stream->seq[src_index]++;
     if( data ) {
-      write_packet_data( src_index, &sc, data );
+      write_stream_data( stream, src_index, &sc, data );
     }
     /* done with the packet, see if it caused a fragment to fit */
-    while( check_fragments( src_index, &sc, 0 ) )
+    while( check_fragments( stream, src_index, &sc, 0 ) )
       ;
   }
   else {
     /* out of order packet */
-    if(data_length > 0 && ((glong)(sequence - seq[src_index]) > 0) ) {
-      tmp_frag = (tcp_frag *)g_malloc( sizeof( tcp_frag ) );
-      tmp_frag->data = (gchar *)g_malloc( data_length );
-      tmp_frag->seq = sequence;
-      tmp_frag->len = length;
-      tmp_frag->data_len = data_length;
-      memcpy( tmp_frag->data, data, data_length );
-      if( frags[src_index] ) {
-	tmp_frag->next = frags[src_index];
-      } else {
-	tmp_frag->next = NULL;
-      }
-      frags[src_index] = tmp_frag;
+    if(data_length > 0 && ((glong)(sequence - stream->seq[src_index]) > 0) ) {
+      tcp_frag *tmp_frag;
+
+      tmp_frag = new_fragment( stream, sequence, length, data, data_length );
+      tmp_frag->next = stream->frags[src_index];
+      stream->frags[src_index] = tmp_frag;
+    }
+  }
+}
+
+void
+reassemble_tcp( guint32 tcp_stream, gulong sequence, gulong acknowledgement,
+                gulong length, const char* data, gulong data_length, 
+                int synflag, address *net_src, address *net_dst, 
+                guint srcport, guint dstport) {
+
+  /* First, check if this packet should be processed. */
+  if (find_tcp_index) {
+    if ((port[0] == srcport && port[1] == dstport &&
+         ADDRESSES_EQUAL(&tcp_addr[0], net_src) &&
+         ADDRESSES_EQUAL(&tcp_addr[1], net_dst))
+        ||
+        (port[1] == srcport && port[0] == dstport &&
+         ADDRESSES_EQUAL(&tcp_addr[1], net_src) &&
+         ADDRESSES_EQUAL(&tcp_addr[0], net_dst))) {
+      find_tcp_index = FALSE;
+      tcp_stream_to_follow = tcp_stream;
+    }
+    else {
+      return;
     }
   }
+  else if ( tcp_stream != tcp_stream_to_follow )
+    return;
+
+  if ((net_src->type != AT_IPv4 && net_src->type != AT_IPv6) ||
+      (net_dst->type != AT_IPv4 && net_dst->type != AT_IPv6))
+    return;
+
+  /* follow_tcp_index() needs to learn address/port pairs */
+  if (find_tcp_addr) {
+    find_tcp_addr = FALSE;
+    memcpy(ip_address[0], net_src->data, net_src->len);
+    port[0] = srcport;
+    memcpy(ip_address[1], net_dst->data, net_dst->len);
+    port[1] = dstport;
+  }
+
+  follow_tcp_segment( &follow_stream, sequence, acknowledgement, length,
+                      data, data_length, synflag, net_src, net_dst,
+                      srcport, dstport );
+  if ( follow_stream.incomplete ) {
+    incomplete_tcp_stream = TRUE;
+  }
 } /* end reassemble_tcp */
 
 /* here we search through all the frag we have collected to see if
    one fits */
 static int
-check_fragments( int idx, tcp_stream_chunk *sc, gulong acknowledged ) {
+check_fragments( follow_stream_t *stream, int idx, tcp_stream_chunk *sc, gulong acknowledged ) {
   tcp_frag *prev = NULL;
   tcp_frag *current;
   gulong lowest_seq;
   gchar *dummy_str;
+  const gchar *data;
 
-  current = frags[idx];
+  current = stream->frags[idx];
   if( current ) {
     lowest_seq = current->seq;
     while( current ) {
@@ -396,27 +549,30 @@ check_fragments( int idx, tcp_stream_chunk *sc, gulong acknowledged ) {
         lowest_seq = current->seq;
       }
 
-      if( current->seq < seq[idx] ) {
+      if( current->seq < stream->seq[idx] ) {
         gulong newseq;
         /* this sequence number seems dated, but
            check the end to make sure it has no more
            info than we have already seen */
         newseq = current->seq + current->len;
-        if( newseq > seq[idx] ) {
+        if( newseq > stream->seq[idx] ) {
           gulong new_pos;
 
           /* this one has more than we have seen. let's get the
              payload that we have not seen. This happens when 
              part of this frame has been retransmitted */
 
-          new_pos = seq[idx] - current->seq;
+          new_pos = stream->seq[idx] - current->seq;
 
           if ( current->data_len > new_pos ) {
-            sc->dlen = current->data_len - new_pos;
-            write_packet_data( idx, sc, current->data + new_pos );
+            data = fragment_data( stream, current );
+            if ( data ) {
+              sc->dlen = current->data_len - new_pos;
+              write_stream_data( stream, idx, sc, data + new_pos );
+            }
           }
 
-          seq[idx] += (current->len - new_pos);
+          stream->seq[idx] += (current->len - new_pos);
         } 
 
         /* Remove the fragment from the list as the "new" part of it
@@ -425,27 +581,26 @@ check_fragments( int idx, tcp_stream_chunk *sc, gulong acknowledged ) {
         if( prev ) {
           prev->next = current->next;
         } else {
-          frags[idx] = current->next;
+          stream->frags[idx] = current->next;
         }
-        g_free( current->data );
-        g_free( current );
+        free_fragment( stream, current );
         return 1;
       }
 
-      if( current->seq == seq[idx] ) {
+      if( current->seq == stream->seq[idx] ) {
         /* this fragment fits the stream */
-        if( current->data ) {
+        data = fragment_data( stream, current );
+        if( data ) {
           sc->dlen = current->data_len;
-          write_packet_data( idx, sc, current->data );
+          write_stream_data( stream, idx, sc, data );
         }
-        seq[idx] += current->len;
+        stream->seq[idx] += current->len;
         if( prev ) {
           prev->next = current->next;
         } else {
-          frags[idx] = current->next;
+          stream->frags[idx] = current->next;
         }
-        g_free( current->data );
-        g_free( current );
+        free_fragment( stream, current );
         return 1;
       }
       prev = current;
@@ -454,14 +609,19 @@ check_fragments( int idx, tcp_stream_chunk *sc, gulong acknowledged ) {
     if( (glong)(acknowledged - lowest_seq) > 0 ) {
       /* There are frames missing in the capture file that were seen
        * by the receiving host. Add dummy stream chunk with the data
-       * "[xxx bytes missing in capture file]".
+       * "[xxx bytes missing in capture file]". Raw stream files only
+       * count the missing bytes, so they stay byte-exact.
        */
-      dummy_str = g_strdup_printf("[%d bytes missing in capture file]",
-                        (int)(lowest_seq - seq[idx]) );
-      sc->dlen = (guint32) strlen(dummy_str);
-      write_packet_data( idx, sc, dummy_str );
-      g_free(dummy_str);
-      seq[idx] = lowest_seq;
+      if ( stream->all ) {
+        stream->bytes_missing[idx] += lowest_seq - stream->seq[idx];
+      } else {
+        dummy_str = g_strdup_printf("[%d bytes missing in capture file]",
+                          (int)(lowest_seq - stream->seq[idx]) );
+        sc->dlen = (guint32) strlen(dummy_str);
+        write_packet_data( stream, idx, sc, dummy_str );
+        g_free(dummy_str);
+      }
+      stream->seq[idx] = lowest_seq;
       return 1;
     }
   } 
@@ -472,33 +632,23 @@ check_fragments( int idx, tcp_stream_chunk *sc, gulong acknowledged ) {
 void
 reset_tcp_reassembly(void)
 {
-  tcp_frag *current, *next;
   int i;
 
   empty_tcp_stream = TRUE;
   incomplete_tcp_stream = FALSE;
   find_tcp_addr = FALSE;
   find_tcp_index = FALSE;
+  free_fragments( &follow_stream );
+  memset( &follow_stream, 0, sizeof follow_stream );
   for( i=0; i<2; i++ ) {
-    seq[i] = 0;
-    memset(src_addr[i], '\0', MAX_IPADDR_LEN);
-    src_port[i] = 0;
     memset(ip_address[i], '\0', MAX_IPADDR_LEN);
     port[i] = 0;
     bytes_written[i] = 0;
-    current = frags[i];
-    while( current ) {
-      next = current->next;
-      g_free( current->data );
-      g_free( current );
-      current = next;
-    }
-    frags[i] = NULL;
   }
 }
 
 static void
-write_packet_data( int idx, tcp_stream_chunk *sc, const char *data )
+write_packet_data( follow_stream_t *stream _U_, int idx, tcp_stream_chunk *sc, const char *data )
 {
   size_t ret;
 
@@ -511,3 +661,306 @@ write_packet_data( int idx, tcp_stream_chunk *sc, const char *data )
   bytes_written[idx] += sc->dlen;
   empty_tcp_stream = FALSE;
 }
+
+/*
+ * Following every stream at once. Each direction of each stream is
+ * written, without any framing, to its own file in a directory, and an
+ * index of the files is written when the capture has been read.
+ */
+
+follow_all_t *
+follow_all_new(const char *dir, gsize mem_limit)
+{
+  follow_all_t *all;
+
+  all = g_new0(follow_all_t, 1);
+  all->dir = g_strdup(dir);
+  all->tcp_streams = g_hash_table_new(g_direct_hash, g_direct_equal);
+  all->udp_streams = g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_queue_init(&all->open_files);
+  all->mem_limit = mem_limit;
+
+  return all;
+}
+
+void
+follow_all_start(follow_all_t *all)
+{
+  follow_all_active = all;
+}
+
+gboolean
+follow_all_tcp_active(void)
+{
+  return follow_all_active != NULL;
+}
+
+static void
+follow_all_close_files(follow_stream_t *stream)
+{
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    if (stream->out[i] != NULL) {
+      if (fclose(stream->out[i]) != 0 && stream->all->err == 0)
+        stream->all->err = errno;
+      stream->out[i] = NULL;
+    }
+  }
+  if (stream->open_link.data != NULL) {
+    g_queue_unlink(&stream->all->open_files, &stream->open_link);
+    stream->open_link.data = NULL;
+  }
+}
+
+static gchar *
+follow_all_file_name(follow_stream_t *stream, int idx)
+{
+  return g_strdup_printf("%s-%u-%d.bin", stream->proto, stream->index, idx);
+}
+
+static void
+follow_all_write(follow_stream_t *stream, int idx, const char *data, guint32 len)
+{
+  follow_all_t *all = stream->all;
+  gchar *name, *path;
+
+  if (len == 0 || all->err != 0)
+    return;
+
+  if (stream->out[idx] == NULL) {
+    /* make room among the open files */
+    if (stream->open_link.data == NULL &&
+        all->open_files.length >= FOLLOW_ALL_MAX_OPEN_STREAMS)
+      follow_all_close_files((follow_stream_t *)all->open_files.head->data);
+
+    name = follow_all_file_name(stream, idx);
+    path = g_build_filename(all->dir, name, NULL);
+    stream->out[idx] = ws_fopen(path, stream->created[idx] ? "ab" : "wb");
+    g_free(path);
+    g_free(name);
+    if (stream->out[idx] == NULL) {
+      all->err = errno;
+      return;
+    }
+    stream->created[idx] = TRUE;
+  }
+
+  /* most recently written streams go to the tail */
+  if (stream->open_link.data != NULL)
+    g_queue_unlink(&all->open_files, &stream->open_link);
+  stream->open_link.data = stream;
+  g_queue_push_tail_link(&all->open_files, &stream->open_link);
+
+  if (fwrite(data, 1, len, stream->out[idx]) != len) {
+    all->err = errno;
+    return;
+  }
+  stream->bytes_written[idx] += len;
+}
+
+static follow_stream_t *
+follow_all_get_stream(follow_all_t *all, GHashTable *streams, const char *proto,
+                      guint32 index, const address *net_src)
+{
+  follow_stream_t *stream;
+
+  stream = (follow_stream_t *)g_hash_table_lookup(streams, GUINT_TO_POINTER(index));
+  if (stream == NULL) {
+    stream = g_new0(follow_stream_t, 1);
+    stream->all = all;
+    stream->proto = proto;
+    stream->index = index;
+    stream->addr_type = net_src->type;
+    stream->addr_len = net_src->len;
+    g_hash_table_insert(streams, GUINT_TO_POINTER(index), stream);
+  }
+  return stream;
+}
+
+void
+follow_all_tcp_segment(guint32 tcp_stream, gulong sequence, gulong acknowledgement,
+                       gulong length, const char *data, gulong data_length,
+                       int synflag, const address *net_src, const address *net_dst,
+                       guint srcport, guint dstport)
+{
+  follow_all_t *all = follow_all_active;
+  follow_stream_t *stream;
+
+  if (all == NULL)
+    return;
+
+  if ((net_src->type != AT_IPv4 && net_src->type != AT_IPv6) ||
+      net_dst->type != net_src->type)
+    return;
+
+  stream = follow_all_get_stream(all, all->tcp_streams, "tcp", tcp_stream, net_src);
+  follow_tcp_segment(stream, sequence, acknowledgement, length, data,
+                     data_length, synflag, net_src, net_dst, srcport, dstport);
+}
+
+void
+follow_all_udp_packet(follow_all_t *all, guint32 conv_index,
+                      const address *net_src, const address *net_dst _U_,
+                      guint srcport, const char *data, guint32 data_length)
+{
+  follow_stream_t *stream;
+  int idx;
+
+  if ((net_src->type != AT_IPv4 && net_src->type != AT_IPv6) ||
+      net_dst->type != net_src->type)
+    return;
+
+  stream = follow_all_get_stream(all, all->udp_streams, "udp", conv_index, net_src);
+
+  for (idx = 0; idx < 2; idx++) {
+    if (stream->src_port[idx] == srcport &&
+        memcmp(stream->src_addr[idx], net_src->data, net_src->len) == 0)
+      break;
+  }
+  if (idx == 2) {
+    for (idx = 0; idx < 2 && stream->src_port[idx] != 0; idx++)
+      ;
+    if (idx == 2) {
+      /* Only the first two endpoints seen get a file; count the
+         rest so the index can say the stream isn't complete */
+      stream->dropped++;
+      stream->bytes_dropped += data_length;
+      stream->incomplete = TRUE;
+      return;
+    }
+    memcpy(stream->src_addr[idx], net_src->data, net_src->len);
+    stream->src_port[idx] = srcport;
+  }
+
+  follow_all_write(stream, idx, data, data_length);
+}
+
+static gint
+follow_all_stream_cmp(gconstpointer a, gconstpointer b)
+{
+  const follow_stream_t *stream_a = (const follow_stream_t *)a;
+  const follow_stream_t *stream_b = (const follow_stream_t *)b;
+
+  if (stream_a->index != stream_b->index)
+    return stream_a->index < stream_b->index ? -1 : 1;
+  return 0;
+}
+
+static void
+follow_all_endpoint_str(const follow_stream_t *stream, int idx, gchar *buf, int buf_len)
+{
+  address addr;
+  gchar addr_str[MAX_IP6_STR_LEN];
+
+  SET_ADDRESS(&addr, stream->addr_type, stream->addr_len, stream->src_addr[idx]);
+  address_to_str_buf(&addr, addr_str, sizeof addr_str);
+  if (stream->addr_type == AT_IPv6)
+    g_snprintf(buf, buf_len, "[%s]:%u", addr_str, stream->src_port[idx]);
+  else
+    g_snprintf(buf, buf_len, "%s:%u", addr_str, stream->src_port[idx]);
+}
+
+/* Write one index line for each direction that carried data */
+static void
+follow_all_write_index(follow_all_t *all, FILE *index_file, GHashTable *streams,
+                       guint *num_streams)
+{
+  GList *list, *entry;
+  follow_stream_t *stream;
+  gchar src[MAX_IP6_STR_LEN + 8], dst[MAX_IP6_STR_LEN + 8];
+  gchar *name;
+  int idx;
+
+  list = g_list_sort(g_hash_table_get_values(streams), follow_all_stream_cmp);
+  for (entry = list; entry != NULL; entry = g_list_next(entry)) {
+    stream = (follow_stream_t *)entry->data;
+    follow_all_close_files(stream);
+    if (stream->frags[0] != NULL || stream->frags[1] != NULL)
+      stream->incomplete = TRUE;
+    free_fragments(stream);
+
+    if (stream->bytes_written[0] == 0 && stream->bytes_written[1] == 0)
+      continue;
+    (*num_streams)++;
+
+    for (idx = 0; idx < 2; idx++) {
+      if (stream->bytes_written[idx] == 0)
+        continue;
+      follow_all_endpoint_str(stream, idx, src, sizeof src);
+      follow_all_endpoint_str(stream, 1 - idx, dst, sizeof dst);
+      name = follow_all_file_name(stream, idx);
+      if (fprintf(index_file, "%s\t%u\t%d\t%s\t%s\t%" G_GINT64_MODIFIER "u\t%" G_GINT64_MODIFIER "u\t%s\t%s\n",
+                  stream->proto, stream->index, idx, src, dst,
+                  stream->bytes_written[idx], stream->bytes_missing[idx],
+                  stream->incomplete ? "incomplete" : "complete", name) < 0 &&
+          all->err == 0)
+        all->err = errno;
+      g_free(name);
+    }
+    if (stream->dropped != 0 &&
+        fprintf(index_file, "# %s\t%u\t%u datagrams (%" G_GINT64_MODIFIER "u bytes) from other endpoints not written\n",
+                stream->proto, stream->index, stream->dropped,
+                stream->bytes_dropped) < 0 &&
+        all->err == 0)
+      all->err = errno;
+  }
+  g_list_free(list);
+}
+
+int
+follow_all_finish(follow_all_t *all, guint *num_tcp, guint *num_udp)
+{
+  FILE *index_file;
+  gchar *path;
+
+  if (follow_all_active == all)
+    follow_all_active = NULL;
+
+  *num_tcp = *num_udp = 0;
+
+  path = g_build_filename(all->dir, "index.txt", NULL);
+  index_file = ws_fopen(path, "w");
+  g_free(path);
+  if (index_file == NULL) {
+    if (all->err == 0)
+      all->err = errno;
+    return all->err;
+  }
+
+  fprintf(index_file, "# proto\tstream\tnode\tsource\tdestination\tbytes\tmissing\tstatus\tfile\n");
+  follow_all_write_index(all, index_file, all->tcp_streams, num_tcp);
+  follow_all_write_index(all, index_file, all->udp_streams, num_udp);
+  if (fclose(index_file) != 0 && all->err == 0)
+    all->err = errno;
+
+  return all->err;
+}
+
+static gboolean
+follow_all_free_stream(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+  follow_stream_t *stream = (follow_stream_t *)value;
+
+  follow_all_close_files(stream);
+  free_fragments(stream);
+  g_free(stream);
+  return TRUE;
+}
+
+void
+follow_all_free(follow_all_t *all)
+{
+  if (follow_all_active == all)
+    follow_all_active = NULL;
+
+  g_hash_table_foreach_remove(all->tcp_streams, follow_all_free_stream, NULL);
+  g_hash_table_destroy(all->tcp_streams);
+  g_hash_table_foreach_remove(all->udp_streams, follow_all_free_stream, NULL);
+  g_hash_table_destroy(all->udp_streams);
+  if (all->spill != NULL)
+    fclose(all->spill);
+  g_free(all->spill_buf);
+  g_free(all->dir);
+  g_free(all);
+}
@@ -57,4 +57,23 @@ typedef struct {
 
 void follow_stats(follow_stats_t* stats);
 
+/* Following every TCP and UDP stream in one pass; each direction of each
+   stream is written to its own file in a directory, and an index of the
+   files ("index.txt") is written by follow_all_finish(). */
+typedef struct _follow_all follow_all_t;
+
+/* Out of order TCP data beyond mem_limit bytes is kept in a temporary file */
+follow_all_t *follow_all_new( const char *dir, gsize mem_limit );
+/* Make packet-tcp.c hand all TCP segments to this follow_all_t */
+void follow_all_start( follow_all_t *all );
+gboolean follow_all_tcp_active( void );
+void follow_all_tcp_segment( guint32, gulong, gulong, gulong, const char*, gulong,
+                             int, const address *, const address *, guint, guint );
+void follow_all_udp_packet( follow_all_t *all, guint32 conv_index,
+                            const address *net_src, const address *net_dst,
+                            guint srcport, const char *data, guint32 data_length );
+/* Returns 0 or the errno of the first error seen while writing */
+int follow_all_finish( follow_all_t *all, guint *num_tcp, guint *num_udp );
+void follow_all_free( follow_all_t *all );
+
 #endif
@@ -30,16 +30,22 @@
 
 #include <ctype.h>
 
+/* The value is an interned string, which isn't ours to free. */
+#define string_is_interned	fvalue_gboolean1
+
 static void
 string_fvalue_new(fvalue_t *fv)
 {
 	fv->value.string = NULL;
+	fv->string_is_interned = FALSE;
 }
 
 static void
 string_fvalue_free(fvalue_t *fv)
 {
-	g_free(fv->value.string);
+	if (!fv->string_is_interned)
+		g_free(fv->value.string);
+	fv->string_is_interned = FALSE;
 }
 
 static void
@@ -51,7 +57,12 @@ string_fvalue_set(fvalue_t *fv, gpointer value, gboolean already_copied)
 	/* Free up the old value, if we have one */
 	string_fvalue_free(fv);
 
-	fv->value.string = (gchar *)g_strdup(value);
+	/* Interned strings live forever; no need to make another copy. */
+	if (emem_is_interned(value)) {
+		fv->value.string = (gchar *)value;
+		fv->string_is_interned = TRUE;
+	} else
+		fv->value.string = (gchar *)g_strdup(value);
 }
 
 static int
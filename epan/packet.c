@@ -56,6 +56,8 @@
 #include <epan/reassemble.h>
 #include <epan/stream.h>
 #include <epan/expert.h>
+#include <epan/conversation.h>
+#include <epan/prefs.h>
 
 static gint proto_malformed = -1;
 static dissector_handle_t frame_handle = NULL;
@@ -70,6 +72,9 @@ struct data_source {
   char *name;
 };
 
+static void heur_memo_reset(void);
+static void heur_replay_reset(void);
+
 void
 packet_init(void)
 {
@@ -150,6 +155,9 @@ init_dissection(void)
 	/* Initialize the table of conversations. */
 	epan_conversation_init();
 
+	/* Forget which heuristic dissectors claimed which conversations. */
+	heur_memo_reset();
+
 	/* Initialize the table of circuits. */
 	epan_circuit_init();
 
@@ -170,6 +178,7 @@ cleanup_dissection(void)
 	 * memory (at least until conversation's use of g_slist is changed).
 	 */
 	epan_conversation_cleanup();
+	heur_memo_reset();
 
 	/* Reclaim all memory of seasonal scope */
 	se_free_all();
@@ -326,6 +335,7 @@ dissect_packet(epan_dissect_t *edt, struct wtap_pkthdr *phdr,
 	edt->pi.cinfo = cinfo;
 	edt->pi.fd = fd;
 	edt->pi.phdr = phdr;
+	heur_replay_reset();
 	edt->pi.pseudo_header = &phdr->pseudo_header;
 	edt->pi.dl_src.type = AT_NONE;
 	edt->pi.dl_dst.type = AT_NONE;
@@ -443,6 +453,9 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 	if (handle->protocol != NULL) {
 		pinfo->current_proto =
 			proto_get_protocol_short_name(handle->protocol);
+
+		/* Register the protocol's fields if it deferred that. */
+		proto_initialize_protocol_prefix(handle->protocol);
 	}
 
 	if (handle->is_new) {
@@ -1653,7 +1666,8 @@ find_heur_dissector_list(const char *name)
 }
 
 void
-heur_dissector_add(const char *name, heur_dissector_t dissector, const int proto)
+heur_dissector_add_with_prefilter(const char *name, heur_dissector_t dissector, const int proto,
+				  const guint8 *first_bytes, const guint first_bytes_len)
 {
 	heur_dissector_list_t *sub_dissectors = find_heur_dissector_list(name);
 	const char            *proto_name;
@@ -1678,14 +1692,24 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const int proto
 	/* XXX: Should verify that sub-dissector is not already in the list ? */
 
 	hdtbl_entry = g_malloc(sizeof (heur_dtbl_entry_t));
-	hdtbl_entry->dissector = dissector;
-	hdtbl_entry->protocol  = find_protocol_by_id(proto);
-	hdtbl_entry->enabled   = TRUE;
+	hdtbl_entry->dissector     = dissector;
+	hdtbl_entry->protocol      = find_protocol_by_id(proto);
+	hdtbl_entry->enabled       = TRUE;
+	hdtbl_entry->prefilter     = first_bytes_len ? first_bytes : NULL;
+	hdtbl_entry->prefilter_len = first_bytes_len;
+	hdtbl_entry->tries         = 0;
+	hdtbl_entry->hits          = 0;
 
 	/* do the table insertion */
 	*sub_dissectors = g_slist_append(*sub_dissectors, (gpointer)hdtbl_entry);
 }
 
+void
+heur_dissector_add(const char *name, heur_dissector_t dissector, const int proto)
+{
+	heur_dissector_add_with_prefilter(name, dissector, proto, NULL, 0);
+}
+
 
 
 static int
@@ -1740,14 +1764,244 @@ heur_dissector_set_enabled(const char *name, heur_dissector_t dissector, const i
 	}
 }
 
+/*
+ * With the "adaptive_heuristics" preference set, remember per conversation
+ * and heuristic list which dissector recognized the conversation, or how
+ * many packets in a row none of them did.
+ */
+typedef struct {
+	guint32                conv_index;
+	heur_dissector_list_t  list;
+	heur_dtbl_entry_t     *claimed;
+	guint                  misses;
+	guint                  skipped;
+} heur_memo_t;
+
+/* Stop trying the heuristics on a conversation after this many misses... */
+#define HEUR_MEMO_MAX_MISSES	8
+/* ...but try them again on every this many packets after that */
+#define HEUR_MEMO_RETRY_INTERVAL	64
+
+/*
+ * Which heuristic dissector, if any, each call to dissector_try_heuristic()
+ * for a frame chose on the first pass, in the order of the calls.  When
+ * the memo decides, the frame is dissected again from this rather than
+ * by going through the whole list, so that it's dissected the same way.
+ */
+typedef struct heur_frame_claim {
+	heur_dissector_list_t    list;
+	heur_dtbl_entry_t       *claimed;
+	struct heur_frame_claim *next;
+} heur_frame_claim_t;
+
+typedef struct {
+	heur_frame_claim_t *first;
+	heur_frame_claim_t *last;
+} heur_frame_claims_t;
+
+/* The frame protocol's id, under which the claims are kept */
+static int heur_claims_proto = -1;
+
+/* The frame being dissected again, and the claim for the next call */
+static frame_data         *heur_replay_fd = NULL;
+static heur_frame_claim_t *heur_replay_next = NULL;
+
+/* Start replaying claims from the first call again */
+static void
+heur_replay_reset(void)
+{
+	heur_replay_fd = NULL;
+	heur_replay_next = NULL;
+}
+
+static GHashTable *heur_memo_table = NULL;
+
+static guint
+heur_memo_hash(gconstpointer v)
+{
+	const heur_memo_t *memo = (const heur_memo_t *)v;
+
+	return memo->conv_index ^ GPOINTER_TO_UINT(memo->list);
+}
+
+static gboolean
+heur_memo_equal(gconstpointer v, gconstpointer w)
+{
+	const heur_memo_t *memo1 = (const heur_memo_t *)v;
+	const heur_memo_t *memo2 = (const heur_memo_t *)w;
+
+	return memo1->conv_index == memo2->conv_index && memo1->list == memo2->list;
+}
+
+static void
+heur_memo_reset(void)
+{
+	if (heur_memo_table != NULL) {
+		g_hash_table_destroy(heur_memo_table);
+		heur_memo_table = NULL;
+	}
+}
+
+static heur_memo_t *
+heur_memo_get(conversation_t *conversation, heur_dissector_list_t list)
+{
+	heur_memo_t  key;
+	heur_memo_t *memo;
+
+	if (heur_memo_table == NULL)
+		heur_memo_table = g_hash_table_new_full(heur_memo_hash, heur_memo_equal, g_free, NULL);
+
+	key.conv_index = conversation->index;
+	key.list       = list;
+	memo = (heur_memo_t *)g_hash_table_lookup(heur_memo_table, &key);
+	if (memo == NULL) {
+		memo = g_new(heur_memo_t, 1);
+		memo->conv_index = conversation->index;
+		memo->list       = list;
+		memo->claimed    = NULL;
+		memo->misses     = 0;
+		memo->skipped    = 0;
+		g_hash_table_insert(heur_memo_table, memo, memo);
+	}
+	return memo;
+}
+
+static void
+heur_claim_record(packet_info *pinfo, heur_dissector_list_t list,
+		  heur_dtbl_entry_t *claimed)
+{
+	heur_frame_claims_t *claims;
+	heur_frame_claim_t  *claim;
+
+	if (heur_claims_proto == -1)
+		heur_claims_proto = proto_get_id_by_filter_name("frame");
+
+	claims = (heur_frame_claims_t *)p_get_proto_data(pinfo->fd, heur_claims_proto);
+	if (claims == NULL) {
+		claims = se_new0(heur_frame_claims_t);
+		p_add_proto_data(pinfo->fd, heur_claims_proto, claims);
+	}
+	claim = se_new(heur_frame_claim_t);
+	claim->list    = list;
+	claim->claimed = claimed;
+	claim->next    = NULL;
+	if (claims->last != NULL)
+		claims->last->next = claim;
+	else
+		claims->first = claim;
+	claims->last = claim;
+}
+
+/*
+ * Return the claim recorded on the first pass for this call, or NULL if
+ * none was, or if the calls no longer match the ones on the first pass.
+ */
+static heur_frame_claim_t *
+heur_claim_replay(packet_info *pinfo, heur_dissector_list_t list)
+{
+	heur_frame_claims_t *claims;
+	heur_frame_claim_t  *claim;
+
+	/* Nothing was recorded for an empty list */
+	if (list == NULL)
+		return NULL;
+
+	if (heur_replay_fd != pinfo->fd) {
+		heur_replay_fd = pinfo->fd;
+		heur_replay_next = NULL;
+		if (heur_claims_proto != -1) {
+			claims = (heur_frame_claims_t *)p_get_proto_data(pinfo->fd, heur_claims_proto);
+			if (claims != NULL)
+				heur_replay_next = claims->first;
+		}
+	}
+
+	claim = heur_replay_next;
+	if (claim == NULL)
+		return NULL;
+	if (claim->list != list) {
+		heur_replay_next = NULL;
+		return NULL;
+	}
+	heur_replay_next = claim->next;
+	return claim;
+}
+
+/* Call one heuristic dissector, returns TRUE if it accepted the data */
+static gboolean
+call_heur_dissector_entry(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			  packet_info *pinfo, proto_tree *tree, void *data,
+			  guint16 saved_can_desegment, gint saved_layer_names_len)
+{
+	/* XXX - why set this now and above? */
+	pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
+
+	if (hdtbl_entry->protocol != NULL &&
+	    (!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
+		/*
+		 * No - don't try this dissector.
+		 */
+		return FALSE;
+	}
+
+	if (hdtbl_entry->prefilter != NULL &&
+	    tvb_memeql(tvb, 0, hdtbl_entry->prefilter, hdtbl_entry->prefilter_len) != 0) {
+		/*
+		 * The data doesn't start the way it would have to.
+		 */
+		return FALSE;
+	}
+
+	if (hdtbl_entry->protocol != NULL) {
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+		proto_initialize_protocol_prefix(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		if (pinfo->layer_names) {
+			if (pinfo->layer_names->len > 0)
+				g_string_append(pinfo->layer_names, ":");
+				g_string_append(pinfo->layer_names,
+				proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol)));
+		}
+	}
+	EP_CHECK_CANARY(("before calling heuristic dissector for protocol: %s",
+			 proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol))));
+	hdtbl_entry->tries++;
+	if ((*hdtbl_entry->dissector)(tvb, pinfo, tree, data)) {
+		EP_CHECK_CANARY(("after heuristic dissector for protocol: %s has accepted and dissected packet",
+				 proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol))));
+		hdtbl_entry->hits++;
+		return TRUE;
+	}
+
+	EP_CHECK_CANARY(("after heuristic dissector for protocol: %s has returned false",
+			 proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol))));
+
+	/*
+	 * That dissector didn't accept the packet, so
+	 * remove its protocol's name from the list
+	 * of protocols.
+	 */
+	if (pinfo->layer_names != NULL) {
+		g_string_truncate(pinfo->layer_names, saved_layer_names_len);
+	}
+	return FALSE;
+}
+
 gboolean
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			packet_info *pinfo, proto_tree *tree, void *data)
 {
-	gboolean           status;
-	const char        *saved_proto;
-	GSList            *entry;
-	heur_dtbl_entry_t *hdtbl_entry;
+	gboolean            status;
+	const char         *saved_proto;
+	GSList             *entry;
+	heur_dtbl_entry_t  *hdtbl_entry, *tried;
+	heur_memo_t        *memo;
+	heur_frame_claim_t *claim;
 	guint16            saved_can_desegment;
 	gint               saved_layer_names_len = 0;
 
@@ -1770,55 +2024,74 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	if (pinfo->layer_names != NULL)
 		saved_layer_names_len = (gint) pinfo->layer_names->len;
 
-	for (entry = sub_dissectors; entry != NULL; entry = g_slist_next(entry)) {
-		/* XXX - why set this now and above? */
-		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
-		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+	memo = NULL;
+	claim = NULL;
+	tried = NULL;
+	hdtbl_entry = NULL;
+	if (pinfo->fd->flags.visited) {
+		/*
+		 * Packets that have already been seen (e.g. one being
+		 * selected in the GUI) are dissected as they were on the
+		 * first pass if the memo decided how.
+		 */
+		claim = heur_claim_replay(pinfo, sub_dissectors);
+	} else if (prefs.adaptive_heuristics && sub_dissectors != NULL) {
+		memo = heur_memo_get(find_or_create_conversation(pinfo), sub_dissectors);
+	}
 
-		if (hdtbl_entry->protocol != NULL &&
-		    (!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==FALSE))) {
-			/*
-			 * No - don't try this dissector.
-			 */
-			continue;
-		}
+	if (claim != NULL && claim->claimed == NULL) {
+		/* None of them recognized it the first time */
+		pinfo->can_desegment = saved_can_desegment;
+		return FALSE;
+	}
 
-		if (hdtbl_entry->protocol != NULL) {
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
+	if (memo != NULL && memo->misses >= HEUR_MEMO_MAX_MISSES &&
+	    ++memo->skipped < HEUR_MEMO_RETRY_INTERVAL) {
+		/*
+		 * None of the heuristic dissectors has recognized this
+		 * conversation lately; don't bother asking them again
+		 * for a while.
+		 */
+		heur_claim_record(pinfo, sub_dissectors, NULL);
+		pinfo->can_desegment = saved_can_desegment;
+		return FALSE;
+	}
 
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			if (pinfo->layer_names) {
-				if (pinfo->layer_names->len > 0)
-					g_string_append(pinfo->layer_names, ":");
-					g_string_append(pinfo->layer_names,
-					proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol)));
-			}
-		}
-		EP_CHECK_CANARY(("before calling heuristic dissector for protocol: %s",
-				 proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol))));
-		if ((*hdtbl_entry->dissector)(tvb, pinfo, tree, data)) {
-			EP_CHECK_CANARY(("after heuristic dissector for protocol: %s has accepted and dissected packet",
-					 proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol))));
+	if (claim != NULL)
+		tried = claim->claimed;
+	else if (memo != NULL)
+		tried = memo->claimed;
+	if (tried != NULL) {
+		/*
+		 * Try the dissector that recognized this packet, or this
+		 * conversation, before; if it doesn't want this packet, try
+		 * the others.
+		 */
+		status = call_heur_dissector_entry(tried, tvb, pinfo,
+		    tree, data, saved_can_desegment, saved_layer_names_len);
+		hdtbl_entry = tried;
+	}
+
+	for (entry = sub_dissectors; !status && entry != NULL; entry = g_slist_next(entry)) {
+		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+
+		if (hdtbl_entry != tried &&
+		    call_heur_dissector_entry(hdtbl_entry, tvb, pinfo, tree,
+		    data, saved_can_desegment, saved_layer_names_len))
 			status = TRUE;
-			break;
-		} else {
-			EP_CHECK_CANARY(("after heuristic dissector for protocol: %s has returned false",
-					 proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol))));
+	}
 
-			/*
-			 * That dissector didn't accept the packet, so
-			 * remove its protocol's name from the list
-			 * of protocols.
-			 */
-			if (pinfo->layer_names != NULL) {
-				g_string_truncate(pinfo->layer_names, saved_layer_names_len);
-			}
+	if (memo != NULL) {
+		if (status) {
+			memo->claimed = hdtbl_entry;
+			memo->misses = 0;
+		} else {
+			memo->misses++;
 		}
+		memo->skipped = 0;
+		heur_claim_record(pinfo, sub_dissectors, status ? hdtbl_entry : NULL);
 	}
+
 	pinfo->current_proto = saved_proto;
 	pinfo->can_desegment=saved_can_desegment;
 	return status;
@@ -240,6 +240,10 @@ typedef struct {
 	heur_dissector_t dissector;
 	protocol_t *protocol;
 	gboolean enabled;
+	const guint8 *prefilter;	/* bytes the data must start with, or NULL */
+	guint prefilter_len;
+	guint32 tries;			/* times the dissector was called */
+	guint32 hits;			/* times it accepted the data */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
@@ -278,6 +282,22 @@ extern gboolean dissector_try_heuristic(heur_dissector_list_t sub_dissectors,
 extern void heur_dissector_add(const char *name, heur_dissector_t dissector,
     const int proto);
 
+/** Add a sub-dissector to a heuristic dissector list, and declare the
+ *  bytes any data it accepts starts with. The sub-dissector is only
+ *  called for data beginning with those bytes, so this must only be used
+ *  by heuristics that reject everything else anyway.
+ *  Call this in the proto_handoff function of the sub-dissector.
+ *
+ * @param name the name of the "parent" protocol, e.g. "tcp"
+ * @param dissector the sub-dissector to be registered
+ * @param proto the protocol id of the sub-dissector
+ * @param first_bytes the leading bytes; must stay valid, e.g. a static array
+ * @param first_bytes_len the number of leading bytes
+ */
+extern void heur_dissector_add_with_prefilter(const char *name,
+    heur_dissector_t dissector, const int proto,
+    const guint8 *first_bytes, const guint first_bytes_len);
+
 /** Remove a sub-dissector from a heuristic dissector list.
  *  Call this in the prefs_reinit function of the sub-dissector.
  *
@@ -1928,6 +1928,21 @@ prefs_register_modules(void)
                                    "Wrap to beginning/end of file during search?",
                                    &prefs.gui_find_wrap);
 
+    prefs_register_bool_preference(gui_module, "find_index_save",
+                                   "Save the packet data search index next to the capture file",
+                                   "Save the index that speeds up searches of the packet data "
+                                   "next to the capture file, as <capture file>.ngidx, so that "
+                                   "it can be used again the next time the file is opened?",
+                                   &prefs.gui_find_index_save);
+
+    prefs_register_uint_preference(gui_module, "find_index_max_size",
+                                   "Maximum size of the packet data search index (MB)",
+                                   "The most memory, in megabytes, that the index that speeds up "
+                                   "searches of the packet data may take; frames that don't fit "
+                                   "in it are always read when searching. 0 turns it off.",
+                                   10,
+                                   &prefs.gui_find_index_max_size);
+
     prefs_register_bool_preference(gui_module, "use_pref_save",
                                    "Settings dialogs use a save button",
                                    "Settings dialogs use a save button?",
@@ -2143,6 +2158,14 @@ prefs_register_modules(void)
                                    "Display all hidden protocol items in the packet list.",
                                    &prefs.display_hidden_proto_items);
 
+    prefs_register_bool_preference(protocols_module, "adaptive_heuristics",
+                                   "Adaptive heuristic dissection",
+                                   "Remember which heuristic dissector recognized each conversation and "
+                                   "try it first, and only try them now and then on conversations none of "
+                                   "them recognizes. This is faster, but a packet may be dissected "
+                                   "differently than in registration order.",
+                                   &prefs.adaptive_heuristics);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
@@ -2612,6 +2635,8 @@ pre_init_prefs(void)
   prefs.gui_fileopen_preview       = 3;
   prefs.gui_ask_unsaved            = TRUE;
   prefs.gui_find_wrap              = TRUE;
+  prefs.gui_find_index_save        = FALSE;
+  prefs.gui_find_index_max_size    = 64;
   prefs.gui_use_pref_save          = FALSE;
   prefs.gui_webbrowser             = HTML_VIEWER " %s";
   prefs.gui_window_title           = "";
@@ -2662,6 +2687,7 @@ pre_init_prefs(void)
   prefs.rtp_player_max_visible = RTP_PLAYER_DEFAULT_VISIBLE;
 
   prefs.display_hidden_proto_items = FALSE;
+  prefs.adaptive_heuristics        = FALSE;
 
   prefs_pre_initialized = TRUE;
 }
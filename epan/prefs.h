@@ -152,6 +152,8 @@ typedef struct _e_prefs {
   guint    gui_fileopen_preview;
   gboolean gui_ask_unsaved;
   gboolean gui_find_wrap;
+  gboolean gui_find_index_save;
+  guint    gui_find_index_max_size;
   gboolean gui_use_pref_save;
   gchar   *gui_webbrowser;
   gchar   *gui_window_title;
@@ -178,6 +180,7 @@ typedef struct _e_prefs {
   guint    rtp_player_max_visible;
   guint    tap_update_interval;
   gboolean display_hidden_proto_items;
+  gboolean adaptive_heuristics;
   gpointer filter_expressions;	/* Actually points to &head */
 } e_prefs;
 
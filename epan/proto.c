@@ -38,7 +38,8 @@
 #include "plugins.h"
 #include "proto.h"
 #include "epan_dissect.h"
-#include "slab.h"
+#include "wmem/wmem.h"
+#include "wmem/wmem_allocator_block.h"
 #include "tvbuff.h"
 #include "emem.h"
 #include "charsets.h"
@@ -172,6 +173,9 @@ static proto_item *
 proto_tree_add_pi(proto_tree *tree, int hfindex, tvbuff_t *tvb,
 		  gint start, gint *length, field_info **pfi);
 
+static guint
+proto_assign_interesting_slot(const gint hfid);
+
 static void
 proto_tree_set_representation_value(proto_item *pi, const char *format, va_list ap);
 static void
@@ -253,6 +257,7 @@ struct _protocol {
 	gboolean    is_enabled;   /* TRUE if protocol is enabled */
 	gboolean    can_toggle;   /* TRUE if is_enabled can be changed */
 	gboolean    is_private;   /* TRUE is protocol is private */
+	gboolean    has_prefix;   /* TRUE if a prefix initializer may still be pending */
 };
 
 /* List of all protocols */
@@ -260,37 +265,60 @@ static GList *protocols = NULL;
 
 #define INITIAL_NUM_PROTOCOL_HFINFO	1500
 
-/* Contains information about a field when a dissector calls
- * proto_tree_add_item.  */
-static struct ws_memory_slab field_info_slab =
-	WS_MEMORY_SLAB_INIT(field_info, 128);
+/* Everything a protocol tree is made of - its proto_nodes, the
+ * field_info of each item and the item labels - is carved from an arena
+ * owned by the tree, so that the whole tree can be freed at once by
+ * resetting the arena instead of walking it.
+ *
+ * The field_infos of primed ("interesting") fields are recorded in the
+ * slots of a dense index: every field primed with proto_tree_prime_hfid()
+ * gets a slot number once, and each tree has an array of slots, so that
+ * finding the array of a field is plain indexing.  The arrays of the
+ * slots are reused from tree to tree; a slot only holds something for the
+ * current tree if it is stamped with the current epoch of the store, and
+ * bumping the epoch empties all of them at once.
+ *
+ * The arena and the slots of a freed tree are kept for the next tree. */
+typedef struct {
+	int        hfid;
+	guint32    epoch;
+	GPtrArray *ptrs;
+} interesting_slot_t;
+
+struct _tree_store_t {
+	wmem_allocator_t   *arena;
+	interesting_slot_t *slots;
+	guint               num_slots;
+	guint32             epoch;
+};
+
+static GSList *idle_tree_stores = NULL;
 
-#define FIELD_INFO_NEW(fi)					\
-	fi = sl_alloc(&field_info_slab)
-#define FIELD_INFO_FREE(fi)					\
-	sl_free(&field_info_slab, fi)
+/* Slot of each primed field, indexed by hfid; 0 if never primed */
+static guint *hfid_slots = NULL;
+static guint  hfid_slots_len = 0;
+/* Number of slots handed out; slot 0 isn't used */
+static guint  num_interesting_slots = 1;
 
-/* Contains the space for proto_nodes. */
-static struct ws_memory_slab proto_node_slab =
-	WS_MEMORY_SLAB_INIT(proto_node, 128);
+/* Field values that hold memory outside the arena, to be cleaned up
+ * when the tree is freed. */
+struct _fvalue_cleanup_t {
+	fvalue_t                 *fv;
+	struct _fvalue_cleanup_t *next;
+};
 
-#define PROTO_NODE_NEW(node)				\
-	node = sl_alloc(&proto_node_slab); \
+#define FIELD_INFO_NEW(tree_data, fi)				\
+	fi = (field_info *)wmem_alloc((tree_data)->arena, sizeof(field_info))
+
+#define PROTO_NODE_NEW(tree_data, node)				\
+	node = (proto_node *)wmem_alloc((tree_data)->arena, sizeof(proto_node)); \
 	node->first_child = NULL;			\
 	node->last_child = NULL;			\
 	node->next = NULL;
 
-#define PROTO_NODE_FREE(node)				\
-	sl_free(&proto_node_slab, node)
-
 /* String space for protocol and field items for the GUI */
-static struct ws_memory_slab item_label_slab =
-	WS_MEMORY_SLAB_INIT(item_label_t, 128);
-
-#define ITEM_LABEL_NEW(il)				\
-	il = sl_alloc(&item_label_slab);
-#define ITEM_LABEL_FREE(il)				\
-	sl_free(&item_label_slab, il);
+#define ITEM_LABEL_NEW(tree_data, il)				\
+	il = (item_label_t *)wmem_alloc((tree_data)->arena, sizeof(item_label_t))
 
 #define PROTO_REGISTRAR_GET_NTH(hfindex, hfinfo) \
 	DISSECTOR_ASSERT((guint)hfindex < gpa_hfinfo.len); \
@@ -453,6 +481,24 @@ proto_cleanup(void)
 		proto_filter_names = NULL;
 	}
 
+	while (idle_tree_stores) {
+		struct _tree_store_t *store = (struct _tree_store_t *)idle_tree_stores->data;
+		guint                 i;
+
+		wmem_destroy_allocator(store->arena);
+		for (i = 0; i < store->num_slots; i++) {
+			if (store->slots[i].ptrs)
+				g_ptr_array_free(store->slots[i].ptrs, TRUE);
+		}
+		g_free(store->slots);
+		g_free(store);
+		idle_tree_stores = g_slist_delete_link(idle_tree_stores, idle_tree_stores);
+	}
+	g_free(hfid_slots);
+	hfid_slots = NULL;
+	hfid_slots_len = 0;
+	num_interesting_slots = 1;
+
 	if (gpa_hfinfo.allocated_len) {
 		gpa_hfinfo.len           = 0;
 		gpa_hfinfo.allocated_len = 0;
@@ -532,10 +578,8 @@ proto_tree_children_foreach(proto_tree *tree, proto_tree_foreach_func func,
 }
 
 static void
-free_GPtrArray_value(gpointer key, gpointer value, gpointer user_data _U_)
+unprime_hfid(int hfid)
 {
-	GPtrArray         *ptrs = value;
-	gint               hfid = (gint)(long)key;
 	header_field_info *hfinfo;
 
 	PROTO_REGISTRAR_GET_NTH(hfid, hfinfo);
@@ -551,62 +595,47 @@ free_GPtrArray_value(gpointer key, gpointer value, gpointer user_data _U_)
 		}
 		hfinfo->ref_type = HF_REF_TYPE_NONE;
 	}
-
-	g_ptr_array_free(ptrs, TRUE);
 }
 
 static void
 free_node_tree_data(tree_data_t *tree_data)
 {
-	if (tree_data->interesting_hfids) {
-		/* Free all the GPtrArray's in the interesting_hfids hash. */
-		g_hash_table_foreach(tree_data->interesting_hfids,
-			free_GPtrArray_value, NULL);
+	struct _tree_store_t     *store = tree_data->store;
+	struct _fvalue_cleanup_t *cleanup;
+	guint                     i;
 
-		/* And then destroy the hash. */
-		g_hash_table_destroy(tree_data->interesting_hfids);
+	if (tree_data->tracking_fields) {
+		/* Unprime the fields found in this tree, and empty all
+		 * the slots by moving on to the next epoch. */
+		for (i = 1; i < store->num_slots; i++) {
+			if (store->slots[i].epoch == store->epoch)
+				unprime_hfid(store->slots[i].hfid);
+		}
+		if (++store->epoch == 0) {
+			for (i = 0; i < store->num_slots; i++)
+				store->slots[i].epoch = 0;
+			store->epoch = 1;
+		}
 	}
-	if (tree_data->fi_tmp)
-		FIELD_INFO_FREE(tree_data->fi_tmp);
 
-	/* And finally the tree_data_t itself. */
-	g_free(tree_data);
-}
-
-#define FREE_NODE_FIELD_INFO(finfo)	\
-	if (finfo->rep) {			\
-		ITEM_LABEL_FREE(finfo->rep);	\
-	}				\
-	FVALUE_CLEANUP(&finfo->value);	\
-	FIELD_INFO_FREE(finfo);
-
-static void
-proto_tree_free_node(proto_node *node, gpointer data _U_)
-{
-	field_info *finfo  = PNODE_FINFO(node);
-
-	proto_tree_children_foreach(node, proto_tree_free_node, NULL);
-
-	/* free the field_info data. */
-	FREE_NODE_FIELD_INFO(finfo);
-
-	/* Free the proto_node. */
-	PROTO_NODE_FREE(node);
+	/* Free what field values hold outside the arena. */
+	for (cleanup = tree_data->fvalue_cleanup; cleanup; cleanup = cleanup->next)
+		FVALUE_CLEANUP(cleanup->fv);
 }
 
 /* frees the resources that the dissection a proto_tree uses */
 void
 proto_tree_free(proto_tree *tree)
 {
-	tree_data_t *tree_data = PTREE_DATA(tree);
-
-	proto_tree_children_foreach(tree, proto_tree_free_node, NULL);
+	tree_data_t          *tree_data = PTREE_DATA(tree);
+	struct _tree_store_t *store     = tree_data->store;
 
-	/* free root node */
-	PROTO_NODE_FREE(tree);
-
-	/* free tree data */
 	free_node_tree_data(tree_data);
+
+	/* Free the nodes, field_infos, labels and the tree data itself
+	 * in one go, and keep the store for the next tree. */
+	wmem_free_all(store->arena);
+	idle_tree_stores = g_slist_prepend(idle_tree_stores, store);
 }
 
 /* Is the parsing being done for a visible proto_tree or an invisible one?
@@ -718,20 +747,58 @@ prefix_equal (gconstpointer ap, gconstpointer bp) {
 /* indexed by prefix, contains initializers */
 static GHashTable* prefixes = NULL;
 
+/* prefixes whose initializers have already been called */
+static GSList* loaded_prefixes = NULL;
+
 
 /* Register a new prefix for "delayed" initialization of field arrays */
 void
 proto_register_prefix(const char *prefix, prefix_initializer_t pi ) {
+	header_field_info *hfinfo;
+
 	if (! prefixes ) {
 		prefixes = g_hash_table_new(prefix_hash, prefix_equal);
 	}
 
 	g_hash_table_insert(prefixes, (gpointer)prefix, pi);
+
+	/*
+	 * If the prefix is the filter name of an already registered
+	 * protocol, mark it so that dispatching a packet to that
+	 * protocol runs the initializer too.
+	 */
+	hfinfo = g_tree_lookup(gpa_name_tree, prefix);
+	if (hfinfo && hfinfo->type == FT_PROTOCOL)
+		((protocol_t *)hfinfo->strings)->has_prefix = TRUE;
+}
+
+/* Call and forget the initializer for the prefix of "match", if any */
+static gboolean
+initialize_prefix_by_name(const char *match) {
+	gpointer key;
+	gpointer pi;
+
+	if (!prefixes)
+		return FALSE;
+
+	if (!g_hash_table_lookup_extended(prefixes, match, &key, &pi))
+		return FALSE;
+
+	/*
+	 * Remove it before calling it, so that an initializer that
+	 * looks up one of its own fields doesn't recurse.
+	 */
+	g_hash_table_remove(prefixes, match);
+	loaded_prefixes = g_slist_prepend(loaded_prefixes, key);
+	((prefix_initializer_t)pi)(match);
+
+	return TRUE;
 }
 
 /* helper to call all prefix initializers */
 static gboolean
 initialize_prefix(gpointer k, gpointer v, gpointer u _U_) {
+	loaded_prefixes = g_slist_prepend(loaded_prefixes, k);
 	((prefix_initializer_t)v)(k);
 	return TRUE;
 }
@@ -739,7 +806,21 @@ initialize_prefix(gpointer k, gpointer v, gpointer u _U_) {
 /** Initialize every remaining uninitialized prefix. */
 void
 proto_initialize_all_prefixes(void) {
-	g_hash_table_foreach_remove(prefixes, initialize_prefix, NULL);
+	if (prefixes)
+		g_hash_table_foreach_remove(prefixes, initialize_prefix, NULL);
+}
+
+/* Called when a packet is handed to a protocol's dissector; if the
+ * protocol registered its fields lazily, register them now.
+ */
+void
+proto_initialize_protocol_prefix(protocol_t *protocol)
+{
+	if (!protocol->has_prefix)
+		return;
+
+	protocol->has_prefix = FALSE;
+	initialize_prefix_by_name(protocol->filter_name);
 }
 
 /* Finds a record in the hf_info_records array by name.
@@ -750,8 +831,7 @@ proto_initialize_all_prefixes(void) {
 header_field_info *
 proto_registrar_get_byname(const char *field_name)
 {
-	header_field_info    *hfinfo;
-	prefix_initializer_t  pi;
+	header_field_info *hfinfo;
 
 	if (!field_name)
 		return NULL;
@@ -761,16 +841,9 @@ proto_registrar_get_byname(const char *field_name)
 	if (hfinfo)
 		return hfinfo;
 
-	if (!prefixes)
+	if (!initialize_prefix_by_name(field_name))
 		return NULL;
 
-	if ((pi = g_hash_table_lookup(prefixes, field_name) ) != NULL) {
-		pi(field_name);
-		g_hash_table_remove(prefixes, field_name);
-	} else {
-		return NULL;
-	}
-
 	return g_tree_lookup(gpa_name_tree, field_name);
 }
 
@@ -1044,16 +1117,8 @@ proto_tree_add_debug_text(proto_tree *tree, const char *format, ...)
 /* We could probably get away with changing is_error to a minimum length value. */
 static void
 report_type_length_mismatch(proto_tree *tree, const gchar *descr, int length, gboolean is_error) {
-	tree_data_t *tree_data = PTREE_DATA(tree);
-	field_info *fi_save = tree_data->fi_tmp;
-
-	/* Keep the current item from getting freed by proto_tree_new_item. */
-	tree_data->fi_tmp = NULL;
-
 	expert_add_info_format(NULL, tree, PI_MALFORMED, is_error ? PI_ERROR : PI_WARN, "Trying to fetch %s with length %d", descr, length);
 
-	tree_data->fi_tmp = fi_save;
-
 	if (is_error) {
 		THROW(ReportedBoundsError);
 	}
@@ -1163,29 +1228,46 @@ static GPtrArray *
 proto_lookup_or_create_interesting_hfids(proto_tree *tree,
 					 header_field_info *hfinfo)
 {
-	GPtrArray *ptrs = NULL;
+	tree_data_t          *tree_data;
+	struct _tree_store_t *store;
+	interesting_slot_t   *slot;
+	guint                 slot_num;
 
 	DISSECTOR_ASSERT(tree);
 	DISSECTOR_ASSERT(hfinfo);
 
-	if (hfinfo->ref_type == HF_REF_TYPE_DIRECT) {
-		if (PTREE_DATA(tree)->interesting_hfids == NULL) {
-			/* Initialize the hash because we now know that it is needed */
-			PTREE_DATA(tree)->interesting_hfids =
-				g_hash_table_new(g_direct_hash, NULL /* g_direct_equal */);
-		}
+	if (hfinfo->ref_type != HF_REF_TYPE_DIRECT)
+		return NULL;
 
-		ptrs = g_hash_table_lookup(PTREE_DATA(tree)->interesting_hfids,
-					   GINT_TO_POINTER(hfinfo->id));
-		if (!ptrs) {
-			/* First element triggers the creation of pointer array */
-			ptrs = g_ptr_array_new();
-			g_hash_table_insert(PTREE_DATA(tree)->interesting_hfids,
-					    GINT_TO_POINTER(hfinfo->id), ptrs);
-		}
+	/* A field can be marked as referenced without having been primed,
+	 * e.g. by a tap that sets it as a parent; give it a slot now. */
+	slot_num = ((guint)hfinfo->id < hfid_slots_len) ? hfid_slots[hfinfo->id] : 0;
+	if (slot_num == 0)
+		slot_num = proto_assign_interesting_slot(hfinfo->id);
+
+	tree_data = PTREE_DATA(tree);
+	store = tree_data->store;
+	if (slot_num >= store->num_slots) {
+		/* Fields were primed since this store was last used */
+		store->slots = g_renew(interesting_slot_t, store->slots, num_interesting_slots);
+		memset(store->slots + store->num_slots, 0,
+		       (num_interesting_slots - store->num_slots) * sizeof(interesting_slot_t));
+		store->num_slots = num_interesting_slots;
+	}
+
+	slot = &store->slots[slot_num];
+	if (slot->epoch != store->epoch) {
+		/* First occurrence of the field in this tree */
+		if (slot->ptrs == NULL)
+			slot->ptrs = g_ptr_array_new();
+		else
+			g_ptr_array_set_size(slot->ptrs, 0);
+		slot->hfid = hfinfo->id;
+		slot->epoch = store->epoch;
 	}
+	tree_data->tracking_fields = TRUE;
 
-	return ptrs;
+	return slot->ptrs;
 }
 
 /* Add an item to a proto_tree, using the text label registered to that item;
@@ -1195,7 +1277,6 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 		    tvbuff_t *tvb, gint start, gint length,
 		    guint encoding)
 {
-	tree_data_t *tree_data = PTREE_DATA(tree);
 	proto_item *pi;
 	guint32	    value, n;
 	float	    floatval;
@@ -1206,24 +1287,8 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 	GPtrArray  *ptrs;
 	gboolean    length_error;
 
-	/* there is a possibility here that we might raise an exception
-	 * and thus would lose track of the field_info.
-	 * store it in a temp so that if we come here again we can reclaim
-	 * the field_info without leaking memory.
-	 */
-	if (tree_data->fi_tmp) {
-		/* oops, last one we got must have been lost due
-		 * to an exception.
-		 * good thing we saved it, now we can reverse the
-		 * memory leak and reclaim it.
-		 */
-		FIELD_INFO_FREE(tree_data->fi_tmp);
-	}
-	/* we might throw an exception, keep track of this one
-	 * across the "dangerous" section below.
-	*/
-	tree_data->fi_tmp = new_fi;
-
+	/* If an exception is thrown below, new_fi is lost; it lives in
+	 * the tree's arena, so it is freed along with the tree. */
 	switch (new_fi->hfinfo->type) {
 		case FT_NONE:
 			/* no value to set for FT_NONE */
@@ -1724,11 +1789,6 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 	 *      to know which item caused exception? */
 	pi = proto_tree_add_node(tree, new_fi);
 
-	/* we did not raise an exception so we dont have to remember this
-	 * field_info struct any more.
-	 */
-	tree_data->fi_tmp = NULL;
-
 	/* If the proto_tree wants to keep a record of this finfo
 	 * for quick lookup, then record it. */
 	ptrs = proto_lookup_or_create_interesting_hfids(tree, new_fi->hfinfo);
@@ -3367,7 +3427,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 	DISSECTOR_ASSERT(tfi == NULL ||
 		(tfi->tree_type >= 0 && tfi->tree_type < num_tree_types));
 
-	PROTO_NODE_NEW(pnode);
+	PROTO_NODE_NEW(PTREE_DATA(tree), pnode);
 	pnode->parent = tnode;
 	PNODE_FINFO(pnode) = fi;
 	pnode->tree_data = PTREE_DATA(tree);
@@ -3555,8 +3615,9 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 	       const gint start, const gint item_length)
 {
 	field_info *fi;
+	tree_data_t *tree_data = PTREE_DATA(tree);
 
-	FIELD_INFO_NEW(fi);
+	FIELD_INFO_NEW(tree_data, fi);
 
 	fi->hfinfo     = hfinfo;
 	fi->start      = start;
@@ -3568,6 +3629,14 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 		FI_SET_FLAG(fi, FI_HIDDEN);
 	fvalue_init(&fi->value, fi->hfinfo->type);
 	fi->rep        = NULL;
+	if (fi->value.ftype->free_value) {
+		struct _fvalue_cleanup_t *cleanup;
+
+		cleanup = (struct _fvalue_cleanup_t *)wmem_alloc(tree_data->arena, sizeof(*cleanup));
+		cleanup->fv   = &fi->value;
+		cleanup->next = tree_data->fvalue_cleanup;
+		tree_data->fvalue_cleanup = cleanup;
+	}
 
 	/* add the data source tvbuff */
 	fi->ds_tvb = tvb ? tvb_get_ds_tvb(tvb) : NULL;
@@ -3605,7 +3674,7 @@ proto_tree_set_representation_value(proto_item *pi, const char *format, va_list
 	hf = fi->hfinfo;
 
 	if (!PROTO_ITEM_IS_HIDDEN(pi)) {
-		ITEM_LABEL_NEW(fi->rep);
+		ITEM_LABEL_NEW(PTREE_DATA(pi), fi->rep);
 		if (hf->bitmask && (hf->type == FT_BOOLEAN || IS_FT_UINT(hf->type))) {
 			char tmpbuf[64];
 			guint32 val;
@@ -3661,7 +3730,9 @@ proto_tree_set_representation(proto_item *pi, const char *format, va_list ap)
 	DISSECTOR_ASSERT(fi);
 
 	if (!PROTO_ITEM_IS_HIDDEN(pi)) {
-		ITEM_LABEL_NEW(fi->rep);
+		/* proto_item_set_text() reuses the existing label */
+		if (fi->rep == NULL)
+			ITEM_LABEL_NEW(PTREE_DATA(pi), fi->rep);
 		ret = g_vsnprintf(fi->rep->representation, ITEM_LABEL_LENGTH,
 				  format, ap);
 		if (ret >= ITEM_LABEL_LENGTH) {
@@ -4054,6 +4125,58 @@ proto_custom_set(proto_tree* tree, const int field_id, gint occurrence,
 	return abbrev ? abbrev : "";
 }
 
+/* Find the single field_info a custom column shows, using the same
+ * occurrence rules as proto_custom_set(); returns NULL if the field is
+ * absent or the column shows several occurrences. */
+field_info *
+proto_custom_get_finfo(proto_tree* tree, const int field_id, gint occurrence)
+{
+	GPtrArray          *finfos;
+	field_info         *finfo   = NULL;
+	header_field_info*  hfinfo;
+	int                 len, prev_len = 0;
+
+	g_assert(field_id >= 0);
+
+	hfinfo = proto_registrar_get_nth((guint)field_id);
+	if (!hfinfo)
+		return NULL;
+
+	if (occurrence < 0) {
+		/* Search other direction */
+		while (hfinfo->same_name_prev) {
+			hfinfo = hfinfo->same_name_prev;
+		}
+	}
+
+	while (hfinfo) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		len = finfos ? g_ptr_array_len(finfos) : 0;
+
+		if (len) {
+			if (occurrence == 0) {
+				/* All occurrences are shown; only a single one has a value. */
+				if (finfo || len > 1)
+					return NULL;
+				finfo = (field_info *)g_ptr_array_index(finfos, 0);
+			} else if (occurrence < 0 && (occurrence + prev_len) >= -len) {
+				return (field_info *)g_ptr_array_index(finfos, occurrence + len + prev_len);
+			} else if (occurrence > 0 && (occurrence - prev_len) <= len) {
+				return (field_info *)g_ptr_array_index(finfos, occurrence - 1 - prev_len);
+			}
+			prev_len += len;
+		}
+
+		if (occurrence < 0) {
+			hfinfo = hfinfo->same_name_next;
+		} else {
+			hfinfo = hfinfo->same_name_prev;
+		}
+	}
+
+	return finfo;
+}
+
 
 /* Set text of proto_item after having already been created. */
 void
@@ -4070,10 +4193,6 @@ proto_item_set_text(proto_item *pi, const char *format, ...)
 	if (fi == NULL)
 		return;
 
-	if (fi->rep) {
-		ITEM_LABEL_FREE(fi->rep);
-	}
-
 	va_start(ap, format);
 	proto_tree_set_representation(pi, format, ap);
 	va_end(ap);
@@ -4102,7 +4221,7 @@ proto_item_append_text(proto_item *pi, const char *format, ...)
 		 * generate the default representation.
 		 */
 		if (fi->rep == NULL) {
-			ITEM_LABEL_NEW(fi->rep);
+			ITEM_LABEL_NEW(PTREE_DATA(pi), fi->rep);
 			proto_item_fill_label(fi, fi->rep->representation);
 		}
 
@@ -4139,7 +4258,7 @@ proto_item_prepend_text(proto_item *pi, const char *format, ...)
 		 * generate the default representation.
 		 */
 		if (fi->rep == NULL) {
-			ITEM_LABEL_NEW(fi->rep);
+			ITEM_LABEL_NEW(PTREE_DATA(pi), fi->rep);
 			proto_item_fill_label(fi, fi->rep->representation);
 		}
 
@@ -4234,19 +4353,37 @@ proto_item_set_expert_flags(proto_item *pi, const int group, const guint severit
 proto_tree *
 proto_tree_create_root(packet_info *pinfo)
 {
-	proto_node *pnode;
+	proto_node       *pnode;
+	tree_data_t          *tree_data;
+	struct _tree_store_t *store;
+
+	/* Take an idle store for the tree, or create one */
+	if (idle_tree_stores) {
+		store = (struct _tree_store_t *)idle_tree_stores->data;
+		idle_tree_stores = g_slist_delete_link(idle_tree_stores, idle_tree_stores);
+	} else {
+		store = g_new(struct _tree_store_t, 1);
+		store->arena = wmem_create_block_allocator();
+		store->slots = NULL;
+		store->num_slots = 0;
+		store->epoch = 1;
+	}
+	tree_data = (tree_data_t *)wmem_alloc(store->arena, sizeof(tree_data_t));
+	tree_data->store = store;
+	tree_data->arena = store->arena;
+	tree_data->fvalue_cleanup = NULL;
 
 	/* Initialize the proto_node */
-	PROTO_NODE_NEW(pnode);
+	PROTO_NODE_NEW(tree_data, pnode);
 	pnode->parent = NULL;
 	PNODE_FINFO(pnode) = NULL;
-	pnode->tree_data = g_new(tree_data_t, 1);
+	pnode->tree_data = tree_data;
 
 	/* Make sure we can access pinfo everywhere */
 	pnode->tree_data->pinfo = pinfo;
 
-	/* Don't initialize the tree_data_t. Wait until we know we need it */
-	pnode->tree_data->interesting_hfids = NULL;
+	/* No primed field has been seen yet */
+	pnode->tree_data->tracking_fields = FALSE;
 
 	/* Set the default to FALSE so it's easier to
 	 * find errors; if we expect to see the protocol tree
@@ -4260,12 +4397,28 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
-	pnode->tree_data->fi_tmp = NULL;
-
 	return (proto_tree *)pnode;
 }
 
 
+/* Give a field a slot in the dense index of primed fields */
+static guint
+proto_assign_interesting_slot(const gint hfid)
+{
+	if ((guint)hfid >= hfid_slots_len) {
+		guint new_len = gpa_hfinfo.len;
+
+		hfid_slots = g_renew(guint, hfid_slots, new_len);
+		memset(hfid_slots + hfid_slots_len, 0,
+		       (new_len - hfid_slots_len) * sizeof(guint));
+		hfid_slots_len = new_len;
+	}
+	if (hfid_slots[hfid] == 0)
+		hfid_slots[hfid] = num_interesting_slots++;
+
+	return hfid_slots[hfid];
+}
+
 /* "prime" a proto_tree with a single hfid that a dfilter
  * is interested in. */
 void
@@ -4274,6 +4427,7 @@ proto_tree_prime_hfid(proto_tree *tree _U_, const gint hfid)
 	header_field_info *hfinfo;
 
 	PROTO_REGISTRAR_GET_NTH(hfid, hfinfo);
+	proto_assign_interesting_slot(hfid);
 	/* this field is referenced by a filter so increase the refcount.
 	   also increase the refcount for the parent, i.e the protocol.
 	*/
@@ -4509,6 +4663,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->is_enabled = TRUE; /* protocol is enabled by default */
 	protocol->can_toggle = TRUE;
 	protocol->is_private = FALSE;
+	protocol->has_prefix = FALSE;
 	/* list will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
 
@@ -6243,19 +6398,25 @@ proto_check_for_protocol_or_field(const proto_tree* tree, const int id)
 /* Return GPtrArray* of field_info pointers for all hfindex that appear in tree.
  * This only works if the hfindex was "primed" before the dissection
  * took place, as we just pass back the already-created GPtrArray*.
- * The caller should *not* free the GPtrArray*; proto_tree_free_node()
- * handles that. */
+ * The caller should *not* free the GPtrArray*; it belongs to the tree
+ * and is reused once the tree is freed. */
 GPtrArray *
 proto_get_finfo_ptr_array(const proto_tree *tree, const int id)
 {
+	struct _tree_store_t *store;
+	guint                 slot_num;
+
 	if (!tree)
 		return NULL;
 
-	if (PTREE_DATA(tree)->interesting_hfids != NULL)
-		return g_hash_table_lookup(PTREE_DATA(tree)->interesting_hfids,
-					   GINT_TO_POINTER(id));
-	else
+	if ((guint)id >= hfid_slots_len || (slot_num = hfid_slots[id]) == 0)
+		return NULL;
+
+	store = PTREE_DATA(tree)->store;
+	if (slot_num >= store->num_slots || store->slots[slot_num].epoch != store->epoch)
 		return NULL;
+
+	return store->slots[slot_num].ptrs;
 }
 
 gboolean
@@ -6264,7 +6425,7 @@ proto_tracking_interesting_fields(const proto_tree *tree)
 	if (!tree)
 		return FALSE;
 
-	return (PTREE_DATA(tree)->interesting_hfids != NULL);
+	return PTREE_DATA(tree)->tracking_fields;
 }
 
 /* Helper struct for proto_find_info() and	proto_all_finfos() */
@@ -6408,6 +6569,32 @@ proto_registrar_dump_protocols(void)
 	}
 }
 
+/* Dumps the display filter prefixes whose fields are registered on demand
+ * to stdout.
+ *
+ * There is one record per line. The fields are tab-delimited.
+ *
+ * Field 1 = prefix
+ * Field 2 = "loaded" if its fields have been registered, "deferred" if not
+ */
+static void
+dump_deferred_prefix(gpointer key, gpointer value _U_, gpointer user_data _U_)
+{
+	printf("%s\tdeferred\n", (const char *)key);
+}
+
+void
+proto_registrar_dump_prefixes(void)
+{
+	GSList *entry;
+
+	for (entry = loaded_prefixes; entry != NULL; entry = g_slist_next(entry))
+		printf("%s\tloaded\n", (const char *)entry->data);
+
+	if (prefixes)
+		g_hash_table_foreach(prefixes, dump_deferred_prefix, NULL);
+}
+
 /* Dumps the value_strings, extended value string headers, range_strings
  * or true/false strings for fields that have them.
  * There is one record per line. Fields are tab-delimited.
@@ -466,12 +466,14 @@ typedef struct
 /** One of these exists for the entire protocol tree. Each proto_node
  * in the protocol tree points to the same copy. */
 typedef struct {
-    GHashTable  *interesting_hfids;
+    struct _tree_store_t *store;                  /**< arena and primed field slots */
+    gboolean     tracking_fields;                 /**< TRUE once a primed field was added */
     gboolean     visible;
     gboolean     fake_protocols;
     gint         count;
     struct _packet_info *pinfo;
-    field_info  *fi_tmp;
+    struct _wmem_allocator_t *arena;              /**< the tree is allocated from this */
+    struct _fvalue_cleanup_t *fvalue_cleanup;     /**< field values to clean up when freeing */
 } tree_data_t;
 
 /** Each proto_tree, proto_item is one of these. */
@@ -1652,7 +1654,8 @@ proto_is_private(const int proto_id);
    @param match  what's being matched */
 typedef void (*prefix_initializer_t)(const char* match);
 
-/** Register a new prefix for delayed initialization of field arrays
+/** Register a new prefix for delayed initialization of field arrays.
+Only RADIUS and the WiMAX ASN CP plugin use this so far.
 @param prefix the prefix for the new protocol
 @param initializer function that will initialize the field array for the given prefix */
 extern void
@@ -1661,6 +1664,11 @@ proto_register_prefix(const char *prefix,  prefix_initializer_t initializer);
 /** Initialize every remaining uninitialized prefix. */
 extern void proto_initialize_all_prefixes(void);
 
+/** Initialize the prefix named after a protocol, if it has not been
+    initialized yet. Called when a packet is handed to that protocol.
+ @param protocol the protocol whose fields are about to be used */
+extern void proto_initialize_protocol_prefix(protocol_t *protocol);
+
 /** Register a header_field array.
  @param parent the protocol handle from proto_register_protocol()
  @param hf the hf_register_info array
@@ -1824,6 +1832,10 @@ extern GPtrArray* proto_all_finfos(proto_tree *tree);
 /** Dumps a glossary of the protocol registrations to STDOUT */
 extern void proto_registrar_dump_protocols(void);
 
+/** Dumps the lazily registered field prefixes, and whether they have
+    been loaded yet, to STDOUT */
+extern void proto_registrar_dump_prefixes(void);
+
 /** Dumps a glossary of the field value strings or true/false strings to STDOUT */
 extern void proto_registrar_dump_values(void);
 
@@ -2075,6 +2087,15 @@ proto_custom_set(proto_tree* tree, const int field_id,
                              gchar *result,
                              gchar *expr, const int size );
 
+/** Find the field shown by a custom column, if it shows a single one
+ @param tree the tree to search
+ @param field_id the field id used for custom column
+ @param occurrence the occurrence of the field used for custom column
+ @return the field_info, or NULL if there is none or several */
+field_info *
+proto_custom_get_finfo(proto_tree* tree, const int field_id,
+                       gint occurrence);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
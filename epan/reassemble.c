@@ -45,10 +45,97 @@ typedef struct _dcerpc_fragment_key {
 	e_uuid_t act_id;
 } dcerpc_fragment_key;
 
-static void LINK_FRAG(fragment_data *fd_head,fragment_data *fd)
+/*
+ * What the reassembly code keeps about a list of fragments while they
+ * are being collected.  Only the heads of lists that are still being
+ * reassembled have one, so rather than growing every fragment_data it's
+ * kept in a table keyed by the head, and dropped when the list has been
+ * defragmented or freed.
+ */
+typedef struct _fragment_head_state {
+	fragment_data *last;	/* last fragment of the list */
+	fragment_data *run;	/* fragment owning the buffer that the data
+				   of the fragments up to "last" are stored
+				   back to back in, if any */
+	guint32 run_alloc;	/* allocated size of that buffer */
+	guint32 contiguous;	/* number of bytes available without gaps
+				   from offset 0 */
+} fragment_head_state;
+
+static GHashTable *fragment_head_states = NULL;
+
+/*
+ * Extend state->contiguous, the amount of data available without gaps
+ * from offset 0, with a fragment that has just been linked into the
+ * (sorted) list.  Only the fragments from the new one on can extend it.
+ */
+static void
+update_contiguous(fragment_head_state *state, fragment_data *fd)
 {
 	fragment_data *fd_i;
 
+	for (fd_i = fd; fd_i && fd_i->offset <= state->contiguous; fd_i = fd_i->next) {
+		if (fd_i->offset + fd_i->len > state->contiguous)
+			state->contiguous = fd_i->offset + fd_i->len;
+	}
+}
+
+/*
+ * Get the state of a list of fragments, creating it from the list if
+ * it doesn't have one yet (e.g. it was defragmented before, and is now
+ * being extended by a partial reassembly).
+ */
+static fragment_head_state *
+fragment_head_get_state(fragment_data *fd_head)
+{
+	fragment_head_state *state;
+	fragment_data *fd_i;
+
+	if (!fragment_head_states)
+		fragment_head_states = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	state = g_hash_table_lookup(fragment_head_states, fd_head);
+	if (state)
+		return state;
+
+	state = g_slice_new0(fragment_head_state);
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next)
+		state->last = fd_i;
+	update_contiguous(state, fd_head->next);
+	g_hash_table_insert(fragment_head_states, fd_head, state);
+	return state;
+}
+
+/* Forget the state of a list that is defragmented or about to be freed */
+static void
+fragment_head_free_state(fragment_data *fd_head)
+{
+	fragment_head_state *state;
+
+	if (!fragment_head_states)
+		return;
+
+	state = g_hash_table_lookup(fragment_head_states, fd_head);
+	if (state) {
+		g_hash_table_remove(fragment_head_states, fd_head);
+		g_slice_free(fragment_head_state, state);
+	}
+}
+
+static void
+link_frag(fragment_head_state *state, fragment_data *fd_head, fragment_data *fd)
+{
+	fragment_data *fd_i;
+
+	/* Fragments mostly arrive in order; if this one doesn't go before
+	 * the last one, append it without walking the list. */
+	if (state && state->last && fd->offset >= state->last->offset) {
+		fd->next = NULL;
+		state->last->next = fd;
+		state->last = fd;
+		return;
+	}
+
 	/* add fragment to list, keep list sorted */
 	for(fd_i= fd_head; fd_i->next;fd_i=fd_i->next) {
 		if (fd->offset < fd_i->next->offset )
@@ -56,6 +143,74 @@ static void LINK_FRAG(fragment_data *fd_head,fragment_data *fd)
 	}
 	fd->next=fd_i->next;
 	fd_i->next=fd;
+	if (state && fd->next == NULL)
+		state->last = fd;
+}
+
+static void LINK_FRAG(fragment_data *fd_head,fragment_data *fd)
+{
+	fragment_head_state *state = NULL;
+
+	/* Keep "last" up to date if the list has a state */
+	if (fragment_head_states)
+		state = g_hash_table_lookup(fragment_head_states, fd_head);
+	link_frag(state, fd_head, fd);
+}
+
+/*
+ * Store the payload of a fragment that isn't part of a defragmented
+ * packet yet.
+ *
+ * When fragments arrive in order, each one directly following the last
+ * one, their data are stored back to back in a single buffer owned by
+ * the first of them (state->run), which is grown as needed; the data
+ * pointers of the following ones point into it, with FD_NOT_MALLOCED set.
+ * If the whole packet arrived that way, that buffer becomes the
+ * reassembled packet without copying the data again.
+ */
+static void
+fragment_store_data(fragment_head_state *state, fragment_data *fd_head,
+		    fragment_data *fd, tvbuff_t *tvb, const int offset)
+{
+	fragment_data *run = state->run;
+	fragment_data *fd_i;
+	guint32 needed, new_alloc;
+	unsigned char *old_data;
+
+	if (run && state->last &&
+	    fd->offset == state->last->offset + state->last->len &&
+	    fd->offset + fd->len >= fd->offset) {
+		needed = fd->offset + fd->len - run->offset;
+		if (needed > state->run_alloc) {
+			new_alloc = MAX(needed, state->run_alloc * 2);
+			old_data = run->data;
+			run->data = g_realloc(run->data, new_alloc);
+			state->run_alloc = new_alloc;
+			if (run->data != old_data) {
+				/* all fragments after the run's first are in the run */
+				for (fd_i = run->next; fd_i; fd_i = fd_i->next)
+					fd_i->data = run->data + (fd_i->offset - run->offset);
+			}
+		}
+		fd->data = run->data + (fd->offset - run->offset);
+		fd->flags |= FD_NOT_MALLOCED;
+		tvb_memcpy(tvb, fd->data, offset, fd->len);
+		link_frag(state, fd_head, fd);
+		return;
+	}
+
+	fd->data = g_malloc(fd->len);
+	tvb_memcpy(tvb, fd->data, offset, fd->len);
+	link_frag(state, fd_head, fd);
+
+	if (state->last == fd) {
+		/* This one can start a new run */
+		state->run = fd;
+		state->run_alloc = fd->len;
+	} else if (run && fd->offset >= run->offset) {
+		/* It went in the middle of the run, which thus ends */
+		state->run = NULL;
+	}
 }
 
 /* copy a fragment key to heap store to insert in the hash */
@@ -202,6 +357,7 @@ free_all_fragments(gpointer key_arg _U_, gpointer value, gpointer user_data _U_)
 	/* g_hash_table_new_full() was used to supply a function
 	 * to free the key and the addresses.
 	 */
+	fragment_head_free_state(value);
 	for (fd_head = value; fd_head != NULL; fd_head = tmp_fd) {
 		tmp_fd=fd_head->next;
 
@@ -376,6 +532,7 @@ free_fragments(gpointer data, gpointer user_data _U_)
 {
 	fragment_data *fd_head = (fragment_data *) data;
 
+	fragment_head_free_state(fd_head);
 	g_free(fd_head->data);
 	g_slice_free(fragment_data, fd_head);
 }
@@ -450,6 +607,7 @@ fragment_delete(const packet_info *pinfo, const guint32 id, GHashTable *fragment
 		g_slice_free(fragment_data, fd);
 		fd=tmp_fd;
 	}
+	fragment_head_free_state(fd_head);
 	g_slice_free(fragment_data, fd_head);
 	g_hash_table_remove(fragment_table, &key);
 
@@ -655,6 +813,7 @@ fragment_reassembled(fragment_data *fd_head, const packet_info *pinfo,
 	}
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in = pinfo->fd->num;
+	fragment_head_free_state(fd_head);
 }
 
 /*
@@ -685,6 +844,7 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 {
 	fragment_data *fd;
 	fragment_data *fd_i;
+	fragment_head_state *state;
 	guint32 max, dfpos;
 	unsigned char *old_data;
 
@@ -777,9 +937,9 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 	 * XXX - what if we didn't capture the entire fragment due
 	 * to a too-short snapshot length?
 	 */
-	fd->data = g_malloc(fd->len);
-	tvb_memcpy(tvb, fd->data, offset, fd->len);
-	LINK_FRAG(fd_head,fd);
+	state = fragment_head_get_state(fd_head);
+	fragment_store_data(state, fd_head, fd, tvb, offset);
+	update_contiguous(state, fd);
 
 
 	if( !(fd_head->flags & FD_DATALEN_SET) ){
@@ -792,21 +952,11 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 
 	/*
 	 * Check if we have received the entire fragment.
-	 * This is easy since the list is sorted and the head is faked.
 	 *
-	 * First, we compute the amount of contiguous data that's
-	 * available.  (The check for fd_i->offset <= max rules out
-	 * fragments that don't start before or at the end of the
-	 * previous fragment, i.e. fragments that have a gap between
-	 * them and the previous fragment.)
+	 * The amount of contiguous data that's available is kept up
+	 * to date as fragments are added.
 	 */
-	max = 0;
-	for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
-		if ( ((fd_i->offset)<=max) &&
-			((fd_i->offset+fd_i->len)>max) ){
-			max = fd_i->offset+fd_i->len;
-		}
-	}
+	max = state->contiguous;
 
 	if (max < (fd_head->datalen)) {
 		/*
@@ -831,6 +981,28 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 	 */
 	/* store old data just in case */
 	old_data=fd_head->data;
+
+	if (state->run && state->run == fd_head->next &&
+	    state->run->offset == 0 &&
+	    state->last->offset + state->last->len == max) {
+		/*
+		 * All fragments were stored back to back in the run's
+		 * buffer, in order and without overlaps: it already holds
+		 * the reassembled packet.
+		 */
+		fd_head->data = state->run->data;
+		for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
+			fd_i->flags &= ~FD_NOT_MALLOCED;
+			fd_i->data = NULL;
+		}
+		fragment_head_free_state(fd_head);
+		g_free(old_data);
+		fd_head->flags |= FD_DEFRAGMENTED;
+		fd_head->reassembled_in=pinfo->fd->num;
+		return TRUE;
+	}
+	fragment_head_free_state(fd_head);
+
 	fd_head->data = g_malloc(max);
 
 	/* add all data fragments */
@@ -885,16 +1057,21 @@ fragment_add_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 						pinfo->fd->num, fd_i->offset,
 						fd_i->len);
 			}
-			if( fd_i->flags & FD_NOT_MALLOCED )
-				fd_i->flags &= ~FD_NOT_MALLOCED;
-			else
-				g_free(fd_i->data);
-			fd_i->data=NULL;
 
 			dfpos=MAX(dfpos,(fd_i->offset+fd_i->len));
 		}
 	}
 
+	/* Now free the fragments' data; this is done separately as the
+	 * data of fragments in a run are part of the run's first one. */
+	for (fd_i=fd_head->next;fd_i;fd_i=fd_i->next) {
+		if( fd_i->flags & FD_NOT_MALLOCED )
+			fd_i->flags &= ~FD_NOT_MALLOCED;
+		else
+			g_free(fd_i->data);
+		fd_i->data=NULL;
+	}
+
 	g_free(old_data);
 	/* mark this packet as defragmented.
 		   allows us to skip any trailing fragments */
@@ -1187,6 +1364,7 @@ fragment_defragment_and_free (fragment_data *fd_head, const packet_info *pinfo)
 	 */
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in=pinfo->fd->num;
+	fragment_head_free_state(fd_head);
 }
 
 /*
@@ -1375,7 +1553,7 @@ fragment_add_seq_work(fragment_data *fd_head, tvbuff_t *tvb, const int offset,
 		fd->data = g_malloc(fd->len);
 		tvb_memcpy(tvb, fd->data, offset, fd->len);
 	}
-	LINK_FRAG(fd_head,fd);
+	link_frag(fragment_head_get_state(fd_head), fd_head, fd);
 
 
 	if( !(fd_head->flags & FD_DATALEN_SET) ){
@@ -1758,8 +1936,7 @@ fragment_start_seq_check(const packet_info *pinfo, const guint32 id, GHashTable
 
 	if (fd_head == NULL) {
 		/* Create list-head. */
-		fd_head = g_slice_new(fragment_data);
-		fd_head->next = NULL;
+		fd_head = g_slice_new0(fragment_data);
 		fd_head->datalen = tot_len;
 		fd_head->offset = 0;
 		fd_head->len = 0;
@@ -1,7 +1,7 @@
 /* Standalone program to test functionality of reassemble.h API
  *
  * These aren't particularly complete - they just test a few corners of
- * functionality which I was interested in. In particular, they only test the
+ * functionality which I was interested in. In particular, they mostly test the
  * fragment_add_seq_* (ie, FD_BLOCKSEQUENCE) family of routines. However,
  * hopefully they will inspire people to write additional tests, and provide a
  * useful basis on which to do so.
@@ -28,6 +28,10 @@
  *     reassembled table.
  *     #define debug  to enable the code.
  *
+ * "reassemble_test -b [fragments]" times fragment_add() instead of running
+ * the tests, reassembling PDUs of that many (default 10000) fragments sent
+ * in order, in reverse order and with every other fragment late.
+ *
  * $Id$
  *
  * Copyright (c) 2007 MX Telecom Ltd. <richardv@mxtelecom.com>
@@ -1617,6 +1621,217 @@ test_missing_data_fragment_add_seq_next_3(void)
 }
 
 
+/**********************************************************************************
+ *
+ * fragment_add
+ *
+ *********************************************************************************/
+
+/* Add a PDU of 20 fragments of 10 bytes each, in order; the fragments'
+ * data are kept in a single buffer, which becomes the reassembled data.
+ */
+static void
+test_fragment_add_in_order(void)
+{
+    fragment_data *fd_head, *fd;
+    guint32 i;
+
+    printf("Starting test test_fragment_add_in_order\n");
+
+    for (i = 0; i < 20; i++) {
+        pinfo.fd->num = i + 1;
+        fd_head=fragment_add(tvb, i*10, &pinfo, 12, fragment_table,
+                             i*10, 10, i < 19);
+        if (i < 19) {
+            ASSERT_EQ(NULL,fd_head);
+            fd_head=fragment_get(&pinfo, 12, fragment_table);
+            ASSERT_NE(NULL,fd_head);
+            /* the fragments after the first one are stored in its buffer */
+            for (fd = fd_head->next->next; fd; fd = fd->next) {
+                ASSERT_EQ(FD_NOT_MALLOCED,fd->flags);
+                ASSERT(fd->data == fd_head->next->data + fd->offset);
+            }
+        }
+    }
+
+    ASSERT_NE(NULL,fd_head);
+    ASSERT_EQ(200,fd_head->datalen);
+    ASSERT_EQ(20,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET,fd_head->flags);
+    ASSERT_NE(NULL,fd_head->data);
+    ASSERT(!memcmp(fd_head->data,data,200));
+
+    for (i = 0, fd = fd_head->next; fd; i++, fd = fd->next) {
+        ASSERT_EQ(i+1,fd->frame);
+        ASSERT_EQ(i*10,fd->offset);
+        ASSERT_EQ(10,fd->len);
+        ASSERT_EQ(0,fd->flags);
+        ASSERT_EQ(NULL,fd->data);
+    }
+    ASSERT_EQ(20,i);
+}
+
+/* Add fragments out of order:
+ *
+ *   frame  offset  len  more_frags
+ *   -----  ------  ---  ----------
+ *     1       0     10    true
+ *     2      10     10    true
+ *     3      30     10    true
+ *     4      40     10    false
+ *     5      20     10    true
+ */
+static void
+test_fragment_add_out_of_order(void)
+{
+    fragment_data *fd_head, *fd;
+    guint32 i;
+
+    printf("Starting test test_fragment_add_out_of_order\n");
+
+    pinfo.fd->num = 1;
+    fd_head=fragment_add(tvb, 0, &pinfo, 12, fragment_table, 0, 10, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 2;
+    fd_head=fragment_add(tvb, 10, &pinfo, 12, fragment_table, 10, 10, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 3;
+    fd_head=fragment_add(tvb, 30, &pinfo, 12, fragment_table, 30, 10, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 4;
+    fd_head=fragment_add(tvb, 40, &pinfo, 12, fragment_table, 40, 10, FALSE);
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 5;
+    fd_head=fragment_add(tvb, 20, &pinfo, 12, fragment_table, 20, 10, TRUE);
+    ASSERT_NE(NULL,fd_head);
+
+    ASSERT_EQ(50,fd_head->datalen);
+    ASSERT_EQ(5,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET,fd_head->flags);
+    ASSERT(!memcmp(fd_head->data,data,50));
+
+    /* the list is sorted by offset */
+    for (i = 0, fd = fd_head->next; fd; i++, fd = fd->next) {
+        ASSERT_EQ(i*10,fd->offset);
+        ASSERT_EQ(0,fd->flags);
+        ASSERT_EQ(NULL,fd->data);
+    }
+    ASSERT_EQ(5,i);
+    ASSERT_EQ(5,fd_head->next->next->next->frame);
+}
+
+/* Add overlapping fragments:
+ *
+ *   frame  offset  len  more_frags
+ *   -----  ------  ---  ----------
+ *     1       0     50    true
+ *     2      40     30    true
+ *     3      70     30    false
+ */
+static void
+test_fragment_add_overlap(void)
+{
+    fragment_data *fd_head;
+
+    printf("Starting test test_fragment_add_overlap\n");
+
+    pinfo.fd->num = 1;
+    fd_head=fragment_add(tvb, 0, &pinfo, 12, fragment_table, 0, 50, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 2;
+    fd_head=fragment_add(tvb, 40, &pinfo, 12, fragment_table, 40, 30, TRUE);
+    ASSERT_EQ(NULL,fd_head);
+
+    pinfo.fd->num = 3;
+    fd_head=fragment_add(tvb, 70, &pinfo, 12, fragment_table, 70, 30, FALSE);
+    ASSERT_NE(NULL,fd_head);
+
+    ASSERT_EQ(100,fd_head->datalen);
+    ASSERT_EQ(3,fd_head->reassembled_in);
+    ASSERT_EQ(FD_DEFRAGMENTED|FD_DATALEN_SET|FD_OVERLAP,fd_head->flags);
+    ASSERT(!memcmp(fd_head->data,data,100));
+
+    ASSERT_EQ(0,fd_head->next->flags);
+    ASSERT_EQ(FD_OVERLAP,fd_head->next->next->flags);
+    ASSERT_EQ(0,fd_head->next->next->next->flags);
+    ASSERT_EQ(NULL,fd_head->next->next->next->next);
+}
+
+/**********************************************************************************
+ *
+ * benchmark
+ *
+ *********************************************************************************/
+
+#define BENCH_FRAG_LEN 8
+
+/* The i'th fragment to be sent out of "count", in the given order */
+static guint32
+bench_frag_index(guint32 order, guint32 i, guint32 count)
+{
+    switch (order) {
+    case 1:     /* reverse */
+        return count - 1 - i;
+    case 2:     /* even fragments first, then the odd ones */
+        return (i < (count + 1) / 2) ? i * 2 : (i - (count + 1) / 2) * 2 + 1;
+    default:    /* in order */
+        return i;
+    }
+}
+
+static void
+benchmark_fragment_add(guint32 count)
+{
+    static const char *orders[] = { "in order", "reverse", "interleaved" };
+    fragment_data *fd_head;
+    GTimer *timer;
+    guint32 order, pdu, pdus, i, n;
+    gdouble elapsed;
+
+    /* Reassemble about a million fragments for each order */
+    pdus = MAX(1, 1000000 / count);
+    timer = g_timer_new();
+
+    for (order = 0; order < G_N_ELEMENTS(orders); order++) {
+        fragment_table_init(&fragment_table);
+
+        g_timer_start(timer);
+        for (pdu = 0; pdu < pdus; pdu++) {
+            for (i = 0; i < count; i++) {
+                n = bench_frag_index(order, i, count);
+                pinfo.fd->num = pdu * count + i + 1;
+                fd_head=fragment_add(tvb, (n * BENCH_FRAG_LEN) % (DATA_LEN - BENCH_FRAG_LEN),
+                                     &pinfo, pdu, fragment_table,
+                                     n * BENCH_FRAG_LEN, BENCH_FRAG_LEN,
+                                     n < count - 1);
+                if (i < count - 1)
+                    ASSERT_EQ(NULL,fd_head);
+            }
+            ASSERT_NE(NULL,fd_head);
+            ASSERT_EQ(count * BENCH_FRAG_LEN,fd_head->datalen);
+            /* as a dissector would once it's done with the PDU */
+            g_free(fragment_delete(&pinfo, pdu, fragment_table));
+        }
+        g_timer_stop(timer);
+        elapsed = g_timer_elapsed(timer, NULL);
+
+        printf("%-12s %u PDUs of %u fragments: %.3f s, %.0f fragments/s\n",
+               orders[order], pdus, count, elapsed,
+               elapsed > 0 ? pdus * (gdouble)count / elapsed : 0);
+
+        fragment_table_init(&fragment_table);
+        g_hash_table_destroy(fragment_table);
+        fragment_table = NULL;
+    }
+
+    g_timer_destroy(timer);
+}
+
 /**********************************************************************************
  *
  * main
@@ -1624,7 +1839,7 @@ test_missing_data_fragment_add_seq_next_3(void)
  *********************************************************************************/
 
 int
-main(int argc _U_, char **argv _U_)
+main(int argc, char **argv)
 {
     frame_data fd;
     char src[] = {1,2,3,4}, dst[] = {5,6,7,8};
@@ -1645,6 +1860,9 @@ main(int argc _U_, char **argv _U_)
         test_missing_data_fragment_add_seq_next,
         test_missing_data_fragment_add_seq_next_2,
         test_missing_data_fragment_add_seq_next_3,
+        test_fragment_add_in_order,
+        test_fragment_add_out_of_order,
+        test_fragment_add_overlap,
 #if 0
         test_fragment_add_seq_check_multiple
 #endif
@@ -1667,6 +1885,13 @@ main(int argc _U_, char **argv _U_)
     SET_ADDRESS(&pinfo.src,AT_IPv4,4,src);
     SET_ADDRESS(&pinfo.dst,AT_IPv4,4,dst);
 
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        benchmark_fragment_add(argc > 2 ? MAX(1, (guint32)atoi(argv[2])) : 10000);
+        tvb_free(tvb);
+        g_free(data);
+        return failure;
+    }
+
     /*************************************************************************/
     for(i=0; i < sizeof(tests)/sizeof(tests[0]); i++ ) {
         /* re-init the fragment tables */
@@ -33,6 +33,12 @@
 /* When required, allocate more memory from the OS in this size chunks (8 MB) */
 #define WMEM_BLOCK_SIZE (8 * 1024 * 1024)
 
+/* Allocations are rounded up to this, so that every chunk handed out is
+ * suitably aligned for any type */
+#define WMEM_ALIGN_AMOUNT (2 * sizeof (gsize))
+#define WMEM_ALIGN_SIZE(SIZE) ((SIZE) + WMEM_ALIGN_AMOUNT - \
+        ((SIZE) & (WMEM_ALIGN_AMOUNT - 1)))
+
 typedef struct _wmem_block_allocator_t {
     GSList *free_list;
     GSList *full_list;
@@ -66,11 +72,15 @@ wmem_block_free_block(wmem_block_t *block)
 }
 
 static void *
-wmem_block_alloc(void *private_data, const size_t size)
+wmem_block_alloc(void *private_data, const size_t requested)
 {
     void                   *buf;
     wmem_block_t           *block;
     wmem_block_allocator_t *allocator = (wmem_block_allocator_t*) private_data;
+    size_t                  size;
+
+    size = (requested & (WMEM_ALIGN_AMOUNT - 1)) ?
+        WMEM_ALIGN_SIZE(requested) : requested;
 
     /* We can't allocate more memory than is in a single block
      * (which is an awful lot) */
@@ -114,7 +124,8 @@ wmem_block_alloc(void *private_data, const size_t size)
 static void
 wmem_block_free_all(void *private_data)
 {
-    GSList                *tmp;
+    GSList                 *tmp;
+    wmem_block_t           *block;
     wmem_block_allocator_t *allocator = (wmem_block_allocator_t*) private_data;
 
     /* Don't actually free the blocks, just move everything back to the
@@ -127,6 +138,13 @@ wmem_block_free_all(void *private_data)
     }
     g_slist_free(allocator->full_list);
     allocator->full_list = NULL;
+
+    /* and mark all of their memory as unused again */
+    for (tmp = allocator->free_list; tmp; tmp = tmp->next) {
+        block = (wmem_block_t *) tmp->data;
+        block->offset    = 0;
+        block->remaining = WMEM_BLOCK_SIZE;
+    }
 }
 
 static void
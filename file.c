@@ -54,6 +54,9 @@
 #include "print.h"
 #include "file.h"
 #include "fileset.h"
+#include "filter_cache.h"
+#include "ngram_index.h"
+#include "frame_readahead.h"
 #include "tempfile.h"
 #include "merge.h"
 
@@ -84,6 +87,12 @@ static nstime_t first_ts;
 static frame_data *prev_dis;
 static frame_data *prev_cap;
 
+/* Results of recently used display filters, for refiltering */
+static filter_cache_t *filter_cache = NULL;
+
+/* Which trigrams are in the frames read by "Find Packet" data searches. */
+static ngram_index_t *find_index = NULL;
+
 static gulong computed_elapsed;
 
 static void cf_reset_state(capture_file *cf);
@@ -396,6 +405,14 @@ cf_reset_state(capture_file *cf)
     wtap_close(cf->wth);
     cf->wth = NULL;
   }
+  if (find_index != NULL) {
+    if (prefs.gui_find_index_save && cf->filename != NULL && !cf->is_tempfile &&
+        ngram_index_changed(find_index))
+      ngram_index_save(find_index, cf->filename);
+    ngram_index_free(find_index);
+    find_index = NULL;
+  }
+
   /* We have no file open... */
   if (cf->filename != NULL) {
     /* If it's a temporary file, remove it. */
@@ -409,6 +426,7 @@ cf_reset_state(capture_file *cf)
 
   dfilter_free(cf->rfcode);
   cf->rfcode = NULL;
+  cf_invalidate_filter_results(cf);
   if (cf->frames != NULL) {
     free_frame_data_sequence(cf->frames);
     cf->frames = NULL;
@@ -650,6 +668,11 @@ cf_read(capture_file *cf, gboolean reloading)
     dfilter_free(dfcode);
   }
 
+  /* Remember which of the frames we've read passed the filter. */
+  if (filter_cache == NULL)
+    filter_cache = filter_cache_new();
+  filter_cache_store(filter_cache, cf->dfilter, cf->frames, cf->count);
+
   /* We're done reading the file; destroy the progress bar if it was created. */
   if (progbar != NULL)
     destroy_progress_dlg(progbar);
@@ -1165,6 +1188,43 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   return row;
 }
 
+/* Like add_packet_to_packet_list(), but for a frame for which we already
+   know whether it passes the display filter, so that it doesn't have to be
+   read or dissected. */
+static void
+add_known_packet_to_packet_list(frame_data *fdata, capture_file *cf,
+    gboolean passed, gboolean dependent)
+{
+  frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                &first_ts, prev_dis, prev_cap);
+  prev_cap = fdata;
+
+  fdata->flags.passed_dfilter = passed ? 1 : 0;
+  if (dependent)
+    fdata->flags.dependent_of_displayed = 1;
+
+  if (fdata->flags.passed_dfilter || fdata->flags.ref_time) {
+    cf->displayed_count++;
+    frame_data_set_after_dissect(fdata, &cum_bytes);
+    prev_dis = fdata;
+
+    if (cf->first_displayed == 0)
+      cf->first_displayed = fdata->num;
+    cf->last_displayed = fdata->num;
+  }
+}
+
+/* Called on the read-ahead thread: will rescan_packets() read this frame? */
+static gboolean
+rescan_frame_wanted(frame_data *fdata, gpointer data)
+{
+  const filter_plan_t *plan = data;
+  gboolean passed, dependent;
+
+  return plan == NULL || !fdata->flags.visited ||
+         !filter_plan_lookup(plan, fdata->num, &passed, &dependent);
+}
+
 /* read in a new packet */
 /* returns the row of the new packet in the packet list or -1 if not displayed */
 static int
@@ -1637,6 +1697,10 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
   cf->dfilter = dftext;
   g_get_current_time(&start_time);
 
+  /* If we're told to refilter anyway, the results we have may be stale. */
+  if (force)
+    cf_invalidate_filter_results(cf);
+
 
   /* Now rescan the packet list, applying the new filter, but not
      throwing away information constructed on a previous pass. */
@@ -1655,6 +1719,8 @@ cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
 void
 cf_reftime_packets(capture_file *cf)
 {
+  /* Filters can test the relative time stamps. */
+  cf_invalidate_filter_results(cf);
   ref_time_packets(cf);
 }
 
@@ -1664,6 +1730,13 @@ cf_redissect_packets(capture_file *cf)
   rescan_packets(cf, "Reprocessing", "all packets", TRUE);
 }
 
+void
+cf_invalidate_filter_results(capture_file *cf _U_)
+{
+  if (filter_cache != NULL)
+    filter_cache_clear(filter_cache);
+}
+
 gboolean
 cf_read_frame_r(capture_file *cf, frame_data *fdata,
                 struct wtap_pkthdr *phdr, guint8 *pd)
@@ -1759,6 +1832,9 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    add_to_packet_list = FALSE;
   gboolean    compiled;
   guint32     frames_count;
+  filter_plan_t *filter_plan = NULL;
+  gboolean    known_passed, known_dependent;
+  frame_readahead_t *readahead = NULL;
 
   /* Compile the current display filter.
    * We assume this will not fail since cf->dfilter is only set in
@@ -1806,8 +1882,25 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
      * packet list store. */
     packet_list_clear();
     add_to_packet_list = TRUE;
+
+    /* The dissectors may now produce something else. */
+    cf_invalidate_filter_results(cf);
+  } else if (!tap_listeners_require_dissection()) {
+    /* If all that has changed is the filter, we may already know which
+       frames pass it, or which ones can't. */
+    if (filter_cache == NULL)
+      filter_cache = filter_cache_new();
+    filter_plan = filter_cache_plan(filter_cache, cf->dfilter, cf->count);
   }
 
+  /* Read the frames on another thread while we dissect them.  Not while
+     we're still capturing, as the number of frames can change under us,
+     nor if the filter cache already knows the result for every frame. */
+  if (cf->state == FILE_READ_DONE &&
+      (filter_plan == NULL || !filter_plan_is_complete(filter_plan, cf->count)))
+    readahead = frame_readahead_new(cf->filename, cf->frames, cf->count,
+                                    rescan_frame_wanted, filter_plan);
+
   /* We don't yet know which will be the first and last frames displayed. */
   cf->first_displayed = 0;
   cf->last_displayed = 0;
@@ -1913,9 +2006,6 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->flags.dependent_of_displayed = 0;
 
-    if (!cf_read_frame(cf, fdata))
-      break; /* error reading the frame */
-
     /* If the previous frame is displayed, and we haven't yet seen the
        selected frame, remember that frame - it's the closest one we've
        yet seen before the selected frame. */
@@ -1923,9 +2013,22 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame_num = prev_frame_num;
       preceding_frame = prev_frame;
     }
-    add_packet_to_packet_list(fdata, cf, dfcode, create_proto_tree,
-                                    cinfo, &cf->phdr, cf->pd,
-                                    add_to_packet_list);
+
+    /* Frames that haven't been dissected sequentially yet, e.g. after an
+       aborted redissection, must be, whatever the filter result. */
+    if (filter_plan != NULL && fdata->flags.visited &&
+        filter_plan_lookup(filter_plan, fdata->num, &known_passed, &known_dependent)) {
+      add_known_packet_to_packet_list(fdata, cf, known_passed, known_dependent);
+    } else {
+      if ((readahead == NULL ||
+           !frame_readahead_get(readahead, fdata, &cf->phdr, cf->pd)) &&
+          !cf_read_frame(cf, fdata))
+        break; /* error reading the frame */
+
+      add_packet_to_packet_list(fdata, cf, dfcode, create_proto_tree,
+                                      cinfo, &cf->phdr, cf->pd,
+                                      add_to_packet_list);
+    }
 
     /* If this frame is displayed, and this is the first frame we've
        seen displayed after the selected frame, remember this frame -
@@ -1950,6 +2053,19 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   /* We are done redissecting the packet list. */
   cf->redissecting = FALSE;
 
+  /* Stop reading ahead before the plan it looks at goes away. */
+  if (readahead != NULL)
+    frame_readahead_free(readahead);
+  if (filter_plan != NULL)
+    filter_plan_free(filter_plan);
+
+  /* If we got through all the frames, remember which ones passed. */
+  if (framenum > frames_count) {
+    if (filter_cache == NULL)
+      filter_cache = filter_cache_new();
+    filter_cache_store(filter_cache, cf->dfilter, cf->frames, frames_count);
+  }
+
   if (redissect) {
       frames_count = cf->count;
     /* Clear out what remains of the visited flags and per-frame data
@@ -2156,6 +2272,7 @@ process_specified_packets(capture_file *cf, packet_range_t *range,
   int              progbar_quantum;
   range_process_e  process_this;
   struct wtap_pkthdr phdr;
+  frame_readahead_t *readahead = NULL;
 
   /* Update the progress bar when it gets to this value. */
   progbar_nextstep = 0;
@@ -2173,6 +2290,13 @@ process_specified_packets(capture_file *cf, packet_range_t *range,
   if (range != NULL)
     packet_range_process_init(range);
 
+  /* If we're going through all the packets of a file we've finished
+     reading, read them on another thread while we process them. */
+  if ((range == NULL || packet_range_process_all(range)) &&
+      cf->state == FILE_READ_DONE)
+    readahead = frame_readahead_new(cf->filename, cf->frames, cf->count,
+                                    NULL, NULL);
+
   /* Iterate through all the packets, printing the packets that
      were selected by the current display filter.  */
   for (framenum = 1; framenum <= cf->count; framenum++) {
@@ -2234,7 +2358,9 @@ process_specified_packets(capture_file *cf, packet_range_t *range,
     }
 
     /* Get the packet */
-    if (!cf_read_frame_r(cf, fdata, &phdr, pd)) {
+    if ((readahead == NULL ||
+         !frame_readahead_get(readahead, fdata, &phdr, pd)) &&
+        !cf_read_frame_r(cf, fdata, &phdr, pd)) {
       /* Attempt to get the packet failed. */
       ret = PSP_FAILED;
       break;
@@ -2247,6 +2373,9 @@ process_specified_packets(capture_file *cf, packet_range_t *range,
     }
   }
 
+  if (readahead != NULL)
+    frame_readahead_free(readahead);
+
   /* We're done printing the packets; destroy the progress bar if
      it was created. */
   if (progbar != NULL)
@@ -3107,18 +3236,28 @@ match_summary_line(capture_file *cf, frame_data *fdata, void *criterion)
 }
 
 typedef struct {
-    const guint8 *data;
-    size_t        data_len;
+    const guint8  *data;
+    size_t         data_len;
+    ngram_query_t *query;   /* NULL if the index can't help */
 } cbs_t;    /* "Counted byte string" */
 
 gboolean
 cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
                     search_direction dir)
 {
-  cbs_t info;
+  cbs_t    info;
+  gboolean result;
 
   info.data = string;
   info.data_len = string_size;
+  info.query = NULL;
+
+  if (find_index == NULL) {
+    find_index = ngram_index_new(
+        (guint64)prefs.gui_find_index_max_size * 1024 * 1024);
+    if (prefs.gui_find_index_save && cf->filename != NULL && !cf->is_tempfile)
+      ngram_index_load(find_index, cf->filename);
+  }
 
   /* String or hex search? */
   if (cf->string) {
@@ -3126,20 +3265,51 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
     switch (cf->scs_type) {
 
     case SCS_ASCII_AND_UNICODE:
-      return find_packet(cf, match_ascii_and_unicode, &info, dir);
+      info.query = ngram_query_new(string, string_size, cf->case_type);
+      result = find_packet(cf, match_ascii_and_unicode, &info, dir);
+      break;
 
     case SCS_ASCII:
-      return find_packet(cf, match_ascii, &info, dir);
+      info.query = ngram_query_new(string, string_size, cf->case_type);
+      result = find_packet(cf, match_ascii, &info, dir);
+      break;
 
     case SCS_UNICODE:
-      return find_packet(cf, match_unicode, &info, dir);
+      /* The characters aren't next to each other; the index can't help. */
+      result = find_packet(cf, match_unicode, &info, dir);
+      break;
 
     default:
       g_assert_not_reached();
       return FALSE;
     }
-  } else
-    return find_packet(cf, match_binary, &info, dir);
+  } else {
+    info.query = ngram_query_new(string, string_size, FALSE);
+    result = find_packet(cf, match_binary, &info, dir);
+  }
+
+  if (info.query != NULL)
+    ngram_query_free(info.query);
+  return result;
+}
+
+/*
+ * Returns FALSE if the index says the frame can't contain the string.
+ * Edited frames aren't in the index.
+ */
+static gboolean
+frame_may_contain(frame_data *fdata, const cbs_t *info)
+{
+  if (info->query == NULL || find_index == NULL || fdata->file_off == -1)
+    return TRUE;
+  return ngram_index_may_match(find_index, info->query, fdata->num);
+}
+
+static void
+index_frame_data(capture_file *cf, frame_data *fdata)
+{
+  if (find_index != NULL && fdata->file_off != -1)
+    ngram_index_add(find_index, fdata->num, cf->pd, fdata->cap_len);
 }
 
 static match_result
@@ -3154,11 +3324,15 @@ match_ascii_and_unicode(capture_file *cf, frame_data *fdata, void *criterion)
   guint8        c_char;
   size_t        c_match    = 0;
 
+  if (!frame_may_contain(fdata, info))
+    return MR_NOTMATCHED;
+
   /* Load the frame's data. */
   if (!cf_read_frame(cf, fdata)) {
     /* Attempt to get the packet failed. */
     return MR_ERROR;
   }
+  index_frame_data(cf, fdata);
 
   result = MR_NOTMATCHED;
   buf_len = fdata->cap_len;
@@ -3200,11 +3374,15 @@ match_ascii(capture_file *cf, frame_data *fdata, void *criterion)
   guint8        c_char;
   size_t        c_match    = 0;
 
+  if (!frame_may_contain(fdata, info))
+    return MR_NOTMATCHED;
+
   /* Load the frame's data. */
   if (!cf_read_frame(cf, fdata)) {
     /* Attempt to get the packet failed. */
     return MR_ERROR;
   }
+  index_frame_data(cf, fdata);
 
   result = MR_NOTMATCHED;
   buf_len = fdata->cap_len;
@@ -3250,6 +3428,7 @@ match_unicode(capture_file *cf, frame_data *fdata, void *criterion)
     /* Attempt to get the packet failed. */
     return MR_ERROR;
   }
+  index_frame_data(cf, fdata);
 
   result = MR_NOTMATCHED;
   buf_len = fdata->cap_len;
@@ -3289,11 +3468,15 @@ match_binary(capture_file *cf, frame_data *fdata, void *criterion)
   guint32       i;
   size_t        c_match     = 0;
 
+  if (!frame_may_contain(fdata, info))
+    return MR_NOTMATCHED;
+
   /* Load the frame's data. */
   if (!cf_read_frame(cf, fdata)) {
     /* Attempt to get the packet failed. */
     return MR_ERROR;
   }
+  index_frame_data(cf, fdata);
 
   result = MR_NOTMATCHED;
   buf_len = fdata->cap_len;
@@ -3750,6 +3933,7 @@ cf_mark_frame(capture_file *cf, frame_data *frame)
 {
   if (! frame->flags.marked) {
     frame->flags.marked = TRUE;
+    cf_invalidate_filter_results(cf);
     if (cf->count > cf->marked_count)
       cf->marked_count++;
   }
@@ -3763,6 +3947,7 @@ cf_unmark_frame(capture_file *cf, frame_data *frame)
 {
   if (frame->flags.marked) {
     frame->flags.marked = FALSE;
+    cf_invalidate_filter_results(cf);
     if (cf->marked_count > 0)
       cf->marked_count--;
   }
@@ -3776,6 +3961,7 @@ cf_ignore_frame(capture_file *cf, frame_data *frame)
 {
   if (! frame->flags.ignored) {
     frame->flags.ignored = TRUE;
+    cf_invalidate_filter_results(cf);
     if (cf->count > cf->ignored_count)
       cf->ignored_count++;
   }
@@ -3789,6 +3975,7 @@ cf_unignore_frame(capture_file *cf, frame_data *frame)
 {
   if (frame->flags.ignored) {
     frame->flags.ignored = FALSE;
+    cf_invalidate_filter_results(cf);
     if (cf->ignored_count > 0)
       cf->ignored_count--;
   }
@@ -3855,6 +4042,9 @@ cf_update_packet_comment(capture_file *cf, frame_data *fdata, gchar *comment)
     cf->packet_comment_count++;
   }
 
+  /* Filters can test the comments. */
+  cf_invalidate_filter_results(cf);
+
   /* OK, we have unsaved changes. */
   cf->unsaved_changes = TRUE;
 }
@@ -364,6 +364,14 @@ cf_status_t cf_filter_packets(capture_file *cf, gchar *dfilter, gboolean force);
  */
 void cf_reftime_packets(capture_file *cf);
 
+/**
+ * Forget which packets passed the display filters used so far, because
+ * something that a filter can test has changed.
+ *
+ * @param cf the capture file
+ */
+void cf_invalidate_filter_results(capture_file *cf);
+
 /**
  * Return the time it took to load the file
  */
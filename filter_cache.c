@@ -0,0 +1,555 @@
+/* filter_cache.c
+ * Remembers which frames passed recently used display filters
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+
+#include "filter_cache.h"
+
+/*
+ * Refiltering a large file means reading and dissecting every frame
+ * again, even if the new filter only narrows down the previous one or
+ * is one that was used a moment ago. We keep, for the last few filters,
+ * a bitmap of the frames that passed and of the frames that displayed
+ * frames depend on, keyed by the filter text with its whitespace,
+ * redundant parentheses and top-level "and"/"or" spellings normalized.
+ *
+ * In the display filter grammar "or" binds more tightly than "and", so
+ * a filter is a conjunction of terms, each of which may be a disjunction:
+ *
+ *  - if the whole filter has been seen, nothing has to be dissected;
+ *  - if it is a single conjunction term whose "||" alternatives have all
+ *    been seen, the result is the union of theirs, and as a frame's
+ *    dependencies don't depend on the filter, so are the dependencies;
+ *  - otherwise, if some of its "&&" terms have been seen, only frames
+ *    that passed all of those can pass, so only those are dissected.
+ *    This covers refining the previous filter with "&& ...".
+ */
+
+#define FILTER_CACHE_MAX_RESULTS 16
+
+/*
+ * Fields whose values come from something other than the frames, and can
+ * change without the cache hearing about it; filters testing them aren't
+ * remembered. The coloring rules are edited in the GUI and applied without
+ * a refilter.
+ */
+static const char *uncacheable_fields[] = {
+  "frame.coloring_rule.",
+  NULL
+};
+
+typedef struct {
+  gchar   *key;           /* normalized filter text */
+  guint32  count;         /* number of frames covered */
+  guint8  *passed;        /* bitmap of frames that passed */
+  guint8  *dependent;     /* bitmap of frames displayed frames depend on */
+} filter_result_t;
+
+struct _filter_cache {
+  GQueue  *results;       /* most recently used first */
+};
+
+struct _filter_plan {
+  guint32  count;         /* number of frames covered */
+  guint8  *passed;        /* complete result, if known */
+  guint8  *dependent;
+  guint8  *candidates;    /* otherwise, frames that may pass */
+};
+
+#define BITMAP_BYTES(count)       (((count) + 7) / 8)
+/* Frame numbers start at 1 */
+#define BITMAP_TEST(bm, num)      ((bm)[((num) - 1) >> 3] & (1 << (((num) - 1) & 7)))
+#define BITMAP_SET(bm, num)       ((bm)[((num) - 1) >> 3] |= (1 << (((num) - 1) & 7)))
+
+static gboolean
+is_filter_word_char(char c)
+{
+  return g_ascii_isalnum(c) || c == '_' || c == '.' || c == '-';
+}
+
+/*
+ * If there's a top-level "&&"/"and" (or "||"/"or") operator at "p",
+ * return its length.
+ */
+static size_t
+filter_operator_len(const char *text, const char *p, gboolean conjunction)
+{
+  const char *symbol = conjunction ? "&&" : "||";
+  const char *word = conjunction ? "and" : "or";
+  size_t word_len = strlen(word);
+
+  if (strncmp(p, symbol, 2) == 0)
+    return 2;
+  if (strncmp(p, word, word_len) == 0 &&
+      (p == text || !is_filter_word_char(p[-1])) &&
+      !is_filter_word_char(p[word_len]))
+    return word_len;
+  return 0;
+}
+
+/*
+ * Split a filter at its top-level "&&" (conjunction) or "||" operators,
+ * i.e. outside parentheses, brackets and quoted strings.
+ */
+static GPtrArray *
+filter_split_top(const char *text, gboolean conjunction)
+{
+  GPtrArray  *parts = g_ptr_array_new();
+  const char *start = text;
+  const char *p;
+  int         depth = 0;
+  gboolean    in_string = FALSE;
+  size_t      op_len;
+
+  for (p = text; *p != '\0'; p++) {
+    if (in_string) {
+      if (*p == '\\' && p[1] != '\0')
+        p++;
+      else if (*p == '"')
+        in_string = FALSE;
+      continue;
+    }
+    switch (*p) {
+    case '"':
+      in_string = TRUE;
+      break;
+    case '(':
+    case '[':
+      depth++;
+      break;
+    case ')':
+    case ']':
+      depth--;
+      break;
+    default:
+      if (depth == 0 && (op_len = filter_operator_len(text, p, conjunction)) != 0) {
+        g_ptr_array_add(parts, g_strndup(start, p - start));
+        p += op_len - 1;
+        start = p + 1;
+      }
+      break;
+    }
+  }
+  g_ptr_array_add(parts, g_strdup(start));
+  return parts;
+}
+
+static void
+filter_free_parts(GPtrArray *parts)
+{
+  guint i;
+
+  for (i = 0; i < parts->len; i++)
+    g_free(g_ptr_array_index(parts, i));
+  g_ptr_array_free(parts, TRUE);
+}
+
+/* Does the parenthesis at "text" match the one at the end of the text? */
+static gboolean
+filter_is_wrapped(const char *text)
+{
+  size_t      len = strlen(text);
+  const char *p;
+  int         depth = 0;
+  gboolean    in_string = FALSE;
+
+  if (len < 2 || text[0] != '(' || text[len - 1] != ')')
+    return FALSE;
+
+  for (p = text; p < text + len - 1; p++) {
+    if (in_string) {
+      if (*p == '\\' && p[1] != '\0')
+        p++;
+      else if (*p == '"')
+        in_string = FALSE;
+      continue;
+    }
+    if (*p == '"')
+      in_string = TRUE;
+    else if (*p == '(')
+      depth++;
+    else if (*p == ')' && --depth == 0)
+      return FALSE;   /* closed before the end */
+  }
+  return TRUE;
+}
+
+/*
+ * Collapse runs of white space outside quoted strings, and strip leading
+ * and trailing white space and parentheses around the whole filter.
+ */
+static gchar *
+filter_squeeze(const char *text)
+{
+  GString    *out = g_string_new("");
+  const char *p;
+  gboolean    in_string = FALSE;
+  gboolean    space = FALSE;
+  gchar      *squeezed;
+
+  for (p = text; *p != '\0'; p++) {
+    if (in_string) {
+      g_string_append_c(out, *p);
+      if (*p == '\\' && p[1] != '\0')
+        g_string_append_c(out, *++p);
+      else if (*p == '"')
+        in_string = FALSE;
+      continue;
+    }
+    if (g_ascii_isspace(*p)) {
+      space = TRUE;
+      continue;
+    }
+    if (space && out->len > 0)
+      g_string_append_c(out, ' ');
+    space = FALSE;
+    g_string_append_c(out, *p);
+    if (*p == '"')
+      in_string = TRUE;
+  }
+
+  squeezed = g_string_free(out, FALSE);
+  while (filter_is_wrapped(squeezed)) {
+    gchar *inner = g_strndup(squeezed + 1, strlen(squeezed) - 2);
+
+    g_free(squeezed);
+    squeezed = filter_squeeze(inner);
+    g_free(inner);
+  }
+  return squeezed;
+}
+
+/* Add the top-level "&&" (or "||") terms of a filter, flattened, to "terms" */
+static void
+filter_add_terms(const char *text, gboolean conjunction, GPtrArray *terms)
+{
+  gchar     *squeezed = filter_squeeze(text);
+  GPtrArray *parts = filter_split_top(squeezed, conjunction);
+  guint      i;
+
+  if (parts->len == 1) {
+    g_ptr_array_add(terms, squeezed);
+  } else {
+    for (i = 0; i < parts->len; i++)
+      filter_add_terms(g_ptr_array_index(parts, i), conjunction, terms);
+    g_free(squeezed);
+  }
+  filter_free_parts(parts);
+}
+
+static GPtrArray *
+filter_terms(const char *text, gboolean conjunction)
+{
+  GPtrArray *terms = g_ptr_array_new();
+
+  filter_add_terms(text, conjunction, terms);
+  return terms;
+}
+
+static gchar *
+filter_key(const char *text)
+{
+  GString   *key = g_string_new("");
+  GPtrArray *conjuncts, *disjuncts, *inner;
+  const gchar *term;
+  guint      i, j;
+
+  conjuncts = filter_terms(text, TRUE);
+  for (i = 0; i < conjuncts->len; i++) {
+    if (i > 0)
+      g_string_append(key, " && ");
+    disjuncts = filter_terms(g_ptr_array_index(conjuncts, i), FALSE);
+    for (j = 0; j < disjuncts->len; j++) {
+      term = g_ptr_array_index(disjuncts, j);
+      if (j > 0)
+        g_string_append(key, " || ");
+      /* "&&" binds less tightly than "||", so keep it grouped */
+      inner = filter_split_top(term, TRUE);
+      if (disjuncts->len > 1 && inner->len > 1)
+        g_string_append_printf(key, "(%s)", term);
+      else
+        g_string_append(key, term);
+      filter_free_parts(inner);
+    }
+    filter_free_parts(disjuncts);
+  }
+  filter_free_parts(conjuncts);
+
+  return g_string_free(key, FALSE);
+}
+
+static gboolean
+filter_is_cacheable(const char *text)
+{
+  const char **field;
+
+  for (field = uncacheable_fields; *field != NULL; field++) {
+    if (strstr(text, *field) != NULL)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static void
+filter_result_free(filter_result_t *result)
+{
+  g_free(result->key);
+  g_free(result->passed);
+  g_free(result->dependent);
+  g_free(result);
+}
+
+filter_cache_t *
+filter_cache_new(void)
+{
+  filter_cache_t *fc;
+
+  fc = g_malloc(sizeof *fc);
+  fc->results = g_queue_new();
+  return fc;
+}
+
+void
+filter_cache_clear(filter_cache_t *fc)
+{
+  filter_result_t *result;
+
+  while ((result = g_queue_pop_head(fc->results)) != NULL)
+    filter_result_free(result);
+}
+
+void
+filter_cache_free(filter_cache_t *fc)
+{
+  filter_cache_clear(fc);
+  g_queue_free(fc->results);
+  g_free(fc);
+}
+
+/* Find the result for a filter and make it the most recently used one */
+static filter_result_t *
+filter_cache_find(filter_cache_t *fc, const char *key)
+{
+  GList *link;
+
+  for (link = fc->results->head; link != NULL; link = link->next) {
+    filter_result_t *result = link->data;
+
+    if (strcmp(result->key, key) == 0) {
+      g_queue_unlink(fc->results, link);
+      g_queue_push_head_link(fc->results, link);
+      return result;
+    }
+  }
+  return NULL;
+}
+
+void
+filter_cache_store(filter_cache_t *fc, const char *dftext,
+                   frame_data_sequence *frames, guint32 count)
+{
+  filter_result_t *result;
+  frame_data      *fdata;
+  gchar           *key;
+  guint32          framenum;
+
+  if (dftext == NULL || count == 0 || !filter_is_cacheable(dftext))
+    return;
+
+  key = filter_key(dftext);
+  result = filter_cache_find(fc, key);
+  if (result != NULL) {
+    g_free(key);
+    g_free(result->passed);
+    g_free(result->dependent);
+  } else {
+    result = g_malloc(sizeof *result);
+    result->key = key;
+    g_queue_push_head(fc->results, result);
+    if (g_queue_get_length(fc->results) > FILTER_CACHE_MAX_RESULTS)
+      filter_result_free(g_queue_pop_tail(fc->results));
+  }
+
+  result->count = count;
+  result->passed = g_malloc0(BITMAP_BYTES(count));
+  result->dependent = g_malloc0(BITMAP_BYTES(count));
+  for (framenum = 1; framenum <= count; framenum++) {
+    fdata = frame_data_sequence_find(frames, framenum);
+    if (fdata->flags.passed_dfilter)
+      BITMAP_SET(result->passed, framenum);
+    if (fdata->flags.dependent_of_displayed)
+      BITMAP_SET(result->dependent, framenum);
+  }
+}
+
+/* Combine a cached result into a plan's bitmap */
+static void
+filter_plan_merge(guint8 **bitmap, const guint8 *from, guint32 count, gboolean intersect)
+{
+  guint32 i;
+
+  if (*bitmap == NULL) {
+    *bitmap = g_memdup(from, BITMAP_BYTES(count));
+    return;
+  }
+  for (i = 0; i < BITMAP_BYTES(count); i++) {
+    if (intersect)
+      (*bitmap)[i] &= from[i];
+    else
+      (*bitmap)[i] |= from[i];
+  }
+}
+
+filter_plan_t *
+filter_cache_plan(filter_cache_t *fc, const char *dftext, guint32 count)
+{
+  filter_plan_t   *plan;
+  filter_result_t *result;
+  GPtrArray       *conjuncts, *disjuncts;
+  gchar           *key;
+  guint32          covered;
+  guint            i;
+
+  if (count == 0)
+    return NULL;
+
+  plan = g_malloc0(sizeof *plan);
+
+  if (dftext == NULL) {
+    plan->count = count;
+    plan->passed = g_malloc(BITMAP_BYTES(count));
+    memset(plan->passed, 0xff, BITMAP_BYTES(count));
+    plan->dependent = g_malloc0(BITMAP_BYTES(count));
+    return plan;
+  }
+
+  key = filter_key(dftext);
+  result = filter_cache_find(fc, key);
+  g_free(key);
+  if (result != NULL) {
+    plan->count = MIN(count, result->count);
+    plan->passed = g_memdup(result->passed, BITMAP_BYTES(plan->count));
+    plan->dependent = g_memdup(result->dependent, BITMAP_BYTES(plan->count));
+    return plan;
+  }
+
+  conjuncts = filter_terms(dftext, TRUE);
+
+  /* An "||" of filters we've all seen */
+  if (conjuncts->len == 1) {
+    disjuncts = filter_terms(g_ptr_array_index(conjuncts, 0), FALSE);
+    covered = count;
+    for (i = 0; i < disjuncts->len; i++) {
+      key = filter_key(g_ptr_array_index(disjuncts, i));
+      result = filter_cache_find(fc, key);
+      g_free(key);
+      if (result == NULL || disjuncts->len == 1)
+        break;
+      covered = MIN(covered, result->count);
+    }
+    if (i == disjuncts->len) {
+      plan->count = covered;
+      for (i = 0; i < disjuncts->len; i++) {
+        key = filter_key(g_ptr_array_index(disjuncts, i));
+        result = filter_cache_find(fc, key);
+        g_free(key);
+        filter_plan_merge(&plan->passed, result->passed, covered, FALSE);
+        filter_plan_merge(&plan->dependent, result->dependent, covered, FALSE);
+      }
+    }
+    filter_free_parts(disjuncts);
+    if (plan->passed != NULL) {
+      filter_free_parts(conjuncts);
+      return plan;
+    }
+  }
+
+  /* An "&&" with some terms we've seen */
+  covered = count;
+  for (i = 0; i < conjuncts->len; i++) {
+    key = filter_key(g_ptr_array_index(conjuncts, i));
+    result = filter_cache_find(fc, key);
+    g_free(key);
+    if (result != NULL && conjuncts->len > 1)
+      covered = MIN(covered, result->count);
+  }
+  for (i = 0; i < conjuncts->len && conjuncts->len > 1; i++) {
+    key = filter_key(g_ptr_array_index(conjuncts, i));
+    result = filter_cache_find(fc, key);
+    g_free(key);
+    if (result != NULL)
+      filter_plan_merge(&plan->candidates, result->passed, covered, TRUE);
+  }
+  filter_free_parts(conjuncts);
+
+  if (plan->candidates == NULL) {
+    g_free(plan);
+    return NULL;
+  }
+  plan->count = covered;
+  return plan;
+}
+
+gboolean
+filter_plan_lookup(const filter_plan_t *plan, guint32 framenum,
+                   gboolean *passed, gboolean *dependent)
+{
+  if (framenum == 0 || framenum > plan->count)
+    return FALSE;
+
+  if (plan->passed != NULL) {
+    *passed = BITMAP_TEST(plan->passed, framenum) ? TRUE : FALSE;
+    *dependent = BITMAP_TEST(plan->dependent, framenum) ? TRUE : FALSE;
+    return TRUE;
+  }
+
+  if (!BITMAP_TEST(plan->candidates, framenum)) {
+    /* Frames after this one may still find that they depend on it. */
+    *passed = FALSE;
+    *dependent = FALSE;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+gboolean
+filter_plan_is_complete(const filter_plan_t *plan, guint32 count)
+{
+  return plan->passed != NULL && plan->count >= count;
+}
+
+void
+filter_plan_free(filter_plan_t *plan)
+{
+  g_free(plan->passed);
+  g_free(plan->dependent);
+  g_free(plan->candidates);
+  g_free(plan);
+}
@@ -0,0 +1,77 @@
+/* filter_cache.h
+ * Remembers which frames passed recently used display filters
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __FILTER_CACHE_H__
+#define __FILTER_CACHE_H__
+
+#include "frame_data_sequence.h"
+
+typedef struct _filter_cache filter_cache_t;
+typedef struct _filter_plan filter_plan_t;
+
+extern filter_cache_t *filter_cache_new(void);
+
+extern void filter_cache_free(filter_cache_t *fc);
+
+/*
+ * Forget all the results, e.g. because something that a filter can test
+ * (marks, time stamps, comments, ...) has changed.
+ */
+extern void filter_cache_clear(filter_cache_t *fc);
+
+/*
+ * Remember which of the first "count" frames passed the filter and which
+ * ones displayed frames depend on, as left in their flags by a complete
+ * pass over the frames. Filters that test the coloring rules aren't
+ * remembered, as the rules can change without a refilter.
+ */
+extern void filter_cache_store(filter_cache_t *fc, const char *dftext,
+    frame_data_sequence *frames, guint32 count);
+
+/*
+ * Work out what the cache already knows about a filter: either the
+ * complete result (the filter, or each of its "||" alternatives, has been
+ * seen before), or the set of frames that can still pass (some of its
+ * "&&" terms have been seen before). Returns NULL if it knows nothing.
+ * A NULL filter passes every frame.
+ */
+extern filter_plan_t *filter_cache_plan(filter_cache_t *fc, const char *dftext,
+    guint32 count);
+
+/*
+ * Returns TRUE, and sets "passed" and "dependent", if the frame doesn't
+ * have to be dissected to find out whether it passes the filter.
+ */
+extern gboolean filter_plan_lookup(const filter_plan_t *plan, guint32 framenum,
+    gboolean *passed, gboolean *dependent);
+
+/*
+ * Returns TRUE if the plan has the complete result for the first "count"
+ * frames, so that none of them has to be read.
+ */
+extern gboolean filter_plan_is_complete(const filter_plan_t *plan, guint32 count);
+
+extern void filter_plan_free(filter_plan_t *plan);
+
+#endif /* __FILTER_CACHE_H__ */
@@ -0,0 +1,243 @@
+/* frame_readahead.c
+ * Reads frames ahead of their dissection on a separate thread
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+
+#include <wiretap/wtap.h>
+
+#include "frame_readahead.h"
+
+/*
+ * Going through all the frames again, to refilter or retap them, reads
+ * each one with a seek and a read, and for a compressed file that means
+ * decompressing it, before it can be dissected.  The dissection itself
+ * has to stay on the main thread, but the reading doesn't: a thread with
+ * its own wtap reads the frames, in order, into a ring of slots, which
+ * are handed over through one queue and handed back through another.
+ */
+
+#define FRAME_READAHEAD_SLOTS 256
+
+typedef struct {
+  guint32            framenum;    /* 0 marks the end of the frames */
+  gboolean           ok;
+  struct wtap_pkthdr phdr;
+  guint8            *pd;
+  guint32            pd_size;
+} frame_readahead_slot_t;
+
+struct _frame_readahead {
+  wtap                      *wth;
+  frame_data_sequence       *frames;
+  guint32                    count;
+  frame_readahead_wanted_cb  wanted;
+  gpointer                   wanted_data;
+  volatile gint              stop;
+  GThreadPool               *pool;
+  GAsyncQueue               *free_slots;
+  GAsyncQueue               *read_slots;
+  frame_readahead_slot_t    *slots;
+  frame_readahead_slot_t    *pending;   /* read, but not asked for yet */
+  gboolean                   done;      /* seen the end */
+};
+
+static void
+frame_readahead_read_slot(frame_readahead_t *fra, frame_readahead_slot_t *slot,
+                          frame_data *fdata)
+{
+  int    err;
+  gchar *err_info = NULL;
+
+  slot->framenum = fdata->num;
+  slot->ok = FALSE;
+
+  /* Edited frames aren't in the file. */
+  if (fdata->file_off == -1)
+    return;
+
+  if (slot->pd_size < fdata->cap_len) {
+    g_free(slot->pd);
+    slot->pd = g_try_malloc(fdata->cap_len);
+    slot->pd_size = slot->pd != NULL ? fdata->cap_len : 0;
+    if (slot->pd == NULL)
+      return;
+  }
+
+  if (wtap_seek_read(fra->wth, fdata->file_off, &slot->phdr, slot->pd,
+                     fdata->cap_len, &err, &err_info)) {
+    /* It points into our wtap, and isn't used after the first pass. */
+    slot->phdr.opt_comment = NULL;
+    slot->ok = TRUE;
+  } else {
+    /* The main thread will read it again and report the error. */
+    g_free(err_info);
+  }
+}
+
+static void
+frame_readahead_thread(gpointer data, gpointer user_data _U_)
+{
+  frame_readahead_t      *fra = data;
+  frame_readahead_slot_t *slot;
+  frame_data             *fdata;
+  guint32                 framenum;
+
+  for (framenum = 1; framenum <= fra->count; framenum++) {
+    if (g_atomic_int_get(&fra->stop))
+      break;
+
+    fdata = frame_data_sequence_find(fra->frames, framenum);
+    if (fra->wanted != NULL && !fra->wanted(fdata, fra->wanted_data))
+      continue;
+
+    slot = g_async_queue_pop(fra->free_slots);
+    frame_readahead_read_slot(fra, slot, fdata);
+    g_async_queue_push(fra->read_slots, slot);
+  }
+
+  /* Always hand over the end marker, even if told to stop. */
+  slot = g_async_queue_pop(fra->free_slots);
+  slot->framenum = 0;
+  g_async_queue_push(fra->read_slots, slot);
+}
+
+frame_readahead_t *
+frame_readahead_new(const char *filename, frame_data_sequence *frames,
+                    guint32 count, frame_readahead_wanted_cb wanted,
+                    gpointer wanted_data)
+{
+  frame_readahead_t *fra;
+  wtap              *wth;
+  int                err;
+  gchar             *err_info = NULL;
+  int                i;
+
+#if !GLIB_CHECK_VERSION(2,31,0)
+  if (!g_thread_supported())
+    return NULL;
+#endif
+  if (filename == NULL || count == 0)
+    return NULL;
+
+  wth = wtap_open_offline(filename, &err, &err_info, TRUE);
+  if (wth == NULL) {
+    g_free(err_info);
+    return NULL;
+  }
+
+  fra = g_malloc0(sizeof *fra);
+  fra->wth = wth;
+  fra->frames = frames;
+  fra->count = count;
+  fra->wanted = wanted;
+  fra->wanted_data = wanted_data;
+  fra->free_slots = g_async_queue_new();
+  fra->read_slots = g_async_queue_new();
+  fra->slots = g_new0(frame_readahead_slot_t, FRAME_READAHEAD_SLOTS);
+  for (i = 0; i < FRAME_READAHEAD_SLOTS; i++)
+    g_async_queue_push(fra->free_slots, &fra->slots[i]);
+
+  fra->pool = g_thread_pool_new(frame_readahead_thread, NULL, 1, TRUE, NULL);
+  if (fra->pool == NULL) {
+    g_async_queue_unref(fra->free_slots);
+    g_async_queue_unref(fra->read_slots);
+    g_free(fra->slots);
+    wtap_close(fra->wth);
+    g_free(fra);
+    return NULL;
+  }
+  g_thread_pool_push(fra->pool, fra, NULL);
+
+  return fra;
+}
+
+gboolean
+frame_readahead_get(frame_readahead_t *fra, frame_data *fdata,
+                    struct wtap_pkthdr *phdr, guint8 *pd)
+{
+  frame_readahead_slot_t *slot;
+  gboolean                ok;
+
+  while (!fra->done) {
+    if (fra->pending == NULL)
+      fra->pending = g_async_queue_pop(fra->read_slots);
+    slot = fra->pending;
+
+    if (slot->framenum == 0) {
+      fra->done = TRUE;
+      break;
+    }
+    if (slot->framenum > fdata->num) {
+      /* This one was skipped; keep the slot for a later frame. */
+      return FALSE;
+    }
+
+    fra->pending = NULL;
+    if (slot->framenum == fdata->num) {
+      ok = slot->ok;
+      if (ok) {
+        *phdr = slot->phdr;
+        memcpy(pd, slot->pd, fdata->cap_len);
+      }
+      g_async_queue_push(fra->free_slots, slot);
+      return ok;
+    }
+
+    /* A frame the caller didn't ask for after all. */
+    g_async_queue_push(fra->free_slots, slot);
+  }
+  return FALSE;
+}
+
+void
+frame_readahead_free(frame_readahead_t *fra)
+{
+  frame_readahead_slot_t *slot;
+  int                     i;
+
+  /* Tell the thread to stop, and keep giving it slots until it has. */
+  g_atomic_int_set(&fra->stop, 1);
+  while (!fra->done) {
+    slot = fra->pending != NULL ? fra->pending : g_async_queue_pop(fra->read_slots);
+    fra->pending = NULL;
+    if (slot->framenum == 0)
+      fra->done = TRUE;
+    g_async_queue_push(fra->free_slots, slot);
+  }
+  g_thread_pool_free(fra->pool, FALSE, TRUE);
+
+  for (i = 0; i < FRAME_READAHEAD_SLOTS; i++)
+    g_free(fra->slots[i].pd);
+  g_free(fra->slots);
+  g_async_queue_unref(fra->free_slots);
+  g_async_queue_unref(fra->read_slots);
+  wtap_close(fra->wth);
+  g_free(fra);
+}
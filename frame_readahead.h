@@ -0,0 +1,60 @@
+/* frame_readahead.h
+ * Reads frames ahead of their dissection on a separate thread
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __FRAME_READAHEAD_H__
+#define __FRAME_READAHEAD_H__
+
+#include "frame_data_sequence.h"
+
+typedef struct _frame_readahead frame_readahead_t;
+
+/*
+ * Called on the reading thread to ask whether a frame will be wanted;
+ * it may only look at things that don't change while the frames are
+ * being gone through.
+ */
+typedef gboolean (*frame_readahead_wanted_cb)(frame_data *fdata, gpointer data);
+
+/*
+ * Start reading frames 1 to "count" of the file, in order, on a thread
+ * of its own, skipping those for which "wanted" (if not NULL) returns
+ * FALSE.  Returns NULL if that can't be done, in which case the frames
+ * should just be read with cf_read_frame().
+ */
+extern frame_readahead_t *frame_readahead_new(const char *filename,
+    frame_data_sequence *frames, guint32 count,
+    frame_readahead_wanted_cb wanted, gpointer wanted_data);
+
+/*
+ * Get the data of a frame, which must come after the frames asked for
+ * before.  Returns FALSE if it wasn't read ahead, or reading it failed;
+ * the caller should then read it itself, which also reports any error.
+ */
+extern gboolean frame_readahead_get(frame_readahead_t *fra, frame_data *fdata,
+    struct wtap_pkthdr *phdr, guint8 *pd);
+
+/* Stop the reading thread, if it's still going, and free everything */
+extern void frame_readahead_free(frame_readahead_t *fra);
+
+#endif /* __FRAME_READAHEAD_H__ */
@@ -0,0 +1,373 @@
+/* ngram_index.c
+ * Remembers which byte trigrams occur in each frame, to speed up
+ * "Find Packet" searches of the packet data
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+
+#include "ngram_index.h"
+
+/*
+ * Searching the packet data for a string means reading every frame from
+ * the file again.  Each time a search reads a frame, its trigrams (three
+ * byte sequences) are hashed into a bit signature for the frame, and a
+ * later search only reads the frames whose signatures have the bits for
+ * all the trigrams of the string it's looking for.
+ *
+ * The signatures are built from the data with the NUL bytes left out and
+ * the ASCII letters upper-cased, so that the same signature serves the
+ * ASCII, "ASCII and Unicode" and hex searches, case sensitive or not.
+ * Bytes with the high bit set are all treated as one, as we don't know
+ * what the locale's upper-casing does with them.  A signature has about
+ * one bit per byte of data, i.e. the index takes about an eighth as much
+ * memory as the data it has seen.  Once it has reached its maximum size,
+ * no more frames are added; those that aren't in it are always read.
+ */
+
+#define NGRAM_MIN_SHIFT      6     /* 64 bits */
+#define NGRAM_MAX_SHIFT      14    /* 16384 bits */
+#define NGRAM_QUERY_MAX      64    /* more trigrams hardly narrow it down */
+
+#define NGRAM_INDEX_MAGIC    0x57534e47  /* "WSNG" */
+#define NGRAM_INDEX_VERSION  1
+#define NGRAM_INDEX_SUFFIX   ".ngidx"
+
+struct _ngram_index {
+  GArray     *offsets;   /* per frame number, 1 + offset of its signature, or 0 */
+  GByteArray *sigs;      /* per frame, log2 of the signature size, then the bits */
+  guint64     max_size;  /* most bytes the two may take */
+  gboolean    changed;
+};
+
+struct _ngram_query {
+  guint   count;
+  guint32 trigrams[NGRAM_QUERY_MAX];
+};
+
+/* What's written to the file, followed by "frames" offsets and the signatures. */
+typedef struct {
+  guint32 magic;
+  guint32 version;
+  gint64  capture_size;
+  gint64  capture_mtime;
+  guint32 frames;
+  guint32 sigs_len;
+} ngram_index_hdr_t;
+
+static guint64
+ngram_index_size(const ngram_index_t *idx)
+{
+  return (guint64)idx->offsets->len * sizeof (guint32) + idx->sigs->len;
+}
+
+static guint8
+ngram_fold(guint8 c)
+{
+  return (c & 0x80) ? 0x80 : g_ascii_toupper(c);
+}
+
+static guint
+ngram_sig_shift(guint32 len)
+{
+  guint shift = NGRAM_MIN_SHIFT;
+
+  while (shift < NGRAM_MAX_SHIFT && (1U << shift) < len)
+    shift++;
+  return shift;
+}
+
+static guint32
+ngram_bit(guint32 trigram, guint shift)
+{
+  return (trigram * 2654435761U) >> (32 - shift);
+}
+
+ngram_index_t *
+ngram_index_new(guint64 max_size)
+{
+  ngram_index_t *idx;
+
+  idx = g_new0(ngram_index_t, 1);
+  idx->offsets = g_array_new(FALSE, TRUE, sizeof (guint32));
+  idx->sigs = g_byte_array_new();
+  idx->max_size = max_size;
+  return idx;
+}
+
+void
+ngram_index_free(ngram_index_t *idx)
+{
+  g_array_free(idx->offsets, TRUE);
+  g_byte_array_free(idx->sigs, TRUE);
+  g_free(idx);
+}
+
+void
+ngram_index_add(ngram_index_t *idx, guint32 framenum, const guint8 *pd,
+                guint32 len)
+{
+  guint    shift;
+  guint32  sig_len;
+  guint64  grow;
+  guint32  offset;
+  guint8  *sig;
+  guint32  trigram = 0;
+  guint32  bit;
+  guint32  i, n = 0;
+
+  if (framenum < idx->offsets->len &&
+      g_array_index(idx->offsets, guint32, framenum) != 0)
+    return;
+
+  shift = ngram_sig_shift(len);
+  sig_len = 1 + (1U << shift) / 8;
+  offset = idx->sigs->len;
+  grow = sig_len;
+  if (framenum >= idx->offsets->len)
+    grow += (guint64)(framenum + 1 - idx->offsets->len) * sizeof (guint32);
+  if ((guint64)offset + sig_len >= G_MAXUINT32 ||
+      ngram_index_size(idx) + grow > idx->max_size)
+    return;   /* full; the frames that don't fit are just always read */
+
+  g_byte_array_set_size(idx->sigs, offset + sig_len);
+  sig = idx->sigs->data + offset;
+  memset(sig, 0, sig_len);
+  *sig++ = (guint8)shift;
+
+  for (i = 0; i < len; i++) {
+    if (pd[i] == '\0')
+      continue;
+    trigram = ((trigram << 8) | ngram_fold(pd[i])) & 0xffffff;
+    if (++n >= 3) {
+      bit = ngram_bit(trigram, shift);
+      sig[bit >> 3] |= 1 << (bit & 7);
+    }
+  }
+
+  if (framenum >= idx->offsets->len)
+    g_array_set_size(idx->offsets, framenum + 1);
+  g_array_index(idx->offsets, guint32, framenum) = offset + 1;
+  idx->changed = TRUE;
+}
+
+gboolean
+ngram_index_may_match(const ngram_index_t *idx, const ngram_query_t *query,
+                      guint32 framenum)
+{
+  guint32       offset;
+  const guint8 *sig;
+  guint         shift;
+  guint32       bit;
+  guint         i;
+
+  if (framenum >= idx->offsets->len)
+    return TRUE;
+  offset = g_array_index(idx->offsets, guint32, framenum);
+  if (offset == 0)
+    return TRUE;
+
+  sig = idx->sigs->data + offset - 1;
+  shift = *sig++;
+  for (i = 0; i < query->count; i++) {
+    bit = ngram_bit(query->trigrams[i], shift);
+    if (!(sig[bit >> 3] & (1 << (bit & 7))))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+gboolean
+ngram_index_changed(const ngram_index_t *idx)
+{
+  return idx->changed;
+}
+
+ngram_query_t *
+ngram_query_new(const guint8 *data, size_t len, gboolean nocase)
+{
+  ngram_query_t *query;
+  guint32        trigram = 0;
+  size_t         i;
+  guint          n = 0;
+  guint          j;
+
+  query = g_new0(ngram_query_t, 1);
+  for (i = 0; i < len && query->count < NGRAM_QUERY_MAX; i++) {
+    /*
+     * A NUL byte isn't in the signatures, so the trigrams can't span one.
+     * In a case insensitive search, a byte with the high bit set may be
+     * what the locale upper-cases an ASCII letter to, so leave those out
+     * as well.
+     */
+    if (data[i] == '\0' || (nocase && (data[i] & 0x80))) {
+      n = 0;
+      continue;
+    }
+    trigram = ((trigram << 8) | ngram_fold(data[i])) & 0xffffff;
+    if (++n < 3)
+      continue;
+
+    for (j = 0; j < query->count; j++) {
+      if (query->trigrams[j] == trigram)
+        break;
+    }
+    if (j == query->count)
+      query->trigrams[query->count++] = trigram;
+  }
+
+  if (query->count == 0) {
+    g_free(query);
+    return NULL;
+  }
+  return query;
+}
+
+void
+ngram_query_free(ngram_query_t *query)
+{
+  g_free(query);
+}
+
+static gchar *
+ngram_index_path(const char *capture_filename)
+{
+  return g_strconcat(capture_filename, NGRAM_INDEX_SUFFIX, NULL);
+}
+
+/* Does every frame's signature lie within the signatures read? */
+static gboolean
+ngram_index_check(const ngram_index_t *idx)
+{
+  guint32 i;
+  guint32 offset;
+  guint   shift;
+
+  for (i = 0; i < idx->offsets->len; i++) {
+    offset = g_array_index(idx->offsets, guint32, i);
+    if (offset == 0)
+      continue;
+    if (offset > idx->sigs->len)
+      return FALSE;
+    shift = idx->sigs->data[offset - 1];
+    if (shift < NGRAM_MIN_SHIFT || shift > NGRAM_MAX_SHIFT ||
+        (guint64)offset + (1U << shift) / 8 > idx->sigs->len)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+gboolean
+ngram_index_load(ngram_index_t *idx, const char *capture_filename)
+{
+  ws_statb64         capture_st, index_st;
+  ngram_index_hdr_t  hdr;
+  gchar             *path;
+  FILE              *fh;
+  gboolean           ok;
+
+  if (ws_stat64(capture_filename, &capture_st) != 0)
+    return FALSE;
+
+  path = ngram_index_path(capture_filename);
+  if (ws_stat64(path, &index_st) != 0) {
+    g_free(path);
+    return FALSE;
+  }
+  fh = ws_fopen(path, "rb");
+  g_free(path);
+  if (fh == NULL)
+    return FALSE;
+
+  ok = fread(&hdr, sizeof hdr, 1, fh) == 1 &&
+       hdr.magic == NGRAM_INDEX_MAGIC &&
+       hdr.version == NGRAM_INDEX_VERSION &&
+       hdr.capture_size == (gint64)capture_st.st_size &&
+       hdr.capture_mtime == (gint64)capture_st.st_mtime &&
+       (gint64)index_st.st_size ==
+         (gint64)sizeof hdr + (gint64)hdr.frames * sizeof (guint32) + hdr.sigs_len &&
+       (guint64)hdr.frames * sizeof (guint32) + hdr.sigs_len <= idx->max_size;
+  if (ok) {
+    g_array_set_size(idx->offsets, hdr.frames);
+    g_byte_array_set_size(idx->sigs, hdr.sigs_len);
+    ok = fread(idx->offsets->data, sizeof (guint32), hdr.frames, fh) == hdr.frames &&
+         fread(idx->sigs->data, 1, hdr.sigs_len, fh) == hdr.sigs_len &&
+         ngram_index_check(idx);
+  }
+  fclose(fh);
+
+  if (!ok) {
+    g_array_set_size(idx->offsets, 0);
+    g_byte_array_set_size(idx->sigs, 0);
+  }
+  idx->changed = FALSE;
+  return ok;
+}
+
+gboolean
+ngram_index_save(ngram_index_t *idx, const char *capture_filename)
+{
+  ws_statb64         capture_st;
+  ngram_index_hdr_t  hdr;
+  gchar             *path;
+  FILE              *fh;
+  gboolean           ok;
+
+  if (ws_stat64(capture_filename, &capture_st) != 0)
+    return FALSE;
+
+  memset(&hdr, 0, sizeof hdr);
+  hdr.magic = NGRAM_INDEX_MAGIC;
+  hdr.version = NGRAM_INDEX_VERSION;
+  hdr.capture_size = (gint64)capture_st.st_size;
+  hdr.capture_mtime = (gint64)capture_st.st_mtime;
+  hdr.frames = idx->offsets->len;
+  hdr.sigs_len = idx->sigs->len;
+
+  path = ngram_index_path(capture_filename);
+  fh = ws_fopen(path, "wb");
+  if (fh == NULL) {
+    /* Most likely we can't write to that directory; never mind. */
+    g_free(path);
+    return FALSE;
+  }
+
+  ok = fwrite(&hdr, sizeof hdr, 1, fh) == 1 &&
+       fwrite(idx->offsets->data, sizeof (guint32), hdr.frames, fh) == hdr.frames &&
+       fwrite(idx->sigs->data, 1, hdr.sigs_len, fh) == hdr.sigs_len;
+  if (fclose(fh) != 0)
+    ok = FALSE;
+  if (!ok)
+    ws_unlink(path);
+  else
+    idx->changed = FALSE;
+
+  g_free(path);
+  return ok;
+}
@@ -0,0 +1,79 @@
+/* ngram_index.h
+ * Remembers which byte trigrams occur in each frame, to speed up
+ * "Find Packet" searches of the packet data
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __NGRAM_INDEX_H__
+#define __NGRAM_INDEX_H__
+
+typedef struct _ngram_index ngram_index_t;
+typedef struct _ngram_query ngram_query_t;
+
+/*
+ * Make an index that takes at most "max_size" bytes; frames that don't
+ * fit aren't added.
+ */
+extern ngram_index_t *ngram_index_new(guint64 max_size);
+
+extern void ngram_index_free(ngram_index_t *idx);
+
+/*
+ * Add a frame's data to the index, unless it's already there.
+ */
+extern void ngram_index_add(ngram_index_t *idx, guint32 framenum,
+    const guint8 *pd, guint32 len);
+
+/*
+ * Returns TRUE if the frame isn't in the index, or if it may contain
+ * the string the query was made for; FALSE if it certainly doesn't.
+ */
+extern gboolean ngram_index_may_match(const ngram_index_t *idx,
+    const ngram_query_t *query, guint32 framenum);
+
+/*
+ * Returns TRUE if frames were added since the index was created or
+ * loaded.
+ */
+extern gboolean ngram_index_changed(const ngram_index_t *idx);
+
+/*
+ * Make a query for a byte string; NUL bytes in it match nothing in
+ * particular.  If "nocase" is set, the string has been upper-cased and
+ * is to be matched against upper-cased frame data.  Returns NULL if the
+ * string is too short for the index to tell anything about it.
+ */
+extern ngram_query_t *ngram_query_new(const guint8 *data, size_t len,
+    gboolean nocase);
+
+extern void ngram_query_free(ngram_query_t *query);
+
+/*
+ * Read or write an index kept next to the capture file it was made
+ * for.  An index is only read if the capture file hasn't changed since
+ * the index was written, and if it's no bigger than the maximum size.
+ */
+extern gboolean ngram_index_load(ngram_index_t *idx, const char *capture_filename);
+
+extern gboolean ngram_index_save(ngram_index_t *idx, const char *capture_filename);
+
+#endif /* __NGRAM_INDEX_H__ */
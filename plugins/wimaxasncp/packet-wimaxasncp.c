@@ -2204,12 +2204,6 @@ dissect_wimaxasncp(
 
     offset = 0;
 
-    /* Register protocol fields, etc if haven't done yet. */
-    if (wimaxasncp_dict == NULL)
-    {
-        register_wimaxasncp_fields(NULL);
-    }
-
     if (tree)
     {
         packet_item = proto_tree_add_item(
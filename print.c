@@ -65,7 +65,7 @@ typedef struct {
 
 typedef struct {
 	int			level;
-	FILE			*fh;
+	GString			*buf;
 	GSList		 	*src_list;
 	epan_dissect_t		*edt;
 } write_pdml_data;
@@ -75,6 +75,113 @@ typedef struct {
 	epan_dissect_t		*edt;
 } write_field_data_t;
 
+/*
+ * Columnar output of the selected fields ("-T columnar").
+ *
+ * Instead of text, the values of the fields are written in their native
+ * types, column by column, in blocks of rows; every value of a column in
+ * a block is contiguous, so the file can be loaded into columnar tools
+ * without parsing text.  All integers are little-endian.
+ *
+ * File header:
+ *   "WSCF"                magic
+ *   guint16               format version (1)
+ *   guint16               number of columns
+ *   per column:
+ *     guint8              value type (COLUMNAR_TYPE_*)
+ *     guint8              flags (COLUMNAR_FLAG_*)
+ *     guint16             length of the field name, followed by the name
+ *
+ * Block, written every "rows" packets (-E rows=N) and at the end:
+ *   "WSCB"                magic
+ *   guint32               number of rows
+ *   per column:
+ *     guint32             length of the rest of the column data
+ *     null bitmap         one bit per row, LSB first; set if the field
+ *                         was absent from the packet
+ *     [offsets]           COLUMNAR_FLAG_LIST columns only: guint32 per
+ *                         row plus one, the index of the row's first value
+ *     [dictionary]        COLUMNAR_TYPE_STRING columns only: guint32
+ *                         number of strings, then per string a guint32
+ *                         length followed by its bytes; it is local to
+ *                         the block
+ *     values              fixed-size values; single-valued columns have
+ *                         a (zeroed) value for absent rows too
+ *
+ * End of file:
+ *   "WSCE"                magic
+ *   guint32               total number of rows
+ *
+ * Single-valued columns hold the first or the last occurrence of the
+ * field, with "-E occurrence=f" or "-E occurrence=l"; with the default,
+ * "-E occurrence=a", columns are lists holding every occurrence.
+ */
+#define COLUMNAR_VERSION        1
+#define COLUMNAR_DEFAULT_ROWS   65536
+
+#define COLUMNAR_TYPE_UINT64    1   /* guint64 */
+#define COLUMNAR_TYPE_INT64     2   /* gint64 */
+#define COLUMNAR_TYPE_DOUBLE    3   /* IEEE 754 double */
+#define COLUMNAR_TYPE_BOOLEAN   4   /* guint8, 0 or 1 */
+#define COLUMNAR_TYPE_IPV4      5   /* 4 bytes, network byte order */
+#define COLUMNAR_TYPE_IPV6      6   /* 16 bytes, network byte order */
+#define COLUMNAR_TYPE_ETHER     7   /* 6 bytes */
+#define COLUMNAR_TYPE_TIME      8   /* gint64 nanoseconds (since the epoch for absolute times) */
+#define COLUMNAR_TYPE_STRING    9   /* guint32 index into the block's dictionary */
+
+#define COLUMNAR_FLAG_LIST      0x01
+
+struct _columnar_column {
+    guint8       type;
+    guint8       value_size;
+    guint32      row_count;     /* number of values in the current row */
+    GByteArray  *nulls;
+    GByteArray  *offsets;
+    GByteArray  *values;
+    guint32      num_values;
+    GHashTable  *dict;          /* string -> index + 1 */
+    GByteArray  *dict_data;
+};
+
+/*
+ * Compiled extraction plan for "-T fields".
+ *
+ * Each field is resolved once to the hfids registered under its name,
+ * which are primed so that the protocol tree keeps an array of their
+ * items; each packet then only looks at those items, rather than at
+ * every item in the tree, and doesn't look at protocols that none of
+ * the fields belong to at all.  Values of the common integer types are
+ * written straight into a buffer that's reused for every packet, and
+ * most other types go straight through fvalue_to_string_repr(), rather
+ * than through a display filter string.
+ *
+ * A field whose name is registered under several hfids has its items
+ * in several arrays, which don't tell in what order they're in the
+ * tree; those fields are instead collected with a walk of the tree, so
+ * that their values, and the occurrence picked by "-E occurrence", are
+ * the same as without a plan.
+ */
+typedef enum {
+    FIELD_FORMAT_GENERIC,       /* get_node_field_value() */
+    FIELD_FORMAT_UINT_DEC,      /* unsigned decimal integer */
+    FIELD_FORMAT_INT_DEC,       /* signed decimal integer */
+    FIELD_FORMAT_HEX,           /* 0x-prefixed, zero-padded hex integer */
+    FIELD_FORMAT_REPR           /* display filter representation */
+} field_format_e;
+
+struct _field_source {
+    int hfid;
+    field_format_e format;
+    int hex_digits;             /* number of digits for FIELD_FORMAT_HEX */
+    struct _field_plan *plan;   /* the field it's a source for */
+};
+
+struct _field_plan {
+    struct _field_source *sources;  /* hfids registered with the field's name */
+    guint num_sources;
+    GString *value;                 /* the field's value(s) in this packet */
+};
+
 struct _output_fields {
     gboolean print_header;
     gchar separator;
@@ -84,6 +191,15 @@ struct _output_fields {
     GHashTable* field_indicies;
     emem_strbuf_t** field_values;
     gchar quote;
+    /* Compiled "-T fields" extraction, NULL until output_fields_prime_edt() */
+    struct _field_plan *plan;
+    gboolean need_labels;       /* TRUE if some field needs item text */
+    GHashTable *walked_sources; /* hfid -> source, for fields with several */
+    /* Columnar output */
+    struct _columnar_column *columns;
+    guint32 rows_per_block;
+    guint32 block_rows;
+    guint32 total_rows;
 };
 
 GHashTable *output_only_tables = NULL;
@@ -91,6 +207,7 @@ GHashTable *output_only_tables = NULL;
 static gboolean write_headers = FALSE;
 
 static const gchar* get_field_hex_value(GSList* src_list, field_info *fi);
+static void columnar_free_columns(output_fields_t* fields);
 static void proto_tree_print_node(proto_node *node, gpointer data);
 static void proto_tree_write_node_pdml(proto_node *node, gpointer data);
 static const guint8 *get_field_data(GSList *src_list, field_info *fi);
@@ -99,12 +216,83 @@ static gboolean print_hex_data_buffer(print_stream_t *stream, const guchar *cp,
     guint length, packet_char_enc encoding);
 static void ps_clean_string(char *out, const char *in,
 			int outbuf_size);
-static void print_escaped_xml(FILE *fh, const char *unescaped_string);
+static void buf_append_escaped_xml(GString *buf, const char *unescaped_string);
 
-static void print_pdml_geninfo(proto_tree *tree, FILE *fh);
+static void print_pdml_geninfo(proto_tree *tree, GString *buf);
 
 static void proto_tree_get_node_field_values(proto_node *node, gpointer data);
 
+/*
+ * The PDML, PSML, CSV and fields writers format each packet into this
+ * buffer, which is reused from packet to packet, and write it out with
+ * a single fwrite() once the packet is complete.
+ */
+static GString *packet_buf = NULL;
+
+static GString *
+packet_buf_begin(void)
+{
+	if (packet_buf == NULL)
+		packet_buf = g_string_sized_new(4096);
+	else
+		g_string_truncate(packet_buf, 0);
+	return packet_buf;
+}
+
+static void
+packet_buf_write(FILE *fh)
+{
+	fwrite(packet_buf->str, 1, packet_buf->len, fh);
+}
+
+/* Append a decimal integer without going through printf */
+static void
+buf_append_int(GString *buf, gint value)
+{
+	gchar	 digits[12];
+	gchar	*p = digits + sizeof digits;
+	guint	 uvalue = value < 0 ? -(guint)value : (guint)value;
+
+	do {
+		*--p = '0' + uvalue % 10;
+		uvalue /= 10;
+	} while (uvalue != 0);
+	if (value < 0)
+		*--p = '-';
+	g_string_append_len(buf, p, digits + sizeof digits - p);
+}
+
+/* Append the indentation for a PDML element at the given level */
+static void
+buf_append_indent(GString *buf, int level)
+{
+	static const gchar spaces[] = "                                ";
+	gsize len = 2 * (level + 1);
+
+	while (len > sizeof spaces - 1) {
+		g_string_append_len(buf, spaces, sizeof spaces - 1);
+		len -= sizeof spaces - 1;
+	}
+	g_string_append_len(buf, spaces, len);
+}
+
+/* Append a lower-case hex dump of some bytes */
+static void
+buf_append_hex(GString *buf, const guint8 *pd, int length)
+{
+	static const gchar hex[] = "0123456789abcdef";
+	gsize	 offset = buf->len;
+	gchar	*p;
+	int	 i;
+
+	g_string_set_size(buf, offset + 2 * length);
+	p = buf->str + offset;
+	for (i = 0; i < length; i++) {
+		*p++ = hex[pd[i] >> 4];
+		*p++ = hex[pd[i] & 0x0f];
+	}
+}
+
 static FILE *
 open_print_dest(gboolean to_file, const char *dest)
 {
@@ -271,19 +459,67 @@ proto_tree_write_pdml(epan_dissect_t *edt, FILE *fh)
 
 	/* Create the output */
 	data.level = 0;
-	data.fh = fh;
+	data.buf = packet_buf_begin();
 	data.src_list = edt->pi.data_src;
 	data.edt = edt;
 
-	fprintf(fh, "<packet>\n");
+	g_string_append(data.buf, "<packet>\n");
 
 	/* Print a "geninfo" protocol as required by PDML */
-	print_pdml_geninfo(edt->tree, fh);
+	print_pdml_geninfo(edt->tree, data.buf);
 
 	proto_tree_children_foreach(edt->tree, proto_tree_write_node_pdml,
 	    &data);
 
-	fprintf(fh, "</packet>\n\n");
+	g_string_append(data.buf, "</packet>\n\n");
+
+	packet_buf_write(fh);
+}
+
+/* Return the '<proto name="..." showname="' or '<field name="..." showname="'
+ * opening of a PDML element for a field; it only depends on the field, so
+ * it's escaped once and cached by field ID. */
+static const gchar *
+pdml_element_start(header_field_info *hfinfo)
+{
+	static gchar	**starts = NULL;
+	static guint	  num_starts = 0;
+	GString		 *start;
+	guint		  i;
+
+	if ((guint)hfinfo->id >= num_starts) {
+		i = num_starts;
+		num_starts = hfinfo->id + 256;
+		starts = g_renew(gchar *, starts, num_starts);
+		for (; i < num_starts; i++)
+			starts[i] = NULL;
+	}
+
+	if (starts[hfinfo->id] == NULL) {
+		start = g_string_new(NULL);
+		if (hfinfo->type == FT_PROTOCOL && hfinfo->id != proto_expert)
+			g_string_append(start, "<proto name=\"");
+		else
+			g_string_append(start, "<field name=\"");
+		buf_append_escaped_xml(start, hfinfo->abbrev);
+		g_string_append(start, "\" showname=\"");
+		starts[hfinfo->id] = g_string_free(start, FALSE);
+	}
+	return starts[hfinfo->id];
+}
+
+/* Append the size and pos attributes of a field */
+static void
+pdml_append_size_pos(GString *buf, proto_node *node, field_info *fi)
+{
+	g_string_append(buf, "\" size=\"");
+	buf_append_int(buf, fi->length);
+	g_string_append(buf, "\" pos=\"");
+	if (node->parent && node->parent->finfo && (fi->start < node->parent->finfo->start)) {
+		buf_append_int(buf, node->parent->finfo->start + fi->start);
+	} else {
+		buf_append_int(buf, fi->start);
+	}
 }
 
 /* Write out a tree's data, and any child nodes, as PDML */
@@ -292,11 +528,11 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 {
 	field_info	*fi = PNODE_FINFO(node);
 	write_pdml_data	*pdata = (write_pdml_data*) data;
+	GString		*buf = pdata->buf;
 	const gchar	*label_ptr;
 	gchar		label_str[ITEM_LABEL_LENGTH];
 	char		*dfilter_string;
 	size_t		chop_len;
-	int		i;
 	gboolean wrap_in_fake_protocol;
 
 	/* dissection with an invisible proto tree? */
@@ -310,19 +546,15 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 	    (pdata->level == 0));
 
 	/* Indent to the correct level */
-	for (i = -1; i < pdata->level; i++) {
-		fputs("  ", pdata->fh);
-	}
+	buf_append_indent(buf, pdata->level);
 
 	if (wrap_in_fake_protocol) {
 		/* Open fake protocol wrapper */
-		fputs("<proto name=\"fake-field-wrapper\">\n", pdata->fh);
+		g_string_append(buf, "<proto name=\"fake-field-wrapper\">\n");
 
 		/* Indent to increased level before writing out field */
 		pdata->level++;
-		for (i = -1; i < pdata->level; i++) {
-			fputs("  ", pdata->fh);
-		}
+		buf_append_indent(buf, pdata->level);
 	}
 
 	/* Text label. It's printed as a field with no name. */
@@ -336,25 +568,19 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 		}
 
 		/* Show empty name since it is a required field */
-		fputs("<field name=\"", pdata->fh);
-		fputs("\" show=\"", pdata->fh);
-		print_escaped_xml(pdata->fh, label_ptr);
+		g_string_append(buf, "<field name=\"\" show=\"");
+		buf_append_escaped_xml(buf, label_ptr);
 
-		fprintf(pdata->fh, "\" size=\"%d", fi->length);
-		if (node->parent && node->parent->finfo && (fi->start < node->parent->finfo->start)) {
-			fprintf(pdata->fh, "\" pos=\"%d", node->parent->finfo->start + fi->start);
-		} else {
-			fprintf(pdata->fh, "\" pos=\"%d", fi->start);
-		}
+		pdml_append_size_pos(buf, node, fi);
 
-		fputs("\" value=\"", pdata->fh);
+		g_string_append(buf, "\" value=\"");
 		write_pdml_field_hex_value(pdata, fi);
 
 		if (node->first_child != NULL) {
-			fputs("\">\n", pdata->fh);
+			g_string_append(buf, "\">\n");
 		}
 		else {
-			fputs("\"/>\n", pdata->fh);
+			g_string_append(buf, "\"/>\n");
 		}
 	}
 
@@ -363,21 +589,12 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 	else if (fi->hfinfo->id == proto_data) {
 
 		/* Write out field with data */
-		fputs("<field name=\"data\" value=\"", pdata->fh);
+		g_string_append(buf, "<field name=\"data\" value=\"");
 		write_pdml_field_hex_value(pdata, fi);
-		fputs("\">\n", pdata->fh);
+		g_string_append(buf, "\">\n");
 	}
 	/* Normal protocols and fields */
 	else {
-		if (fi->hfinfo->type == FT_PROTOCOL && fi->hfinfo->id != proto_expert) {
-			fputs("<proto name=\"", pdata->fh);
-		}
-		else {
-			fputs("<field name=\"", pdata->fh);
-		}
-		print_escaped_xml(pdata->fh, fi->hfinfo->abbrev);
-
-#if 0
 	/* PDML spec, see:
 	 * http://www.nbee.org/doku.php?id=netpdl:pdml_specification
 	 *
@@ -391,31 +608,21 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 	 * (like it's contained in the fi->rep->representation).
 	 * Unfortunately, we don't have the field data representation for
 	 * all fields, so this isn't currently possible */
-		fputs("\" showname=\"", pdata->fh);
-		print_escaped_xml(pdata->fh, fi->hfinfo->name);
-#endif
+		g_string_append(buf, pdml_element_start(fi->hfinfo));
 
 		if (fi->rep) {
-			fputs("\" showname=\"", pdata->fh);
-			print_escaped_xml(pdata->fh, fi->rep->representation);
+			buf_append_escaped_xml(buf, fi->rep->representation);
 		}
 		else {
 			label_ptr = label_str;
 			proto_item_fill_label(fi, label_str);
-			fputs("\" showname=\"", pdata->fh);
-			print_escaped_xml(pdata->fh, label_ptr);
+			buf_append_escaped_xml(buf, label_ptr);
 		}
 
 		if (PROTO_ITEM_IS_HIDDEN(node))
-			fprintf(pdata->fh, "\" hide=\"yes");
+			g_string_append(buf, "\" hide=\"yes");
 
-		fprintf(pdata->fh, "\" size=\"%d", fi->length);
-		if (node->parent && node->parent->finfo && (fi->start < node->parent->finfo->start)) {
-			fprintf(pdata->fh, "\" pos=\"%d", node->parent->finfo->start + fi->start);
-		} else {
-			fprintf(pdata->fh, "\" pos=\"%d", fi->start);
-		}
-/*		fprintf(pdata->fh, "\" id=\"%d", fi->hfinfo->id);*/
+		pdml_append_size_pos(buf, node, fi);
 
 		/* show, value, and unmaskedvalue attributes */
 		switch (fi->hfinfo->type)
@@ -423,7 +630,7 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 		case FT_PROTOCOL:
 			break;
 		case FT_NONE:
-			fputs("\" show=\"\" value=\"",  pdata->fh);
+			g_string_append(buf, "\" show=\"\" value=\"");
 			break;
 		default:
 			/* XXX - this is a hack until we can just call
@@ -443,8 +650,8 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 					chop_len++;
 				}
 
-				fputs("\" show=\"", pdata->fh);
-				print_escaped_xml(pdata->fh, &dfilter_string[chop_len]);
+				g_string_append(buf, "\" show=\"");
+				buf_append_escaped_xml(buf, &dfilter_string[chop_len]);
 			}
 
 			/*
@@ -455,11 +662,11 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 			 * they might be generated fields.
 			 */
 			if (fi->length > 0) {
-				fputs("\" value=\"", pdata->fh);
+				g_string_append(buf, "\" value=\"");
 
 				if (fi->hfinfo->bitmask!=0) {
-					fprintf(pdata->fh, "%X", fvalue_get_uinteger(&fi->value));
-					fputs("\" unmaskedvalue=\"", pdata->fh);
+					g_string_append_printf(buf, "%X", fvalue_get_uinteger(&fi->value));
+					g_string_append(buf, "\" unmaskedvalue=\"");
 					write_pdml_field_hex_value(pdata, fi);
 				}
 				else {
@@ -469,13 +676,13 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 		}
 
 		if (node->first_child != NULL) {
-			fputs("\">\n", pdata->fh);
+			g_string_append(buf, "\">\n");
 		}
 		else if (fi->hfinfo->id == proto_data) {
-			fputs("\">\n", pdata->fh);
+			g_string_append(buf, "\">\n");
 		}
 		else {
-			fputs("\"/>\n", pdata->fh);
+			g_string_append(buf, "\"/>\n");
 		}
 	}
 
@@ -494,26 +701,24 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
 
 	if (node->first_child != NULL) {
 		/* Indent to correct level */
-		for (i = -1; i < pdata->level; i++) {
-			fputs("  ", pdata->fh);
-		}
+		buf_append_indent(buf, pdata->level);
 		/* Close off current element */
 		/* Data and expert "protocols" use simple tags */
 		if (fi->hfinfo->id != proto_data && fi->hfinfo->id != proto_expert) {
 			if (fi->hfinfo->type == FT_PROTOCOL) {
-				fputs("</proto>\n", pdata->fh);
+				g_string_append(buf, "</proto>\n");
 			}
 			else {
-				fputs("</field>\n", pdata->fh);
+				g_string_append(buf, "</field>\n");
 			}
 		} else {
-			fputs("</field>\n", pdata->fh);
+			g_string_append(buf, "</field>\n");
 		}
 	}
 
 	/* Close off fake wrapper protocol */
 	if (wrap_in_fake_protocol) {
-		fputs("</proto>\n", pdata->fh);
+		g_string_append(buf, "</proto>\n");
 	}
 }
 
@@ -522,7 +727,7 @@ proto_tree_write_node_pdml(proto_node *node, gpointer data)
  * but we produce a 'geninfo' protocol in the PDML to conform to spec.
  * The 'frame' protocol follows the 'geninfo' protocol in the PDML. */
 static void
-print_pdml_geninfo(proto_tree *tree, FILE *fh)
+print_pdml_geninfo(proto_tree *tree, GString *buf)
 {
 	guint32 num, len, caplen;
 	nstime_t *timestamp;
@@ -570,33 +775,32 @@ print_pdml_geninfo(proto_tree *tree, FILE *fh)
 	g_ptr_array_free(finfo_array, TRUE);
 
 	/* Print geninfo start */
-	fprintf(fh,
+	g_string_append_printf(buf,
 "  <proto name=\"geninfo\" pos=\"0\" showname=\"General information\" size=\"%u\">\n",
 		frame_finfo->length);
 
 	/* Print geninfo.num */
-	fprintf(fh,
+	g_string_append_printf(buf,
 "    <field name=\"num\" pos=\"0\" show=\"%u\" showname=\"Number\" value=\"%x\" size=\"%u\"/>\n",
 		num, num, frame_finfo->length);
 
 	/* Print geninfo.len */
-	fprintf(fh,
+	g_string_append_printf(buf,
 "    <field name=\"len\" pos=\"0\" show=\"%u\" showname=\"Frame Length\" value=\"%x\" size=\"%u\"/>\n",
 		len, len, frame_finfo->length);
 
 	/* Print geninfo.caplen */
-	fprintf(fh,
+	g_string_append_printf(buf,
 "    <field name=\"caplen\" pos=\"0\" show=\"%u\" showname=\"Captured Length\" value=\"%x\" size=\"%u\"/>\n",
 		caplen, caplen, frame_finfo->length);
 
 	/* Print geninfo.timestamp */
-	fprintf(fh,
+	g_string_append_printf(buf,
 "    <field name=\"timestamp\" pos=\"0\" show=\"%s\" showname=\"Captured Time\" value=\"%d.%09d\" size=\"%u\"/>\n",
 		abs_time_to_str(timestamp, ABSOLUTE_TIME_LOCAL, TRUE), (int) timestamp->secs, timestamp->nsecs, frame_finfo->length);
 
 	/* Print geninfo end */
-	fprintf(fh,
-"  </proto>\n");
+	g_string_append(buf, "  </proto>\n");
 }
 
 void
@@ -618,31 +822,34 @@ void
 proto_tree_write_psml(epan_dissect_t *edt, FILE *fh)
 {
 	gint	i;
+	GString	*buf = packet_buf_begin();
 
 	/* if this is the first packet, we have to create the PSML structure output */
 	if(write_headers) {
-	    fprintf(fh, "<structure>\n");
+	    g_string_append(buf, "<structure>\n");
 
 	    for(i=0; i < edt->pi.cinfo->num_cols; i++) {
-		fprintf(fh, "<section>");
-		print_escaped_xml(fh, edt->pi.cinfo->col_title[i]);
-		fprintf(fh, "</section>\n");
+		g_string_append(buf, "<section>");
+		buf_append_escaped_xml(buf, edt->pi.cinfo->col_title[i]);
+		g_string_append(buf, "</section>\n");
 	    }
 
-	    fprintf(fh, "</structure>\n\n");
+	    g_string_append(buf, "</structure>\n\n");
 
 	    write_headers = FALSE;
 	}
 
-	fprintf(fh, "<packet>\n");
+	g_string_append(buf, "<packet>\n");
 
 	for(i=0; i < edt->pi.cinfo->num_cols; i++) {
-	    fprintf(fh, "<section>");
-	    print_escaped_xml(fh, edt->pi.cinfo->col_data[i]);
-	    fprintf(fh, "</section>\n");
+	    g_string_append(buf, "<section>");
+	    buf_append_escaped_xml(buf, edt->pi.cinfo->col_data[i]);
+	    g_string_append(buf, "</section>\n");
 	}
 
-	fprintf(fh, "</packet>\n\n");
+	g_string_append(buf, "</packet>\n\n");
+
+	packet_buf_write(fh);
 }
 
 void
@@ -669,31 +876,50 @@ static gchar *csv_massage_str(const gchar *source, const gchar *exceptions)
     return csv_str;
 }
 
-static void csv_write_str(const char *str, char sep, FILE *fh)
+/* Append a quoted string followed by a separator; strings that need no
+ * escaping, which is almost all of them, are copied as they are instead
+ * of being run through g_strescape(). */
+static void csv_write_str(const char *str, char sep, GString *buf)
 {
+    const guchar *p;
     gchar *csv_str;
 
-    csv_str = csv_massage_str(str, NULL);
-    fprintf(fh, "\"%s\"%c", csv_str, sep);
-    g_free(csv_str);
+    for (p = (const guchar *)str; *p != '\0'; p++) {
+        if (*p < ' ' || *p >= 0x7f || *p == '\\' || *p == '"')
+            break;
+    }
+
+    g_string_append_c(buf, '"');
+    if (*p == '\0') {
+        g_string_append_len(buf, str, (const gchar *)p - str);
+    } else {
+        csv_str = csv_massage_str(str, NULL);
+        g_string_append(buf, csv_str);
+        g_free(csv_str);
+    }
+    g_string_append_c(buf, '"');
+    g_string_append_c(buf, sep);
 }
 
 void
 proto_tree_write_csv(epan_dissect_t *edt, FILE *fh)
 {
     gint i;
+    GString *buf = packet_buf_begin();
 
     /* if this is the first packet, we have to write the CSV header */
     if(write_headers) {
         for(i=0; i < edt->pi.cinfo->num_cols - 1; i++)
-            csv_write_str(edt->pi.cinfo->col_title[i], ',', fh);
-        csv_write_str(edt->pi.cinfo->col_title[i], '\n', fh);
+            csv_write_str(edt->pi.cinfo->col_title[i], ',', buf);
+        csv_write_str(edt->pi.cinfo->col_title[i], '\n', buf);
         write_headers = FALSE;
     }
 
     for(i=0; i < edt->pi.cinfo->num_cols - 1; i++)
-        csv_write_str(edt->pi.cinfo->col_data[i], ',', fh);
-    csv_write_str(edt->pi.cinfo->col_data[i], '\n', fh);
+        csv_write_str(edt->pi.cinfo->col_data[i], ',', buf);
+    csv_write_str(edt->pi.cinfo->col_data[i], '\n', buf);
+
+    packet_buf_write(fh);
 }
 
 void
@@ -816,53 +1042,58 @@ get_field_data(GSList *src_list, field_info *fi)
 	return NULL;	/* not found */
 }
 
-/* Print a string, escaping out certain characters that need to
- * escaped out for XML. */
+/* Append a string, escaping out certain characters that need to
+ * escaped out for XML; runs of characters that need no escaping are
+ * copied in one go. */
 static void
-print_escaped_xml(FILE *fh, const char *unescaped_string)
+buf_append_escaped_xml(GString *buf, const char *unescaped_string)
 {
 	const char *p;
-	char temp_str[8];
+	const char *run = unescaped_string;
+	const char *entity;
 
 	for (p = unescaped_string; *p != '\0'; p++) {
 		switch (*p) {
 			case '&':
-				fputs("&amp;", fh);
+				entity = "&amp;";
 				break;
 			case '<':
-				fputs("&lt;", fh);
+				entity = "&lt;";
 				break;
 			case '>':
-				fputs("&gt;", fh);
+				entity = "&gt;";
 				break;
 			case '"':
-				fputs("&quot;", fh);
+				entity = "&quot;";
 				break;
 			case '\'':
-				fputs("&apos;", fh);
+				entity = "&apos;";
 				break;
 			default:
 				if (g_ascii_isprint(*p))
-					fputc(*p, fh);
-				else {
-					g_snprintf(temp_str, sizeof(temp_str), "\\x%x", (guint8)*p);
-					fputs(temp_str, fh);
-				}
+					continue;
+				entity = NULL;
 		}
+		g_string_append_len(buf, run, p - run);
+		if (entity != NULL)
+			g_string_append(buf, entity);
+		else
+			g_string_append_printf(buf, "\\x%x", (guint8)*p);
+		run = p + 1;
 	}
+	g_string_append_len(buf, run, p - run);
 }
 
 static void
 write_pdml_field_hex_value(write_pdml_data *pdata, field_info *fi)
 {
-	int i;
 	const guint8 *pd;
 
 	if (!fi->ds_tvb)
 		return;
 
 	if (fi->length > tvb_length_remaining(fi->ds_tvb, fi->start)) {
-		fprintf(pdata->fh, "field length invalid!");
+		g_string_append(pdata->buf, "field length invalid!");
 		return;
 	}
 
@@ -871,9 +1102,7 @@ write_pdml_field_hex_value(write_pdml_data *pdata, field_info *fi)
 
 	if (pd) {
 		/* Print a simple hex dump */
-		for (i = 0 ; i < fi->length; i++) {
-			fprintf(pdata->fh, "%02x", pd[i]);
-		}
+		buf_append_hex(pdata->buf, pd, fi->length);
 	}
 }
 
@@ -1328,6 +1557,13 @@ output_fields_t* output_fields_new(void)
     fields->field_indicies = NULL;
     fields->field_values = NULL;
     fields->quote='\0';
+    fields->plan = NULL;
+    fields->need_labels = FALSE;
+    fields->walked_sources = NULL;
+    fields->columns = NULL;
+    fields->rows_per_block = COLUMNAR_DEFAULT_ROWS;
+    fields->block_rows = 0;
+    fields->total_rows = 0;
     return fields;
 }
 
@@ -1352,6 +1588,18 @@ void output_fields_free(output_fields_t* fields)
          */
         g_hash_table_destroy(fields->field_indicies);
     }
+    columnar_free_columns(fields);
+    if(NULL != fields->plan) {
+        gsize i;
+        for(i = 0; i < fields->fields->len; ++i) {
+            g_free(fields->plan[i].sources);
+            g_string_free(fields->plan[i].value, TRUE);
+        }
+        g_free(fields->plan);
+    }
+    if(NULL != fields->walked_sources) {
+        g_hash_table_destroy(fields->walked_sources);
+    }
     if(NULL != fields->fields) {
         gsize i;
         for(i = 0; i < fields->fields->len; ++i) {
@@ -1486,6 +1734,21 @@ gboolean output_fields_set_option(output_fields_t* info, gchar* option)
         return TRUE;
     }
 
+    if(0 == strcmp(option_name, "rows")) {
+        gchar *p;
+        gulong rows;
+
+        if(NULL == option_value || '\0' == *option_value) {
+            return FALSE;
+        }
+        rows = strtoul(option_value, &p, 10);
+        if(*p != '\0' || rows == 0 || rows > G_MAXUINT32) {
+            return FALSE;
+        }
+        info->rows_per_block = (guint32)rows;
+        return TRUE;
+    }
+
     return FALSE;
 }
 
@@ -1497,6 +1760,7 @@ void output_fields_list_options(FILE *fh)
     fputs("occurrence=f|l|a  Select the occurrence of a field to use;\n     \"f\" = first, \"l\" = last, \"a\" = all (def: a: all)\n", fh);
     fputs("aggregator=,|/s|<character>   Set the aggregator to use;\n     \",\" = comma, \"/s\" = space (def: ,: comma)\n", fh);
     fputs("quote=d|s|n   Print either d: double-quotes, s: single quotes or \n     n: no quotes around field values (def: n: none)\n", fh);
+    fputs("rows=<n>      Number of packets per block of columnar output (def: 65536)\n", fh);
 }
 
 
@@ -1521,6 +1785,312 @@ void write_fields_preamble(output_fields_t* fields, FILE *fh)
     fputc('\n', fh);
 }
 
+static field_format_e
+field_format_for_hfinfo(header_field_info *hfinfo, int *hex_digits)
+{
+    /* Fields whose value comes from the item text or the raw bytes */
+    if (hfinfo->id == hf_text_only || hfinfo->id == proto_data)
+        return FIELD_FORMAT_GENERIC;
+
+    /* These have to match what proto_construct_match_selected_string()
+     * does, as that's what get_node_field_value() uses. */
+    switch (hfinfo->type) {
+
+    case FT_FRAMENUM:
+        return FIELD_FORMAT_UINT_DEC;
+
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        /* Enumerated values are written as their names */
+        if (hfinfo->strings && (hfinfo->display & BASE_DISPLAY_E_MASK) == BASE_NONE)
+            return FIELD_FORMAT_GENERIC;
+
+        switch (hfinfo->display & BASE_DISPLAY_E_MASK) {
+
+        case BASE_DEC:
+        case BASE_DEC_HEX:
+        case BASE_OCT:
+        case BASE_CUSTOM:
+            return IS_FT_INT(hfinfo->type) ? FIELD_FORMAT_INT_DEC : FIELD_FORMAT_UINT_DEC;
+
+        case BASE_HEX:
+        case BASE_HEX_DEC:
+            switch (hfinfo->type) {
+            case FT_UINT8:
+            case FT_INT8:
+                *hex_digits = 2;
+                break;
+            case FT_UINT16:
+            case FT_INT16:
+                *hex_digits = 4;
+                break;
+            case FT_UINT24:
+            case FT_INT24:
+                *hex_digits = 6;
+                break;
+            default:
+                *hex_digits = 8;
+                break;
+            }
+            return FIELD_FORMAT_HEX;
+
+        default:
+            return FIELD_FORMAT_GENERIC;
+        }
+
+    case FT_INT64:
+    case FT_UINT64:
+    case FT_PROTOCOL:
+    case FT_NONE:
+    case FT_PCRE:
+        return FIELD_FORMAT_GENERIC;
+
+    default:
+        return FIELD_FORMAT_REPR;
+    }
+}
+
+/* Resolve each field to the hfids registered under its name */
+static void
+output_fields_compile(output_fields_t* fields)
+{
+    gsize i;
+    header_field_info *hfinfo, *first;
+    struct _field_plan *plan;
+    guint n;
+
+    fields->plan = g_new0(struct _field_plan, fields->fields->len);
+    for(i = 0; i < fields->fields->len; ++i) {
+        plan = &fields->plan[i];
+        plan->value = g_string_new("");
+
+        first = proto_registrar_get_byname((const gchar *)g_ptr_array_index(fields->fields, i));
+        if (first == NULL) {
+            /* No such field; it'll always be empty */
+            continue;
+        }
+        while (first->same_name_prev != NULL)
+            first = first->same_name_prev;
+
+        n = 0;
+        for (hfinfo = first; hfinfo != NULL; hfinfo = hfinfo->same_name_next)
+            n++;
+        plan->sources = g_new(struct _field_source, n);
+        for (hfinfo = first; hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+            struct _field_source *source = &plan->sources[plan->num_sources++];
+
+            source->hfid = hfinfo->id;
+            source->hex_digits = 0;
+            source->format = field_format_for_hfinfo(hfinfo, &source->hex_digits);
+            source->plan = plan;
+            if (n > 1) {
+                if (fields->walked_sources == NULL)
+                    fields->walked_sources = g_hash_table_new(g_direct_hash, g_direct_equal);
+                g_hash_table_insert(fields->walked_sources, GINT_TO_POINTER(hfinfo->id), source);
+            }
+
+            /* Protocol items and text items are written using their
+             * text, which is only filled in if the tree is visible */
+            if (hfinfo->type == FT_PROTOCOL || hfinfo->id == hf_text_only)
+                fields->need_labels = TRUE;
+        }
+    }
+}
+
+void output_fields_prime_edt(output_fields_t* fields, epan_dissect_t *edt)
+{
+    gsize i;
+    guint j;
+
+    g_assert(fields);
+    g_assert(edt);
+
+    if (NULL == fields->fields || NULL == edt->tree) {
+        return;
+    }
+    if (NULL == fields->plan) {
+        output_fields_compile(fields);
+    }
+    for(i = 0; i < fields->fields->len; ++i) {
+        for(j = 0; j < fields->plan[i].num_sources; ++j) {
+            proto_tree_prime_hfid(edt->tree, fields->plan[i].sources[j].hfid);
+        }
+    }
+
+    /* Nothing else in the tree is wanted, so don't build it */
+    if (!fields->need_labels) {
+        proto_tree_set_visible(edt->tree, FALSE);
+    }
+}
+
+/* Append an unsigned decimal integer without going through printf */
+static void
+buf_append_uint(GString *buf, guint32 value)
+{
+    gchar  digits[10];
+    gchar *p = digits + sizeof digits;
+
+    do {
+        *--p = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+    g_string_append_len(buf, p, digits + sizeof digits - p);
+}
+
+/* Append a 0x-prefixed hex integer with the given number of digits */
+static void
+buf_append_hex_uint(GString *buf, guint32 value, int num_digits)
+{
+    static const gchar hex_digits[16] =
+        { '0', '1', '2', '3', '4', '5', '6', '7',
+          '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+    gchar  digits[10];
+    gchar *p = digits + sizeof digits;
+
+    /* Like printf, don't cut off digits that don't fit */
+    while (num_digits > 0 || value != 0) {
+        *--p = hex_digits[value & 0xF];
+        value >>= 4;
+        num_digits--;
+    }
+    *--p = 'x';
+    *--p = '0';
+    g_string_append_len(buf, p, digits + sizeof digits - p);
+}
+
+/* Append the value of a field item, as get_node_field_value() would
+ * return it */
+static void
+buf_append_field_value(GString *buf, const struct _field_source *source,
+                       field_info *fi, epan_dissect_t *edt)
+{
+    const gchar *value;
+    gsize start;
+    int len;
+
+    switch (source->format) {
+
+    case FIELD_FORMAT_UINT_DEC:
+        buf_append_uint(buf, fvalue_get_uinteger(&fi->value));
+        return;
+
+    case FIELD_FORMAT_INT_DEC:
+        buf_append_int(buf, fvalue_get_sinteger(&fi->value));
+        return;
+
+    case FIELD_FORMAT_HEX:
+        if (IS_FT_INT(fi->hfinfo->type))
+            buf_append_hex_uint(buf, (guint32)fvalue_get_sinteger(&fi->value), source->hex_digits);
+        else
+            buf_append_hex_uint(buf, fvalue_get_uinteger(&fi->value), source->hex_digits);
+        return;
+
+    case FIELD_FORMAT_REPR:
+        len = fvalue_string_repr_len(&fi->value, FTREPR_DFILTER);
+        if (len < 0)
+            break;
+        start = buf->len;
+        g_string_set_size(buf, start + len);
+        fvalue_to_string_repr(&fi->value, FTREPR_DFILTER, buf->str + start);
+        g_string_truncate(buf, start + strlen(buf->str + start));
+
+        /* Strip the quotes from quoted strings */
+        if (buf->len - start >= 2 && buf->str[buf->len - 1] == '"') {
+            g_string_truncate(buf, buf->len - 1);
+            g_string_erase(buf, start, 1);
+        } else if (buf->len - start == 1 && buf->str[start] == '"') {
+            g_string_truncate(buf, start);
+        }
+        return;
+
+    case FIELD_FORMAT_GENERIC:
+        break;
+    }
+
+    value = get_node_field_value(fi, edt); /* ep_alloced string */
+    if (NULL != value) {
+        g_string_append(buf, value);
+    }
+}
+
+/* Add the value of one of a field's items, as "-E occurrence" says */
+static void
+field_plan_add_value(output_fields_t* fields, struct _field_source *source,
+                     field_info *fi, epan_dissect_t *edt)
+{
+    GString *value = source->plan->value;
+    gboolean found;
+    gsize start, value_start;
+
+    /* Empty values are left out, so anything there is an earlier one */
+    found = value->len != 0;
+    if (found && fields->occurrence == 'f') {
+        return;
+    }
+
+    start = value->len;
+    if (found && fields->occurrence == 'a') {
+        g_string_append_c(value, fields->aggregator);
+    }
+    value_start = value->len;
+    buf_append_field_value(value, source, fi, edt);
+    if (value->len == value_start) {
+        g_string_truncate(value, start);
+        return;
+    }
+    if (found && fields->occurrence == 'l') {
+        /* Keep only the value of the last occurrence */
+        g_string_erase(value, 0, value_start);
+    }
+}
+
+/* Collect the values of a field registered under a single hfid from
+ * its items, which are in tree order */
+static void
+field_plan_get_values(output_fields_t* fields, struct _field_plan *plan,
+                      epan_dissect_t *edt)
+{
+    GPtrArray *finfos;
+    guint j;
+
+    finfos = proto_get_finfo_ptr_array(edt->tree, plan->sources[0].hfid);
+    if (NULL == finfos) {
+        return;
+    }
+    for(j = 0; j < finfos->len; ++j) {
+        field_plan_add_value(fields, &plan->sources[0],
+                             (field_info *)g_ptr_array_index(finfos, j), edt);
+    }
+}
+
+/* Collect the values of fields registered under several hfids */
+static void
+proto_tree_get_node_walked_values(proto_node *node, gpointer data)
+{
+    write_field_data_t *call_data = (write_field_data_t *)data;
+    field_info *fi = PNODE_FINFO(node);
+    struct _field_source *source;
+
+    g_assert(fi);
+
+    source = (struct _field_source *)g_hash_table_lookup(call_data->fields->walked_sources,
+                                                         GINT_TO_POINTER(fi->hfinfo->id));
+    if (source != NULL) {
+        field_plan_add_value(call_data->fields, source, fi, call_data->edt);
+    }
+
+    if (node->first_child != NULL) {
+        proto_tree_children_foreach(node, proto_tree_get_node_walked_values,
+                                    call_data);
+    }
+}
+
 static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
 {
     write_field_data_t *call_data;
@@ -1566,6 +2136,7 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
 void proto_tree_write_fields(output_fields_t* fields, epan_dissect_t *edt, FILE *fh)
 {
     gsize i;
+    GString *buf;
 
     write_field_data_t data;
 
@@ -1573,6 +2144,44 @@ void proto_tree_write_fields(output_fields_t* fields, epan_dissect_t *edt, FILE
     g_assert(edt);
     g_assert(fh);
 
+    if(NULL != fields->plan) {
+        /* Fields were primed for this tree; use the compiled plan */
+        for(i = 0; i < fields->fields->len; ++i) {
+            struct _field_plan *plan = &fields->plan[i];
+
+            g_string_truncate(plan->value, 0);
+            if(1 == plan->num_sources) {
+                field_plan_get_values(fields, plan, edt);
+            }
+        }
+        if(NULL != fields->walked_sources) {
+            data.fields = fields;
+            data.edt = edt;
+            proto_tree_children_foreach(edt->tree, proto_tree_get_node_walked_values,
+                                        &data);
+        }
+
+        buf = packet_buf_begin();
+        for(i = 0; i < fields->fields->len; ++i) {
+            struct _field_plan *plan = &fields->plan[i];
+
+            if(0 != i) {
+                g_string_append_c(buf, fields->separator);
+            }
+            if(0 != plan->value->len) {
+                if(fields->quote != '\0') {
+                    g_string_append_c(buf, fields->quote);
+                }
+                g_string_append_len(buf, plan->value->str, plan->value->len);
+                if(fields->quote != '\0') {
+                    g_string_append_c(buf, fields->quote);
+                }
+            }
+        }
+        packet_buf_write(fh);
+        return;
+    }
+
     data.fields = fields;
     data.edt = edt;
 
@@ -1597,20 +2206,23 @@ void proto_tree_write_fields(output_fields_t* fields, epan_dissect_t *edt, FILE
     proto_tree_children_foreach(edt->tree, proto_tree_get_node_field_values,
                                 &data);
 
+    buf = packet_buf_begin();
     for(i = 0; i < fields->fields->len; ++i) {
         if(0 != i) {
-            fputc(fields->separator, fh);
+            g_string_append_c(buf, fields->separator);
         }
         if(NULL != fields->field_values[i]) {
             if(fields->quote != '\0') {
-                fputc(fields->quote, fh);
+                g_string_append_c(buf, fields->quote);
             }
-            fputs(fields->field_values[i]->str, fh);
+            g_string_append_len(buf, fields->field_values[i]->str,
+                                fields->field_values[i]->len);
             if(fields->quote != '\0') {
-                fputc(fields->quote, fh);
+                g_string_append_c(buf, fields->quote);
             }
         }
     }
+    packet_buf_write(fh);
 }
 
 void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
@@ -1717,3 +2329,457 @@ get_field_hex_value(GSList* src_list, field_info *fi)
         return NULL;
     }
 }
+
+static void
+columnar_free_columns(output_fields_t* fields)
+{
+    gsize i;
+    struct _columnar_column *col;
+
+    if (fields->columns == NULL)
+        return;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        col = &fields->columns[i];
+        g_byte_array_free(col->nulls, TRUE);
+        g_byte_array_free(col->offsets, TRUE);
+        g_byte_array_free(col->values, TRUE);
+        if (col->dict != NULL) {
+            g_hash_table_destroy(col->dict);
+            g_byte_array_free(col->dict_data, TRUE);
+        }
+    }
+    g_free(fields->columns);
+    fields->columns = NULL;
+}
+
+static void
+columnar_append_uint16(GByteArray *ba, guint16 value)
+{
+    guint8 b[2];
+
+    b[0] = (guint8)value;
+    b[1] = (guint8)(value >> 8);
+    g_byte_array_append(ba, b, 2);
+}
+
+static void
+columnar_append_uint32(GByteArray *ba, guint32 value)
+{
+    guint8 b[4];
+
+    b[0] = (guint8)value;
+    b[1] = (guint8)(value >> 8);
+    b[2] = (guint8)(value >> 16);
+    b[3] = (guint8)(value >> 24);
+    g_byte_array_append(ba, b, 4);
+}
+
+static void
+columnar_append_uint64(GByteArray *ba, guint64 value)
+{
+    columnar_append_uint32(ba, (guint32)value);
+    columnar_append_uint32(ba, (guint32)(value >> 32));
+}
+
+static void
+columnar_type_for_field(const gchar *abbrev, guint8 *type, guint8 *value_size)
+{
+    header_field_info *hfinfo = proto_registrar_get_byname(abbrev);
+
+    *type = COLUMNAR_TYPE_STRING;
+    *value_size = 4;
+    if (hfinfo == NULL)
+        return;
+
+    switch (hfinfo->type) {
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_UINT64:
+    case FT_FRAMENUM:
+    case FT_IPXNET:
+        *type = COLUMNAR_TYPE_UINT64;
+        *value_size = 8;
+        break;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+    case FT_INT64:
+        *type = COLUMNAR_TYPE_INT64;
+        *value_size = 8;
+        break;
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        *type = COLUMNAR_TYPE_DOUBLE;
+        *value_size = 8;
+        break;
+    case FT_BOOLEAN:
+        *type = COLUMNAR_TYPE_BOOLEAN;
+        *value_size = 1;
+        break;
+    case FT_IPv4:
+        *type = COLUMNAR_TYPE_IPV4;
+        *value_size = 4;
+        break;
+    case FT_IPv6:
+        *type = COLUMNAR_TYPE_IPV6;
+        *value_size = 16;
+        break;
+    case FT_ETHER:
+        *type = COLUMNAR_TYPE_ETHER;
+        *value_size = 6;
+        break;
+    case FT_ABSOLUTE_TIME:
+    case FT_RELATIVE_TIME:
+        *type = COLUMNAR_TYPE_TIME;
+        *value_size = 8;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Encode the value of a field as the column's type into "value".
+ * Returns FALSE if the field's type doesn't fit the column, which can
+ * happen when several fields share an abbreviation.
+ */
+static gboolean
+columnar_encode_value(struct _columnar_column *col, field_info *fi,
+                      epan_dissect_t *edt, guint8 *value)
+{
+    ftenum_t     ftype = fi->hfinfo->type;
+    guint64      u64;
+    gdouble      d;
+    nstime_t    *ts;
+    const gchar *str;
+    gpointer     dict_index;
+    guint32      len;
+
+    switch (col->type) {
+    case COLUMNAR_TYPE_UINT64:
+    case COLUMNAR_TYPE_INT64:
+    case COLUMNAR_TYPE_BOOLEAN:
+        switch (ftype) {
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_FRAMENUM:
+        case FT_IPXNET:
+        case FT_BOOLEAN:
+            u64 = fvalue_get_uinteger(&fi->value);
+            break;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+            u64 = (guint64)(gint64)fvalue_get_sinteger(&fi->value);
+            break;
+        case FT_UINT64:
+        case FT_INT64:
+            u64 = fvalue_get_integer64(&fi->value);
+            break;
+        default:
+            return FALSE;
+        }
+        if (col->type == COLUMNAR_TYPE_BOOLEAN) {
+            value[0] = u64 ? 1 : 0;
+        } else {
+            for (len = 0; len < 8; len++)
+                value[len] = (guint8)(u64 >> (8 * len));
+        }
+        return TRUE;
+
+    case COLUMNAR_TYPE_DOUBLE:
+        if (ftype != FT_FLOAT && ftype != FT_DOUBLE)
+            return FALSE;
+        d = fvalue_get_floating(&fi->value);
+        memcpy(&u64, &d, sizeof u64);
+        for (len = 0; len < 8; len++)
+            value[len] = (guint8)(u64 >> (8 * len));
+        return TRUE;
+
+    case COLUMNAR_TYPE_IPV4:
+        if (ftype != FT_IPv4)
+            return FALSE;
+        len = ipv4_get_net_order_addr((ipv4_addr *)fvalue_get(&fi->value));
+        memcpy(value, &len, 4);
+        return TRUE;
+
+    case COLUMNAR_TYPE_IPV6:
+        if (ftype != FT_IPv6)
+            return FALSE;
+        memcpy(value, &((ipv6_addr *)fvalue_get(&fi->value))->addr, 16);
+        return TRUE;
+
+    case COLUMNAR_TYPE_ETHER:
+        if (ftype != FT_ETHER)
+            return FALSE;
+        memcpy(value, fvalue_get(&fi->value), 6);
+        return TRUE;
+
+    case COLUMNAR_TYPE_TIME:
+        if (ftype != FT_ABSOLUTE_TIME && ftype != FT_RELATIVE_TIME)
+            return FALSE;
+        ts = (nstime_t *)fvalue_get(&fi->value);
+        u64 = (guint64)((gint64)ts->secs * G_GINT64_CONSTANT(1000000000) + ts->nsecs);
+        for (len = 0; len < 8; len++)
+            value[len] = (guint8)(u64 >> (8 * len));
+        return TRUE;
+
+    case COLUMNAR_TYPE_STRING:
+        str = get_node_field_value(fi, edt);
+        if (str == NULL)
+            return FALSE;
+        dict_index = g_hash_table_lookup(col->dict, str);
+        if (dict_index == NULL) {
+            len = (guint32)strlen(str);
+            dict_index = GUINT_TO_POINTER(g_hash_table_size(col->dict) + 1);
+            g_hash_table_insert(col->dict, g_strdup(str), dict_index);
+            columnar_append_uint32(col->dict_data, len);
+            g_byte_array_append(col->dict_data, (const guint8 *)str, len);
+        }
+        len = GPOINTER_TO_UINT(dict_index) - 1;
+        value[0] = (guint8)len;
+        value[1] = (guint8)(len >> 8);
+        value[2] = (guint8)(len >> 16);
+        value[3] = (guint8)(len >> 24);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static void
+columnar_reset_block(output_fields_t* fields)
+{
+    gsize i;
+    struct _columnar_column *col;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        col = &fields->columns[i];
+        g_byte_array_set_size(col->nulls, 0);
+        g_byte_array_set_size(col->offsets, 0);
+        g_byte_array_set_size(col->values, 0);
+        col->num_values = 0;
+        if (col->type == COLUMNAR_TYPE_STRING) {
+            g_hash_table_remove_all(col->dict);
+            g_byte_array_set_size(col->dict_data, 0);
+        }
+    }
+    fields->block_rows = 0;
+}
+
+static void
+columnar_write_block(output_fields_t* fields, FILE *fh)
+{
+    GByteArray *hdr;
+    gsize i;
+    guint32 len;
+    struct _columnar_column *col;
+
+    if (fields->block_rows == 0)
+        return;
+
+    hdr = g_byte_array_new();
+    g_byte_array_append(hdr, (const guint8 *)"WSCB", 4);
+    columnar_append_uint32(hdr, fields->block_rows);
+    fwrite(hdr->data, 1, hdr->len, fh);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        col = &fields->columns[i];
+        g_byte_array_set_size(hdr, 0);
+
+        len = col->nulls->len + col->offsets->len + col->values->len;
+        if (col->offsets->len != 0)
+            len += 4;   /* the final offset */
+        if (col->type == COLUMNAR_TYPE_STRING)
+            len += 4 + col->dict_data->len;
+        columnar_append_uint32(hdr, len);
+        fwrite(hdr->data, 1, hdr->len, fh);
+
+        fwrite(col->nulls->data, 1, col->nulls->len, fh);
+        if (col->offsets->len != 0) {
+            fwrite(col->offsets->data, 1, col->offsets->len, fh);
+            g_byte_array_set_size(hdr, 0);
+            columnar_append_uint32(hdr, col->num_values);
+            fwrite(hdr->data, 1, hdr->len, fh);
+        }
+        if (col->type == COLUMNAR_TYPE_STRING) {
+            g_byte_array_set_size(hdr, 0);
+            columnar_append_uint32(hdr, g_hash_table_size(col->dict));
+            fwrite(hdr->data, 1, hdr->len, fh);
+            fwrite(col->dict_data->data, 1, col->dict_data->len, fh);
+        }
+        fwrite(col->values->data, 1, col->values->len, fh);
+    }
+    g_byte_array_free(hdr, TRUE);
+
+    columnar_reset_block(fields);
+}
+
+void write_columnar_preamble(output_fields_t* fields, FILE *fh)
+{
+    GByteArray *hdr;
+    gsize i;
+    guint8 flags;
+    struct _columnar_column *col;
+    const gchar *field;
+    gsize len;
+
+    g_assert(fields);
+    g_assert(fh);
+
+    flags = (fields->occurrence == 'a') ? COLUMNAR_FLAG_LIST : 0;
+
+    columnar_free_columns(fields);
+    fields->columns = g_new0(struct _columnar_column, fields->fields->len);
+    fields->total_rows = 0;
+
+    hdr = g_byte_array_new();
+    g_byte_array_append(hdr, (const guint8 *)"WSCF", 4);
+    columnar_append_uint16(hdr, COLUMNAR_VERSION);
+    columnar_append_uint16(hdr, (guint16)fields->fields->len);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        field = (const gchar *)g_ptr_array_index(fields->fields, i);
+        col = &fields->columns[i];
+
+        columnar_type_for_field(field, &col->type, &col->value_size);
+        col->nulls = g_byte_array_new();
+        col->offsets = g_byte_array_new();
+        col->values = g_byte_array_new();
+        if (col->type == COLUMNAR_TYPE_STRING) {
+            col->dict = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+            col->dict_data = g_byte_array_new();
+        }
+
+        len = strlen(field);
+        g_byte_array_append(hdr, &col->type, 1);
+        g_byte_array_append(hdr, &flags, 1);
+        columnar_append_uint16(hdr, (guint16)len);
+        g_byte_array_append(hdr, (const guint8 *)field, (guint)len);
+    }
+    fwrite(hdr->data, 1, hdr->len, fh);
+    g_byte_array_free(hdr, TRUE);
+
+    columnar_reset_block(fields);
+}
+
+typedef struct {
+    output_fields_t *fields;
+    epan_dissect_t  *edt;
+} write_columnar_data_t;
+
+static void proto_tree_get_node_columnar_values(proto_node *node, gpointer data)
+{
+    write_columnar_data_t *call_data = (write_columnar_data_t *)data;
+    output_fields_t *fields = call_data->fields;
+    field_info *fi = PNODE_FINFO(node);
+    gpointer field_index;
+    struct _columnar_column *col;
+    guint8 value[16];
+
+    /* dissection with an invisible proto tree? */
+    g_assert(fi);
+
+    field_index = g_hash_table_lookup(fields->field_indicies, fi->hfinfo->abbrev);
+    if (NULL != field_index) {
+        col = &fields->columns[GPOINTER_TO_UINT(field_index) - 1];
+
+        if (col->row_count == 0 || fields->occurrence != 'f') {
+            if (columnar_encode_value(col, fi, call_data->edt, value)) {
+                if (col->row_count != 0 && fields->occurrence == 'l') {
+                    /* Replace the previous occurrence. */
+                    memcpy(col->values->data + col->values->len - col->value_size,
+                           value, col->value_size);
+                } else {
+                    g_byte_array_append(col->values, value, col->value_size);
+                    col->num_values++;
+                    col->row_count++;
+                }
+            }
+        }
+    }
+
+    /* Recurse here. */
+    if (node->first_child != NULL) {
+        proto_tree_children_foreach(node, proto_tree_get_node_columnar_values,
+                                    call_data);
+    }
+}
+
+void proto_tree_write_columnar(output_fields_t* fields, epan_dissect_t *edt, FILE *fh)
+{
+    write_columnar_data_t data;
+    struct _columnar_column *col;
+    guint32 row;
+    gsize i;
+    static const guint8 zeroes[16];
+
+    g_assert(fields);
+    g_assert(edt);
+    g_assert(fh);
+
+    if(NULL == fields->field_indicies) {
+        /* Prepare a lookup table from string abbreviation for field to its index. */
+        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
+
+        for (i = 0; i < fields->fields->len; i++) {
+            /* Store field indicies +1 so that zero is not a valid value,
+             * and can be distinguished from NULL as a pointer.
+             */
+            g_hash_table_insert(fields->field_indicies,
+                                g_ptr_array_index(fields->fields, i),
+                                GUINT_TO_POINTER(i + 1));
+        }
+    }
+
+    row = fields->block_rows;
+    for (i = 0; i < fields->fields->len; i++) {
+        col = &fields->columns[i];
+        col->row_count = 0;
+        if (fields->occurrence == 'a')
+            columnar_append_uint32(col->offsets, col->num_values);
+        if (row % 8 == 0)
+            g_byte_array_append(col->nulls, zeroes, 1);
+    }
+
+    data.fields = fields;
+    data.edt = edt;
+    proto_tree_children_foreach(edt->tree, proto_tree_get_node_columnar_values,
+                                &data);
+
+    for (i = 0; i < fields->fields->len; i++) {
+        col = &fields->columns[i];
+        if (col->row_count == 0) {
+            col->nulls->data[row / 8] |= 1 << (row % 8);
+            if (fields->occurrence != 'a') {
+                /* Single-valued columns have a slot for every row. */
+                g_byte_array_append(col->values, zeroes, col->value_size);
+                col->num_values++;
+            }
+        }
+    }
+
+    fields->block_rows++;
+    fields->total_rows++;
+    if (fields->block_rows >= fields->rows_per_block)
+        columnar_write_block(fields, fh);
+}
+
+void write_columnar_finale(output_fields_t* fields, FILE *fh)
+{
+    GByteArray *trailer;
+
+    columnar_write_block(fields, fh);
+
+    trailer = g_byte_array_new();
+    g_byte_array_append(trailer, (const guint8 *)"WSCE", 4);
+    columnar_append_uint32(trailer, fields->total_rows);
+    fwrite(trailer->data, 1, trailer->len, fh);
+    g_byte_array_free(trailer, TRUE);
+}
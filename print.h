@@ -124,6 +124,14 @@ extern gsize output_fields_num_fields(output_fields_t* info);
 extern gboolean output_fields_set_option(output_fields_t* info, gchar* option);
 extern void output_fields_list_options(FILE *fh);
 
+/*
+ * Prime a protocol tree with the fields, so that proto_tree_write_fields()
+ * can pick them straight out of it; if none of the fields need the text
+ * of their items, this also makes the tree invisible, so that nothing
+ * else is added to it.
+ */
+extern void output_fields_prime_edt(output_fields_t* info, epan_dissect_t *edt);
+
 /*
  * Output only these protocols
  */
@@ -157,6 +165,10 @@ extern void write_fields_preamble(output_fields_t* fields, FILE *fh);
 extern void proto_tree_write_fields(output_fields_t* fields, epan_dissect_t *edt, FILE *fh);
 extern void write_fields_finale(output_fields_t* fields, FILE *fh);
 
+extern void write_columnar_preamble(output_fields_t* fields, FILE *fh);
+extern void proto_tree_write_columnar(output_fields_t* fields, epan_dissect_t *edt, FILE *fh);
+extern void write_columnar_finale(output_fields_t* fields, FILE *fh);
+
 extern const gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt);
 
 #ifdef __cplusplus
@@ -131,10 +131,49 @@ wireshark_io_suite() {
 	test_step_add "Input file" io_step_input_file
 }
 
+# columnar output, read back with tools/wscf.py, must match "-T fields"
+io_step_columnar_round_trip() {
+	PYTHON=`which python 2> /dev/null`
+	if [ -z "$PYTHON" ] ; then
+		test_step_skipped
+		return
+	fi
+
+	COLUMNAR_FIELDS="-e frame.number -e frame.len -e eth.src -e ip.addr -e udp.srcport -e bootp.hw.mac_addr -e bootp.option.type -e frame.protocols"
+	$DUT -r "${CAPTURE_DIR}dhcp.pcap" -T fields $COLUMNAR_FIELDS > ./testout.txt 2> ./testout2.txt
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		test_step_failed "exit status of $DUT -T fields: $RETURNVALUE"
+		return
+	fi
+	# Three rows per block, so that the last block is a partial one
+	$DUT -r "${CAPTURE_DIR}dhcp.pcap" -T columnar -E rows=3 $COLUMNAR_FIELDS > ./testout.wscf 2> ./testout2.txt
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout2.txt
+		test_step_failed "exit status of $DUT -T columnar: $RETURNVALUE"
+		return
+	fi
+	$PYTHON ../tools/wscf.py ./testout.wscf > ./testout2.txt 2>&1
+	RETURNVALUE=$?
+	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
+		cat ./testout2.txt
+		test_step_failed "tools/wscf.py can't read the columnar output"
+		return
+	fi
+	if diff ./testout.txt ./testout2.txt > /dev/null ; then
+		test_step_ok
+	else
+		diff ./testout.txt ./testout2.txt
+		test_step_failed "Columnar output doesn't match the fields output"
+	fi
+}
+
 tshark_io_suite() {
 	DUT=$TSHARK
 	test_step_add "Input file" io_step_input_file
 	test_step_add "Output piping" io_step_output_piping
+	test_step_add "Columnar output round trip" io_step_columnar_round_trip
 	#test_step_add "Piping" io_step_input_piping
 }
 
@@ -150,6 +189,7 @@ io_cleanup_step() {
 	rm -f ./testout2.txt
 	rm -f ./testout.pcap
 	rm -f ./testout2.pcap
+	rm -f ./testout.wscf
 }
 
 io_suite() {
@@ -51,7 +51,7 @@ unittests_step_test() {
 		DUT=../wireshark-gtk2/`basename $DUT`
 	fi
 
-	$DUT > testout.txt 2>&1
+	$DUT $DUT_ARGS > testout.txt 2>&1
 	RETURNVALUE=$?
 	if [ ! $RETURNVALUE -eq $EXIT_OK ]; then
 		echo
@@ -65,16 +65,25 @@ unittests_step_test() {
 
 unittests_step_exntest() {
 	DUT=../epan/exntest
+	DUT_ARGS=
 	unittests_step_test
 }
 
 unittests_step_reassemble_test() {
 	DUT=../epan/reassemble_test
+	DUT_ARGS=
 	unittests_step_test
 }
 
 unittests_step_tvbtest() {
 	DUT=../epan/tvbtest
+	DUT_ARGS=
+	unittests_step_test
+}
+
+unittests_step_chunktest() {
+	DUT=../wiretap/chunktest
+	DUT_ARGS="${CAPTURE_DIR}pcap-zeroed-region.pcap"
 	unittests_step_test
 }
 
@@ -88,4 +97,5 @@ unittests_suite() {
 	test_step_add "exntest" unittests_step_exntest
 	test_step_add "reassemble_test" unittests_step_reassemble_test
 	test_step_add "tvbtest" unittests_step_tvbtest
+	test_step_add "chunktest" unittests_step_chunktest
 }
@@ -0,0 +1,113 @@
+#!/bin/bash
+
+# Compare the cost of gzip- and Zstandard-compressed capture files
+#
+# Writes each capture file given uncompressed, gzip-compressed and
+# zstd-compressed with editcap, then reports the best of several runs
+# for writing each copy and scanning it (capinfos), in seconds, and for
+# opening it without reading any records and reading one of its records
+# at random with wtap_seek_read(), in milliseconds, along with the size
+# of each copy.  The last two are timed by wiretap/wtapbench, which is
+# built with "make -C wiretap wtapbench".
+#
+# $Id$
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# Directory containing binaries.  Default current directory.
+BIN_DIR=${BIN_DIR:-.}
+CAPINFOS="$BIN_DIR/capinfos"
+EDITCAP="$BIN_DIR/editcap"
+WTAPBENCH=${WTAPBENCH:-$BIN_DIR/wiretap/wtapbench}
+
+RUNS=3
+# Opens, and random reads, timed by each run of wtapbench
+OPENS=20
+SEEKS=1000
+
+usage() {
+	echo "Usage: $0 [-n <runs>] <capture file> ..." >&2
+	exit 1
+}
+
+while getopts "n:" OPTCHAR ; do
+	case $OPTCHAR in
+		n) RUNS=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+shift $(($OPTIND - 1))
+
+if [ $# -lt 1 ] ; then
+	usage
+fi
+
+TMP_DIR=`mktemp -d ${TMPDIR:-/tmp}/compressed-bench.XXXXXX` || exit 1
+trap 'rm -rf "$TMP_DIR"' EXIT
+
+# Run "$@" $RUNS times and print the best time in seconds.
+best_time() {
+	BEST=
+	for RUN in `seq $RUNS` ; do
+		START=`date +%s.%N`
+		"$@" > /dev/null 2>&1
+		END=`date +%s.%N`
+		ELAPSED=`echo "$END - $START" | bc`
+		if [ -z "$BEST" ] || [ `echo "$ELAPSED < $BEST" | bc` -eq 1 ] ; then
+			BEST=$ELAPSED
+		fi
+	done
+	echo $BEST
+}
+
+# Run wtapbench "$@" $RUNS times and print the best time it reports for
+# one operation, in milliseconds.
+best_op_time() {
+	BEST=
+	for RUN in `seq $RUNS` ; do
+		ELAPSED=`$WTAPBENCH "$@" 2> /dev/null | sed -n 's/.*: \([0-9.]*\) s per .*/\1/p'`
+		if [ -z "$ELAPSED" ] ; then
+			echo "$WTAPBENCH $* failed" >&2
+			exit 1
+		fi
+		if [ -z "$BEST" ] || [ `echo "$ELAPSED < $BEST" | bc` -eq 1 ] ; then
+			BEST=$ELAPSED
+		fi
+	done
+	echo "$BEST * 1000" | bc -l
+}
+
+printf "%-30s %-5s %12s %8s %8s %8s %8s\n" File Type Bytes Write Open/ms Scan Seek/ms
+for CF in "$@" ; do
+	BASE="$TMP_DIR/`basename "$CF"`"
+	for TYPE in none gzip zstd ; do
+		case $TYPE in
+			none) OUT="$BASE.pcapng" ; COMPRESS= ;;
+			gzip) OUT="$BASE.pcapng.gz" ; COMPRESS="-z 1" ;;
+			zstd) OUT="$BASE.pcapng.zst" ; COMPRESS="-z 1" ;;
+		esac
+		WRITE=`best_time $EDITCAP $COMPRESS "$CF" "$OUT"`
+		OPEN=`best_op_time open $OPENS "$OUT"` || exit 1
+		SCAN=`best_time $CAPINFOS "$OUT"`
+		SEEK=`best_op_time seek $SEEKS "$OUT"` || exit 1
+		BYTES=`wc -c < "$OUT"`
+		printf "%-30s %-5s %12d %8.3f %8.3f %8.3f %8.3f\n" \
+			"`basename "$CF"`" $TYPE $BYTES $WRITE $OPEN $SCAN $SEEK
+	done
+done
@@ -0,0 +1,216 @@
+#!/usr/bin/python
+#
+# Time TShark's TCP sequence number analysis on a synthetic bulk transfer
+# over a long fat pipe.  By default the flow runs at 10 Gbit/s with a
+# 100 ms RTT, which keeps about 85000 full sized segments in flight, and
+# the sequence numbers wrap around part way through.  The capture is taken
+# at the sender; segments can be dropped after the capture point, so that
+# there are duplicate ACKs and fast retransmissions to find as well.
+#
+# $Id$
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+
+from optparse import OptionParser
+import heapq
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+MSS = 1448
+HDR_LEN = 14 + 20 + 20          # Ethernet, IPv4, TCP; all that's captured
+WIRE_OVERHEAD = 14 + 4 + 8 + 12 # plus FCS, preamble and interframe gap
+SENDER_ISN = 0xf0000000         # wraps after 256MB
+RECEIVER_ISN = 0x10000000
+
+TH_PUSH = 0x08
+TH_ACK = 0x10
+
+# Event kinds, in the order they're handled when they happen together
+SEND, ACK_ARRIVAL, DATA_ARRIVAL = range(3)
+
+class PcapWriter:
+    def __init__(self, f):
+        self.f = f
+        self.count = 0
+        self.ip_id = 0
+        # nanosecond resolution pcap, Ethernet
+        f.write(struct.pack("<IHHiIII", 0xa1b23c4d, 2, 4, 0, 0, 65535, 1))
+
+    def write(self, t, to_receiver, seq, ack, flags, seglen):
+        if to_receiver:
+            macs = b"\x00\x00\x5e\x00\x53\x02\x00\x00\x5e\x00\x53\x01"
+            addrs = struct.pack(">II", 0xc0000201, 0xc0000202)
+            ports = struct.pack(">HH", 40000, 5001)
+        else:
+            macs = b"\x00\x00\x5e\x00\x53\x01\x00\x00\x5e\x00\x53\x02"
+            addrs = struct.pack(">II", 0xc0000202, 0xc0000201)
+            ports = struct.pack(">HH", 5001, 40000)
+        self.ip_id = (self.ip_id + 1) & 0xffff
+        pkt = macs + b"\x08\x00" + \
+              struct.pack(">BBHHHBBH", 0x45, 0, 40 + seglen, self.ip_id,
+                          0x4000, 64, 6, 0) + addrs + \
+              ports + struct.pack(">IIBBHHH", seq & 0xffffffff,
+                                  ack & 0xffffffff, 5 << 4, flags,
+                                  65535, 0, 0)
+        nsecs = int(round(t * 1e9))
+        self.f.write(struct.pack("<IIII", nsecs // 1000000000,
+                                 nsecs % 1000000000, HDR_LEN,
+                                 HDR_LEN + seglen))
+        self.f.write(pkt)
+        self.count += 1
+
+def generate(f, rate, rtt, duration, loss, seed):
+    """Write the capture; returns the number of packets in it."""
+    rnd = random.Random(seed)
+    out = PcapWriter(f)
+    owd = rtt / 2.0
+    interval = (HDR_LEN + MSS + WIRE_OVERHEAD) * 8.0 / rate
+    events = []
+    order = 0
+
+    snd_nxt = SENDER_ISN
+    rcv_nxt = SENDER_ISN
+    rcv_high = SENDER_ISN       # end of the highest segment received
+    ooo = {}                    # seq -> len, received beyond a hole
+    unacked_in_order = 0
+
+    # The first new segment; later ones are scheduled as each is sent.
+    heapq.heappush(events, (0.0, SEND, order, None))
+
+    while events:
+        (t, kind, _, arg) = heapq.heappop(events)
+
+        if kind == SEND:
+            seq = arg
+            retransmission = seq is not None
+            if not retransmission:
+                seq = snd_nxt
+                snd_nxt += MSS
+                if t + interval < duration:
+                    order += 1
+                    heapq.heappush(events, (t + interval, SEND, order, None))
+            out.write(t, True, seq, RECEIVER_ISN, TH_ACK | TH_PUSH, MSS)
+            if retransmission or rnd.random() >= loss:
+                order += 1
+                heapq.heappush(events, (t + owd, DATA_ARRIVAL, order, seq))
+
+        elif kind == DATA_ARRIVAL:
+            # The receiver ACKs every other segment, and at once if
+            # anything is out of order.  Like a SACK block, an ACK tells
+            # the sender about any new hole.
+            seq = arg
+            send_ack = True
+            holes = ()
+            if seq > rcv_high:
+                holes = range(rcv_high, seq, MSS)
+            rcv_high = max(rcv_high, seq + MSS)
+            if seq == rcv_nxt:
+                rcv_nxt += MSS
+                filled = len(ooo) > 0
+                while rcv_nxt in ooo:
+                    rcv_nxt += ooo.pop(rcv_nxt)
+                unacked_in_order += 1
+                if not filled and not ooo and unacked_in_order < 2:
+                    send_ack = False
+            elif seq > rcv_nxt:
+                ooo[seq] = MSS
+            if send_ack:
+                unacked_in_order = 0
+                order += 1
+                heapq.heappush(events, (t + owd, ACK_ARRIVAL, order,
+                                        (rcv_nxt, holes)))
+
+        else:
+            # Retransmit a hole just after the third duplicate ACK for it
+            # would arrive.
+            (ack, holes) = arg
+            out.write(t, False, RECEIVER_ISN, ack, TH_ACK, 0)
+            for seq in holes:
+                order += 1
+                heapq.heappush(events, (t + 2 * interval + 1e-9, SEND,
+                                        order, seq))
+
+    return out.count
+
+def timed_tshark(tshark, capture, analyze):
+    cmd = [tshark, "-n", "-r", capture,
+           "-o", "tcp.analyze_sequence_numbers:%s" % ("TRUE" if analyze else "FALSE")]
+    devnull = open(os.devnull, "w")
+    start = time.time()
+    subprocess.call(cmd, stdout=devnull)
+    elapsed = time.time() - start
+    devnull.close()
+    return elapsed
+
+def main():
+    parser = OptionParser(usage="usage: %prog [options]")
+    parser.add_option("-t", "--tshark", dest="tshark", default="tshark",
+                      help="path to the TShark binary")
+    parser.add_option("-b", "--rate", dest="rate", type="float",
+                      default=10e9, help="link rate in bits/s")
+    parser.add_option("-r", "--rtt", dest="rtt", type="float",
+                      default=0.1, help="round trip time in seconds")
+    parser.add_option("-d", "--duration", dest="duration", type="float",
+                      default=1.0, help="seconds of data to send")
+    parser.add_option("-l", "--loss", dest="loss", type="float",
+                      default=0.0001, help="fraction of segments dropped")
+    parser.add_option("-s", "--seed", dest="seed", type="int",
+                      default=1, help="random seed for the drops")
+    parser.add_option("-w", "--write", dest="write", default=None,
+                      help="keep the capture in this file")
+    parser.add_option("-n", "--runs", dest="runs", type="int",
+                      default=3, help="number of runs; the best one counts")
+    (options, args) = parser.parse_args()
+
+    if args:
+        parser.error("unexpected arguments")
+
+    if options.write:
+        capture = options.write
+    else:
+        (fd, capture) = tempfile.mkstemp(suffix=".pcap")
+        os.close(fd)
+
+    f = open(capture, "wb")
+    packets = generate(f, options.rate, options.rtt, options.duration,
+                       options.loss, options.seed)
+    f.close()
+
+    in_flight = int(options.rate * options.rtt / 8 / MSS)
+    print("%d packets, about %d segments in flight" % (packets, in_flight))
+
+    try:
+        for analyze in (False, True):
+            best = min([timed_tshark(options.tshark, capture, analyze)
+                        for i in range(options.runs)])
+            print("analysis %-3s: %7.2f s, %9.0f packets/s" %
+                  ("on" if analyze else "off", best, packets / best))
+    finally:
+        if not options.write:
+            os.unlink(capture)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,101 @@
+#!/bin/bash
+
+# Time TShark's output formats over one or more capture files
+#
+# For each output format this runs TShark over every capture file given,
+# writing the output to /dev/null, and reports the best of several runs
+# in seconds along with the number of packets per second.  Use it to
+# compare two builds by pointing BIN_DIR at each in turn.
+#
+# The "tree" format builds the full, visible protocol tree of every packet
+# as -V does, but prints only the frame protocol, so that it mostly
+# measures the cost of building and freeing the tree.
+#
+# $Id$
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# Directory containing binaries.  Default current directory.
+BIN_DIR=${BIN_DIR:-.}
+TSHARK="$BIN_DIR/tshark"
+CAPINFOS="$BIN_DIR/capinfos"
+
+RUNS=3
+
+# Fields used for the "fields" format.
+FIELDS="-e frame.number -e frame.time_epoch -e ip.src -e ip.dst -e ip.proto \
+-e tcp.srcport -e tcp.dstport -e udp.srcport -e udp.dstport -e frame.len"
+
+usage() {
+	echo "Usage: $0 [-n <runs>] [-f <format>] <capture file> ..." >&2
+	echo "  formats: text, verbose, tree, pdml, psml, fields (default: all)" >&2
+	exit 1
+}
+
+FORMATS=
+while getopts "n:f:" OPTCHAR ; do
+	case $OPTCHAR in
+		n) RUNS=$OPTARG ;;
+		f) FORMATS="$FORMATS $OPTARG" ;;
+		*) usage ;;
+	esac
+done
+shift $(($OPTIND - 1))
+
+if [ $# -lt 1 ] ; then
+	usage
+fi
+
+if [ -z "$FORMATS" ] ; then
+	FORMATS="text verbose tree pdml psml fields"
+fi
+
+PACKETS=0
+for CF in "$@" ; do
+	COUNT=`$CAPINFOS -cT "$CF" | tail -1 | cut -f2`
+	PACKETS=$(($PACKETS + ${COUNT:-0}))
+done
+
+for FORMAT in $FORMATS ; do
+	case $FORMAT in
+		text) ARGS="" ;;
+		verbose) ARGS="-V" ;;
+		tree) ARGS="-V -O frame" ;;
+		pdml) ARGS="-T pdml" ;;
+		psml) ARGS="-T psml" ;;
+		fields) ARGS="-T fields $FIELDS" ;;
+		*) usage ;;
+	esac
+
+	BEST=
+	for RUN in `seq $RUNS` ; do
+		START=`date +%s.%N`
+		for CF in "$@" ; do
+			$TSHARK -n -r "$CF" $ARGS > /dev/null 2>&1
+		done
+		END=`date +%s.%N`
+		ELAPSED=`echo "$END - $START" | bc`
+		if [ -z "$BEST" ] || [ `echo "$ELAPSED < $BEST" | bc` -eq 1 ] ; then
+			BEST=$ELAPSED
+		fi
+	done
+
+	printf "%-8s %8.3f s  %10.0f packets/s\n" $FORMAT $BEST \
+		`echo "$PACKETS / $BEST" | bc -l`
+done
@@ -0,0 +1,140 @@
+#!/usr/bin/python
+#
+# Compare the number of small capture files per second that TShark can
+# dissect when started once per file with the number it can dissect in
+# daemon mode ("tshark -j <socket>").
+#
+# $Id$
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#
+
+from optparse import OptionParser
+import os
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+def run_forked(tshark, files, rfilter, fields):
+    devnull = open(os.devnull, "w")
+    for file in files:
+        cmd = [tshark, "-r", file]
+        if rfilter:
+            cmd += ["-R", rfilter]
+        if fields:
+            cmd += ["-Tfields"]
+            for field in fields:
+                cmd += ["-e", field]
+        subprocess.call(cmd, stdout=devnull, stderr=devnull)
+    devnull.close()
+
+def run_daemon_jobs(sock_path, files, rfilter, fields):
+    for file in files:
+        job = "r %s\n" % file
+        if rfilter:
+            job += "R %s\n" % rfilter
+        for field in fields:
+            job += "e %s\n" % field
+        job += "\n"
+
+        s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        s.connect(sock_path)
+        s.sendall(job.encode())
+        while s.recv(65536):
+            pass
+        s.close()
+
+def timed(func, args, clients):
+    # Give every client its share of the files.
+    files = args[1]
+    threads = []
+    start = time.time()
+    for i in range(clients):
+        t = threading.Thread(target=func,
+                args=(args[0], files[i::clients]) + args[2:])
+        t.start()
+        threads.append(t)
+    for t in threads:
+        t.join()
+    return time.time() - start
+
+def wait_for_socket(sock_path, timeout):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            s.connect(sock_path)
+            s.sendall(b"\n")
+            s.close()
+            return True
+        except socket.error:
+            time.sleep(0.1)
+    return False
+
+def main():
+    parser = OptionParser(usage="usage: %prog [options] <capture file> ...")
+    parser.add_option("-t", "--tshark", dest="tshark", default="tshark",
+                      help="path to the TShark binary")
+    parser.add_option("-n", "--iterations", dest="iterations", type="int",
+                      default=100, help="number of jobs per capture file")
+    parser.add_option("-w", "--workers", dest="workers", type="int",
+                      default=4, help="number of daemon workers and clients")
+    parser.add_option("-R", dest="rfilter", default=None,
+                      help="read filter to apply in every job")
+    parser.add_option("-e", dest="fields", action="append", default=[],
+                      help="field to print in every job (implies -Tfields)")
+    (options, args) = parser.parse_args()
+
+    if len(args) == 0:
+        parser.error("no capture files specified")
+
+    files = [os.path.abspath(f) for f in args] * options.iterations
+
+    forked = timed(run_forked,
+            (options.tshark, files, options.rfilter, options.fields),
+            options.workers)
+
+    sock_path = os.path.join(tempfile.mkdtemp(), "tshark.sock")
+    cmd = [options.tshark, "-j", "%s,%d" % (sock_path, options.workers)]
+    if options.fields:
+        cmd += ["-Tfields"]
+    daemon = subprocess.Popen(cmd)
+    if not wait_for_socket(sock_path, 60):
+        daemon.terminate()
+        print("TShark daemon didn't start")
+        return 1
+
+    served = timed(run_daemon_jobs,
+            (sock_path, files, options.rfilter, options.fields),
+            options.workers)
+
+    daemon.terminate()
+    daemon.wait()
+    os.rmdir(os.path.dirname(sock_path))
+
+    print("%d jobs, %d clients" % (len(files), options.workers))
+    print("forked: %8.1f jobs/s" % (len(files) / forked))
+    print("daemon: %8.1f jobs/s" % (len(files) / served))
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
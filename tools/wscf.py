@@ -0,0 +1,204 @@
+#!/usr/bin/env python
+"""
+Reader for the columnar binary output of TShark ("-T columnar").
+
+The format is described in print.c.  read_columnar() returns the field
+names and the rows; each row holds, per field, None if the field was
+absent, a list of values for list columns ("-E occurrence=a"), or a
+single value otherwise.  Values are Python integers, floats, booleans
+and strings; addresses are in their usual text forms, and time stamps
+are integers in nanoseconds.
+
+Run as a script, it prints the rows of a file, or of the standard input,
+the way "-T fields" prints them, with the values of list columns joined
+by "," and the fields separated by tabs.
+
+$Id$
+
+Wireshark - Network traffic analyzer
+By Gerald Combs <gerald@wireshark.org>
+Copyright 1998 Gerald Combs
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+"""
+
+import struct
+import sys
+
+VERSION = 1
+
+TYPE_UINT64 = 1
+TYPE_INT64 = 2
+TYPE_DOUBLE = 3
+TYPE_BOOLEAN = 4
+TYPE_IPV4 = 5
+TYPE_IPV6 = 6
+TYPE_ETHER = 7
+TYPE_TIME = 8
+TYPE_STRING = 9
+
+FLAG_LIST = 0x01
+
+VALUE_SIZES = {
+    TYPE_UINT64: 8, TYPE_INT64: 8, TYPE_DOUBLE: 8, TYPE_BOOLEAN: 1,
+    TYPE_IPV4: 4, TYPE_IPV6: 16, TYPE_ETHER: 6, TYPE_TIME: 8,
+    TYPE_STRING: 4,
+}
+
+class FormatError(Exception):
+    pass
+
+class _Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def take(self, n):
+        if self.pos + n > len(self.data):
+            raise FormatError("truncated at offset %d" % self.pos)
+        chunk = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return chunk
+
+    def unpack(self, fmt):
+        return struct.unpack(fmt, self.take(struct.calcsize(fmt)))
+
+def _ipv6_str(b):
+    groups = struct.unpack(">8H", b)
+    # Compress the longest run of zero groups, as inet_ntop() does
+    best_start, best_len = -1, 0
+    start = None
+    for i in range(9):
+        if i < 8 and groups[i] == 0:
+            if start is None:
+                start = i
+        elif start is not None:
+            if i - start > best_len and i - start > 1:
+                best_start, best_len = start, i - start
+            start = None
+    hexes = ["%x" % g for g in groups]
+    if best_len == 0:
+        return ":".join(hexes)
+    return ":".join(hexes[:best_start]) + "::" + \
+        ":".join(hexes[best_start + best_len:])
+
+def _decode_value(col_type, b, strings):
+    if col_type == TYPE_UINT64:
+        return struct.unpack("<Q", b)[0]
+    if col_type in (TYPE_INT64, TYPE_TIME):
+        return struct.unpack("<q", b)[0]
+    if col_type == TYPE_DOUBLE:
+        return struct.unpack("<d", b)[0]
+    if col_type == TYPE_BOOLEAN:
+        return struct.unpack("B", b)[0] != 0
+    if col_type == TYPE_IPV4:
+        return "%d.%d.%d.%d" % struct.unpack("4B", b)
+    if col_type == TYPE_IPV6:
+        return _ipv6_str(b)
+    if col_type == TYPE_ETHER:
+        return "%02x:%02x:%02x:%02x:%02x:%02x" % struct.unpack("6B", b)
+    if col_type == TYPE_STRING:
+        index = struct.unpack("<I", b)[0]
+        if index >= len(strings):
+            raise FormatError("string index %d out of range" % index)
+        return strings[index]
+    raise FormatError("unknown value type %d" % col_type)
+
+def read_columnar(data):
+    """Decode a whole file given as bytes; returns (names, rows)."""
+    r = _Reader(data)
+    if r.take(4) != b"WSCF":
+        raise FormatError("not a columnar file")
+    version, n_cols = r.unpack("<HH")
+    if version != VERSION:
+        raise FormatError("unsupported version %d" % version)
+    columns = []
+    for i in range(n_cols):
+        col_type, flags, name_len = r.unpack("<BBH")
+        if col_type not in VALUE_SIZES:
+            raise FormatError("unknown value type %d" % col_type)
+        name = r.take(name_len).decode("utf-8")
+        columns.append((name, col_type, flags))
+
+    rows = []
+    while True:
+        magic = r.take(4)
+        if magic == b"WSCE":
+            total = r.unpack("<I")[0]
+            if total != len(rows):
+                raise FormatError("%d rows, but the trailer says %d" %
+                                  (len(rows), total))
+            return [c[0] for c in columns], rows
+        if magic != b"WSCB":
+            raise FormatError("bad block at offset %d" % (r.pos - 4))
+        n_rows = r.unpack("<I")[0]
+        block = [[] for i in range(n_rows)]
+        for name, col_type, flags in columns:
+            col_len = r.unpack("<I")[0]
+            c = _Reader(r.take(col_len))
+            nulls = bytearray(c.take((n_rows + 7) // 8))
+            offsets = None
+            if flags & FLAG_LIST:
+                offsets = c.unpack("<%dI" % (n_rows + 1))
+            strings = []
+            if col_type == TYPE_STRING:
+                n_strings = c.unpack("<I")[0]
+                for i in range(n_strings):
+                    s_len = c.unpack("<I")[0]
+                    strings.append(c.take(s_len).decode("utf-8", "replace"))
+            size = VALUE_SIZES[col_type]
+            n_values = offsets[-1] if offsets is not None else n_rows
+            values = [_decode_value(col_type, c.take(size), strings)
+                      for i in range(n_values)]
+            if c.pos != len(c.data):
+                raise FormatError("column %s has %d extra bytes" %
+                                  (name, len(c.data) - c.pos))
+            for row in range(n_rows):
+                if nulls[row // 8] & (1 << (row % 8)):
+                    block[row].append(None)
+                elif offsets is not None:
+                    block[row].append(values[offsets[row]:offsets[row + 1]])
+                else:
+                    block[row].append(values[row])
+        rows.extend(block)
+
+def _field_str(value):
+    if value is None:
+        return ""
+    if isinstance(value, list):
+        return ",".join([_field_str(v) for v in value])
+    if isinstance(value, bool):
+        return value and "1" or "0"
+    return str(value)
+
+def main(argv):
+    if len(argv) > 2:
+        sys.stderr.write("Usage: %s [<columnar file>]\n" % argv[0])
+        return 1
+    if len(argv) == 2:
+        f = open(argv[1], "rb")
+    else:
+        f = getattr(sys.stdin, "buffer", sys.stdin)
+    try:
+        names, rows = read_columnar(f.read())
+    except FormatError:
+        sys.stderr.write("%s: %s\n" % (argv[0], sys.exc_info()[1]))
+        return 1
+    for row in rows:
+        sys.stdout.write("\t".join([_field_str(v) for v in row]) + "\n")
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,84 @@
+#!/bin/bash
+
+# Time opening capture files with Wiretap
+#
+# Runs wiretap/wtapbench, which opens and closes files without reading
+# any of their records, over every capture file in one or more
+# directories (default: test/captures), and reports the best of several
+# runs in seconds per open along with the number of files opened per
+# second.  Each file is opened several times in each run.  wtapbench is
+# built with "make -C wiretap wtapbench".  Use this to compare two builds
+# by pointing BIN_DIR at each in turn.
+#
+# $Id$
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# Directory containing binaries.  Default current directory.
+BIN_DIR=${BIN_DIR:-.}
+WTAPBENCH=${WTAPBENCH:-$BIN_DIR/wiretap/wtapbench}
+
+RUNS=3
+REPEAT=100
+
+usage() {
+	echo "Usage: $0 [-n <runs>] [-r <repeat>] [<capture directory> ...]" >&2
+	exit 1
+}
+
+while getopts "n:r:" OPTCHAR ; do
+	case $OPTCHAR in
+		n) RUNS=$OPTARG ;;
+		r) REPEAT=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+shift $(($OPTIND - 1))
+
+if [ $# -lt 1 ] ; then
+	set -- test/captures
+fi
+
+FILES=
+for DIR in "$@" ; do
+	for CF in "$DIR"/* ; do
+		[ -f "$CF" ] && FILES="$FILES $CF"
+	done
+done
+
+if [ -z "$FILES" ] ; then
+	echo "No capture files found in $*" >&2
+	exit 1
+fi
+
+BEST=
+for RUN in `seq $RUNS` ; do
+	ELAPSED=`$WTAPBENCH open $REPEAT $FILES 2> /dev/null | sed -n 's/.*: \([0-9.]*\) s per .*/\1/p'`
+	if [ -z "$ELAPSED" ] ; then
+		echo "$WTAPBENCH failed" >&2
+		exit 1
+	fi
+	if [ -z "$BEST" ] || [ `echo "$ELAPSED < $BEST" | bc` -eq 1 ] ; then
+		BEST=$ELAPSED
+	fi
+done
+
+NFILES=`echo $FILES | wc -w`
+printf "%d files x %d opens  %10.6f s per open  %10.0f files/s\n" \
+	$NFILES $REPEAT $BEST `echo "1 / $BEST" | bc -l`
@@ -0,0 +1,80 @@
+#!/bin/bash
+
+# Time reading capture files with Wiretap
+#
+# Runs capinfos and editcap over one or more capture files and reports
+# the best of several runs in seconds along with the number of records
+# read per second.  editcap copies every record to /dev/null, so it also
+# measures writing.  Use it to compare two builds by pointing BIN_DIR at
+# each in turn.
+#
+# $Id$
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+# Directory containing binaries.  Default current directory.
+BIN_DIR=${BIN_DIR:-.}
+CAPINFOS="$BIN_DIR/capinfos"
+EDITCAP="$BIN_DIR/editcap"
+
+RUNS=3
+
+usage() {
+	echo "Usage: $0 [-n <runs>] <capture file> ..." >&2
+	exit 1
+}
+
+while getopts "n:" OPTCHAR ; do
+	case $OPTCHAR in
+		n) RUNS=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+shift $(($OPTIND - 1))
+
+if [ $# -lt 1 ] ; then
+	usage
+fi
+
+RECORDS=0
+for CF in "$@" ; do
+	COUNT=`$CAPINFOS -cT "$CF" | tail -1 | cut -f2`
+	RECORDS=$(($RECORDS + ${COUNT:-0}))
+done
+
+for PROGRAM in capinfos editcap ; do
+	BEST=
+	for RUN in `seq $RUNS` ; do
+		START=`date +%s.%N`
+		for CF in "$@" ; do
+			case $PROGRAM in
+				capinfos) $CAPINFOS "$CF" > /dev/null 2>&1 ;;
+				editcap) $EDITCAP "$CF" /dev/null > /dev/null 2>&1 ;;
+			esac
+		done
+		END=`date +%s.%N`
+		ELAPSED=`echo "$END - $START" | bc`
+		if [ -z "$BEST" ] || [ `echo "$ELAPSED < $BEST" | bc` -eq 1 ] ; then
+			BEST=$ELAPSED
+		fi
+	done
+
+	printf "%-8s %8.3f s  %10.0f records/s\n" $PROGRAM $BEST \
+		`echo "$RECORDS / $BEST" | bc -l`
+done
@@ -49,6 +49,13 @@
 # include <sys/stat.h>
 #endif
 
+#if !defined(_WIN32) && defined(HAVE_SYS_SOCKET_H) && defined(HAVE_SYS_WAIT_H)
+#define TSHARK_DAEMON
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
+
 #ifndef HAVE_GETOPT
 #include "wsutil/wsgetopt.h"
 #endif
@@ -118,7 +125,8 @@ static gboolean perform_two_pass_analysis;
 typedef enum {
   WRITE_TEXT,   /* summary or detail text */
   WRITE_XML,    /* PDML or PSML */
-  WRITE_FIELDS  /* User defined list of fields */
+  WRITE_FIELDS, /* User defined list of fields */
+  WRITE_COLUMNAR /* User defined list of fields, in columnar binary form */
   /* Add CSV and the like here */
 } output_action_e;
 
@@ -305,7 +313,7 @@ print_usage(gboolean print_ver)
   fprintf(output, "  -P                       print packet summary even when writing to a file\n");
   fprintf(output, "  -S <separator>           the line separator to print between packets\n");
   fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
-  fprintf(output, "  -T pdml|ps|psml|text|fields\n");
+  fprintf(output, "  -T pdml|ps|psml|text|fields|columnar\n");
   fprintf(output, "                           format of text output (def: text)\n");
   fprintf(output, "  -e <field>               field to print if -Tfields selected (e.g. tcp.port);\n");
   fprintf(output, "                           this option can be repeated to print multiple fields\n");
@@ -316,6 +324,7 @@ print_usage(gboolean print_ver)
   fprintf(output, "     aggregator=,|/s|<char> select comma, space, printable character as\n");
   fprintf(output, "                           aggregator\n");
   fprintf(output, "     quote=d|s|n           select double, single, no quotes for values\n");
+  fprintf(output, "     rows=<count>          packets per block of -Tcolumnar output\n");
   fprintf(output, "  -t ad|a|r|d|dd|e         output format of time stamps (def: r: rel. to first)\n");
   fprintf(output, "  -u s|hms                 output format of seconds (def: s: seconds)\n");
   fprintf(output, "  -l                       flush standard output after each packet\n");
@@ -331,6 +340,9 @@ print_usage(gboolean print_ver)
   fprintf(output, "  -v                       display version info and exit\n");
   fprintf(output, "  -o <name>:<value> ...    override preference setting\n");
   fprintf(output, "  -K <keytab>              keytab file to use for kerberos decryption\n");
+#ifdef TSHARK_DAEMON
+  fprintf(output, "  -j <socket>[,<workers>]  serve dissection jobs on a UNIX socket (def: 4 workers)\n");
+#endif
   fprintf(output, "  -G [report]              dump one of several available reports and exit\n");
   fprintf(output, "                           default report=\"fields\"\n");
   fprintf(output, "                           use \"-G ?\" for more help\n");
@@ -353,6 +365,7 @@ glossary_option_help(void)
   fprintf(output, "  -G fields2               dump glossary in format 2 and exit\n");
   fprintf(output, "  -G fields3               dump glossary in format 3 and exit\n");
   fprintf(output, "  -G protocols             dump protocols in registration database and exit\n");
+  fprintf(output, "  -G prefixes              dump field prefixes registered on demand and exit\n");
   fprintf(output, "  -G values                dump value, range, true/false strings and exit\n");
   fprintf(output, "  -G ftypes                dump field type basic and descriptive names\n");
   fprintf(output, "  -G decodes               dump \"layer type\"/\"decode as\" associations and exit\n");
@@ -854,6 +867,383 @@ show_version(GString *comp_info_str, GString *runtime_info_str)
          runtime_info_str->str);
 }
 
+/* Set the time stamp precision from that of the capture file; there
+   should arguably be a command-line option to let the user set this. */
+static void
+set_timestamp_precision_from_file(wtap *wth)
+{
+  switch(wtap_file_tsprecision(wth)) {
+  case(WTAP_FILE_TSPREC_SEC):
+    timestamp_set_precision(TS_PREC_AUTO_SEC);
+    break;
+  case(WTAP_FILE_TSPREC_DSEC):
+    timestamp_set_precision(TS_PREC_AUTO_DSEC);
+    break;
+  case(WTAP_FILE_TSPREC_CSEC):
+    timestamp_set_precision(TS_PREC_AUTO_CSEC);
+    break;
+  case(WTAP_FILE_TSPREC_MSEC):
+    timestamp_set_precision(TS_PREC_AUTO_MSEC);
+    break;
+  case(WTAP_FILE_TSPREC_USEC):
+    timestamp_set_precision(TS_PREC_AUTO_USEC);
+    break;
+  case(WTAP_FILE_TSPREC_NSEC):
+    timestamp_set_precision(TS_PREC_AUTO_NSEC);
+    break;
+  default:
+    g_assert_not_reached();
+  }
+}
+
+#ifdef TSHARK_DAEMON
+/*
+ * Daemon mode ("-j <socket>[,<workers>]").
+ *
+ * Starting TShark - registering all the dissectors, reading the
+ * preferences - costs far more than dissecting a small capture file,
+ * so for lots of small files we keep the initialized process around
+ * and hand it files over a UNIX-domain socket instead.
+ *
+ * The main process binds the socket and forks a pool of workers; each
+ * worker accepts one connection at a time, so a worker never runs more
+ * than one job.  A job is a set of lines, terminated by an empty line
+ * or by the client shutting down its side of the connection, using the
+ * letters of the corresponding command-line options:
+ *
+ *   r <infile>             capture file to read (required)
+ *   R <read filter>        display filter to apply
+ *   e <field>              field to print, with "-T fields"; replaces
+ *                          the fields given on the command line
+ *   E <option>=<value>     field output option for the job's fields
+ *
+ * The output, and any error messages, are written to the connection,
+ * which is closed when the job is done.  Each job starts with fresh
+ * dissection state (cf_open() calls cleanup_dissection() and
+ * init_dissection()) and fresh tap listener state.
+ */
+
+#define DAEMON_DEFAULT_WORKERS 4
+#define DAEMON_MAX_WORKERS     256
+#define DAEMON_MAX_LINE        4096
+
+typedef struct {
+  gchar           *cf_name;
+  gchar           *rfilter;
+  output_fields_t *fields;    /* NULL to use the ones from the command line */
+} daemon_job_t;
+
+static volatile sig_atomic_t daemon_stop = 0;
+
+static void
+daemon_stop_handler(int signum _U_)
+{
+  daemon_stop = 1;
+}
+
+/* Read a line from the connection; we read it a byte at a time, as
+   the job is short and we mustn't read past its end. */
+static gboolean
+daemon_read_line(int fd, char *buf, size_t bufsize)
+{
+  size_t  len = 0;
+  ssize_t n;
+  char    c;
+
+  for (;;) {
+    n = read(fd, &c, 1);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      if (len == 0)
+        return FALSE;
+      break;
+    }
+    if (c == '\n')
+      break;
+    if (len < bufsize - 1)
+      buf[len++] = c;
+  }
+  if (len > 0 && buf[len - 1] == '\r')
+    len--;
+  buf[len] = '\0';
+  return TRUE;
+}
+
+static gboolean
+daemon_read_job(int fd, daemon_job_t *job)
+{
+  char line[DAEMON_MAX_LINE];
+
+  while (daemon_read_line(fd, line, sizeof line)) {
+    if (line[0] == '\0')
+      break;
+    if (line[1] != ' ' || line[2] == '\0') {
+      cmdarg_err("\"%s\" isn't a valid job line.", line);
+      return FALSE;
+    }
+    switch (line[0]) {
+
+    case 'r':
+      g_free(job->cf_name);
+      job->cf_name = g_strdup(&line[2]);
+      break;
+
+    case 'R':
+      g_free(job->rfilter);
+      job->rfilter = g_strdup(&line[2]);
+      break;
+
+    case 'e':
+      if (job->fields == NULL)
+        job->fields = output_fields_new();
+      output_fields_add(job->fields, &line[2]);
+      break;
+
+    case 'E':
+      if (job->fields == NULL)
+        job->fields = output_fields_new();
+      if (!output_fields_set_option(job->fields, &line[2])) {
+        cmdarg_err("\"%s\" is not a valid field output option=value pair.", &line[2]);
+        return FALSE;
+      }
+      break;
+
+    default:
+      cmdarg_err("\"%s\" isn't a valid job line.", line);
+      return FALSE;
+    }
+  }
+
+  if (job->cf_name == NULL) {
+    cmdarg_err("No capture file was specified with \"r\".");
+    return FALSE;
+  }
+  if (job->fields != NULL) {
+    if (output_action != WRITE_FIELDS && output_action != WRITE_COLUMNAR) {
+      cmdarg_err("Output fields were specified with \"e\", "
+          "but \"-Tfields\" or \"-Tcolumnar\" was not specified.");
+      return FALSE;
+    }
+    if (output_fields_num_fields(job->fields) == 0) {
+      cmdarg_err("No fields were specified with \"e\".");
+      return FALSE;
+    }
+  } else if ((output_action == WRITE_FIELDS || output_action == WRITE_COLUMNAR) &&
+             output_fields_num_fields(output_fields) == 0) {
+    cmdarg_err("\"-Tfields\" or \"-Tcolumnar\" was specified, but neither \"-e\" nor the job"
+        " specified any fields.");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static int
+daemon_run_job(daemon_job_t *job, int out_file_type, gboolean out_file_name_res)
+{
+  dfilter_t       *rfcode = NULL;
+  output_fields_t *saved_fields = output_fields;
+  int              err;
+  volatile int     status = 0;
+
+  if (job->rfilter != NULL && !dfilter_compile(job->rfilter, &rfcode)) {
+    cmdarg_err("%s", dfilter_error_msg);
+    return 2;
+  }
+  cfile.rfcode = rfcode;
+  if (job->fields != NULL)
+    output_fields = job->fields;
+
+  do_dissection = print_packet_info || rfcode || tap_listeners_require_dissection();
+  reset_tap_listeners();
+
+  if (cf_open(&cfile, job->cf_name, FALSE, &err) != CF_OK) {
+    status = 2;
+  } else {
+    set_timestamp_precision_from_file(cfile.wth);
+
+    TRY {
+      if (load_cap_file(&cfile, NULL, out_file_type, out_file_name_res, 0, 0) != 0)
+        status = 2;
+    }
+    CATCH(OutOfMemoryError) {
+      fprintf(stderr, "Out Of Memory!\n");
+      status = 2;
+    }
+    ENDTRY;
+
+    draw_tap_listeners(TRUE);
+  }
+
+  if (cfile.frames != NULL) {
+    free_frame_data_sequence(cfile.frames);
+    cfile.frames = NULL;
+  }
+  g_free(cfile.filename);
+  cfile.filename = NULL;
+  cfile.rfcode = NULL;
+  if (rfcode != NULL)
+    dfilter_free(rfcode);
+  output_fields = saved_fields;
+
+  return status;
+}
+
+static void
+daemon_worker(int listen_fd, int out_file_type, gboolean out_file_name_res)
+{
+  int           conn_fd;
+  int           saved_stdout, saved_stderr;
+  daemon_job_t  job;
+
+  signal(SIGTERM, SIG_DFL);
+  signal(SIGINT, SIG_DFL);
+  /* A client that goes away shows up as a write error, not a signal. */
+  signal(SIGPIPE, SIG_IGN);
+
+  saved_stdout = dup(1);
+  saved_stderr = dup(2);
+
+  for (;;) {
+    conn_fd = accept(listen_fd, NULL, NULL);
+    if (conn_fd < 0) {
+      if (errno == EINTR)
+        continue;
+      cmdarg_err("Can't accept a daemon connection: %s.", g_strerror(errno));
+      exit(2);
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(conn_fd, 1);
+    dup2(conn_fd, 2);
+
+    memset(&job, 0, sizeof job);
+    if (daemon_read_job(conn_fd, &job))
+      daemon_run_job(&job, out_file_type, out_file_name_res);
+
+    fflush(stdout);
+    fflush(stderr);
+    clearerr(stdout);
+    clearerr(stderr);
+    dup2(saved_stdout, 1);
+    dup2(saved_stderr, 2);
+    close(conn_fd);
+
+    g_free(job.cf_name);
+    g_free(job.rfilter);
+    if (job.fields != NULL)
+      output_fields_free(job.fields);
+  }
+}
+
+/*
+ * Bind the socket, keep "workers" worker processes running until we're
+ * told to stop, then clean up.  Only the main process returns.
+ */
+static int
+run_daemon(const char *socket_arg, int out_file_type, gboolean out_file_name_res)
+{
+  gchar              *path;
+  gchar              *p;
+  guint               workers = DAEMON_DEFAULT_WORKERS;
+  struct sockaddr_un  addr;
+  ws_statb64          st;
+  struct sigaction    sa;
+  int                 listen_fd;
+  pid_t              *pids;
+  pid_t               pid;
+  guint               i;
+
+  path = g_strdup(socket_arg);
+  p = strchr(path, ',');
+  if (p != NULL) {
+    *p++ = '\0';
+    workers = get_positive_int(p, "number of daemon workers");
+    if (workers > DAEMON_MAX_WORKERS) {
+      cmdarg_err("At most %u daemon workers can be started.", DAEMON_MAX_WORKERS);
+      g_free(path);
+      return 1;
+    }
+  }
+
+  if (strlen(path) >= sizeof addr.sun_path) {
+    cmdarg_err("The socket path \"%s\" is too long.", path);
+    g_free(path);
+    return 1;
+  }
+
+  /* Remove a socket left behind by a previous daemon, but nothing else. */
+  if (ws_stat64(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    ws_unlink(path);
+
+  listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    cmdarg_err("Can't create the daemon socket: %s.", g_strerror(errno));
+    g_free(path);
+    return 2;
+  }
+  memset(&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  g_strlcpy(addr.sun_path, path, sizeof addr.sun_path);
+  if (bind(listen_fd, (struct sockaddr *)&addr, sizeof addr) < 0 ||
+      listen(listen_fd, SOMAXCONN) < 0) {
+    cmdarg_err("Can't listen on \"%s\": %s.", path, g_strerror(errno));
+    close(listen_fd);
+    g_free(path);
+    return 2;
+  }
+
+  /* No SA_RESTART, so that waitpid() returns when we're told to stop. */
+  memset(&sa, 0, sizeof sa);
+  sa.sa_handler = daemon_stop_handler;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGTERM, &sa, NULL);
+  sigaction(SIGINT, &sa, NULL);
+
+  pids = g_new0(pid_t, workers);
+  while (!daemon_stop) {
+    for (i = 0; i < workers; i++) {
+      if (pids[i] != 0)
+        continue;
+      pid = fork();
+      if (pid == 0) {
+        daemon_worker(listen_fd, out_file_type, out_file_name_res);
+        _exit(0);
+      }
+      if (pid < 0) {
+        cmdarg_err("Can't start a daemon worker: %s.", g_strerror(errno));
+        daemon_stop = 1;
+        break;
+      }
+      pids[i] = pid;
+    }
+
+    /* Wait for a worker to die, and replace it. */
+    pid = waitpid(-1, NULL, 0);
+    for (i = 0; pid > 0 && i < workers; i++) {
+      if (pids[i] == pid)
+        pids[i] = 0;
+    }
+  }
+
+  for (i = 0; i < workers; i++) {
+    if (pids[i] != 0)
+      kill(pids[i], SIGTERM);
+  }
+  for (i = 0; i < workers; i++) {
+    if (pids[i] != 0)
+      waitpid(pids[i], NULL, 0);
+  }
+
+  close(listen_fd);
+  ws_unlink(path);
+  g_free(pids);
+  g_free(path);
+  return 0;
+}
+#endif /* TSHARK_DAEMON */
+
 int
 main(int argc, char *argv[])
 {
@@ -900,6 +1290,9 @@ main(int argc, char *argv[])
   GLogLevelFlags       log_flags;
   int                  optind_initial;
   gchar               *output_only = NULL;
+#ifdef TSHARK_DAEMON
+  gchar               *daemon_socket = NULL;
+#endif
 
 #ifdef HAVE_PCAP_REMOTE
 #define OPTSTRING_A "A:"
@@ -922,7 +1315,13 @@ main(int argc, char *argv[])
 #define OPTSTRING_I ""
 #endif
 
-#define OPTSTRING "2a:" OPTSTRING_A "b:" OPTSTRING_B "c:C:d:De:E:f:F:G:hH:i:" OPTSTRING_I "K:lLnN:o:O:pPqr:R:s:S:t:T:u:vVw:W:xX:y:z:"
+#ifdef TSHARK_DAEMON
+#define OPTSTRING_J "j:"
+#else
+#define OPTSTRING_J ""
+#endif
+
+#define OPTSTRING "2a:" OPTSTRING_A "b:" OPTSTRING_B "c:C:d:De:E:f:F:G:hH:i:" OPTSTRING_I OPTSTRING_J "K:lLnN:o:O:pPqr:R:s:S:t:T:u:vVw:W:xX:y:z:"
 
   static const char    optstring[] = OPTSTRING;
 
@@ -1069,7 +1468,10 @@ main(int argc, char *argv[])
      If none of our build or other processes uses "-G" with no arguments,
      we can just process it with the other arguments. */
   if (argc >= 2 && strcmp(argv[1], "-G") == 0) {
-    proto_initialize_all_prefixes();
+    /* "-G prefixes" reports which prefixes are still deferred, so
+       don't load them all for that one. */
+    if (argc == 2 || strcmp(argv[2], "prefixes") != 0)
+      proto_initialize_all_prefixes();
 
     if (argc == 2)
       proto_registrar_dump_fields(1);
@@ -1082,6 +1484,8 @@ main(int argc, char *argv[])
         proto_registrar_dump_fields(3);
       else if (strcmp(argv[2], "protocols") == 0)
         proto_registrar_dump_protocols();
+      else if (strcmp(argv[2], "prefixes") == 0)
+        proto_registrar_dump_prefixes();
       else if (strcmp(argv[2], "values") == 0)
         proto_registrar_dump_values();
       else if (strcmp(argv[2], "ftypes") == 0)
@@ -1216,6 +1620,11 @@ main(int argc, char *argv[])
       if (!add_decode_as(optarg))
         return 1;
       break;
+#ifdef TSHARK_DAEMON
+    case 'j':        /* Serve dissection jobs on a socket */
+      daemon_socket = optarg;
+      break;
+#endif
 #if defined(HAVE_HEIMDAL_KERBEROS) || defined(HAVE_MIT_KERBEROS)
     case 'K':        /* Kerberos keytab file */
       read_keytab_file(optarg);
@@ -1403,9 +1812,17 @@ main(int argc, char *argv[])
         output_action = WRITE_FIELDS;
         print_details = TRUE;   /* Need full tree info */
         print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "columnar") == 0) {
+        output_action = WRITE_COLUMNAR;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
+#ifdef _WIN32
+        /* The output is binary; don't let newlines be translated */
+        _setmode(fileno(stdout), O_BINARY);
+#endif
       } else {
         cmdarg_err("Invalid -T parameter.");
-        cmdarg_err_cont("It must be \"ps\", \"text\", \"pdml\", \"psml\" or \"fields\".");
+        cmdarg_err_cont("It must be \"ps\", \"text\", \"pdml\", \"psml\", \"fields\" or \"columnar\".");
         return 1;
       }
       break;
@@ -1475,13 +1892,20 @@ main(int argc, char *argv[])
   }
 
   /* If we specified output fields, but not the output field type... */
-  if (WRITE_FIELDS != output_action && 0 != output_fields_num_fields(output_fields)) {
+  if (WRITE_FIELDS != output_action && WRITE_COLUMNAR != output_action &&
+      0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
-            "but \"-Tfields\" was not specified.");
+            "but \"-Tfields\" or \"-Tcolumnar\" was not specified.");
         return 1;
-  } else if (WRITE_FIELDS == output_action && 0 == output_fields_num_fields(output_fields)) {
-        cmdarg_err("\"-Tfields\" was specified, but no fields were "
-                    "specified with \"-e\".");
+  } else if ((WRITE_FIELDS == output_action || WRITE_COLUMNAR == output_action)
+             && 0 == output_fields_num_fields(output_fields)
+#ifdef TSHARK_DAEMON
+             && daemon_socket == NULL  /* jobs can give their own fields */
+#endif
+            ) {
+        cmdarg_err("\"-T%s\" was specified, but no fields were "
+                    "specified with \"-e\".",
+                    WRITE_FIELDS == output_action ? "fields" : "columnar");
 
         return 1;
   }
@@ -1802,6 +2226,35 @@ main(int argc, char *argv[])
         we're using any taps that need dissection. */
   do_dissection = print_packet_info || rfcode || tap_listeners_require_dissection();
 
+#ifdef TSHARK_DAEMON
+  if (daemon_socket) {
+    /*
+     * We're serving jobs; they give their own capture files and
+     * read filters.
+     */
+    if (cf_name || rfilter) {
+      cmdarg_err("Capture files and read filters can't be specified with -j;"
+          " they are given by each job.");
+      return 1;
+    }
+#ifdef HAVE_LIBPCAP
+    if (global_capture_opts.saving_to_file) {
+      cmdarg_err("Packets can't be saved to a file with -j.");
+      return 1;
+    }
+#endif
+
+    /* As with "-r", don't read files with special privileges. */
+    relinquish_special_privs_perm();
+    print_current_user();
+
+    exit_status = run_daemon(daemon_socket, out_file_type, out_file_name_res);
+    epan_cleanup();
+    output_fields_free(output_fields);
+    return exit_status;
+  }
+#endif
+
   if (cf_name) {
     /*
      * We're reading a capture file.
@@ -1820,30 +2273,7 @@ main(int argc, char *argv[])
       return 2;
     }
 
-    /* Set timestamp precision; there should arguably be a command-line
-       option to let the user set this. */
-    switch(wtap_file_tsprecision(cfile.wth)) {
-    case(WTAP_FILE_TSPREC_SEC):
-      timestamp_set_precision(TS_PREC_AUTO_SEC);
-      break;
-    case(WTAP_FILE_TSPREC_DSEC):
-      timestamp_set_precision(TS_PREC_AUTO_DSEC);
-      break;
-    case(WTAP_FILE_TSPREC_CSEC):
-      timestamp_set_precision(TS_PREC_AUTO_CSEC);
-      break;
-    case(WTAP_FILE_TSPREC_MSEC):
-      timestamp_set_precision(TS_PREC_AUTO_MSEC);
-      break;
-    case(WTAP_FILE_TSPREC_USEC):
-      timestamp_set_precision(TS_PREC_AUTO_USEC);
-      break;
-    case(WTAP_FILE_TSPREC_NSEC):
-      timestamp_set_precision(TS_PREC_AUTO_NSEC);
-      break;
-    default:
-      g_assert_not_reached();
-    }
+    set_timestamp_precision_from_file(cfile.wth);
 
     /* Process the packets in the file */
     TRY {
@@ -2699,6 +3129,10 @@ process_packet_second_pass(capture_file *cf, frame_data *fdata,
 
     col_custom_prime_edt(&edt, &cf->cinfo);
 
+    /* If we're writing fields, prime the epan_dissect_t with them. */
+    if (print_packet_info && output_action == WRITE_FIELDS)
+      output_fields_prime_edt(output_fields, &edt);
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3144,6 +3578,10 @@ process_packet(capture_file *cf, gint64 offset, struct wtap_pkthdr *whdr,
 
     col_custom_prime_edt(&edt, &cf->cinfo);
 
+    /* If we're writing fields, prime the epan_dissect_t with them. */
+    if (print_packet_info && output_action == WRITE_FIELDS)
+      output_fields_prime_edt(output_fields, &edt);
+
     /* We only need the columns if either
          1) some tap needs the columns
        or
@@ -3237,45 +3675,44 @@ write_preamble(capture_file *cf)
     write_fields_preamble(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_COLUMNAR:
+    write_columnar_preamble(output_fields, stdout);
+    return !ferror(stdout);
+
   default:
     g_assert_not_reached();
     return FALSE;
   }
 }
 
-static char *
-get_line_buf(size_t len)
+/* Append a column, padded with spaces to at least "width" characters */
+static void
+append_padded_column(GString *line, const char *col_data, size_t width,
+                     gboolean left_justify)
 {
-  static char   *line_bufp    = NULL;
-  static size_t  line_buf_len = 256;
-  size_t         new_line_buf_len;
-
-  for (new_line_buf_len = line_buf_len; len > new_line_buf_len;
-       new_line_buf_len *= 2)
-    ;
-  if (line_bufp == NULL) {
-    line_buf_len = new_line_buf_len;
-    line_bufp = g_malloc(line_buf_len + 1);
-  } else {
-    if (new_line_buf_len > line_buf_len) {
-      line_buf_len = new_line_buf_len;
-      line_bufp = g_realloc(line_bufp, line_buf_len + 1);
-    }
-  }
-  return line_bufp;
+  size_t col_len = strlen(col_data);
+
+  if (!left_justify)
+    for (; col_len < width; width--)
+      g_string_append_c(line, ' ');
+  g_string_append_len(line, col_data, col_len);
+  if (left_justify)
+    for (; col_len < width; width--)
+      g_string_append_c(line, ' ');
 }
 
 static gboolean
 print_columns(capture_file *cf)
 {
-  char   *line_bufp;
-  int     i;
-  size_t  buf_offset;
-  size_t  column_len;
-
-  line_bufp = get_line_buf(256);
-  buf_offset = 0;
-  *line_bufp = '\0';
+  static GString *line = NULL;
+  int             i;
+
+  /* The line is built in a buffer that's reused for every packet. */
+  if (line == NULL)
+    line = g_string_sized_new(256);
+  else
+    g_string_truncate(line, 0);
+
   for (i = 0; i < cf->cinfo.num_cols; i++) {
     /* Skip columns not marked as visible. */
     if (!get_column_visible(i))
@@ -3297,11 +3734,7 @@ print_columns(capture_file *cf)
       if (global_capture_opts.ifaces->len > 0)
         continue;
 #endif
-      column_len = strlen(cf->cinfo.col_data[i]);
-      if (column_len < 3)
-        column_len = 3;
-      line_bufp = get_line_buf(buf_offset + column_len);
-      g_snprintf(line_bufp + buf_offset, (int)column_len + 1, "%3s", cf->cinfo.col_data[i]);
+      append_padded_column(line, cf->cinfo.col_data[i], 3, FALSE);
       break;
 
     case COL_CLS_TIME:
@@ -3310,11 +3743,7 @@ print_columns(capture_file *cf)
     case COL_ABS_DATE_TIME:
     case COL_UTC_TIME:
     case COL_UTC_DATE_TIME: /* XXX - wider */
-      column_len = strlen(cf->cinfo.col_data[i]);
-      if (column_len < 10)
-        column_len = 10;
-      line_bufp = get_line_buf(buf_offset + column_len);
-      g_snprintf(line_bufp + buf_offset, (int)column_len + 1, "%10s", cf->cinfo.col_data[i]);
+      append_padded_column(line, cf->cinfo.col_data[i], 10, FALSE);
       break;
 
     case COL_DEF_SRC:
@@ -3326,11 +3755,7 @@ print_columns(capture_file *cf)
     case COL_DEF_NET_SRC:
     case COL_RES_NET_SRC:
     case COL_UNRES_NET_SRC:
-      column_len = strlen(cf->cinfo.col_data[i]);
-      if (column_len < 12)
-        column_len = 12;
-      line_bufp = get_line_buf(buf_offset + column_len);
-      g_snprintf(line_bufp + buf_offset, (int)column_len + 1, "%12s", cf->cinfo.col_data[i]);
+      append_padded_column(line, cf->cinfo.col_data[i], 12, FALSE);
       break;
 
     case COL_DEF_DST:
@@ -3342,20 +3767,13 @@ print_columns(capture_file *cf)
     case COL_DEF_NET_DST:
     case COL_RES_NET_DST:
     case COL_UNRES_NET_DST:
-      column_len = strlen(cf->cinfo.col_data[i]);
-      if (column_len < 12)
-        column_len = 12;
-      line_bufp = get_line_buf(buf_offset + column_len);
-      g_snprintf(line_bufp + buf_offset, (int)column_len + 1, "%-12s", cf->cinfo.col_data[i]);
+      append_padded_column(line, cf->cinfo.col_data[i], 12, TRUE);
       break;
 
     default:
-      column_len = strlen(cf->cinfo.col_data[i]);
-      line_bufp = get_line_buf(buf_offset + column_len);
-      g_strlcat(line_bufp + buf_offset, cf->cinfo.col_data[i], column_len + 1);
+      g_string_append(line, cf->cinfo.col_data[i]);
       break;
     }
-    buf_offset += column_len;
     if (i != cf->cinfo.num_cols - 1) {
       /*
        * This isn't the last column, so we need to print a
@@ -3367,11 +3785,7 @@ print_columns(capture_file *cf)
        * and are printing a network source of the same type
        * next, separate them with " <- "; otherwise separate them
        * with a space.
-       *
-       * We add enough space to the buffer for " <- " or " -> ",
-       * even if we're only adding " ".
        */
-      line_bufp = get_line_buf(buf_offset + 4);
       switch (cf->cinfo.col_fmt[i]) {
 
       case COL_DEF_SRC:
@@ -3382,13 +3796,11 @@ print_columns(capture_file *cf)
         case COL_DEF_DST:
         case COL_RES_DST:
         case COL_UNRES_DST:
-          g_strlcat(line_bufp + buf_offset, " -> ", 5);
-          buf_offset += 4;
+          g_string_append(line, " -> ");
           break;
 
         default:
-          g_strlcat(line_bufp + buf_offset, " ", 5);
-          buf_offset += 1;
+          g_string_append_c(line, ' ');
           break;
         }
         break;
@@ -3401,13 +3813,11 @@ print_columns(capture_file *cf)
         case COL_DEF_DL_DST:
         case COL_RES_DL_DST:
         case COL_UNRES_DL_DST:
-          g_strlcat(line_bufp + buf_offset, " -> ", 5);
-          buf_offset += 4;
+          g_string_append(line, " -> ");
           break;
 
         default:
-          g_strlcat(line_bufp + buf_offset, " ", 5);
-          buf_offset += 1;
+          g_string_append_c(line, ' ');
           break;
         }
         break;
@@ -3420,13 +3830,11 @@ print_columns(capture_file *cf)
         case COL_DEF_NET_DST:
         case COL_RES_NET_DST:
         case COL_UNRES_NET_DST:
-          g_strlcat(line_bufp + buf_offset, " -> ", 5);
-          buf_offset += 4;
+          g_string_append(line, " -> ");
           break;
 
         default:
-          g_strlcat(line_bufp + buf_offset, " ", 5);
-          buf_offset += 1;
+          g_string_append_c(line, ' ');
           break;
         }
         break;
@@ -3439,13 +3847,11 @@ print_columns(capture_file *cf)
         case COL_DEF_SRC:
         case COL_RES_SRC:
         case COL_UNRES_SRC:
-          g_strlcat(line_bufp + buf_offset, " <- ", 5);
-          buf_offset += 4;
+          g_string_append(line, " <- ");
           break;
 
         default:
-          g_strlcat(line_bufp + buf_offset, " ", 5);
-          buf_offset += 1;
+          g_string_append_c(line, ' ');
           break;
         }
         break;
@@ -3458,13 +3864,11 @@ print_columns(capture_file *cf)
         case COL_DEF_DL_SRC:
         case COL_RES_DL_SRC:
         case COL_UNRES_DL_SRC:
-          g_strlcat(line_bufp + buf_offset, " <- ", 5);
-          buf_offset += 4;
+          g_string_append(line, " <- ");
           break;
 
         default:
-          g_strlcat(line_bufp + buf_offset, " ", 5);
-          buf_offset += 1;
+          g_string_append_c(line, ' ');
           break;
         }
         break;
@@ -3477,25 +3881,22 @@ print_columns(capture_file *cf)
         case COL_DEF_NET_SRC:
         case COL_RES_NET_SRC:
         case COL_UNRES_NET_SRC:
-          g_strlcat(line_bufp + buf_offset, " <- ", 5);
-          buf_offset += 4;
+          g_string_append(line, " <- ");
           break;
 
         default:
-          g_strlcat(line_bufp + buf_offset, " ", 5);
-          buf_offset += 1;
+          g_string_append_c(line, ' ');
           break;
         }
         break;
 
       default:
-        g_strlcat(line_bufp + buf_offset, " ", 5);
-        buf_offset += 1;
+        g_string_append_c(line, ' ');
         break;
       }
     }
   }
-  return print_line(print_stream, 0, line_bufp);
+  return print_line(print_stream, 0, line->str);
 }
 
 static gboolean
@@ -3519,6 +3920,7 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
         proto_tree_write_psml(edt, stdout);
         return !ferror(stdout);
     case WRITE_FIELDS: /*No non-verbose "fields" format */
+    case WRITE_COLUMNAR:
         g_assert_not_reached();
         break;
     }
@@ -3556,6 +3958,9 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
       proto_tree_write_fields(output_fields, edt, stdout);
       printf("\n");
       return !ferror(stdout);
+    case WRITE_COLUMNAR:
+      proto_tree_write_columnar(output_fields, edt, stdout);
+      return !ferror(stdout);
     }
   }
   if (print_hex) {
@@ -3590,6 +3995,10 @@ write_finale(void)
     write_fields_finale(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_COLUMNAR:
+    write_columnar_finale(output_fields, stdout);
+    return !ferror(stdout);
+
   default:
     g_assert_not_reached();
     return FALSE;
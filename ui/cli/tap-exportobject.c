@@ -0,0 +1,483 @@
+/* tap-exportobject.c
+ * Write the objects found by the export object taps to a directory
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* This module is the tshark counterpart of the GUI's "Export Objects"
+ * dialog. Rather than keeping every object in memory until the end of
+ * the capture, HTTP and DICOM objects are written out as soon as the
+ * dissector hands them over and their payload is freed. Objects whose
+ * contents have already been written once are not written again; they
+ * only get a line in the index file pointing at the first copy.
+ *
+ * SMB hands over a file chunk by chunk, as it is read or written, so
+ * the chunks of each open file are put in a temporary file, which is
+ * written out like the other objects when the file is closed, or at the
+ * end of the capture if it never is.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/filesystem.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+#include <epan/crypt/md5.h>
+#include <epan/dissectors/packet-smb.h>
+
+#include <wsutil/file_util.h>
+
+#include <ui/export_object.h>
+
+#define MAXFILELEN	255
+
+#define COPY_BUF_SIZE	65536
+
+static gboolean eo_smb_stream_packet(void *tapdata, packet_info *pinfo,
+	epan_dissect_t *edt, const void *data);
+
+typedef struct _eo_proto_t {
+	const char *name;		/* as given to -z export-objects */
+	const char *tapname;
+	tap_packet_cb packet;
+} eo_proto_t;
+
+static const eo_proto_t eo_protos[] = {
+	{ "dicom", "dicom_eo", eo_dicom_packet },
+	{ "http",  "http_eo",  eo_http_packet },
+	{ "smb",   "smb_eo",   eo_smb_stream_packet },
+	{ NULL,    NULL,       NULL }
+};
+
+struct _export_object_list_t {
+	const eo_proto_t *proto;
+	gchar *dir;
+	FILE *index;
+	guint32 objects;
+	GHashTable *digests;	/* MD5 (hex) -> name of the file written */
+	GHashTable *smb_files;	/* tid << 16 | fid -> eo_smb_file_t */
+	guint32 written;
+	guint32 duplicates;
+	guint32 failed;
+	gint64 bytes_written;
+};
+
+/* An SMB file that is open, with the chunks seen so far */
+typedef struct _eo_smb_file_t {
+	export_object_entry_t *entry;	/* payload_len is the file length */
+	FILE *tmp;			/* NULL after an error */
+	int err;
+	guint8 contains;		/* SMB_EO_READS and SMB_EO_WRITES */
+} eo_smb_file_t;
+
+#define SMB_EO_READS	0x01
+#define SMB_EO_WRITES	0x02
+
+static void
+eo_free_entry(export_object_entry_t *entry)
+{
+	g_free(entry->hostname);
+	g_free(entry->content_type);
+	g_free(entry->filename);
+	g_free(entry->payload_data);
+	g_free(entry);
+}
+
+/* Open a new file in the output directory, the same way the GUI's
+ * "Save All" picks its names. */
+static int
+eo_open_unique(export_object_list_t *object_list, export_object_entry_t *entry, gchar **name)
+{
+	GString *safe_filename;
+	gchar *fullpath;
+	int count=0;
+	int fd;
+
+	if(strlen(object_list->dir) >= MAXFILELEN){
+		return -1;
+	}
+
+	do {
+		if(entry->filename){
+			safe_filename=eo_massage_str(entry->filename,
+				MAXFILELEN - strlen(object_list->dir), count);
+		} else {
+			char generic_name[256];
+			const char *ext;
+
+			ext=ct2ext(entry->content_type);
+			g_snprintf(generic_name, sizeof(generic_name),
+				"object%u%s%s", entry->pkt_num, ext ? "." : "",
+				ext ? ext : "");
+			safe_filename=eo_massage_str(generic_name,
+				MAXFILELEN - strlen(object_list->dir), count);
+		}
+		fullpath=g_build_filename(object_list->dir, safe_filename->str, NULL);
+		fd=ws_open(fullpath, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0644);
+		g_free(fullpath);
+		if(fd != -1){
+			*name=g_string_free(safe_filename, FALSE);
+			return fd;
+		}
+		g_string_free(safe_filename, TRUE);
+	} while(errno == EEXIST && ++count < 1000);
+
+	return -1;
+}
+
+static void
+eo_digest_hex(md5_state_t *ms, gchar *hex)
+{
+	md5_byte_t digest[16];
+	int i;
+
+	md5_finish(ms, digest);
+	for(i=0;i<16;i++){
+		g_snprintf(&hex[i*2], 3, "%02x", digest[i]);
+	}
+}
+
+/* Write an object's contents, from memory or from an SMB temporary
+ * file, unless a copy with the same digest has been written already,
+ * and add its line to the index. */
+static void
+eo_write_object(export_object_list_t *object_list, export_object_entry_t *entry,
+    FILE *tmp, const gchar *hex)
+{
+	const gchar *name;
+	gchar *new_name=NULL;
+	guint8 *buf;
+	size_t len;
+	int fd, err;
+
+	object_list->objects++;
+
+	name=g_hash_table_lookup(object_list->digests, hex);
+	if(name){
+		object_list->duplicates++;
+	} else {
+		fd=eo_open_unique(object_list, entry, &new_name);
+		if(fd == -1){
+			fprintf(stderr, "tshark: Can't create a file for the object in frame %u: %s\n",
+			    entry->pkt_num, g_strerror(errno));
+			object_list->failed++;
+			return;
+		}
+		err=0;
+		if(tmp){
+			buf=g_malloc(COPY_BUF_SIZE);
+			rewind(tmp);
+			while((len=fread(buf, 1, COPY_BUF_SIZE, tmp)) != 0){
+				if(ws_write(fd, buf, (unsigned int)len) != (int)len){
+					err=errno;
+					break;
+				}
+			}
+			if(err == 0 && ferror(tmp)){
+				err=errno ? errno : EIO;
+			}
+			g_free(buf);
+			if(ws_close(fd) < 0 && err == 0){
+				err=errno;
+			}
+		} else if(!eo_write_entry_fd(fd, entry, &err)){
+			ws_close(fd);
+		} else if(ws_close(fd) < 0){
+			err=errno;
+		}
+		if(err != 0){
+			gchar *fullpath;
+
+			/* Don't leave a truncated file for later duplicates to
+			 * point at; the next copy of the object gets another go. */
+			fprintf(stderr, "tshark: Can't write %s: %s\n",
+			    new_name, g_strerror(err));
+			fullpath=g_build_filename(object_list->dir, new_name, NULL);
+			ws_unlink(fullpath);
+			g_free(fullpath);
+			g_free(new_name);
+			object_list->failed++;
+		} else {
+			object_list->written++;
+			object_list->bytes_written+=entry->payload_len;
+			g_hash_table_insert(object_list->digests, g_strdup(hex), new_name);
+			name=new_name;
+		}
+	}
+
+	if(object_list->index){
+		fprintf(object_list->index, "%u\t%s\t%s\t%" G_GINT64_MODIFIER "d\t%s\t%s\n",
+		    entry->pkt_num,
+		    entry->hostname ? entry->hostname : "",
+		    entry->content_type ? entry->content_type : "",
+		    entry->payload_len, hex, name ? name : "");
+	}
+}
+
+void
+object_list_add_entry(export_object_list_t *object_list, export_object_entry_t *entry)
+{
+	md5_state_t ms;
+	gchar hex[33];
+
+	md5_init(&ms);
+	md5_append(&ms, entry->payload_data, (size_t)entry->payload_len);
+	eo_digest_hex(&ms, hex);
+	eo_write_object(object_list, entry, NULL, hex);
+	eo_free_entry(entry);
+}
+
+/* Entries are written as soon as they are added, so there are none to
+ * get back */
+export_object_entry_t *
+object_list_get_entry(export_object_list_t *object_list _U_, int row _U_)
+{
+	return NULL;
+}
+
+/* Write out an SMB file whose chunks are all in its temporary file */
+static void
+eo_smb_finish_file(export_object_list_t *object_list, eo_smb_file_t *file)
+{
+	export_object_entry_t *entry=file->entry;
+	md5_state_t ms;
+	gchar hex[33];
+	guint8 *buf;
+	size_t len;
+
+	entry->content_type=g_strdup_printf("FILE %s",
+	    file->contains == (SMB_EO_READS|SMB_EO_WRITES) ? "R&W" :
+	    file->contains == SMB_EO_WRITES ? "W" : "R");
+
+	if(file->tmp && fflush(file->tmp) != 0){
+		file->err=errno;
+	}
+	if(file->err == 0){
+		md5_init(&ms);
+		buf=g_malloc(COPY_BUF_SIZE);
+		rewind(file->tmp);
+		while((len=fread(buf, 1, COPY_BUF_SIZE, file->tmp)) != 0){
+			md5_append(&ms, buf, len);
+		}
+		if(ferror(file->tmp)){
+			file->err=errno ? errno : EIO;
+		}
+		g_free(buf);
+	}
+	if(file->err == 0){
+		eo_digest_hex(&ms, hex);
+		eo_write_object(object_list, entry, file->tmp, hex);
+	} else {
+		fprintf(stderr, "tshark: Can't keep the SMB file in frame %u: %s\n",
+		    entry->pkt_num, g_strerror(file->err));
+		object_list->objects++;
+		object_list->failed++;
+	}
+
+	if(file->tmp){
+		fclose(file->tmp);
+	}
+	eo_free_entry(entry);
+	g_free(file);
+}
+
+static gboolean
+eo_smb_finish_remaining(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	eo_smb_finish_file((export_object_list_t *)user_data, (eo_smb_file_t *)value);
+	return TRUE;
+}
+
+static gboolean
+eo_smb_stream_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_,
+    const void *data)
+{
+	export_object_list_t *object_list=tapdata;
+	const smb_eo_t *eo_info=data;
+	eo_smb_file_t *file;
+	export_object_entry_t *entry;
+	gpointer key;
+	gchar **parts;
+	guint64 end;
+
+	key=GUINT_TO_POINTER(((guint)eo_info->tid & 0xffff) << 16 | ((guint)eo_info->fid & 0xffff));
+	file=g_hash_table_lookup(object_list->smb_files, key);
+
+	if(eo_info->cmd == SMB_COM_CLOSE){
+		if(file){
+			g_hash_table_remove(object_list->smb_files, key);
+			eo_smb_finish_file(object_list, file);
+		}
+		return FALSE;
+	}
+
+	/* right now we only support files */
+	if(eo_info->fid_type != SMB_FID_TYPE_FILE){
+		return FALSE;
+	}
+
+	if(!file){
+		entry=g_new0(export_object_entry_t, 1);
+		entry->pkt_num=pinfo->fd->num;
+		entry->hostname=g_strdup(eo_info->hostname);
+		if(g_str_has_prefix(eo_info->filename, "\\")){
+			parts=g_strsplit(eo_info->filename, "\\", -1);
+			entry->filename=g_strdup(parts[g_strv_length(parts)-1]);
+			g_strfreev(parts);
+		} else {
+			entry->filename=g_strdup(eo_info->filename);
+		}
+		file=g_new0(eo_smb_file_t, 1);
+		file->entry=entry;
+		file->tmp=tmpfile();
+		if(file->tmp == NULL){
+			file->err=errno;
+		}
+		g_hash_table_insert(object_list->smb_files, key, file);
+	}
+
+	file->contains|=eo_info->cmd == SMB_COM_WRITE_ANDX ? SMB_EO_WRITES : SMB_EO_READS;
+	if(file->tmp == NULL){
+		return FALSE;
+	}
+	if(ws_fseek64(file->tmp, (gint64)eo_info->smb_file_offset, SEEK_SET) != 0 ||
+	    fwrite(eo_info->payload_data, 1, eo_info->payload_len, file->tmp) != eo_info->payload_len){
+		/* the file is reported as failed when it's finished */
+		file->err=errno ? errno : EIO;
+		fclose(file->tmp);
+		file->tmp=NULL;
+		return FALSE;
+	}
+	end=eo_info->smb_file_offset + eo_info->payload_len;
+	if(end > (guint64)file->entry->payload_len){
+		file->entry->payload_len=(gint64)end;
+	}
+	return FALSE;
+}
+
+static void
+eo_draw(void *tapdata)
+{
+	export_object_list_t *object_list=tapdata;
+
+	/* SMB files that were still open at the end of the capture */
+	g_hash_table_foreach_remove(object_list->smb_files, eo_smb_finish_remaining, object_list);
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("%s objects exported to %s\n", object_list->proto->name, object_list->dir);
+	printf("Objects: %u\n", object_list->objects);
+	printf("Written: %u (%" G_GINT64_MODIFIER "d bytes)\n",
+	    object_list->written, object_list->bytes_written);
+	printf("Duplicates skipped: %u\n", object_list->duplicates);
+	if(object_list->failed){
+		printf("Failed: %u\n", object_list->failed);
+	}
+	printf("===================================================================\n");
+
+	if(object_list->index){
+		fclose(object_list->index);
+		object_list->index=NULL;
+	}
+}
+
+static void
+eo_init(const char *optarg, void* userdata _U_)
+{
+	export_object_list_t *object_list;
+	const eo_proto_t *proto;
+	const char *dir;
+	gchar *index_path;
+	GString *error_string;
+	size_t len;
+
+	if(strncmp(optarg, "export-objects,", 15)!=0){
+		fprintf(stderr, "tshark: invalid \"-z export-objects,<protocol>,<directory>\" argument\n");
+		exit(1);
+	}
+	optarg+=15;
+
+	for(proto=eo_protos;proto->name;proto++){
+		len=strlen(proto->name);
+		if(strncmp(optarg, proto->name, len)==0 && optarg[len]==','){
+			break;
+		}
+	}
+	if(!proto->name){
+		fprintf(stderr, "tshark: \"-z export-objects\" supports dicom, http and smb\n");
+		exit(1);
+	}
+	dir=optarg+strlen(proto->name)+1;
+	if(*dir==0){
+		fprintf(stderr, "tshark: \"-z export-objects,%s\" needs a directory\n", proto->name);
+		exit(1);
+	}
+
+	if(test_for_directory(dir) != EISDIR && ws_mkdir(dir, 0755) != 0){
+		fprintf(stderr, "tshark: Can't create directory %s: %s\n", dir, g_strerror(errno));
+		exit(1);
+	}
+
+	object_list=g_malloc0(sizeof(export_object_list_t));
+	object_list->proto=proto;
+	object_list->dir=g_strdup(dir);
+	object_list->digests=g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	object_list->smb_files=g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	index_path=g_strdup_printf("%s%c%s-index.txt", dir, G_DIR_SEPARATOR, proto->name);
+	object_list->index=ws_fopen(index_path, "w");
+	if(!object_list->index){
+		fprintf(stderr, "tshark: Can't create %s: %s\n", index_path, g_strerror(errno));
+		exit(1);
+	}
+	g_free(index_path);
+	fprintf(object_list->index, "# packet\thostname\tcontent type\tbytes\tmd5\tfile\n");
+
+	error_string=register_tap_listener(proto->tapname, object_list, NULL, 0, NULL, proto->packet, eo_draw);
+	if(error_string){
+		fprintf(stderr, "tshark: Couldn't register export-objects tap: %s\n",
+		    error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+
+void
+register_tap_listener_exportobject(void)
+{
+	register_stat_cmd_arg("export-objects,", eo_init, NULL);
+}
@@ -36,9 +36,13 @@
 #include <ctype.h>
 #include <stdio.h>
 
+#include <errno.h>
+
 #include <glib.h>
 #include <epan/addr_resolv.h>
+#include <epan/conversation.h>
 #include <epan/epan_dissect.h>
+#include <epan/filesystem.h>
 #include <epan/follow.h>
 #include <epan/stat_cmd_args.h>
 #include <epan/tap.h>
@@ -85,6 +89,10 @@ typedef struct
 #define STR_FOLLOW      "follow,"
 #define STR_FOLLOW_TCP  STR_FOLLOW "tcp"
 #define STR_FOLLOW_UDP  STR_FOLLOW "udp"
+#define STR_FOLLOW_ALL  STR_FOLLOW "all"
+
+/* default limit on out of order TCP data kept in memory, in megabytes */
+#define FOLLOW_ALL_MEM_LIMIT    64
 
 #define STR_HEX         ",hex"
 #define STR_ASCII       ",ascii"
@@ -858,9 +866,127 @@ followUdp(
   }
 }
 
+typedef struct
+{
+  follow_all_t *        allp;
+  gchar *               dirp;
+} follow_all_ctx_t;
+
+static int
+followAllUdpPacket(
+  void *                contextp,
+  packet_info *         pip,
+  epan_dissect_t *      edp _U_,
+  const void *          datap
+  )
+{
+  follow_all_ctx_t *    fap     = contextp;
+  const tvbuff_t *      tvbp    = datap;
+  conversation_t *      convp;
+
+  if (tvbp->length > 0)
+  {
+    convp = find_or_create_conversation(pip);
+    follow_all_udp_packet(fap->allp, convp->index,
+                          &pip->net_src, &pip->net_dst, pip->srcport,
+                          (const char *)tvbp->real_data, tvbp->length);
+  }
+
+  return 0;
+}
+
+static void
+followAllDraw(
+  void *        contextp
+  )
+{
+  static const char     seperator[] =
+    "===================================================================\n";
+
+  follow_all_ctx_t *    fap     = contextp;
+  guint                 tcp;
+  guint                 udp;
+  int                   err;
+
+  err = follow_all_finish(fap->allp, &tcp, &udp);
+
+  printf("\n%s", seperator);
+  printf("Follow: all\n");
+  printf("Directory: %s\n", fap->dirp);
+  printf("TCP streams: %u\n", tcp);
+  printf("UDP streams: %u\n", udp);
+  printf("%s", seperator);
+
+  if (err != 0)
+  {
+    fprintf(stderr, "tshark: follow - Error writing streams to \"%s\": %s\n",
+            fap->dirp, g_strerror(err));
+  }
+}
+
+static void
+followAll(
+  const char *  optarg,
+  void *        userdata _U_
+  )
+{
+  static follow_all_ctx_t *     fap     = NULL;
+  const char *                  limitp;
+  guint                         limit   = FOLLOW_ALL_MEM_LIMIT;
+  int                           len;
+  GString *                     errp;
+
+  if (fap != NULL)
+  {
+    followExit("Only one follow,all can be used.");
+  }
+
+  optarg += strlen(STR_FOLLOW_ALL);
+  if (*optarg++ != ',' || *optarg == 0)
+  {
+    followExit("Missing directory.");
+  }
+
+  fap = g_malloc0(sizeof *fap);
+
+  /* an optional trailing ",<megabytes>" sets the memory limit */
+  limitp = strrchr(optarg, ',');
+  if (limitp != NULL &&
+      sscanf(limitp, ",%u%n", &limit, &len) == 1 && limitp[len] == 0)
+  {
+    fap->dirp = g_strndup(optarg, limitp - optarg);
+  }
+  else
+  {
+    limit = FOLLOW_ALL_MEM_LIMIT;
+    fap->dirp = g_strdup(optarg);
+  }
+
+  if (test_for_directory(fap->dirp) != EISDIR &&
+      ws_mkdir(fap->dirp, 0755) != 0)
+  {
+    followExit("Can't create output directory.");
+  }
+
+  fap->allp = follow_all_new(fap->dirp, (gsize)limit * 1024 * 1024);
+  follow_all_start(fap->allp);
+
+  errp = register_tap_listener("udp_follow", fap, NULL, 0,
+                               NULL, followAllUdpPacket, followAllDraw);
+  if (errp != NULL)
+  {
+    follow_all_free(fap->allp);
+    g_free(fap->dirp);
+    g_free(fap);
+    g_string_free(errp, TRUE);
+    followExit("Error registering udp tap listner.");
+  }
+}
+
 void
 register_tap_listener_follow(void)
 {
   register_stat_cmd_arg(STR_FOLLOW_TCP, followTcp, NULL);
   register_stat_cmd_arg(STR_FOLLOW_UDP, followUdp, NULL);
+  register_stat_cmd_arg(STR_FOLLOW_ALL, followAll, NULL);
 }
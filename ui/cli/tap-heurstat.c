@@ -0,0 +1,127 @@
+/* tap-heurstat.c
+ * Heuristic dissector statistics for tshark
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* This module prints how often each heuristic dissector was tried and
+ * how often it recognized a packet. The counters are kept by
+ * dissector_try_heuristic() itself, so this tap only has to print them.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <string.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+typedef struct _heur_table_t {
+	const gchar *name;
+	heur_dissector_list_t *sub_dissectors;
+} heur_table_t;
+
+static gint
+heurstat_table_cmp(gconstpointer a, gconstpointer b)
+{
+	return strcmp(((const heur_table_t *)a)->name, ((const heur_table_t *)b)->name);
+}
+
+static void
+heurstat_add_table(const gchar *table_name, gpointer table, gpointer user_data)
+{
+	GSList **tables=user_data;
+	heur_table_t *ht;
+
+	ht=g_malloc(sizeof(heur_table_t));
+	ht->name=table_name;
+	ht->sub_dissectors=table;
+	*tables=g_slist_insert_sorted(*tables, ht, heurstat_table_cmp);
+}
+
+static void
+heurstat_draw_table(const heur_table_t *ht)
+{
+	GSList *entry;
+	heur_dtbl_entry_t *hdtbl_entry;
+
+	for(entry=*ht->sub_dissectors;entry;entry=g_slist_next(entry)){
+		hdtbl_entry=(heur_dtbl_entry_t *)entry->data;
+		if(hdtbl_entry->protocol==NULL || hdtbl_entry->tries==0){
+			continue;
+		}
+		printf("%-12s %-20s %12u %12u %7.2f%%\n",
+			ht->name,
+			proto_get_protocol_filter_name(proto_get_id(hdtbl_entry->protocol)),
+			hdtbl_entry->tries,
+			hdtbl_entry->hits,
+			100.0*hdtbl_entry->hits/hdtbl_entry->tries);
+	}
+}
+
+static void
+heurstat_draw(void *dummy _U_)
+{
+	GSList *tables=NULL, *table;
+
+	printf("===================================================================\n");
+	printf("Heuristic Dissector Statistics\n");
+	printf("Table        Dissector                   Tries         Hits     Rate\n");
+
+	/* print the tables in a stable order */
+	dissector_all_heur_tables_foreach_table(heurstat_add_table, &tables);
+	for(table=tables;table;table=g_slist_next(table)){
+		heurstat_draw_table(table->data);
+		g_free(table->data);
+	}
+	g_slist_free(tables);
+
+	printf("===================================================================\n");
+}
+
+
+static void
+heurstat_init(const char *optarg, void* userdata _U_)
+{
+	GString *error_string;
+
+	if(strcmp("heur,stat",optarg)!=0){
+		fprintf(stderr, "tshark: invalid \"-z heur,stat\" argument\n");
+		exit(1);
+	}
+
+	error_string=register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING, NULL, NULL, heurstat_draw);
+	if(error_string){
+		fprintf(stderr, "tshark: Couldn't register heur,stat tap: %s\n",
+		    error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+
+void
+register_tap_listener_heurstat(void)
+{
+	register_stat_cmd_arg("heur,stat", heurstat_init, NULL);
+}
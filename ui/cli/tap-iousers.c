@@ -46,14 +46,16 @@
 #include <epan/dissectors/packet-fc.h>
 #include <epan/dissectors/packet-fddi.h>
 
+#include "ui/conversation_hash.h"
+
 typedef struct _io_users_t {
 	const char *type;
 	char *filter;
-	struct _io_users_item_t *items;
+	GArray *items;          /* io_users_item_t, in order of appearance */
+	GHashTable *hashtable;  /* conversation key -> index into items + 1 */
 } io_users_t;
 
 typedef struct _io_users_item_t {
-    struct _io_users_item_t *next;
     char                    *name1;
     char                    *name2;
     conv_id_t               conv_id;
@@ -67,9 +69,83 @@ typedef struct _io_users_item_t {
     nstime_t                stop_time;
 } io_users_item_t;
 
+/* Key for conversations that are only known by their printed names */
+typedef struct _io_users_name_key_t {
+    const char              *name1;
+    const char              *name2;
+    conv_id_t               conv_id;
+} io_users_name_key_t;
+
 #define iousers_process_name_packet(iu, name1, name2, direction, pkt_len, ts) \
     iousers_process_name_packet_with_conv_id(iu, name1, name2, CONV_ID_UNSET, direction, pkt_len, ts)
 
+static guint
+iousers_name_hash(gconstpointer v)
+{
+	const io_users_name_key_t *key = (const io_users_name_key_t *)v;
+
+	return (g_str_hash(key->name1) * 31 + g_str_hash(key->name2)) ^ key->conv_id;
+}
+
+static gboolean
+iousers_name_match(gconstpointer v, gconstpointer w)
+{
+	const io_users_name_key_t *v1 = (const io_users_name_key_t *)v;
+	const io_users_name_key_t *v2 = (const io_users_name_key_t *)w;
+
+	return (v1->conv_id == v2->conv_id)
+	    && (!strcmp(v1->name1, v2->name1))
+	    && (!strcmp(v1->name2, v2->name2));
+}
+
+/* Look up a conversation, returns NULL if it hasn't been seen yet */
+static io_users_item_t *
+iousers_lookup_item(io_users_t *iu, gconstpointer key)
+{
+	guint idx;
+
+	idx=GPOINTER_TO_UINT(g_hash_table_lookup(iu->hashtable, key));
+	if(!idx){
+		return NULL;
+	}
+	return &g_array_index(iu->items, io_users_item_t, idx-1);
+}
+
+/* Append a new, empty conversation and index it by key */
+static io_users_item_t *
+iousers_new_item(io_users_t *iu, gpointer key, nstime_t *ts)
+{
+	io_users_item_t new_iui, *iui;
+
+	memset(&new_iui, 0, sizeof(new_iui));
+	memcpy(&new_iui.start_time, ts, sizeof(new_iui.start_time));
+	memcpy(&new_iui.stop_time, ts, sizeof(new_iui.stop_time));
+	g_array_append_val(iu->items, new_iui);
+	iui=&g_array_index(iu->items, io_users_item_t, iu->items->len-1);
+
+	g_hash_table_insert(iu->hashtable, key, GUINT_TO_POINTER(iu->items->len));
+
+	return iui;
+}
+
+static void
+iousers_update_item(io_users_item_t *iui, int direction, guint64 pkt_len, nstime_t *ts)
+{
+	if (nstime_cmp(ts, &iui->stop_time) > 0) {
+		memcpy(&iui->stop_time, ts, sizeof(iui->stop_time));
+	} else if (nstime_cmp(ts, &iui->start_time) < 0) {
+		memcpy(&iui->start_time, ts, sizeof(iui->start_time));
+	}
+
+	if(direction){
+		iui->frames1++;
+		iui->bytes1+=pkt_len;
+	} else {
+		iui->frames2++;
+		iui->bytes2+=pkt_len;
+	}
+}
+
 void
 iousers_process_name_packet_with_conv_id(
     io_users_t *iu,
@@ -81,44 +157,87 @@ iousers_process_name_packet_with_conv_id(
     nstime_t *ts)
 {
 	io_users_item_t *iui;
+	io_users_name_key_t existing_key;
 
-	for(iui=iu->items;iui;iui=iui->next){
-		if((iui->conv_id==conv_id)
-            && (!strcmp(iui->name1, name1))
-            && (!strcmp(iui->name2, name2)) ){
-			break;
-		}
+	if(!iu->hashtable){
+		iu->hashtable=g_hash_table_new_full(iousers_name_hash, iousers_name_match, g_free, NULL);
 	}
 
+	existing_key.name1=name1;
+	existing_key.name2=name2;
+	existing_key.conv_id=conv_id;
+	iui=iousers_lookup_item(iu, &existing_key);
+
 	if(!iui){
-		iui=g_malloc(sizeof(io_users_item_t));
-		iui->next=iu->items;
-		iu->items=iui;
+		io_users_name_key_t *new_key;
+
+		new_key=g_new(io_users_name_key_t, 1);
+		iui=iousers_new_item(iu, new_key, ts);
 		iui->name1=g_strdup(name1);
 		iui->name2=g_strdup(name2);
-        iui->conv_id=conv_id;
-		iui->frames1=0;
-		iui->frames2=0;
-		iui->bytes1=0;
-		iui->bytes2=0;
-		memcpy(&iui->start_time, ts, sizeof(iui->start_time));
-		memcpy(&iui->stop_time, ts, sizeof(iui->stop_time));
-	}
-	else {
-		if (nstime_cmp(ts, &iui->stop_time) > 0) {
-			memcpy(&iui->stop_time, ts, sizeof(iui->stop_time));
-		} else if (nstime_cmp(ts, &iui->start_time) < 0) {
-			memcpy(&iui->start_time, ts, sizeof(iui->start_time));
-		}
+		iui->conv_id=conv_id;
+		/* the names are owned by the item, which stays put in the array */
+		new_key->name1=iui->name1;
+		new_key->name2=iui->name2;
+		new_key->conv_id=conv_id;
 	}
 
-	if(direction){
-		iui->frames1++;
-		iui->bytes1+=pkt_len;
+	iousers_update_item(iui, direction, pkt_len, ts);
+}
+
+/*
+ * Conversations between two address/port pairs. The item names are
+ * only formatted the first time a conversation is seen; the lookup
+ * itself is done on the addresses and ports.
+ */
+static void
+iousers_process_port_packet(io_users_t *iu, const address *src, const address *dst,
+    guint32 src_port, guint32 dst_port, gchar *(*port_to_str)(guint), conv_id_t conv_id,
+    guint64 pkt_len, nstime_t *ts)
+{
+	const address *addr1, *addr2;
+	guint32 port1, port2;
+	int direction;
+	io_users_item_t *iui;
+	conv_key_t existing_key;
+
+	if((src_port>dst_port)
+	|| ((src_port==dst_port) && (CMP_ADDRESS(src, dst)>0)) ){
+		direction=0;
+		addr1=src;
+		addr2=dst;
+		port1=src_port;
+		port2=dst_port;
 	} else {
-		iui->frames2++;
-		iui->bytes2+=pkt_len;
+		direction=1;
+		addr2=src;
+		addr1=dst;
+		port2=src_port;
+		port1=dst_port;
+	}
+
+	if(!iu->hashtable){
+		iu->hashtable=g_hash_table_new_full(conversation_hash, conversation_match, g_free, NULL);
+	}
+
+	conversation_key_set(&existing_key, addr1, addr2, port1, port2, conv_id);
+	iui=iousers_lookup_item(iu, &existing_key);
+
+	if(!iui){
+		conv_key_t *new_key;
+
+		new_key=g_new(conv_key_t, 1);
+		iui=iousers_new_item(iu, new_key, ts);
+		COPY_ADDRESS(&iui->addr1, addr1);
+		iui->name1=g_strdup_printf("%s:%s", ep_address_to_str(addr1), port_to_str(port1));
+		COPY_ADDRESS(&iui->addr2, addr2);
+		iui->name2=g_strdup_printf("%s:%s", ep_address_to_str(addr2), port_to_str(port2));
+		iui->conv_id=conv_id;
+		/* the key points at the item's copies of the addresses */
+		conversation_key_set(new_key, &iui->addr1, &iui->addr2, port1, port2, conv_id);
 	}
+
+	iousers_update_item(iui, direction, pkt_len, ts);
 }
 
 void
@@ -126,6 +245,7 @@ iousers_process_address_packet(io_users_t *iu, const address *src, const address
 {
 	const address *addr1, *addr2;
 	io_users_item_t *iui;
+	conv_key_t existing_key;
 
 	if(CMP_ADDRESS(src, dst)>0){
 		addr1=src;
@@ -135,43 +255,27 @@ iousers_process_address_packet(io_users_t *iu, const address *src, const address
 		addr1=dst;
 	}
 
-	for(iui=iu->items;iui;iui=iui->next){
-		if((!CMP_ADDRESS(&iui->addr1, addr1))
-		&&(!CMP_ADDRESS(&iui->addr2, addr2)) ){
-			break;
-		}
+	if(!iu->hashtable){
+		iu->hashtable=g_hash_table_new_full(conversation_hash, conversation_match, g_free, NULL);
 	}
 
+	conversation_key_set(&existing_key, addr1, addr2, 0, 0, CONV_ID_UNSET);
+	iui=iousers_lookup_item(iu, &existing_key);
+
 	if(!iui){
-		iui=g_malloc(sizeof(io_users_item_t));
-		iui->next=iu->items;
-		iu->items=iui;
+		conv_key_t *new_key;
+
+		new_key=g_new(conv_key_t, 1);
+		iui=iousers_new_item(iu, new_key, ts);
 		COPY_ADDRESS(&iui->addr1, addr1);
 		iui->name1=g_strdup(ep_address_to_str(addr1));
 		COPY_ADDRESS(&iui->addr2, addr2);
 		iui->name2=g_strdup(ep_address_to_str(addr2));
-		iui->frames1=0;
-		iui->frames2=0;
-		iui->bytes1=0;
-		iui->bytes2=0;
-		memcpy(&iui->start_time, ts, sizeof(iui->start_time));
-		memcpy(&iui->stop_time, ts, sizeof(iui->stop_time));
-	}
-	else {
-		if (nstime_cmp(ts, &iui->stop_time) > 0) {
-			memcpy(&iui->stop_time, ts, sizeof(iui->stop_time));
-		} else if (nstime_cmp(ts, &iui->start_time) < 0) {
-			memcpy(&iui->start_time, ts, sizeof(iui->start_time));
-		}
+		iui->conv_id=CONV_ID_UNSET;
+		conversation_key_set(new_key, &iui->addr1, &iui->addr2, 0, 0, CONV_ID_UNSET);
 	}
 
-	if(!CMP_ADDRESS(dst, &iui->addr1)){
-		iui->frames1++;
-		iui->bytes1+=pkt_len;
-	} else {
-		iui->frames2++;
-		iui->bytes2+=pkt_len;
-	}
+	iousers_update_item(iui, !CMP_ADDRESS(dst, &iui->addr1), pkt_len, ts);
 }
 
 static int
@@ -179,29 +283,10 @@ iousers_udpip_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt _U_, con
 {
 	io_users_t *iu=arg;
 	const e_udphdr *udph=vudph;
-	char name1[256],name2[256];
-	int direction=0;
 
-	if(udph->uh_sport>udph->uh_dport){
-		direction=0;
-		g_snprintf(name1,256,"%s:%s",ep_address_to_str(&udph->ip_src),get_udp_port(udph->uh_sport));
-		g_snprintf(name2,256,"%s:%s",ep_address_to_str(&udph->ip_dst),get_udp_port(udph->uh_dport));
-	} else if(udph->uh_sport<udph->uh_dport){
-		direction=1;
-		g_snprintf(name2,256,"%s:%s",ep_address_to_str(&udph->ip_src),get_udp_port(udph->uh_sport));
-		g_snprintf(name1,256,"%s:%s",ep_address_to_str(&udph->ip_dst),get_udp_port(udph->uh_dport));
-	} else if(CMP_ADDRESS(&udph->ip_src, &udph->ip_dst)>0){
-		direction=0;
-		g_snprintf(name1,256,"%s:%s",ep_address_to_str(&udph->ip_src),get_udp_port(udph->uh_sport));
-		g_snprintf(name2,256,"%s:%s",ep_address_to_str(&udph->ip_dst),get_udp_port(udph->uh_dport));
-	} else {
-		direction=1;
-		g_snprintf(name2,256,"%s:%s",ep_address_to_str(&udph->ip_src),get_udp_port(udph->uh_sport));
-		g_snprintf(name1,256,"%s:%s",ep_address_to_str(&udph->ip_dst),get_udp_port(udph->uh_dport));
-	}
+	iousers_process_port_packet(iu, &udph->ip_src, &udph->ip_dst, udph->uh_sport, udph->uh_dport,
+	    get_udp_port, CONV_ID_UNSET, pinfo->fd->pkt_len, &pinfo->fd->rel_ts);
 
-	iousers_process_name_packet(iu, name1, name2, direction, pinfo->fd->pkt_len, &pinfo->fd->rel_ts);
-	
 	return 1;
 }
 
@@ -242,28 +327,9 @@ iousers_tcpip_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt _U_, con
 {
 	io_users_t *iu=arg;
 	const struct tcpheader *tcph=vtcph;
-	char name1[256],name2[256];
-	int direction=0;
-
-	if(tcph->th_sport>tcph->th_dport){
-		direction=0;
-		g_snprintf(name1,256,"%s:%s",ep_address_to_str(&tcph->ip_src),get_tcp_port(tcph->th_sport));
-		g_snprintf(name2,256,"%s:%s",ep_address_to_str(&tcph->ip_dst),get_tcp_port(tcph->th_dport));
-	} else if(tcph->th_sport<tcph->th_dport){
-		direction=1;
-		g_snprintf(name2,256,"%s:%s",ep_address_to_str(&tcph->ip_src),get_tcp_port(tcph->th_sport));
-		g_snprintf(name1,256,"%s:%s",ep_address_to_str(&tcph->ip_dst),get_tcp_port(tcph->th_dport));
-	} else if(CMP_ADDRESS(&tcph->ip_src, &tcph->ip_dst)>0){
-		direction=0;
-		g_snprintf(name1,256,"%s:%s",ep_address_to_str(&tcph->ip_src),get_tcp_port(tcph->th_sport));
-		g_snprintf(name2,256,"%s:%s",ep_address_to_str(&tcph->ip_dst),get_tcp_port(tcph->th_dport));
-	} else {
-		direction=1;
-		g_snprintf(name2,256,"%s:%s",ep_address_to_str(&tcph->ip_src),get_tcp_port(tcph->th_sport));
-		g_snprintf(name1,256,"%s:%s",ep_address_to_str(&tcph->ip_dst),get_tcp_port(tcph->th_dport));
-	}
 
-	iousers_process_name_packet_with_conv_id(iu, name1, name2, tcph->th_stream, direction, pinfo->fd->pkt_len, &pinfo->fd->rel_ts);
+	iousers_process_port_packet(iu, &tcph->ip_src, &tcph->ip_dst, tcph->th_sport, tcph->th_dport,
+	    get_tcp_port, tcph->th_stream, pinfo->fd->pkt_len, &pinfo->fd->rel_ts);
 
 	return 1;
 }
@@ -353,48 +419,59 @@ iousers_tr_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt _U_, const
 	return 1;
 }
 
+/* Most frames first; ties in reverse order of appearance */
+static gint
+iousers_sort_cmp(gconstpointer a, gconstpointer b)
+{
+	const io_users_item_t *iui_a = *(const io_users_item_t * const *)a;
+	const io_users_item_t *iui_b = *(const io_users_item_t * const *)b;
+	guint32 tot_a, tot_b;
+
+	tot_a=iui_a->frames1+iui_a->frames2;
+	tot_b=iui_b->frames1+iui_b->frames2;
+	if(tot_a!=tot_b){
+		return tot_a>tot_b ? -1 : 1;
+	}
+	/* both items live in the same array */
+	if(iui_a!=iui_b){
+		return iui_a>iui_b ? -1 : 1;
+	}
+	return 0;
+}
+
 static void
 iousers_draw(void *arg)
 {
 	io_users_t *iu = arg;
 	io_users_item_t *iui;
-	guint32 last_frames, max_frames;
+	GPtrArray *sorted;
+	guint i;
 
 	printf("================================================================================\n");
 	printf("%s Conversations\n",iu->type);
 	printf("Filter:%s\n",iu->filter?iu->filter:"<No Filter>");
 	printf("                                               |       <-      | |       ->      | |     Total     |   Rel. Start   |   Duration   |\n");
 	printf("                                               | Frames  Bytes | | Frames  Bytes | | Frames  Bytes |                |              |\n");
-	max_frames=0xffffffff;
-	do {
-		last_frames=0;
-		for(iui=iu->items;iui;iui=iui->next){
-			guint32 tot_frames;
-			tot_frames=iui->frames1+iui->frames2;
-
-			if((tot_frames>last_frames)
-			&&(tot_frames<max_frames)){
-				last_frames=tot_frames;
-			}
-		}
-		for(iui=iu->items;iui;iui=iui->next){
-			guint32 tot_frames;
-			tot_frames=iui->frames1+iui->frames2;
-
-			if(tot_frames==last_frames){
-				printf("%-20s <-> %-20s  %6d %9" G_GINT64_MODIFIER "d  %6d %9" G_GINT64_MODIFIER "d  %6d %9" G_GINT64_MODIFIER "d  %14.9f   %12.4f\n",
-					iui->name1, iui->name2,
-					iui->frames1, iui->bytes1,
-					iui->frames2, iui->bytes2,
-					iui->frames1+iui->frames2,
-					iui->bytes1+iui->bytes2,
-					nstime_to_sec(&iui->start_time),
-					nstime_to_sec(&iui->stop_time) - nstime_to_sec(&iui->start_time)
-				);
-			}
-		}
-		max_frames=last_frames;
-	} while(last_frames);
+
+	sorted=g_ptr_array_sized_new(iu->items->len);
+	for(i=0;i<iu->items->len;i++){
+		g_ptr_array_add(sorted, &g_array_index(iu->items, io_users_item_t, i));
+	}
+	g_ptr_array_sort(sorted, iousers_sort_cmp);
+
+	for(i=0;i<sorted->len;i++){
+		iui=g_ptr_array_index(sorted, i);
+		printf("%-20s <-> %-20s  %6d %9" G_GINT64_MODIFIER "d  %6d %9" G_GINT64_MODIFIER "d  %6d %9" G_GINT64_MODIFIER "d  %14.9f   %12.4f\n",
+			iui->name1, iui->name2,
+			iui->frames1, iui->bytes1,
+			iui->frames2, iui->bytes2,
+			iui->frames1+iui->frames2,
+			iui->bytes1+iui->bytes2,
+			nstime_to_sec(&iui->start_time),
+			nstime_to_sec(&iui->stop_time) - nstime_to_sec(&iui->start_time)
+		);
+	}
+	g_ptr_array_free(sorted, TRUE);
 	printf("================================================================================\n");
 }
 
@@ -514,7 +591,8 @@ iousers_init(const char *optarg, void* userdata _U_)
 
 
 	iu=g_malloc(sizeof(io_users_t));
-	iu->items=NULL;
+	iu->items=g_array_new(FALSE, FALSE, sizeof(io_users_item_t));
+	iu->hashtable=NULL;
 	iu->type=tap_type_name;
 	if(filter){
 		iu->filter=g_strdup(filter);
@@ -524,9 +602,8 @@ iousers_init(const char *optarg, void* userdata _U_)
 
 	error_string=register_tap_listener(tap_type, iu, filter, 0, NULL, packet_func, iousers_draw);
 	if(error_string){
-		if(iu->items){
-			g_free(iu->items);
-		}
+		g_array_free(iu->items, TRUE);
+		g_free(iu->filter);
 		g_free(iu);
 		fprintf(stderr, "tshark: Couldn't register conversations tap: %s\n",
 		    error_string->str);
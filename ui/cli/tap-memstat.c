@@ -0,0 +1,95 @@
+/* tap-memstat.c
+ * Allocation counts of the emem allocators, for tshark
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/* This module prints how many ep_ and se_ allocations were made and how
+ * much the interned-string table saved. The counters are kept by emem
+ * itself, so this tap only has to print them; they cover everything since
+ * tshark started, not just the packets that were dissected.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <string.h>
+#include <epan/packet.h>
+#include <epan/emem.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+static void
+memstat_draw(void *dummy _U_)
+{
+	emem_stats_t stats;
+
+	emem_get_stats(&stats);
+
+	printf("===================================================================\n");
+	printf("Memory Allocation Statistics\n");
+	printf("Scope                      Allocations                Bytes\n");
+	printf("Packet (ep_)          %16" G_GINT64_MODIFIER "u %20" G_GINT64_MODIFIER "u\n",
+		stats.ep_allocs, stats.ep_bytes);
+	printf("Capture (se_)         %16" G_GINT64_MODIFIER "u %20" G_GINT64_MODIFIER "u\n",
+		stats.se_allocs, stats.se_bytes);
+	printf("\n");
+	printf("String copies:        %16" G_GINT64_MODIFIER "u\n", stats.strdups);
+	printf("Interned strings:     %16" G_GINT64_MODIFIER "u %20" G_GINT64_MODIFIER "u\n",
+		stats.intern_strings, stats.intern_bytes);
+	printf("Intern lookups:       %16" G_GINT64_MODIFIER "u\n", stats.intern_lookups);
+	printf("Intern hits:          %16" G_GINT64_MODIFIER "u",
+		stats.intern_hits);
+	if(stats.intern_lookups){
+		printf(" (%.2f%%)", 100.0*stats.intern_hits/stats.intern_lookups);
+	}
+	printf("\n");
+	printf("===================================================================\n");
+}
+
+
+static void
+memstat_init(const char *optarg, void* userdata _U_)
+{
+	GString *error_string;
+
+	if(strcmp("mem,stat",optarg)!=0){
+		fprintf(stderr, "tshark: invalid \"-z mem,stat\" argument\n");
+		exit(1);
+	}
+
+	error_string=register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING, NULL, NULL, memstat_draw);
+	if(error_string){
+		fprintf(stderr, "tshark: Couldn't register mem,stat tap: %s\n",
+		    error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+
+void
+register_tap_listener_memstat(void)
+{
+	register_stat_cmd_arg("mem,stat", memstat_init, NULL);
+}
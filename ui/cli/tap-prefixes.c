@@ -0,0 +1,77 @@
+/* tap-prefixes.c
+ * Report which on-demand protocol fields a tshark run registered
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* This module prints, at the end of a run, which display filter prefixes
+ * registered with proto_register_prefix() had their fields registered,
+ * because the protocol was dissected or one of its fields was referenced,
+ * and which ones were never needed. Unlike "tshark -G prefixes", which
+ * runs before any packet is read, this shows what the run itself loaded.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string.h>
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_cmd_args.h>
+
+static void
+prefixes_draw(void *dummy _U_)
+{
+	printf("===================================================================\n");
+	printf("On-demand Protocol Fields\n");
+	printf("Prefix\tState\n");
+	proto_registrar_dump_prefixes();
+	printf("===================================================================\n");
+}
+
+
+static void
+prefixes_init(const char *optarg, void* userdata _U_)
+{
+	GString *error_string;
+
+	if(strcmp("prefixes,loaded",optarg)!=0){
+		fprintf(stderr, "tshark: invalid \"-z prefixes,loaded\" argument\n");
+		exit(1);
+	}
+
+	error_string=register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING, NULL, NULL, prefixes_draw);
+	if(error_string){
+		fprintf(stderr, "tshark: Couldn't register prefixes,loaded tap: %s\n",
+		    error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+
+void
+register_tap_listener_prefixes(void)
+{
+	register_stat_cmd_arg("prefixes,loaded", prefixes_init, NULL);
+}
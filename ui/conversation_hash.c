@@ -0,0 +1,131 @@
+/* conversation_hash.c
+ *
+ * $Id$
+ *
+ * Hash table helpers shared by the conversation statistics in the
+ * GTK+ conversation table and tshark's "-z conv" tap.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <epan/address.h>
+#include <epan/conv_id.h>
+
+#include "ui/conversation_hash.h"
+
+void
+conversation_key_set(conv_key_t *key, const address *addr1, const address *addr2,
+    guint32 port1, guint32 port2, conv_id_t conv_id)
+{
+    SET_ADDRESS(&key->addr1, addr1->type, addr1->len, addr1->data);
+    SET_ADDRESS(&key->addr2, addr2->type, addr2->len, addr2->data);
+    key->port1 = port1;
+    key->port2 = port2;
+    key->conv_id = conv_id;
+}
+
+/*
+ * Hash one address/port pair. Summing the address bytes, as
+ * ADD_ADDRESS_TO_HASH() does, puts every IPv4 host pair into a
+ * thousand or so buckets, so mix each byte in instead.
+ */
+static guint
+conversation_endpoint_hash(const address *addr, guint32 port)
+{
+    const guint8 *data = (const guint8 *)addr->data;
+    guint hash_val = 2166136261U;
+    int i;
+
+    for (i = 0; i < addr->len; i++) {
+        hash_val ^= data[i];
+        hash_val *= 16777619U;
+    }
+    hash_val ^= port;
+    hash_val *= 16777619U;
+    hash_val ^= hash_val >> 15;
+
+    return hash_val;
+}
+
+/*
+ * Compute the hash value for two given address/port pairs. The
+ * endpoint hashes are combined with an addition so that both
+ * directions of a conversation end up in the same bucket.
+ */
+guint
+conversation_hash(gconstpointer v)
+{
+    const conv_key_t *key = (const conv_key_t *)v;
+    guint hash_val;
+
+    hash_val = conversation_endpoint_hash(&key->addr1, key->port1);
+    hash_val += conversation_endpoint_hash(&key->addr2, key->port2);
+    hash_val ^= key->conv_id;
+
+    return hash_val;
+}
+
+/*
+ * Compare two conversation keys for an exact match.
+ */
+gboolean
+conversation_match(gconstpointer v, gconstpointer w)
+{
+    const conv_key_t *v1 = (const conv_key_t *)v;
+    const conv_key_t *v2 = (const conv_key_t *)w;
+
+    if (v1->conv_id == v2->conv_id)
+    {
+        if (v1->port1 == v2->port1 &&
+            v1->port2 == v2->port2 &&
+            ADDRESSES_EQUAL(&v1->addr1, &v2->addr1) &&
+            ADDRESSES_EQUAL(&v1->addr2, &v2->addr2)) {
+            return TRUE;
+        }
+
+        if (v1->port2 == v2->port1 &&
+            v1->port1 == v2->port2 &&
+            ADDRESSES_EQUAL(&v1->addr2, &v2->addr1) &&
+            ADDRESSES_EQUAL(&v1->addr1, &v2->addr2)) {
+            return TRUE;
+        }
+    }
+
+    /*
+     * The addresses, ports, or conversation IDs don't match.
+     */
+    return FALSE;
+}
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
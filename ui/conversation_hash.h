@@ -0,0 +1,99 @@
+/* conversation_hash.h
+ *
+ * $Id$
+ *
+ * Hash table helpers shared by the conversation statistics in the
+ * GTK+ conversation table and tshark's "-z conv" tap.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __CONVERSATION_HASH_H__
+#define __CONVERSATION_HASH_H__
+
+#include <epan/address.h>
+#include <epan/conv_id.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @file
+ *  Conversation hash table keys.
+ */
+
+/** Key identifying a conversation between two address/port pairs.
+ *  The key does not own the address data it points to; the address
+ *  data must stay valid for as long as the key is in a hash table.
+ *  Keys match regardless of which side is stored as addr1/port1.
+ */
+typedef struct _conv_key_t {
+    address     addr1;      /**< first address */
+    address     addr2;      /**< second address */
+    guint32     port1;      /**< first port, or 0 */
+    guint32     port2;      /**< second port, or 0 */
+    conv_id_t   conv_id;    /**< conversation id, or CONV_ID_UNSET */
+} conv_key_t;
+
+/** Fill in a conversation key. The address data is not copied.
+ *
+ * @param key the key to fill in
+ * @param addr1 first address
+ * @param addr2 second address
+ * @param port1 first port, or 0
+ * @param port2 second port, or 0
+ * @param conv_id conversation id, or CONV_ID_UNSET
+ */
+extern void conversation_key_set(conv_key_t *key, const address *addr1, const address *addr2,
+    guint32 port1, guint32 port2, conv_id_t conv_id);
+
+/** GHashFunc for conv_key_t keys. Both directions of a conversation
+ *  hash to the same value.
+ *
+ * @param v the conv_key_t key
+ * @return the hash value
+ */
+extern guint conversation_hash(gconstpointer v);
+
+/** GEqualFunc for conv_key_t keys.
+ *
+ * @param v the first conv_key_t key
+ * @param w the second conv_key_t key
+ * @return TRUE if both keys refer to the same conversation in either direction
+ */
+extern gboolean conversation_match(gconstpointer v, gconstpointer w);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CONVERSATION_HASH_H__ */
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
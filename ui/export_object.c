@@ -43,27 +43,19 @@
 
 #include <wsutil/file_util.h>
 
-#include <ui/alert_box.h>
-
 #include "export_object.h"
 
+/*
+ * Write an object's payload to an open file descriptor. This has no user
+ * interface, so tshark can use it as well as the GUI's eo_save_entry().
+ */
 gboolean
-eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry, gboolean show_err)
+eo_write_entry_fd(int to_fd, export_object_entry_t *entry, int *err)
 {
-    int to_fd;
     gint64 bytes_left;
     int bytes_to_write;
     ssize_t bytes_written;
     guint8 *ptr;
-    int err;
-
-    to_fd = ws_open(save_as_filename, O_WRONLY | O_CREAT | O_EXCL |
-             O_BINARY, 0644);
-    if(to_fd == -1) { /* An error occurred */
-        if (show_err)
-            open_failure_alert_box(save_as_filename, errno, TRUE);
-        return FALSE;
-    }
 
     /*
      * The third argument to _write() on Windows is an unsigned int,
@@ -88,22 +80,14 @@ eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry, gbool
         bytes_written = ws_write(to_fd, ptr, bytes_to_write);
         if(bytes_written <= 0) {
             if (bytes_written < 0)
-                err = errno;
+                *err = errno;
             else
-                err = WTAP_ERR_SHORT_WRITE;
-            if (show_err)
-                write_failure_alert_box(save_as_filename, err);
-            ws_close(to_fd);
+                *err = WTAP_ERR_SHORT_WRITE;
             return FALSE;
         }
         bytes_left -= bytes_written;
         ptr += bytes_written;
     }
-    if (ws_close(to_fd) < 0) {
-        if (show_err)
-            write_failure_alert_box(save_as_filename, errno);
-        return FALSE;
-    }
 
     return TRUE;
 }
@@ -51,6 +51,7 @@ void object_list_add_entry(export_object_list_t *object_list, export_object_entr
 export_object_entry_t *object_list_get_entry(export_object_list_t *object_list, int row);
 
 gboolean eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry, gboolean show_err);
+gboolean eo_write_entry_fd(int to_fd, export_object_entry_t *entry, int *err);
 GString *eo_massage_str(const gchar *in_str, gsize maxlen, int dup);
 const char *ct2ext(const char *content_type);
 
@@ -0,0 +1,91 @@
+/* export_object_save.c
+ * Saving objects found in streams of data from the GUI
+ * Copyright 2007, Stephen Fisher (see AUTHORS file)
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+ * USA.
+ */
+
+#include "config.h"
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <errno.h>
+
+#include <epan/packet_info.h>
+
+#include <wsutil/file_util.h>
+
+#include <ui/alert_box.h>
+
+#include "export_object.h"
+
+/*
+ * This is kept apart from export_object.c because of the alert boxes,
+ * which tshark doesn't have.
+ */
+gboolean
+eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry, gboolean show_err)
+{
+    int to_fd;
+    int err;
+
+    to_fd = ws_open(save_as_filename, O_WRONLY | O_CREAT | O_EXCL |
+             O_BINARY, 0644);
+    if(to_fd == -1) { /* An error occurred */
+        if (show_err)
+            open_failure_alert_box(save_as_filename, errno, TRUE);
+        return FALSE;
+    }
+
+    if (!eo_write_entry_fd(to_fd, entry, &err)) {
+        if (show_err)
+            write_failure_alert_box(save_as_filename, err);
+        ws_close(to_fd);
+        return FALSE;
+    }
+    if (ws_close(to_fd) < 0) {
+        if (show_err)
+            write_failure_alert_box(save_as_filename, errno);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -276,6 +276,11 @@ eo_smb_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 
     gchar                 **aux_string_v;
 
+    /* Files are kept in memory until the list is saved, so closes
+       don't matter here */
+    if (eo_info->cmd == SMB_COM_CLOSE)
+        return FALSE;
+
     /* Is this an eo_smb supported file_type? (right now we only support FILE */
     is_supported_filetype = (eo_info->fid_type == SMB_FID_TYPE_FILE);
 
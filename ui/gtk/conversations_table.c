@@ -39,6 +39,7 @@
 
 #include "../globals.h"
 
+#include "ui/conversation_hash.h"
 #include "ui/simple_dialog.h"
 #include "ui/utf8_entities.h"
 
@@ -3005,68 +3006,6 @@ init_conversation_notebook_cb(GtkWidget *w _U_, gpointer d _U_)
     gdk_window_raise(gtk_widget_get_window(win));
 }
 
-typedef struct _key {
-    address     addr1;
-    address     addr2;
-    guint32     port1;
-    guint32     port2;
-    conv_id_t   conv_id;
-} conv_key_t;
-
-
-/*
- * Compute the hash value for two given address/port pairs if the match
- * is to be exact.
- */
-static guint
-conversation_hash(gconstpointer v)
-{
-    const conv_key_t *key = (const conv_key_t *)v;
-    guint hash_val;
-
-    hash_val = 0;
-    ADD_ADDRESS_TO_HASH(hash_val, &key->addr1);
-    hash_val += key->port1;
-    ADD_ADDRESS_TO_HASH(hash_val, &key->addr2);
-    hash_val += key->port2;
-    hash_val ^= key->conv_id;
-
-    return hash_val;
-}
-
-/*
- * Compare two conversation keys for an exact match.
- */
-static gint
-conversation_match(gconstpointer v, gconstpointer w)
-{
-    const conv_key_t *v1 = (const conv_key_t *)v;
-    const conv_key_t *v2 = (const conv_key_t *)w;
-
-    if (v1->conv_id == v2->conv_id)
-    {
-        if (v1->port1 == v2->port1 &&
-            v1->port2 == v2->port2 &&
-            ADDRESSES_EQUAL(&v1->addr1, &v2->addr1) &&
-            ADDRESSES_EQUAL(&v1->addr2, &v2->addr2)) {
-            return 1;
-        }
-
-        if (v1->port2 == v2->port1 &&
-            v1->port1 == v2->port2 &&
-            ADDRESSES_EQUAL(&v1->addr2, &v2->addr1) &&
-            ADDRESSES_EQUAL(&v1->addr1, &v2->addr2)) {
-            return 1;
-        }
-    }
-
-    /*
-     * The addresses, ports, or conversation IDs don't match.
-     */
-    return 0;
-}
-
-
 void
 add_conversation_table_data(conversations_table *ct, const address *src, const address *dst, guint32 src_port, guint32 dst_port, int num_frames, int num_bytes, nstime_t *ts, SAT_E sat, int port_type_val)
 {
@@ -3127,11 +3066,7 @@ add_conversation_table_data_with_conv_id(
         /* try to find it among the existing known conversations */
         conv_key_t existing_key;
 
-        existing_key.addr1 = *addr1;
-        existing_key.addr2 = *addr2;
-        existing_key.port1 = port1;
-        existing_key.port2 = port2;
-        existing_key.conv_id = conv_id;
+        conversation_key_set(&existing_key, addr1, addr2, port1, port2, conv_id);
         conversation_idx = GPOINTER_TO_UINT(g_hash_table_lookup(ct->hashtable, &existing_key));
         if (conversation_idx) {
             conversation_idx--;
@@ -3172,11 +3107,7 @@ add_conversation_table_data_with_conv_id(
 
         /* ct->conversations address is not a constant but src/dst_address.data are */
         new_key = g_new(conv_key_t, 1);
-        SET_ADDRESS(&new_key->addr1, conversation->src_address.type, conversation->src_address.len, conversation->src_address.data);
-        SET_ADDRESS(&new_key->addr2, conversation->dst_address.type, conversation->dst_address.len, conversation->dst_address.data);
-        new_key->port1 = port1;
-        new_key->port2 = port2;
-        new_key->conv_id = conv_id;
+        conversation_key_set(new_key, &conversation->src_address, &conversation->dst_address, port1, port2, conv_id);
         g_hash_table_insert(ct->hashtable, new_key, GUINT_TO_POINTER(conversation_idx +1));
 
         ct->num_conversations++;
@@ -60,6 +60,8 @@ typedef struct _PacketListRecord {
 	gchar **col_text;
 	/**< The length of the column text strings in 'col_text' */
 	gushort *col_text_len;
+	/** The typed values of the custom columns, for sorting */
+	col_custom_value_t *col_custom_value;
 
 	frame_data *fdata;
 
@@ -270,6 +272,16 @@ packet_list_init(PacketList *packet_list)
 	}
 	packet_list->n_text_cols = j;
 
+	packet_list->col_to_custom = g_new(int, packet_list->n_cols);
+	for (i = 0, j = 0; i < packet_list->n_cols; i++) {
+		if (cfile.cinfo.col_fmt[i] == COL_CUSTOM) {
+			packet_list->col_to_custom[i] = j;
+			j++;
+		} else
+			packet_list->col_to_custom[i] = -1;
+	}
+	packet_list->n_custom_cols = j;
+
 #ifdef PACKET_LIST_STATISTICS
 	packet_list->const_strings = 0;
 #endif
@@ -280,9 +292,11 @@ packet_list_init(PacketList *packet_list)
 static void
 packet_list_finalize(GObject *object)
 {
-	/* PacketList *packet_list = PACKET_LIST(object); */
+	PacketList *packet_list = PACKET_LIST(object);
 
 	/* XXX - Free all records and free all memory used by the list */
+	g_free(packet_list->col_to_text);
+	g_free(packet_list->col_to_custom);
 
 	/* must chain up - finalize parent */
 	(* parent_class->finalize) (object);
@@ -650,6 +664,10 @@ packet_list_append_record(PacketList *packet_list, frame_data *fdata)
 	newrecord->colorized    = FALSE;
 	newrecord->col_text_len = se_alloc0(sizeof(*newrecord->col_text_len) * packet_list->n_text_cols);
 	newrecord->col_text     = se_alloc0(sizeof(*newrecord->col_text) * packet_list->n_text_cols);
+	if (packet_list->n_custom_cols)
+		newrecord->col_custom_value = se_alloc0(sizeof(*newrecord->col_custom_value) * packet_list->n_custom_cols);
+	else
+		newrecord->col_custom_value = NULL;
 	newrecord->fdata        = fdata;
 #ifdef PACKET_PARANOID_CHECKS
 	newrecord->physical_pos = PACKET_LIST_RECORD_COUNT(packet_list->physical_rows);
@@ -706,6 +724,11 @@ packet_list_change_record(PacketList *packet_list, PacketListRecord *record, gin
 	if (text_col == -1 || record->col_text[text_col] != NULL)
 		return;
 
+	/* Keep the typed value of a custom column, so that sorting
+	 * doesn't have to parse the text. */
+	if (packet_list->col_to_custom[col] != -1)
+		record->col_custom_value[packet_list->col_to_custom[col]] = cinfo->col_custom_value[col];
+
 	switch (cfile.cinfo.col_fmt[col]) {
 		case COL_DEF_SRC:
 		case COL_RES_SRC:	/* COL_DEF_SRC is currently just like COL_RES_SRC */
@@ -971,9 +994,29 @@ packet_list_sortable_has_default_sort_func(GtkTreeSortable *sortable _U_)
 }
 
 static gint
-packet_list_compare_custom(gint sort_id, gint text_sort_id, PacketListRecord *a, PacketListRecord *b)
+packet_list_compare_custom(PacketList *packet_list, gint sort_id, gint text_sort_id, PacketListRecord *a, PacketListRecord *b)
 {
 	header_field_info *hfi;
+	col_custom_value_t *value_a, *value_b;
+
+	/*
+	 * Rows with a typed value come first, ordered by the type and then
+	 * by the value; the others follow, ordered by their text.  Comparing
+	 * typed values only when both rows happen to have the same type, and
+	 * the text otherwise, wouldn't be a consistent order for a column
+	 * mixing both.
+	 */
+	value_a = &a->col_custom_value[packet_list->col_to_custom[sort_id]];
+	value_b = &b->col_custom_value[packet_list->col_to_custom[sort_id]];
+	if (value_a->type != COL_CUSTOM_VALUE_NONE || value_b->type != COL_CUSTOM_VALUE_NONE) {
+		if (value_a->type == COL_CUSTOM_VALUE_NONE)
+			return 1;
+		if (value_b->type == COL_CUSTOM_VALUE_NONE)
+			return -1;
+		if (value_a->type != value_b->type)
+			return (value_a->type < value_b->type) ? -1 : 1;
+		return col_custom_value_compare(value_a, value_b);
+	}
 
 	hfi = proto_registrar_get_byname(cfile.cinfo.col_custom_field[sort_id]);
 
@@ -1003,31 +1046,32 @@ packet_list_compare_custom(gint sort_id, gint text_sort_id, PacketListRecord *a,
 }
 
 static gint
-_packet_list_compare_records(gint sort_id, gint text_sort_id, PacketListRecord *a, PacketListRecord *b)
+_packet_list_compare_records(PacketList *packet_list, gint sort_id, gint text_sort_id, PacketListRecord *a, PacketListRecord *b)
 {
 	g_assert(a->col_text);
 	g_assert(b->col_text);
 	g_assert(a->col_text[text_sort_id]);
 	g_assert(b->col_text[text_sort_id]);
 
+	/* Rows with the same text can still have different typed values */
+	if (cfile.cinfo.col_fmt[sort_id] == COL_CUSTOM)
+		return packet_list_compare_custom(packet_list, sort_id, text_sort_id, a, b);
+
 	if(a->col_text[text_sort_id] == b->col_text[text_sort_id])
 		return 0; /* no need to call strcmp() */
 
-	if (cfile.cinfo.col_fmt[sort_id] == COL_CUSTOM)
-		return packet_list_compare_custom(sort_id, text_sort_id, a, b);
-
 	return strcmp(a->col_text[text_sort_id], b->col_text[text_sort_id]);
 }
 
 static gint
-packet_list_compare_records(gint sort_id, gint text_sort_id, PacketListRecord *a, PacketListRecord *b)
+packet_list_compare_records(PacketList *packet_list, gint sort_id, gint text_sort_id, PacketListRecord *a, PacketListRecord *b)
 {
 	gint ret;
 
 	if (text_sort_id == -1)	/* based on frame_data ? */
 		return frame_data_compare(a->fdata, b->fdata, cfile.cinfo.col_fmt[sort_id]);
 
-	ret = _packet_list_compare_records(sort_id, text_sort_id, a, b);
+	ret = _packet_list_compare_records(packet_list, sort_id, text_sort_id, a, b);
 	if (ret == 0)
 		ret = frame_data_compare(a->fdata, b->fdata, COL_NUMBER);
 	return ret;
@@ -1042,7 +1086,7 @@ packet_list_qsort_physical_compare_func(PacketListRecord **a, PacketListRecord *
 
 	g_assert((a) && (b) && (packet_list));
 
-	ret = packet_list_compare_records(sort_id, packet_list->col_to_text[sort_id], *a, *b);
+	ret = packet_list_compare_records(packet_list, sort_id, packet_list->col_to_text[sort_id], *a, *b);
 
 	/* Swap -1 and 1 if sort order is reverse */
 	if(ret != 0 && packet_list->sort_order == GTK_SORT_DESCENDING)
@@ -70,6 +70,8 @@ struct _PacketList
 	gint n_cols;		/* copy of cfile.cinfo.num_cols */
 	gint n_text_cols;	/* number of cols not based on frame, which we need to store text */
 	gint *col_to_text;	/* mapping from column number to col_text index, when -1 column is based on frame_data */
+	gint n_custom_cols;	/* number of custom columns, for which we also store the typed value */
+	gint *col_to_custom;	/* mapping from column number to col_custom_value index, -1 if not a custom column */
 	GtkWidget *view;
 
 	gint sort_id;
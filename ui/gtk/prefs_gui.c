@@ -59,6 +59,8 @@ static gboolean recent_df_entries_changed_cb(GtkWidget *recent_df_entry _U_,
 					     GdkEvent *event _U_, gpointer parent_w);
 static gint scroll_percent_changed_cb(GtkWidget *recent_df_entry _U_,
 					  GdkEvent *event _U_, gpointer parent_w);
+static gboolean find_index_max_size_changed_cb(GtkWidget *find_index_entry _U_,
+					       GdkEvent *event _U_, gpointer parent_w);
 #define PLIST_SEL_BROWSE_KEY		"plist_sel_browse"
 #define PTREE_SEL_BROWSE_KEY		"ptree_sel_browse"
 #define GEOMETRY_POSITION_KEY		"geometry_position"
@@ -76,6 +78,8 @@ static gint scroll_percent_changed_cb(GtkWidget *recent_df_entry _U_,
 #define GUI_ASK_UNSAVED_KEY		"ask_unsaved"
 #define GUI_WEBBROWSER_KEY		"webbrowser"
 #define GUI_FIND_WRAP_KEY		"find_wrap"
+#define GUI_FIND_INDEX_SAVE_KEY		"find_index_save"
+#define GUI_FIND_INDEX_MAX_SIZE_KEY	"find_index_max_size"
 #define GUI_USE_PREF_SAVE_KEY		"use_pref_save"
 #define GUI_SHOW_VERSION_KEY		"show_version"
 #define GUI_EXPERT_EYECANDY_KEY		"expert_eyecandy"
@@ -167,6 +171,9 @@ static char open_file_preview_str[128] = "";
 /* Used to contain the string from the Auto Scroll Percentage pref item */
 static char scroll_percent_preview_str[128] = "";
 
+/* Used to contain the string from the Find Index Max Size pref item */
+static char find_index_max_size_str[128] = "";
+
 #define GUI_TABLE_ROWS 4
 
 GtkWidget*
@@ -180,6 +187,7 @@ gui_prefs_show(void)
 #endif
 	GtkWidget *fileopen_rb, *fileopen_dir_te, *fileopen_preview_te;
 	GtkWidget *recent_files_count_max_te, *recent_df_entries_max_te, *ask_unsaved_cb, *find_wrap_cb;
+	GtkWidget *find_index_save_cb, *find_index_max_size_te;
 	GtkWidget *use_pref_save_cb;
 	GtkWidget *show_version_om;
 	GtkWidget *auto_scroll_cb, *scroll_percent_te;
@@ -326,6 +334,25 @@ gui_prefs_show(void)
 	    prefs.gui_find_wrap);
 	g_object_set_data(G_OBJECT(main_vb), GUI_FIND_WRAP_KEY, find_wrap_cb);
 
+	/* do we want to keep the data search index for the next time? */
+	find_index_save_cb = create_preference_check_button(main_tb, pos++,
+	    "Save the find index next to the capture file:",
+	    "Whether the index that speeds up searches of the packet data "
+	    "should be saved next to the capture file, for the next time it is opened.",
+	    prefs.gui_find_index_save);
+	g_object_set_data(G_OBJECT(main_vb), GUI_FIND_INDEX_SAVE_KEY, find_index_save_cb);
+
+	/* How much memory the data search index may take */
+	find_index_max_size_te = create_preference_entry(main_tb, pos++,
+	    "Maximum find index size (MB):",
+	    "The most memory the index that speeds up searches of the packet data may take; "
+	    "frames that don't fit in it are always read when searching. 0 turns it off.",
+	    find_index_max_size_str);
+	g_snprintf(current_val_str, sizeof(current_val_str), "%u", prefs.gui_find_index_max_size);
+	gtk_entry_set_text(GTK_ENTRY(find_index_max_size_te), current_val_str);
+	g_object_set_data(G_OBJECT(main_vb), GUI_FIND_INDEX_MAX_SIZE_KEY, find_index_max_size_te);
+	g_signal_connect(find_index_max_size_te, "focus_out_event", G_CALLBACK(find_index_max_size_changed_cb), main_vb);
+
 	/* show an explicit Save button for settings dialogs (preferences and alike)? */
 	use_pref_save_cb = create_preference_check_button(main_tb, pos++,
 	    "Settings dialogs show a save button:",
@@ -474,6 +501,9 @@ gui_prefs_fetch(GtkWidget *w)
 	prefs.gui_find_wrap =
 		gtk_toggle_button_get_active(g_object_get_data(G_OBJECT(w), GUI_FIND_WRAP_KEY));
 
+	prefs.gui_find_index_save =
+		gtk_toggle_button_get_active(g_object_get_data(G_OBJECT(w), GUI_FIND_INDEX_SAVE_KEY));
+
 	prefs.gui_use_pref_save =
 		gtk_toggle_button_get_active(g_object_get_data(G_OBJECT(w), GUI_USE_PREF_SAVE_KEY));
 
@@ -714,3 +744,20 @@ scroll_percent_changed_cb(GtkWidget *recent_files_entry _U_,
   /* We really should pop up a dialog box is newval < 0 or > 100 */
   return FALSE;
 }
+
+static gboolean
+find_index_max_size_changed_cb(GtkWidget *find_index_entry _U_,
+			       GdkEvent *event _U_, gpointer parent_w)
+{
+	GtkWidget	*find_index_max_size_te;
+
+	find_index_max_size_te = (GtkWidget *)g_object_get_data(G_OBJECT(parent_w), GUI_FIND_INDEX_MAX_SIZE_KEY);
+
+	/*
+	 * Now, just convert the string to a number and store it in the prefs
+	 * field ...  It's used the next time a capture file is searched.
+	 */
+	prefs.gui_find_index_max_size = (guint)strtoul(gtk_entry_get_text(GTK_ENTRY(find_index_max_size_te)), NULL, 10);
+
+	return FALSE;
+}
@@ -931,6 +931,8 @@ time_shift_frame_destroy_cb(GtkWidget *win _U_, gpointer user_data _U_)
 static void
 modify_time_init(frame_data *fd)
 {
+  /* Filters on the time stamps will give other results. */
+  cf_invalidate_filter_results(&cfile);
   modify_time_perform(fd, SHIFT_NEG, NULL, SHIFT_KEEPOFFSET);
 }
 
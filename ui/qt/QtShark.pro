@@ -150,10 +150,13 @@ SOURCES_WS_C = \
     ../../disabled_protos.c       \
     ../../file.c  \
     ../../fileset.c       \
+    ../../filter_cache.c  \
     ../../filters.c       \
+    ../../frame_readahead.c \
     ../../frame_data_sequence.c   \
     ../../g711.c \
     ../../merge.c \
+    ../../ngram_index.c \
     ../../packet-range.c  \
     ../../print.c \
     ../../proto_hier_stats.c      \
@@ -165,6 +165,7 @@ packet_list_thaw(void)
 {
     if (gbl_cur_packet_list) {
         gbl_cur_packet_list->setUpdatesEnabled(true);
+        gbl_cur_packet_list->prefetchVisibleRows();
     }
 
     packets_bar_update();
@@ -211,6 +212,9 @@ packet_list_recent_write_all(FILE *rf) {
 }
 
 #define MIN_COL_WIDTH_STR "...."
+// Rows beyond the bottom of the view to dissect in the background, in
+// screens.
+#define PREFETCH_SCREENS 4
 
 PacketList::PacketList(QWidget *parent) :
     QTreeView(parent),
@@ -229,6 +233,8 @@ PacketList::PacketList(QWidget *parent) :
     packet_list_model_->setColorEnabled(true); // We don't yet fetch color settings.
 //    packet_list_model_->setColorEnabled(recent.packet_list_colorize);
 
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(prefetchVisibleRows()));
+
     g_assert(gbl_cur_packet_list == NULL);
     gbl_cur_packet_list = this;
 }
@@ -270,6 +276,12 @@ void PacketList::showEvent (QShowEvent *event) {
     }
 }
 
+void PacketList::resizeEvent(QResizeEvent *event)
+{
+    QTreeView::resizeEvent(event);
+    prefetchVisibleRows();
+}
+
 void PacketList::selectionChanged (const QItemSelection & selected, const QItemSelection & deselected) {
     QTreeView::selectionChanged(selected, deselected);
 
@@ -302,7 +314,9 @@ void PacketList::selectionChanged (const QItemSelection & selected, const QItemS
 
 // Redraw the packet list and detail
 void PacketList::updateAll() {
+    packet_list_model_->invalidateColumnCache();
     update();
+    prefetchVisibleRows();
 
     if (cap_file_ && selectedIndexes().length() > 0) {
         cf_select_packet(cap_file_, selectedIndexes()[0].row());
@@ -381,6 +395,23 @@ void PacketList::goToPacket(int packet) {
     }
 }
 
+// Dissect the rows on screen and a few screens below it ahead of time.
+void PacketList::prefetchVisibleRows()
+{
+    QModelIndex top = indexAt(viewport()->rect().topLeft());
+    QModelIndex bottom = indexAt(viewport()->rect().bottomLeft());
+    int first_row, last_row, page_rows;
+
+    if (!top.isValid())
+        return;
+
+    first_row = top.row();
+    last_row = bottom.isValid() ? bottom.row() : packet_list_model_->rowCount() - 1;
+    page_rows = last_row - first_row + 1;
+
+    packet_list_model_->prefetchRows(first_row, last_row + page_rows * PREFETCH_SCREENS);
+}
+
 /*
  * Editor modelines
  *
@@ -46,6 +46,7 @@ public:
 
 protected:
     void showEvent (QShowEvent *event);
+    void resizeEvent (QResizeEvent *event);
     void selectionChanged (const QItemSelection & selected, const QItemSelection & deselected);
 
 private:
@@ -63,6 +64,7 @@ public slots:
     void goFirstPacket();
     void goLastPacket();
     void goToPacket(int packet);
+    void prefetchVisibleRows();
 };
 
 #endif // PACKET_LIST_H
@@ -36,17 +36,36 @@
 
 #include "wireshark_application.h"
 #include <QColor>
+#include <QElapsedTimer>
+#include <QTimer>
 
+// Number of rows whose column text we keep. This is a few screens' worth
+// plus the lookahead.
+#define COL_CACHE_ROWS 10000
+// How long a single prefetch step may keep the event loop busy.
+#define PREFETCH_SLICE_MS 20
 
 PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
-    QAbstractItemModel(parent)
+    QAbstractItemModel(parent),
+    col_cache_(COL_CACHE_ROWS),
+    prefetch_next_(0),
+    prefetch_last_(-1)
 {
     cap_file_ = cf;
+    resetScrollStats();
+
+    // Dissection isn't thread safe, so rows are prefetched in small
+    // slices from the event loop instead of from a worker thread.
+    prefetch_timer_ = new QTimer(this);
+    prefetch_timer_->setSingleShot(true);
+    prefetch_timer_->setInterval(0);
+    connect(prefetch_timer_, SIGNAL(timeout()), this, SLOT(prefetchStep()));
 }
 
 void PacketListModel::setCaptureFile(capture_file *cf)
 {
     cap_file_ = cf;
+    invalidateColumnCache();
 }
 
 // Packet list records have no children (for now, at least).
@@ -78,6 +97,7 @@ guint PacketListModel::recreateVisibleRows()
     beginResetModel();
     visible_rows_.clear();
     endResetModel();
+    prefetch_timer_->stop();
     beginInsertRows(QModelIndex(), pos, pos);
     foreach (record, physical_rows_) {
         if (record->getFdata()->flags.passed_dfilter || record->getFdata()->flags.ref_time) {
@@ -96,6 +116,7 @@ void PacketListModel::clear() {
     beginResetModel();
     physical_rows_.clear();
     visible_rows_.clear();
+    invalidateColumnCache();
     endResetModel();
 }
 
@@ -173,6 +194,39 @@ QVariant PacketListModel::data(const QModelIndex &index, int role) const
     if (!cap_file_ || col_num > cap_file_->cinfo.num_cols)
         return QVariant();
 
+    if (col_based_on_frame_data(&cap_file_->cinfo, col_num))
+        return record->data(col_num, &cap_file_->cinfo);
+
+    QStringList *cached_text = col_cache_.object(record);
+    if (cached_text && col_num < cached_text->count()) {
+        scroll_stats_.cache_hits++;
+        return cached_text->at(col_num);
+    }
+
+    // Not prefetched yet, so the view has to wait for this one.
+    QElapsedTimer miss_timer;
+    QStringList col_text;
+    qint64 miss_ms;
+
+    miss_timer.start();
+    if (!dissectRecord(record, col_text))
+        return QVariant();	/* error reading the frame */
+    miss_ms = miss_timer.elapsed();
+
+    scroll_stats_.cache_misses++;
+    scroll_stats_.miss_ms_total += miss_ms;
+    if (miss_ms > scroll_stats_.miss_ms_max)
+        scroll_stats_.miss_ms_max = miss_ms;
+
+    col_cache_.insert(record, new QStringList(col_text));
+    return col_text.at(col_num);
+}
+
+// Dissect a record once and keep the text of all of its columns that
+// aren't based on frame_data. Colorizes the record as a side effect.
+bool PacketListModel::dissectRecord(PacketListRecord *record, QStringList &col_text) const
+{
+    frame_data *fdata = record->getFdata();
     epan_dissect_t edt;
     column_info *cinfo;
     gboolean create_proto_tree;
@@ -198,19 +252,11 @@ QVariant PacketListModel::data(const QModelIndex &index, int role) const
          */
         if (dissect_columns) {
             col_fill_in_error(cinfo, fdata, FALSE, FALSE /* fill_fd_columns */);
-
-            //            for(gint col = 0; col < cinfo->num_cols; ++col) {
-            //                /* Skip columns based on frame_data because we already store those. */
-            //                if (!col_based_on_frame_data(cinfo, col))
-            //                    packet_list_change_record(packet_list, record->physical_pos, col, cinfo);
-            //            }
-            //            record->columnized = TRUE;
         }
         if (enable_color_) {
             fdata->color_filter = NULL;
-            //            record->colorized = TRUE;
         }
-        return QVariant();	/* error reading the frame */
+        return false;
     }
 
     create_proto_tree = (color_filters_used() && enable_color_) ||
@@ -234,22 +280,86 @@ QVariant PacketListModel::data(const QModelIndex &index, int role) const
         /* "Stringify" non frame_data vals */
         epan_dissect_fill_in_columns(&edt, FALSE, FALSE /* fill_fd_columns */);
 
-        //            for(col = 0; col < cinfo->num_cols; ++col) {
-        //                    /* Skip columns based on frame_data because we already store those. */
-        //                    if (!col_based_on_frame_data(cinfo, col))
-        //                            packet_list_change_record(packet_list, record->physical_pos, col, cinfo);
-        //            }
-//        g_log(NULL, G_LOG_LEVEL_DEBUG, "d_c %d: %s", col_num, cinfo->col_data[col_num]);
+        for (int col = 0; col < cinfo->num_cols; col++) {
+            /* Skip columns based on frame_data because we fill those in as needed. */
+            if (col_based_on_frame_data(cinfo, col))
+                col_text << QString();
+            else
+                col_text << cinfo->col_data[col];
+        }
     }
 
-    //    if (dissect_columns)
-    //            record->columnized = TRUE;
-    //    if (enable_color_)
-    //            record->colorized = TRUE;
-
     epan_dissect_cleanup(&edt);
 
-    return record->data(col_num, cinfo);
+    return dissect_columns;
+}
+
+// Forget the text of every row, e.g. when name resolution or the
+// columns have changed.
+void PacketListModel::invalidateColumnCache()
+{
+    prefetch_timer_->stop();
+    col_cache_.clear();
+}
+
+// Dissect the given range of visible rows ahead of time, a slice at a
+// time, so that they are cached by the time they are displayed.
+void PacketListModel::prefetchRows(int first_row, int last_row)
+{
+    if (first_row < 0)
+        first_row = 0;
+    if (last_row >= visible_rows_.count())
+        last_row = visible_rows_.count() - 1;
+    if (last_row - first_row >= COL_CACHE_ROWS)
+        last_row = first_row + COL_CACHE_ROWS - 1;
+
+    prefetch_next_ = first_row;
+    prefetch_last_ = last_row;
+    if (prefetch_next_ <= prefetch_last_)
+        prefetch_timer_->start();
+}
+
+void PacketListModel::resetScrollStats()
+{
+    scroll_stats_.cache_hits = 0;
+    scroll_stats_.cache_misses = 0;
+    scroll_stats_.prefetched = 0;
+    scroll_stats_.miss_ms_total = 0;
+    scroll_stats_.miss_ms_max = 0;
+}
+
+void PacketListModel::prefetchStep()
+{
+    QElapsedTimer slice_timer;
+    int first_changed = -1, last_changed = -1;
+
+    // Don't dissect behind the back of a file that's still being read.
+    if (!cap_file_ || cap_file_->state != FILE_READ_DONE)
+        return;
+
+    slice_timer.start();
+    while (prefetch_next_ <= prefetch_last_ && prefetch_next_ < visible_rows_.count()
+           && slice_timer.elapsed() < PREFETCH_SLICE_MS) {
+        PacketListRecord *record = visible_rows_[prefetch_next_];
+        QStringList col_text;
+
+        if (!col_cache_.contains(record) && dissectRecord(record, col_text)) {
+            col_cache_.insert(record, new QStringList(col_text));
+            scroll_stats_.prefetched++;
+            if (first_changed < 0)
+                first_changed = prefetch_next_;
+            last_changed = prefetch_next_;
+        }
+        prefetch_next_++;
+    }
+
+    if (first_changed >= 0) {
+        emit dataChanged(index(first_changed, 0),
+                         index(last_changed, columnCount() - 1));
+    }
+
+    if (prefetch_next_ <= prefetch_last_ && prefetch_next_ < visible_rows_.count())
+        prefetch_timer_->start();
 }
 
 QVariant PacketListModel::headerData(int section, Qt::Orientation orientation,
@@ -33,13 +33,17 @@
 #include <epan/packet.h>
 
 #include <QAbstractItemModel>
+#include <QCache>
 #include <QFont>
+#include <QStringList>
 #include <QVector>
 
 #include "packet_list_record.h"
 
 #include "cfile.h"
 
+class QTimer;
+
 class PacketListModel : public QAbstractItemModel
 {
     Q_OBJECT
@@ -63,12 +67,32 @@ public:
     frame_data *getRowFdata(int row);
     int visibleIndexOf(frame_data *fdata) const;
 
+    void invalidateColumnCache();
+    void prefetchRows(int first_row, int last_row);
+
+    // Column cache statistics. A test can drive data() without a view,
+    // run the event loop to let prefetching catch up and then look at
+    // how many rows had to be dissected while they were being displayed.
+    struct ScrollStats {
+        guint cache_hits;
+        guint cache_misses;     // Rows dissected synchronously by data()
+        guint prefetched;       // Rows dissected ahead of time
+        qint64 miss_ms_total;
+        qint64 miss_ms_max;
+    };
+    const ScrollStats &scrollStats() const { return scroll_stats_; }
+    void resetScrollStats();
 
 signals:
 
 public slots:
 
+private slots:
+    void prefetchStep();
+
 private:
+    bool dissectRecord(PacketListRecord *record, QStringList &col_text) const;
+
     capture_file *cap_file_;
     QList<QString> col_names_;
     QVector<PacketListRecord *> visible_rows_;
@@ -77,6 +101,14 @@ private:
 
     int header_height_;
     bool enable_color_;
+
+    // Text of the columns that aren't based on frame_data, for the most
+    // recently dissected rows.
+    mutable QCache<PacketListRecord *, QStringList> col_cache_;
+    mutable ScrollStats scroll_stats_;
+    QTimer *prefetch_timer_;
+    int prefetch_next_;
+    int prefetch_last_;
 };
 
 #endif // PACKET_LIST_MODEL_H
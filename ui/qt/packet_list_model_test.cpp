@@ -0,0 +1,306 @@
+/* packet_list_model_test.cpp
+ *
+ * $Id$
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Headless test of the packet list model's column cache. It feeds the
+// model the frames of a capture file, reads the text of a column over a
+// scrolling window with data(), as a view would, and checks how many rows
+// had to be dissected on the spot according to scrollStats().
+//
+// The model is linked on its own, without the rest of the GUI, so the
+// few routines it uses from outside libwireshark are defined below in
+// the simplest way that does the job: frames are read straight from the
+// wtap and nothing is colorized.
+
+#include "config.h"
+
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/column.h>
+#include <epan/column-utils.h>
+#include <epan/frame_data.h>
+#include <epan/prefs.h>
+#include <epan/timestamp.h>
+
+#include "color_filters.h"
+#include "file.h"
+#include "register.h"
+
+#include "packet_list_model.h"
+#include "wireshark_application.h"
+
+#include <QApplication>
+#include <QtTest/QtTest>
+
+#ifndef TEST_CAPTURE_FILE
+#define TEST_CAPTURE_FILE "dhcp.pcap"
+#endif
+
+// Rows read by data() at a time, like the visible part of a view
+#define WINDOW_ROWS 2
+
+WiresharkApplication *wsApp = NULL;
+
+QFont WiresharkApplication::monospaceFont(bool bold)
+{
+    Q_UNUSED(bold);
+    return QFont();
+}
+
+gboolean
+cf_read_frame_r(capture_file *cf, frame_data *fdata,
+                struct wtap_pkthdr *phdr, guint8 *pd)
+{
+    int err;
+    gchar *err_info;
+
+    if (!wtap_seek_read(cf->wth, fdata->file_off, phdr, pd,
+                        fdata->cap_len, &err, &err_info)) {
+        g_free(err_info);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gboolean
+color_filters_used(void)
+{
+    return FALSE;
+}
+
+void
+color_filters_prime_edt(epan_dissect_t *edt)
+{
+    Q_UNUSED(edt);
+}
+
+const color_filter_t *
+color_filters_colorize_packet(epan_dissect_t *edt)
+{
+    Q_UNUSED(edt);
+    return NULL;
+}
+
+static void
+test_failure_message(const char *msg_format, va_list ap)
+{
+    vfprintf(stderr, msg_format, ap);
+    fprintf(stderr, "\n");
+}
+
+static void
+test_open_failure_message(const char *filename, int err, gboolean for_writing)
+{
+    Q_UNUSED(for_writing);
+    fprintf(stderr, "Can't open %s: %s\n", filename, g_strerror(err));
+}
+
+static void
+test_read_failure_message(const char *filename, int err)
+{
+    fprintf(stderr, "Can't read %s: %s\n", filename, g_strerror(err));
+}
+
+static void
+test_write_failure_message(const char *filename, int err)
+{
+    fprintf(stderr, "Can't write %s: %s\n", filename, g_strerror(err));
+}
+
+class PacketListModelTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    capture_file cf_;
+    frame_data *frames_;
+    guint32 count_;
+    PacketListModel *model_;
+    int col_;                   // a column that isn't based on frame_data
+
+    void scroll(int first_row, int last_row);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    void scrollingWindowMisses();
+    void prefetchedRowsHit();
+    void invalidatedRowsMiss();
+};
+
+void PacketListModelTest::initTestCase()
+{
+    int err;
+    gchar *err_info = NULL;
+    gint64 data_offset;
+    guint32 cum_bytes = 0;
+    guint32 allocated = 64;
+
+    timestamp_set_type(TS_RELATIVE);
+    timestamp_set_precision(TS_PREC_AUTO);
+    timestamp_set_seconds_type(TS_SECONDS_DEFAULT);
+
+    epan_init(register_all_protocols, register_all_protocol_handoffs, NULL, NULL,
+              test_failure_message, test_open_failure_message,
+              test_read_failure_message, test_write_failure_message);
+    // The wired-in defaults, not the user's preferences
+    prefs_reset();
+
+    memset(&cf_, 0, sizeof cf_);
+    build_column_format_array(&cf_.cinfo, prefs.num_cols, TRUE);
+    col_ = -1;
+    for (int col = 0; col < cf_.cinfo.num_cols; col++) {
+        if (!col_based_on_frame_data(&cf_.cinfo, col)) {
+            col_ = col;
+            break;
+        }
+    }
+    QVERIFY2(col_ >= 0, "no column that needs dissection");
+
+    cf_.filename = g_strdup(TEST_CAPTURE_FILE);
+    cf_.wth = wtap_open_offline(cf_.filename, &err, &err_info, TRUE);
+    QVERIFY2(cf_.wth != NULL, wtap_strerror(err));
+
+    frames_ = g_new0(frame_data, allocated);
+    count_ = 0;
+    while (wtap_read(cf_.wth, &err, &err_info, &data_offset)) {
+        if (count_ == allocated) {
+            allocated *= 2;
+            frames_ = g_renew(frame_data, frames_, allocated);
+        }
+        frame_data_init(&frames_[count_], count_ + 1, wtap_phdr(cf_.wth),
+                        data_offset, cum_bytes);
+        frames_[count_].flags.passed_dfilter = 1;
+        cum_bytes = frames_[count_].cum_bytes;
+        count_++;
+    }
+    QVERIFY2(err == 0, wtap_strerror(err));
+    QVERIFY(count_ > WINDOW_ROWS);
+    cf_.count = count_;
+    cf_.state = FILE_READ_DONE;
+
+    model_ = new PacketListModel(this, &cf_);
+    model_->setColorEnabled(false);
+    for (guint32 i = 0; i < count_; i++)
+        model_->appendPacket(&frames_[i]);
+    QCOMPARE(model_->rowCount(), (int)count_);
+}
+
+void PacketListModelTest::cleanupTestCase()
+{
+    delete model_;
+    for (guint32 i = 0; i < count_; i++)
+        frame_data_cleanup(&frames_[i]);
+    g_free(frames_);
+    wtap_close(cf_.wth);
+    g_free(cf_.filename);
+    epan_cleanup();
+}
+
+// Every test starts with nothing cached
+void PacketListModelTest::init()
+{
+    model_->invalidateColumnCache();
+    model_->resetScrollStats();
+}
+
+// Read the column for the rows a view would display
+void PacketListModelTest::scroll(int first_row, int last_row)
+{
+    for (int row = first_row; row <= last_row; row++) {
+        QVariant text = model_->data(model_->index(row, col_), Qt::DisplayRole);
+        QVERIFY(text.isValid());
+    }
+}
+
+// Scrolling one row at a time only dissects the row that comes into
+// view; the others are cached.
+void PacketListModelTest::scrollingWindowMisses()
+{
+    int windows = 0;
+
+    for (int first = 0; first + WINDOW_ROWS <= (int)count_; first++) {
+        scroll(first, first + WINDOW_ROWS - 1);
+        windows++;
+    }
+
+    const PacketListModel::ScrollStats &stats = model_->scrollStats();
+    QCOMPARE(stats.cache_misses, count_);
+    QCOMPARE(stats.cache_hits, (guint)(windows * WINDOW_ROWS) - count_);
+    QCOMPARE(stats.prefetched, 0U);
+}
+
+// Rows prefetched from the event loop are all cached by the time the
+// view gets to them.
+void PacketListModelTest::prefetchedRowsHit()
+{
+    model_->prefetchRows(0, count_ - 1);
+    for (int i = 0; i < 100 && model_->scrollStats().prefetched < count_; i++)
+        QTest::qWait(10);
+    QCOMPARE(model_->scrollStats().prefetched, count_);
+
+    scroll(0, count_ - 1);
+
+    const PacketListModel::ScrollStats &stats = model_->scrollStats();
+    QCOMPARE(stats.cache_misses, 0U);
+    QCOMPARE(stats.cache_hits, count_);
+}
+
+// After the cache is invalidated, e.g. when name resolution changes,
+// every row has to be dissected again.
+void PacketListModelTest::invalidatedRowsMiss()
+{
+    scroll(0, WINDOW_ROWS - 1);
+    model_->invalidateColumnCache();
+    scroll(0, WINDOW_ROWS - 1);
+
+    const PacketListModel::ScrollStats &stats = model_->scrollStats();
+    QCOMPARE(stats.cache_misses, (guint)(2 * WINDOW_ROWS));
+    QCOMPARE(stats.cache_hits, 0U);
+}
+
+int main(int argc, char *argv[])
+{
+    // No display is needed
+    QApplication app(argc, argv, false);
+    PacketListModelTest test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "packet_list_model_test.moc"
+
+/*
+ * Editor modelines
+ *
+ * Local Variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * ex: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,209 @@
+/* Standalone program to test splitting a capture file into ranges of
+ * records with wtap_find_chunks() and wtap_set_range().
+ *
+ * $Id$
+ *
+ * Each packet of the capture files it's meant for starts, after a 14-byte
+ * Ethernet header, with "WTAPCHNK" and the offset of its record in the
+ * file as a little-endian 64-bit number, so that we can tell whether a
+ * range starts at a real record.  test/captures/pcap-zeroed-region.pcap
+ * is such a file, with a few kilobytes in the middle of it zeroed, which
+ * the search for record boundaries mustn't take for records.
+ *
+ * The records read from all the ranges, in order, must also be the ones
+ * a plain sequential read of the file gets, each exactly once.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "wtap.h"
+
+#define MAX_CHUNKS	64
+
+#define MARKER		"WTAPCHNK"
+#define MARKER_OFFSET	14
+#define MARKER_LEN	8
+
+static gboolean failed = FALSE;
+
+/* Read the records of a range, adding their offsets to offsets, and
+ * check that the first record is the one starting there */
+static void
+check_range(const char *filename, gint64 start, gint64 end, GArray *offsets)
+{
+	wtap *wth;
+	int err;
+	gchar *err_info = NULL;
+	gint64 data_offset, rec_offset;
+	struct wtap_pkthdr *phdr;
+	guint8 *pd;
+	guint first;
+	int i;
+
+	wth = wtap_open_offline(filename, &err, &err_info, FALSE);
+	if (wth == NULL) {
+		printf("Can't open %s: %s\n", filename, wtap_strerror(err));
+		g_free(err_info);
+		failed = TRUE;
+		return;
+	}
+
+	if (!wtap_set_range(wth, start, end, &err)) {
+		printf("Can't restrict reading to %" G_GINT64_MODIFIER "d-%"
+		    G_GINT64_MODIFIER "d: %s\n", start, end,
+		    err != 0 ? wtap_strerror(err) : "not supported");
+		failed = TRUE;
+		wtap_close(wth);
+		return;
+	}
+
+	first = offsets->len;
+	while (wtap_read(wth, &err, &err_info, &data_offset)) {
+		if (offsets->len == first) {
+			phdr = wtap_phdr(wth);
+			pd = wtap_buf_ptr(wth);
+			rec_offset = 0;
+			if (phdr->caplen >= MARKER_OFFSET + MARKER_LEN + 8 &&
+			    memcmp(pd + MARKER_OFFSET, MARKER, MARKER_LEN) == 0) {
+				for (i = 7; i >= 0; i--) {
+					rec_offset = (rec_offset << 8) |
+					    pd[MARKER_OFFSET + MARKER_LEN + i];
+				}
+			}
+			if (rec_offset != start) {
+				printf("Range %" G_GINT64_MODIFIER "d-%"
+				    G_GINT64_MODIFIER "d doesn't start at a record\n",
+				    start, end);
+				failed = TRUE;
+			}
+		}
+		g_array_append_val(offsets, data_offset);
+	}
+	if (err != 0) {
+		printf("Range %" G_GINT64_MODIFIER "d-%" G_GINT64_MODIFIER
+		    "d: %s\n", start, end, wtap_strerror(err));
+		g_free(err_info);
+		failed = TRUE;
+	} else if (offsets->len == first) {
+		printf("Range %" G_GINT64_MODIFIER "d-%" G_GINT64_MODIFIER
+		    "d: no record\n", start, end);
+		failed = TRUE;
+	}
+
+	wtap_close(wth);
+}
+
+/* Check that the ranges together read every record exactly once */
+static void
+check_coverage(const char *filename, GArray *offsets)
+{
+	wtap *wth;
+	int err;
+	gchar *err_info = NULL;
+	gint64 data_offset;
+	guint n = 0;
+
+	wth = wtap_open_offline(filename, &err, &err_info, FALSE);
+	if (wth == NULL) {
+		printf("Can't open %s: %s\n", filename, wtap_strerror(err));
+		g_free(err_info);
+		failed = TRUE;
+		return;
+	}
+
+	while (wtap_read(wth, &err, &err_info, &data_offset)) {
+		if (n >= offsets->len) {
+			printf("Record %u at %" G_GINT64_MODIFIER "d isn't in any range\n",
+			    n + 1, data_offset);
+			failed = TRUE;
+			break;
+		}
+		if (g_array_index(offsets, gint64, n) != data_offset) {
+			printf("Record %u is at %" G_GINT64_MODIFIER "d, but the ranges read %"
+			    G_GINT64_MODIFIER "d\n", n + 1, data_offset,
+			    g_array_index(offsets, gint64, n));
+			failed = TRUE;
+			break;
+		}
+		n++;
+	}
+	if (err != 0) {
+		printf("Can't read %s: %s\n", filename, wtap_strerror(err));
+		g_free(err_info);
+		failed = TRUE;
+	} else if (!failed && n != offsets->len) {
+		printf("The ranges read %u records, the file has %u\n",
+		    offsets->len, n);
+		failed = TRUE;
+	}
+
+	wtap_close(wth);
+}
+
+int
+main(int argc, char **argv)
+{
+	wtap *wth;
+	int err;
+	gchar *err_info = NULL;
+	gint64 starts[MAX_CHUNKS];
+	GArray *offsets;
+	int n, i;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: chunktest <capture file>\n");
+		exit(2);
+	}
+
+	wth = wtap_open_offline(argv[1], &err, &err_info, FALSE);
+	if (wth == NULL) {
+		printf("Can't open %s: %s\n", argv[1], wtap_strerror(err));
+		exit(1);
+	}
+	n = wtap_find_chunks(wth, MAX_CHUNKS, starts, &err, &err_info);
+	wtap_close(wth);
+	if (n < 0) {
+		printf("Can't split %s: %s\n", argv[1], wtap_strerror(err));
+		g_free(err_info);
+		exit(1);
+	}
+	if (n < 2) {
+		printf("%s wasn't split\n", argv[1]);
+		exit(1);
+	}
+
+	offsets = g_array_new(FALSE, FALSE, sizeof (gint64));
+	for (i = 0; i < n; i++)
+		check_range(argv[1], starts[i], i + 1 < n ? starts[i + 1] : 0,
+		    offsets);
+	check_coverage(argv[1], offsets);
+
+	printf("%d ranges, %u records: %s\n", n, offsets->len,
+	    failed ? "FAILURE" : "SUCCESS");
+	g_array_free(offsets, TRUE);
+	exit(failed ? 1 : 0);
+}
@@ -169,6 +169,99 @@ static wtap_open_routine_t open_routines_base[] = {
 
 #define	N_FILE_TYPES	(sizeof open_routines_base / sizeof open_routines_base[0])
 
+/* The first of the routines in open_routines_base that use a heuristic. */
+#define FIRST_HEURISTIC_OPEN_ROUTINE	netscreen_open
+
+/*
+ * Magic numbers at fixed offsets at the beginning of a file, and the
+ * routine to try first for files that have them.  The routine still
+ * does its own check; if it doesn't accept the file, all the others
+ * are tried as usual.
+ */
+struct open_magic {
+	guint			offset;
+	guint			len;
+	const char		*magic;
+	wtap_open_routine_t	open_routine;
+};
+
+static const struct open_magic open_magics[] = {
+	{ 0, 4, "\xa1\xb2\xc3\xd4", libpcap_open },
+	{ 0, 4, "\xd4\xc3\xb2\xa1", libpcap_open },
+	{ 0, 4, "\xa1\xb2\xcd\x34", libpcap_open },
+	{ 0, 4, "\x34\xcd\xb2\xa1", libpcap_open },
+	{ 0, 4, "\xa1\xb2\x3c\x4d", libpcap_open },
+	{ 0, 4, "\x4d\x3c\xb2\xa1", libpcap_open },
+	{ 0, 4, "\x0a\x0d\x0d\x0a", pcapng_open },
+	{ 0, 8, "snoop\0\0\0", snoop_open },
+	{ 0, 4, "RTSS", netmon_open },
+	{ 0, 4, "GMBU", netmon_open },
+	{ 0, 4, "XCP\0", netxray_open },
+	{ 0, 4, "VL\0\0", netxray_open },
+	{ 0, 17, "TRSNIFF data    \x1a", ngsniffer_open },
+	{ 0, 4, "\x05VNF", visual_open },
+	{ 0, 17, "ObserverPktBuffer", network_instruments_open },
+	{ 0, 8, "\x00\x00\x02\x00\x12\x05\x00\x10", k12_open },
+	{ 0, 8, "btsnoop\0", btsnoop_open },
+	{ 0, 6, "EyeSDN", eyesdn_open }
+};
+
+#define N_OPEN_MAGICS	(sizeof open_magics / sizeof open_magics[0])
+
+/*
+ * Text that the heuristic routines for some text formats look for in the
+ * first lines of a file, and the routine to try, before those suggested
+ * by the file name's extension, if the beginning of the file has it.
+ */
+struct open_signature {
+	const char		*text;
+	wtap_open_routine_t	open_routine;
+};
+
+static const struct open_signature open_signatures[] = {
+	{ "(i) len=", netscreen_open },
+	{ "(o) len=", netscreen_open },
+	{ "COMMUNICATIONS TRACE", iseries_open },
+	{ "T O S H I B A", toshiba_open },
+	{ "TCPIPtrace", vms_open },
+	{ "TCPtrace", vms_open },
+	{ "INTERnet trace", vms_open },
+	{ "l2-tx", cosine_open },
+	{ "l2-rx", cosine_open }
+};
+
+#define N_OPEN_SIGNATURES	(sizeof open_signatures / sizeof open_signatures[0])
+
+/*
+ * Number of bytes at the beginning of the file we read once, and look
+ * at for magic numbers and text signatures; enough for the first lines
+ * of the text formats.
+ */
+#define OPEN_PROBE_LEN	4096
+
+/*
+ * Extensions that suggest files of the types some heuristic routines
+ * handle; if the file name has one of them, that routine is tried
+ * before the other heuristic ones.
+ */
+struct open_extension_hint {
+	wtap_open_routine_t	open_routine;
+	const char		*extensions;	/* separated by ";" */
+};
+
+static const struct open_extension_hint open_extension_hints[] = {
+	{ erf_open, "erf" },
+	{ ipfix_open, "pfx;ipfix" },
+	{ peekclassic_open, "pkt;tpc;apc;wpz" },
+	{ commview_open, "ncf" }
+};
+
+#define N_OPEN_EXTENSION_HINTS	(sizeof open_extension_hints / sizeof open_extension_hints[0])
+
+/* Maximum number of routines tried before going through open_routines. */
+#define MAX_PREFERRED_OPEN_ROUTINES \
+	(N_OPEN_MAGICS + N_OPEN_SIGNATURES + N_OPEN_EXTENSION_HINTS)
+
 static wtap_open_routine_t* open_routines = NULL;
 
 static GArray* open_routines_arr = NULL;
@@ -216,6 +309,91 @@ void wtap_register_open_routine(wtap_open_routine_t open_routine, gboolean has_m
 #define S_ISDIR(mode)   (((mode) & S_IFMT) == S_IFDIR)
 #endif
 
+/*
+ * Seek back to the beginning of the file, as the routine tried before
+ * may have left the file position somewhere else, and try an open
+ * routine.  Returns what the open routine returned, or -1 on an I/O
+ * error while seeking.
+ */
+static int
+try_open_routine(wtap *wth, wtap_open_routine_t open_routine, int *err,
+    char **err_info)
+{
+	if (file_seek(wth->fh, 0, SEEK_SET, err) == -1)
+		return -1;
+	return (*open_routine)(wth, err, err_info);
+}
+
+static gboolean
+open_routine_tried(wtap_open_routine_t open_routine,
+    const wtap_open_routine_t *tried, guint n_tried)
+{
+	guint i;
+
+	for (i = 0; i < n_tried; i++) {
+		if (tried[i] == open_routine)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* Check whether some text appears anywhere in the probed bytes */
+static gboolean
+probe_has_text(const guint8 *probe, int probe_len, const char *text)
+{
+	size_t len = strlen(text);
+	const guint8 *p, *end;
+
+	if ((size_t)probe_len < len)
+		return FALSE;
+	end = probe + probe_len - len;
+	for (p = probe; p <= end; p++) {
+		p = (const guint8 *)memchr(p, text[0], end - p + 1);
+		if (p == NULL)
+			return FALSE;
+		if (memcmp(p, text, len) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Check whether the extension of a file name is in a ";"-separated
+ * list of extensions.  Compressed-file extensions are ignored, so that
+ * "foo.erf.gz" matches "erf".
+ */
+static gboolean
+file_extension_matches(const char *filename, const char *extensions)
+{
+	const char *basename, *extension, *end;
+	size_t len;
+	gchar **extensions_set, **extensionp;
+	gboolean found = FALSE;
+
+	basename = strrchr(filename, G_DIR_SEPARATOR);
+	basename = (basename != NULL) ? basename + 1 : filename;
+	end = basename + strlen(basename);
+	if (end - basename > 3 && g_ascii_strcasecmp(end - 3, ".gz") == 0)
+		end -= 3;
+	for (extension = end; extension > basename && *(extension - 1) != '.';
+	    extension--)
+		;
+	if (extension == basename)
+		return FALSE;	/* no extension */
+	len = end - extension;
+
+	extensions_set = g_strsplit(extensions, ";", 0);
+	for (extensionp = extensions_set; *extensionp != NULL; extensionp++) {
+		if (strlen(*extensionp) == len &&
+		    g_ascii_strncasecmp(*extensionp, extension, len) == 0) {
+			found = TRUE;
+			break;
+		}
+	}
+	g_strfreev(extensions_set);
+	return found;
+}
+
 /* Opens a file and prepares a wtap struct.
    If "do_random" is TRUE, it opens the file twice; the second open
    allows the application to do random-access I/O without moving
@@ -229,8 +407,13 @@ wtap* wtap_open_offline(const char *filename, int *err, char **err_info,
 	int	fd;
 	ws_statb64 statb;
 	wtap	*wth;
-	unsigned int	i;
+	unsigned int	i, j;
 	gboolean use_stdin = FALSE;
+	guint8	*probe = NULL;
+	int	probe_len;
+	wtap_open_routine_t tried[MAX_PREFERRED_OPEN_ROUTINES];
+	guint	n_tried = 0;
+	gboolean hints_tried = FALSE;
 
 	/* open standard input if filename is '-' */
 	if (strcmp(filename, "-") == 0)
@@ -354,33 +537,93 @@ wtap* wtap_open_offline(const char *filename, int *err, char **err_info,
 		file_set_random_access(wth->random_fh, TRUE, wth->fast_seek);
 	}
 
+	/*
+	 * Read the beginning of the file once, and first try the routines
+	 * for the file types whose magic numbers it has; most files are
+	 * identified that way without going through all the routines.
+	 */
+	probe = (guint8 *)g_malloc(OPEN_PROBE_LEN);
+	probe_len = file_read(probe, OPEN_PROBE_LEN, wth->fh);
+	if (probe_len < 0) {
+		*err = file_error(wth->fh, err_info);
+		goto fail;
+	}
+	for (j = 0; j < N_OPEN_MAGICS; j++) {
+		const struct open_magic *m = &open_magics[j];
+
+		if ((guint)probe_len < m->offset + m->len ||
+		    memcmp(probe + m->offset, m->magic, m->len) != 0 ||
+		    open_routine_tried(m->open_routine, tried, n_tried))
+			continue;
+		tried[n_tried++] = m->open_routine;
+		switch (try_open_routine(wth, m->open_routine, err, err_info)) {
+
+		case -1:
+			goto fail;
+
+		case 1:
+			goto success;
+		}
+	}
+
+	/*
+	 * Then the text formats whose signatures it has, so that the
+	 * extension hints below don't take those files for something else.
+	 */
+	for (j = 0; j < N_OPEN_SIGNATURES; j++) {
+		const struct open_signature *sig = &open_signatures[j];
+
+		if (open_routine_tried(sig->open_routine, tried, n_tried) ||
+		    !probe_has_text(probe, probe_len, sig->text))
+			continue;
+		tried[n_tried++] = sig->open_routine;
+		switch (try_open_routine(wth, sig->open_routine, err, err_info)) {
+
+		case -1:
+			goto fail;
+
+		case 1:
+			goto success;
+		}
+	}
+	g_free(probe);
+	probe = NULL;
+
 	/* Try all file types */
 	for (i = 0; i < open_routines_arr->len; i++) {
-		/* Seek back to the beginning of the file; the open routine
-		   for the previous file type may have left the file
-		   position somewhere other than the beginning, and the
-		   open routine for this file type will probably want
-		   to start reading at the beginning.
-
-		   Initialize the data offset while we're at it. */
-		if (file_seek(wth->fh, 0, SEEK_SET, err) == -1) {
-			/* I/O error - give up */
-			if (wth->random_fh != NULL)
-				file_close(wth->random_fh);
-			file_close(wth->fh);
-			g_free(wth);
-			return NULL;
+		if (!hints_tried && !use_stdin &&
+		    open_routines[i] == FIRST_HEURISTIC_OPEN_ROUTINE) {
+			/*
+			 * Before the heuristics, try the ones suggested
+			 * by the file name's extension.
+			 */
+			hints_tried = TRUE;
+			for (j = 0; j < N_OPEN_EXTENSION_HINTS; j++) {
+				const struct open_extension_hint *h = &open_extension_hints[j];
+
+				if (open_routine_tried(h->open_routine, tried, n_tried) ||
+				    !file_extension_matches(filename, h->extensions))
+					continue;
+				tried[n_tried++] = h->open_routine;
+				switch (try_open_routine(wth, h->open_routine, err, err_info)) {
+
+				case -1:
+					goto fail;
+
+				case 1:
+					goto success;
+				}
+			}
 		}
 
-		switch ((*open_routines[i])(wth, err, err_info)) {
+		if (open_routine_tried(open_routines[i], tried, n_tried))
+			continue;
+
+		switch (try_open_routine(wth, open_routines[i], err, err_info)) {
 
 		case -1:
 			/* I/O error - give up */
-			if (wth->random_fh != NULL)
-				file_close(wth->random_fh);
-			file_close(wth->fh);
-			g_free(wth);
-			return NULL;
+			goto fail;
 
 		case 0:
 			/* No I/O error, but not that type of file */
@@ -397,7 +640,17 @@ wtap* wtap_open_offline(const char *filename, int *err, char **err_info,
 	*err = WTAP_ERR_FILE_UNKNOWN_FORMAT;
 	return NULL;
 
+fail:
+	g_free(probe);
+	if (wth->random_fh != NULL)
+		file_close(wth->random_fh);
+	file_close(wth->fh);
+	g_free(wth);
+	return NULL;
+
 success:
+	g_free(probe);
+	wth->first_record_offset = file_tell(wth->fh);
 	wth->frame_buffer = (struct Buffer *)g_malloc(sizeof(struct Buffer));
 	buffer_init(wth->frame_buffer, 1500);
 
@@ -1103,11 +1356,40 @@ gboolean wtap_dump_can_compress(int filetype)
 
 	return TRUE;
 }
+
+/*
+ * Set the number of threads used to compress files opened for writing
+ * from now on; with more than one, the file is written as a sequence of
+ * independently-compressed gzip members.  If the GLib being used needs
+ * it, g_thread_init() must have been called first.
+ */
+void wtap_dump_set_compression_threads(int threads)
+{
+	gzwfile_set_threads(threads);
+}
+
+/*
+ * Set the type of compression used for files opened for writing from
+ * now on; returns FALSE if that type isn't supported.
+ */
+gboolean wtap_dump_set_compression_type(int type)
+{
+	return gzwfile_set_compression_type(type);
+}
 #else
 gboolean wtap_dump_can_compress(int filetype _U_)
 {
 	return FALSE;
 }
+
+void wtap_dump_set_compression_threads(int threads _U_)
+{
+}
+
+gboolean wtap_dump_set_compression_type(int type _U_)
+{
+	return FALSE;
+}
 #endif
 
 gboolean wtap_dump_has_name_resolution(int filetype)
@@ -61,6 +61,10 @@
 #include <zlib.h>
 #endif /* HAVE_LIBZ */
 
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif /* HAVE_LIBZSTD */
+
 /*
  * See RFC 1952 for a description of the gzip file format.
  *
@@ -69,6 +73,10 @@
  *	XZ format: http://tukaani.org/xz/
  *
  *	Bzip2 format: http://bzip.org/
+ *
+ * Zstandard files are also supported, if we have libzstd; see RFC 8478
+ * for a description of the format, and the "seekable format" document
+ * in the zstd source for the seek table that can be appended to them.
  */
 
 /*
@@ -80,6 +88,9 @@
 static const char *compressed_file_extensions[] = {
 #ifdef HAVE_LIBZ
 	"gz",
+#endif
+#ifdef HAVE_LIBZSTD
+	"zst",
 #endif
 	NULL
 };
@@ -118,7 +129,7 @@ struct wtap_reader {
 	int eof;                /* true if end of input file reached */
 	gint64 start;           /* where the gzip data started, for rewinding */
 	gint64 raw;             /* where the raw data started, for seeking */
-	int compression;        /* 0: ?, 1: uncompressed, 2: zlib */
+	int compression;        /* 0: ?, 1: uncompressed, 2: zlib, 4: zstd */
 	gboolean is_compressed; /* FALSE if completely uncompressed, TRUE otherwise */
 	/* seek request */
 	gint64 skip;            /* amount to skip (already rewound if backwards) */
@@ -133,6 +144,11 @@ struct wtap_reader {
 	/* zlib inflate stream */
 	z_stream strm;          /* stream structure in-place (not a pointer) */
 	int dont_check_crc;	/* 1 if we aren't supposed to check the CRC */
+#endif
+#ifdef HAVE_LIBZSTD
+	/* zstd decompression stream, allocated when first needed */
+	ZSTD_DStream *zstd_strm;
+	gboolean zstd_frame_done; /* TRUE if not in the middle of a zstd frame */
 #endif
 	/* fast seeking */
 	GPtrArray *fast_seek;
@@ -146,6 +162,9 @@ struct wtap_reader {
 #define ZLIB		2	/* decompress a zlib stream */
 #define GZIP_AFTER_HEADER 3
 #endif
+#ifdef HAVE_LIBZSTD
+#define ZSTD		4	/* decompress zstd frames */
+#endif
 
 static int	/* gz_load */
 raw_read(FILE_T state, unsigned char *buf, unsigned int count, unsigned *have)
@@ -560,6 +579,200 @@ zlib_read(FILE_T state, unsigned char *buf, unsigned int count)
 }
 #endif
 
+#ifdef HAVE_LIBZSTD
+/* magic numbers for zstd frames and for the seekable format's seek table */
+#define ZSTD_FRAME_MAGIC	0xFD2FB528
+#define ZSTD_SKIPPABLE_MAGIC	0x184D2A5E
+#define ZSTD_SEEKABLE_MAGIC	0x8F92EAB1
+
+/* size of the seek table footer, and the flag in it saying whether the
+   entries have checksums */
+#define ZSTD_SEEK_FOOTER_SIZE	9
+#define ZSTD_SEEK_CHECKSUM_FLAG	0x80
+
+/* Return 1 if the input starts with a zstd frame, 0 if it doesn't, and
+   -1 on a read error. */
+static int
+zstd_check_magic(FILE_T state)
+{
+	unsigned got;
+
+	/* make sure we have all of the magic number, if there's that much
+	   left in the file */
+	if (state->avail_in < 4 && !state->eof) {
+		memmove(state->in, state->next_in, state->avail_in);
+		state->next_in = state->in;
+		if (raw_read(state, state->in + state->avail_in, state->size - state->avail_in, &got) == -1)
+			return -1;
+		state->avail_in += got;
+	}
+	if (state->avail_in < 4)
+		return 0;
+	return pletohl(state->next_in) == ZSTD_FRAME_MAGIC;
+}
+
+/* Read len bytes at offset off in the file, without disturbing the
+   current position; return FALSE if they can't all be read. */
+static gboolean
+zstd_read_at(FILE_T state, gint64 off, unsigned char *buf, unsigned len)
+{
+	unsigned got = 0;
+	int ret;
+
+	if (ws_lseek64(state->fd, off, SEEK_SET) == -1)
+		return FALSE;
+	do {
+		ret = read(state->fd, buf + got, len - got);
+		if (ret <= 0)
+			break;
+		got += ret;
+	} while (got < len);
+	return got == len;
+}
+
+/* If the file ends with a seekable-format seek table, add a fast-seek
+   point for the start of every frame it lists, so that file_seek() can
+   go straight to any frame without reading the ones before it.  Files
+   without a seek table still get those points, one frame at a time, as
+   they're read. */
+static void
+zstd_read_seek_table(FILE_T state)
+{
+	unsigned char footer[ZSTD_SEEK_FOOTER_SIZE];
+	unsigned char header[8];
+	unsigned char *table;
+	gint64 end, table_start;
+	guint32 num_frames, i;
+	unsigned entry_size;
+	guint64 table_size;
+	gint64 in_pos, out_pos;
+
+	end = ws_lseek64(state->fd, 0, SEEK_END);
+	if (end == -1)
+		goto done;
+	if (end - state->start < 8 + ZSTD_SEEK_FOOTER_SIZE ||
+	    !zstd_read_at(state, end - ZSTD_SEEK_FOOTER_SIZE, footer, ZSTD_SEEK_FOOTER_SIZE) ||
+	    pletohl(&footer[5]) != ZSTD_SEEKABLE_MAGIC ||
+	    (footer[4] & ~ZSTD_SEEK_CHECKSUM_FLAG) != 0)
+		goto done;
+
+	num_frames = pletohl(&footer[0]);
+	entry_size = (footer[4] & ZSTD_SEEK_CHECKSUM_FLAG) ? 12 : 8;
+	table_size = (guint64)num_frames * entry_size;
+	if (table_size > (guint64)(end - state->start - 8 - ZSTD_SEEK_FOOTER_SIZE))
+		goto done;
+	table_start = end - ZSTD_SEEK_FOOTER_SIZE - (gint64)table_size;
+
+	/* the table is the contents of a skippable frame */
+	if (!zstd_read_at(state, table_start - 8, header, 8) ||
+	    pletohl(&header[0]) != ZSTD_SKIPPABLE_MAGIC ||
+	    pletohl(&header[4]) != table_size + ZSTD_SEEK_FOOTER_SIZE)
+		goto done;
+
+	table = (unsigned char *)g_try_malloc((gsize)table_size);
+	if (table == NULL)
+		goto done;
+	if (zstd_read_at(state, table_start, table, (unsigned)table_size)) {
+		/* the frames must account for everything before the table */
+		in_pos = state->start;
+		for (i = 0; i < num_frames; i++)
+			in_pos += pletohl(&table[i * entry_size]);
+		if (in_pos == table_start - 8) {
+			in_pos = state->start;
+			out_pos = 0;
+			for (i = 0; i < num_frames; i++) {
+				fast_seek_header(state, in_pos, out_pos, ZSTD);
+				in_pos += pletohl(&table[i * entry_size]);
+				out_pos += pletohl(&table[i * entry_size + 4]);
+			}
+		}
+	}
+	g_free(table);
+
+done:
+	/* go back to where we were reading */
+	(void)ws_lseek64(state->fd, state->raw_pos, SEEK_SET);
+}
+
+static void
+zstd_read(FILE_T state, unsigned char *buf, unsigned int count)
+{
+	ZSTD_inBuffer input;
+	ZSTD_outBuffer output;
+	size_t before, ret;
+
+	output.dst = buf;
+	output.size = count;
+	output.pos = 0;
+
+	/* fill output buffer up to end of the input or error */
+	do {
+		/* get more input, unless we're at the end of the file after
+		   a complete frame */
+		if (state->avail_in == 0 && fill_in_buffer(state) == -1)
+			break;
+		if (state->avail_in == 0 && state->zstd_frame_done)
+			break;
+
+		input.src = state->next_in;
+		input.size = state->avail_in;
+		input.pos = 0;
+		before = output.pos;
+		ret = ZSTD_decompressStream(state->zstd_strm, &output, &input);
+		state->next_in += input.pos;
+		state->avail_in -= (unsigned)input.pos;
+		if (ZSTD_isError(ret)) {
+			state->err = WTAP_ERR_DECOMPRESS;
+			state->err_info = ZSTD_getErrorName(ret);
+			break;
+		}
+		if (input.pos == 0 && output.pos == before) {
+			/* EOF in the middle of a frame */
+			state->err = WTAP_ERR_SHORT_READ;
+			state->err_info = NULL;
+			break;
+		}
+
+		/* a frame that's been completely decompressed and handed to us
+		   is followed by one that can be decompressed independently,
+		   so the start of that is a good place to seek to */
+		state->zstd_frame_done = (ret == 0);
+		if (ret == 0 && state->fast_seek)
+			fast_seek_header(state, state->raw_pos - state->avail_in, state->pos + output.pos, ZSTD);
+	} while (output.pos < output.size);
+
+	/* update available output */
+	state->next = buf;
+	state->have = (unsigned)output.pos;
+}
+
+/* Set up for decompressing zstd frames starting at the current input
+   position; return -1, and set state->err, on failure. */
+static int
+zstd_init(FILE_T state)
+{
+	size_t ret;
+
+	if (state->zstd_strm == NULL) {
+		state->zstd_strm = ZSTD_createDStream();
+		if (state->zstd_strm == NULL) {
+			state->err = ENOMEM;
+			state->err_info = NULL;
+			return -1;
+		}
+	}
+	ret = ZSTD_initDStream(state->zstd_strm);
+	if (ZSTD_isError(ret)) {
+		state->err = WTAP_ERR_DECOMPRESS;
+		state->err_info = ZSTD_getErrorName(ret);
+		return -1;
+	}
+	state->zstd_frame_done = TRUE;
+	state->compression = ZSTD;
+	return 0;
+}
+#endif
+
 static int
 gz_head(FILE_T state)
 {
@@ -670,6 +883,27 @@ gz_head(FILE_T state)
 		}
 	}
 #endif
+#ifdef HAVE_LIBZSTD
+	/* look for the zstd frame magic number 28 B5 2F FD */
+	if (state->have == 0) {
+		int is_zstd = zstd_check_magic(state);
+
+		if (is_zstd == -1)
+			return -1;
+		if (is_zstd) {
+			if (zstd_init(state) == -1)
+				return -1;
+			state->zstd_frame_done = FALSE;
+			state->is_compressed = TRUE;
+			if (state->fast_seek) {
+				fast_seek_header(state, state->raw_pos - state->avail_in, state->pos, ZSTD);
+				if (state->pos == 0 && state->fast_seek->len == 1)
+					zstd_read_seek_table(state);
+			}
+			return 0;
+		}
+	}
+#endif
 #ifdef HAVE_LIBXZ
 	/* { 0xFD, '7', 'z', 'X', 'Z', 0x00 } */
 	/* FD 37 7A 58 5A 00 */
@@ -709,6 +943,11 @@ fill_out_buffer(FILE_T state)
 	else if (state->compression == ZLIB) {      /* decompress */
 		zlib_read(state, state->out, state->size << 1);
 	}
+#endif
+#ifdef HAVE_LIBZSTD
+	else if (state->compression == ZSTD) {      /* decompress */
+		zstd_read(state, state->out, state->size << 1);
+	}
 #endif
 	return 0;
 }
@@ -833,6 +1072,9 @@ file_fdopen(int fd)
 
 	/* for now, assume we should check the crc */
 	state->dont_check_crc = 0;
+#endif
+#ifdef HAVE_LIBZSTD
+	state->zstd_strm = NULL;
 #endif
 	/* return stream */
 	return state;
@@ -962,6 +1204,12 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
 			off = here->in;
 			off2 = here->out;
 		} else
+#endif
+#ifdef HAVE_LIBZSTD
+		if (here->compression == ZSTD) {
+			off = here->in;
+			off2 = here->out;
+		} else
 #endif
 		{
 			off2 = (file->pos + offset);
@@ -1014,6 +1262,14 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
 			strm->adler = crc32(0L, Z_NULL, 0);
 			file->compression = ZLIB;
 		} else
+#endif
+#ifdef HAVE_LIBZSTD
+		if (here->compression == ZSTD) {
+			if (zstd_init(file) == -1) {
+				*err = file->err;
+				return -1;
+			}
+		} else
 #endif
 			file->compression = here->compression;
 
@@ -1329,6 +1585,10 @@ file_close(FILE_T file)
 	if (file->size) {
 #ifdef HAVE_LIBZ
 		inflateEnd(&(file->strm));
+#endif
+#ifdef HAVE_LIBZSTD
+		if (file->zstd_strm != NULL)
+			ZSTD_freeDStream(file->zstd_strm);
 #endif
 		g_free(file->out);
 		g_free(file->in);
@@ -1347,6 +1607,48 @@ file_close(FILE_T file)
 }
 
 #ifdef HAVE_LIBZ
+/*
+ * When writing with more than one compression thread, the uncompressed
+ * data is cut into blocks of GZ_MEMBER_SIZE bytes, and each block is
+ * deflated, independently of all the others, into a complete gzip member
+ * of its own by a pool of threads; the members are then written out in
+ * order.  A sequence of gzip members is itself a valid gzip file (see
+ * RFC 1952), and, as each member starts with an empty dictionary, the
+ * reader records the start of each member as a fast-seek point that
+ * needs no saved window.
+ */
+#define GZ_MEMBER_SIZE  (1024*1024)
+
+/* Number of compression threads used by writers opened from now on. */
+static int gz_threads = 1;
+
+/* Type of compression used by writers opened from now on. */
+static int gz_type = WTAP_GZIP_COMPRESSED;
+
+#ifdef HAVE_LIBZSTD
+/*
+ * zstd files are written in the seekable format: the data is cut into
+ * frames of ZSTD_FRAME_SIZE bytes, each compressed independently of the
+ * others, followed by a skippable frame holding a table of the sizes of
+ * those frames, which the reader uses to find them without reading the
+ * file.
+ */
+#define ZSTD_FRAME_SIZE		(1024*1024)
+#define ZSTD_WRITE_LEVEL	3
+#endif
+
+/* a block of data being compressed into a gzip member by a thread */
+struct gz_member {
+    unsigned char *in;      /* uncompressed data */
+    unsigned in_len;        /* amount of uncompressed data */
+    unsigned char *out;     /* compressed data, NULL if not compressed yet */
+    unsigned out_len;       /* amount of compressed data */
+    int level;              /* compression level */
+    int strategy;           /* compression strategy */
+    int err;                /* error code, 0 if compressed successfully */
+    gboolean done;          /* TRUE once the writer knows it's compressed */
+};
+
 /* internal gzip file state data structure for writing */
 struct wtap_writer {
     int fd;                 /* file descriptor */
@@ -1361,8 +1663,50 @@ struct wtap_writer {
     int err;                /* error code */
 	/* zlib deflate stream */
     z_stream strm;          /* stream structure in-place (not a pointer) */
+    /* multi-threaded compression */
+    int threads;            /* number of compression threads, 1 if none */
+    GThreadPool *pool;      /* threads compressing members */
+    GAsyncQueue *compressed; /* members the threads have finished with */
+    GQueue *pending;        /* members handed to the threads, in file order */
+    struct gz_member *cur;  /* member being filled by gzwfile_write() */
+    guint64 members;        /* number of members handed to the threads */
+    /* compression type */
+    int type;               /* WTAP_GZIP_COMPRESSED or WTAP_ZSTD_COMPRESSED */
+#ifdef HAVE_LIBZSTD
+    ZSTD_CStream *zstd_strm; /* zstd compression stream */
+    guint32 frame_in;       /* uncompressed data in the current frame */
+    guint32 frame_out;      /* compressed data in the current frame */
+    GByteArray *seek_table; /* seek table entries for the frames so far */
+#endif
 };
 
+/* Set the number of threads to use to compress gzip files opened for
+   writing from now on; 1 means compress on the writing thread. */
+void
+gzwfile_set_threads(int threads)
+{
+    gz_threads = threads < 1 ? 1 : threads;
+}
+
+/* Set the type of compression to use for files opened for writing from
+   now on; return FALSE if that type isn't supported. */
+gboolean
+gzwfile_set_compression_type(int type)
+{
+    switch (type) {
+
+    case WTAP_GZIP_COMPRESSED:
+#ifdef HAVE_LIBZSTD
+    case WTAP_ZSTD_COMPRESSED:
+#endif
+        gz_type = type;
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+
 GZWFILE_T
 gzwfile_open(const char *path)
 {
@@ -1403,10 +1747,35 @@ gzwfile_fdopen(int fd)
     state->pos = 0;                 /* no uncompressed data yet */
     state->strm.avail_in = 0;       /* no input data yet */
 
+    state->threads = gz_threads;
+#if !GLIB_CHECK_VERSION(2,31,0)
+    /* the thread pool can only be used if threads have been initialized */
+    if (!g_thread_supported())
+        state->threads = 1;
+#endif
+    state->pool = NULL;
+    state->compressed = NULL;
+    state->pending = NULL;
+    state->cur = NULL;
+    state->members = 0;
+
+    state->type = gz_type;
+#ifdef HAVE_LIBZSTD
+    /* zstd streams are compressed on the writing thread */
+    if (state->type == WTAP_ZSTD_COMPRESSED)
+        state->threads = 1;
+    state->zstd_strm = NULL;
+    state->frame_in = 0;
+    state->frame_out = 0;
+    state->seek_table = NULL;
+#endif
+
     /* return stream */
     return state;
 }
 
+static void gz_member_compress(gpointer data, gpointer user_data);
+
 /* Initialize state for writing a gzip file.  Mark initialization by setting
    state->size to non-zero.  Return -1, and set state->err, on failure;
    return 0 on success. */
@@ -1416,6 +1785,22 @@ gz_init(GZWFILE_T state)
     int ret;
     z_streamp strm = &(state->strm);
 
+    if (state->threads > 1) {
+        /* start the compression threads; if we can't, compress on this
+           thread instead */
+        state->compressed = g_async_queue_new();
+        state->pool = g_thread_pool_new(gz_member_compress, state->compressed,
+                                        state->threads, TRUE, NULL);
+        if (state->pool != NULL) {
+            state->pending = g_queue_new();
+            state->size = GZ_MEMBER_SIZE;
+            return 0;
+        }
+        g_async_queue_unref(state->compressed);
+        state->compressed = NULL;
+        state->threads = 1;
+    }
+
     /* allocate input and output buffers */
     state->in = (unsigned char *)g_try_malloc(state->want);
     state->out = (unsigned char *)g_try_malloc(state->want);
@@ -1516,6 +1901,392 @@ gz_comp(GZWFILE_T state, int flush)
     return 0;
 }
 
+/* Compress a block of data into a complete gzip member; called on one
+   of the threads in the pool, which hands the member back through the
+   queue in user_data. */
+static void
+gz_member_compress(gpointer data, gpointer user_data)
+{
+    struct gz_member *member = (struct gz_member *)data;
+    GAsyncQueue *compressed = (GAsyncQueue *)user_data;
+    z_stream strm;
+    uLong out_size;
+    int ret;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    ret = deflateInit2(&strm, member->level, Z_DEFLATED,
+                       15 + 16, 8, member->strategy);
+    if (ret != Z_OK) {
+        member->err = (ret == Z_MEM_ERROR) ? ENOMEM : WTAP_ERR_INTERNAL;
+        g_async_queue_push(compressed, member);
+        return;
+    }
+
+    /* allow for the gzip header and trailer, which older versions of
+       deflateBound() leave out */
+    out_size = deflateBound(&strm, member->in_len) + 32;
+    member->out = (unsigned char *)g_try_malloc(out_size);
+    if (member->out == NULL) {
+        member->err = ENOMEM;
+    } else {
+        strm.next_in = member->in;
+        strm.avail_in = member->in_len;
+        strm.next_out = member->out;
+        strm.avail_out = (uInt)out_size;
+        if (deflate(&strm, Z_FINISH) == Z_STREAM_END)
+            member->out_len = (unsigned)(out_size - strm.avail_out);
+        else {
+            /* This "shouldn't happen". */
+            member->err = WTAP_ERR_INTERNAL;
+        }
+    }
+    (void)deflateEnd(&strm);
+    g_async_queue_push(compressed, member);
+}
+
+/* Write len bytes of already-compressed data from buf to the output file.
+   Return -1, and set state->err, on failure; return 0 on success. */
+static int
+gz_write_raw(GZWFILE_T state, const void *buf, unsigned len)
+{
+    int got;
+
+    got = write(state->fd, buf, len);
+    if (got < 0) {
+        state->err = errno;
+        return -1;
+    }
+    if ((unsigned)got != len) {
+        state->err = WTAP_ERR_SHORT_WRITE;
+        return -1;
+    }
+    return 0;
+}
+
+static void
+gz_member_free(struct gz_member *member)
+{
+    g_free(member->out);
+    g_free(member->in);
+    g_free(member);
+}
+
+/* Wait for the oldest member handed to the threads to be compressed and
+   write it out, or just discard it if we've already had an error.  Return
+   -1, and set state->err, on failure; return 0 on success. */
+static int
+gz_member_wait(GZWFILE_T state)
+{
+    struct gz_member *member = (struct gz_member *)g_queue_pop_head(state->pending);
+
+    /* the threads can finish members in any order, so collect finished
+       ones until the one we want comes back */
+    while (!member->done)
+        ((struct gz_member *)g_async_queue_pop(state->compressed))->done = TRUE;
+
+    if (state->err == Z_OK) {
+        if (member->err != 0)
+            state->err = member->err;
+        else
+            (void)gz_write_raw(state, member->out, member->out_len);
+    }
+    gz_member_free(member);
+    return state->err == Z_OK ? 0 : -1;
+}
+
+/* Hand the member being filled to the threads, and write out whatever
+   members at the front of the file have been compressed, waiting for
+   them if too many are outstanding.  Return -1, and set state->err, on
+   failure; return 0 on success. */
+static int
+gz_member_submit(GZWFILE_T state)
+{
+    struct gz_member *member;
+
+    g_queue_push_tail(state->pending, state->cur);
+    g_thread_pool_push(state->pool, state->cur, NULL);
+    state->cur = NULL;
+    state->members++;
+
+    while ((member = (struct gz_member *)g_async_queue_try_pop(state->compressed)) != NULL)
+        member->done = TRUE;
+    while (!g_queue_is_empty(state->pending)) {
+        member = (struct gz_member *)g_queue_peek_head(state->pending);
+        if (!member->done && g_queue_get_length(state->pending) <= 2 * (guint)state->threads)
+            break;
+        if (gz_member_wait(state) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+/* Hand any partly-filled member to the threads, and wait for all members
+   to be compressed and written out.  Return -1, and set state->err, on
+   failure; return 0 on success. */
+static int
+gz_member_drain(GZWFILE_T state)
+{
+    if (state->cur != NULL && state->cur->in_len != 0 && state->err == Z_OK) {
+        if (gz_member_submit(state) == -1)
+            return -1;
+    }
+    while (!g_queue_is_empty(state->pending))
+        gz_member_wait(state);
+    return state->err == Z_OK ? 0 : -1;
+}
+
+/* Write out len bytes from buf, cutting it into members to be compressed
+   by the threads.  Return 0, and set state->err, on failure; return the
+   number of bytes written on success. */
+static unsigned
+gz_member_write(GZWFILE_T state, const void *buf, unsigned len)
+{
+    unsigned put = len;
+    unsigned n;
+
+    while (len) {
+        if (state->cur == NULL) {
+            state->cur = g_try_new0(struct gz_member, 1);
+            if (state->cur == NULL) {
+                state->err = ENOMEM;
+                return 0;
+            }
+            state->cur->in = (unsigned char *)g_try_malloc(GZ_MEMBER_SIZE);
+            if (state->cur->in == NULL) {
+                g_free(state->cur);
+                state->cur = NULL;
+                state->err = ENOMEM;
+                return 0;
+            }
+            state->cur->level = state->level;
+            state->cur->strategy = state->strategy;
+        }
+        n = GZ_MEMBER_SIZE - state->cur->in_len;
+        if (n > len)
+            n = len;
+        memcpy(state->cur->in + state->cur->in_len, buf, n);
+        state->cur->in_len += n;
+        state->pos += n;
+        buf = (const char *)buf + n;
+        len -= n;
+        if (state->cur->in_len == GZ_MEMBER_SIZE && gz_member_submit(state) == -1)
+            return 0;
+    }
+    return put;
+}
+
+#ifdef HAVE_LIBZSTD
+/* Initialize state for writing a zstd file, marking it as initialized by
+   setting state->size to non-zero.  Return -1, and set state->err, on
+   failure; return 0 on success. */
+static int
+zstd_writer_init(GZWFILE_T state)
+{
+    size_t ret;
+
+    state->size = (unsigned)ZSTD_CStreamOutSize();
+    state->out = (unsigned char *)g_try_malloc(state->size);
+    state->zstd_strm = ZSTD_createCStream();
+    if (state->out == NULL || state->zstd_strm == NULL) {
+        if (state->zstd_strm != NULL)
+            ZSTD_freeCStream(state->zstd_strm);
+        state->zstd_strm = NULL;
+        g_free(state->out);
+        state->out = NULL;
+        state->size = 0;
+        state->err = ENOMEM;
+        return -1;
+    }
+    ret = ZSTD_initCStream(state->zstd_strm, ZSTD_WRITE_LEVEL);
+    if (ZSTD_isError(ret)) {
+        /* This "shouldn't happen". */
+        ZSTD_freeCStream(state->zstd_strm);
+        state->zstd_strm = NULL;
+        g_free(state->out);
+        state->out = NULL;
+        state->size = 0;
+        state->err = WTAP_ERR_INTERNAL;
+        return -1;
+    }
+    state->seek_table = g_byte_array_new();
+    return 0;
+}
+
+static void
+zstd_append_le32(GByteArray *array, guint32 val)
+{
+    guint8 bytes[4];
+
+    phtolel(bytes, val);
+    g_byte_array_append(array, bytes, 4);
+}
+
+/* Write out whatever zstd has put in the output buffer, and empty it.
+   Return -1, and set state->err, on failure; return 0 on success. */
+static int
+zstd_write_out(GZWFILE_T state, ZSTD_outBuffer *output)
+{
+    if (output->pos != 0) {
+        if (gz_write_raw(state, output->dst, (unsigned)output->pos) == -1)
+            return -1;
+        state->frame_out += (guint32)output->pos;
+        output->pos = 0;
+    }
+    return 0;
+}
+
+/* Finish the current frame, add it to the seek table, and start a new
+   one.  Return -1, and set state->err, on failure; return 0 on success. */
+static int
+zstd_end_frame(GZWFILE_T state)
+{
+    ZSTD_outBuffer output;
+    size_t ret;
+
+    output.dst = state->out;
+    output.size = state->size;
+    output.pos = 0;
+    do {
+        ret = ZSTD_endStream(state->zstd_strm, &output);
+        if (ZSTD_isError(ret)) {
+            /* This "shouldn't happen". */
+            state->err = WTAP_ERR_INTERNAL;
+            return -1;
+        }
+        if (zstd_write_out(state, &output) == -1)
+            return -1;
+    } while (ret != 0);
+
+    zstd_append_le32(state->seek_table, state->frame_out);
+    zstd_append_le32(state->seek_table, state->frame_in);
+    state->frame_in = 0;
+    state->frame_out = 0;
+
+    ret = ZSTD_initCStream(state->zstd_strm, ZSTD_WRITE_LEVEL);
+    if (ZSTD_isError(ret)) {
+        state->err = WTAP_ERR_INTERNAL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Compress len bytes from buf into zstd frames.  Return 0, and set
+   state->err, on failure; return the number of bytes written on
+   success. */
+static unsigned
+zstd_write(GZWFILE_T state, const void *buf, unsigned len)
+{
+    unsigned put = len;
+    unsigned n;
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output;
+    size_t ret;
+
+    if (state->size == 0 && zstd_writer_init(state) == -1)
+        return 0;
+
+    output.dst = state->out;
+    output.size = state->size;
+    output.pos = 0;
+    while (len) {
+        /* don't let the frame get bigger than ZSTD_FRAME_SIZE */
+        n = ZSTD_FRAME_SIZE - state->frame_in;
+        if (n > len)
+            n = len;
+        input.src = buf;
+        input.size = n;
+        input.pos = 0;
+        while (input.pos < input.size) {
+            ret = ZSTD_compressStream(state->zstd_strm, &output, &input);
+            if (ZSTD_isError(ret)) {
+                /* This "shouldn't happen". */
+                state->err = WTAP_ERR_INTERNAL;
+                return 0;
+            }
+            if (zstd_write_out(state, &output) == -1)
+                return 0;
+        }
+        state->frame_in += n;
+        state->pos += n;
+        buf = (const char *)buf + n;
+        len -= n;
+        if (state->frame_in == ZSTD_FRAME_SIZE && zstd_end_frame(state) == -1)
+            return 0;
+    }
+    return put;
+}
+
+/* Write out everything zstd has buffered up, without ending the frame.
+   Return -1, and set state->err, on failure; return 0 on success. */
+static int
+zstd_flush(GZWFILE_T state)
+{
+    ZSTD_outBuffer output;
+    size_t ret;
+
+    if (state->size == 0)
+        return 0;
+    output.dst = state->out;
+    output.size = state->size;
+    output.pos = 0;
+    do {
+        ret = ZSTD_flushStream(state->zstd_strm, &output);
+        if (ZSTD_isError(ret)) {
+            state->err = WTAP_ERR_INTERNAL;
+            return -1;
+        }
+        if (zstd_write_out(state, &output) == -1)
+            return -1;
+    } while (ret != 0);
+    return 0;
+}
+
+/* Finish the last frame, and write out the seek table, in a skippable
+   frame.  Return -1, and set state->err, on failure; return 0 on
+   success. */
+static int
+zstd_finish(GZWFILE_T state)
+{
+    GByteArray *table;
+    guint32 num_frames;
+    int ret;
+
+    if (state->size == 0 && zstd_writer_init(state) == -1)
+        return -1;
+
+    /* write an empty frame if there's no data, so it's still a zstd file */
+    if ((state->frame_in != 0 || state->seek_table->len == 0) &&
+        zstd_end_frame(state) == -1)
+        return -1;
+
+    num_frames = state->seek_table->len / 8;
+    table = g_byte_array_sized_new(8 + state->seek_table->len + 9);
+    zstd_append_le32(table, ZSTD_SKIPPABLE_MAGIC);
+    zstd_append_le32(table, state->seek_table->len + 9);
+    g_byte_array_append(table, state->seek_table->data, state->seek_table->len);
+    zstd_append_le32(table, num_frames);
+    g_byte_array_append(table, (const guint8 *)"", 1);  /* no checksums */
+    zstd_append_le32(table, ZSTD_SEEKABLE_MAGIC);
+    ret = gz_write_raw(state, table->data, table->len);
+    g_byte_array_free(table, TRUE);
+    return ret;
+}
+
+/* Free up the zstd state. */
+static void
+zstd_writer_free(GZWFILE_T state)
+{
+    if (state->zstd_strm != NULL)
+        ZSTD_freeCStream(state->zstd_strm);
+    if (state->seek_table != NULL)
+        g_byte_array_free(state->seek_table, TRUE);
+    if (state->size != 0)
+        g_free(state->out);
+}
+#endif
+
 /* Write out len bytes from buf.  Return 0, and set state->err, on
    failure or on an attempt to write 0 bytes (in which case state->err
    is Z_OK); return the number of bytes written on success. */
@@ -1536,10 +2307,18 @@ gzwfile_write(GZWFILE_T state, const void *buf, unsigned len)
     if (len == 0)
         return 0;
 
+#ifdef HAVE_LIBZSTD
+    if (state->type == WTAP_ZSTD_COMPRESSED)
+        return zstd_write(state, buf, len);
+#endif
+
     /* allocate memory if this is the first time through */
     if (state->size == 0 && gz_init(state) == -1)
         return 0;
 
+    if (state->threads > 1)
+        return gz_member_write(state, buf, len);
+
     /* for small len, copy to input buffer, otherwise compress directly */
     if (len < state->size) {
         /* copy to input buffer, compress when full */
@@ -1584,6 +2363,15 @@ gzwfile_flush(GZWFILE_T state)
     if (state->err != Z_OK)
         return -1;
 
+#ifdef HAVE_LIBZSTD
+    if (state->type == WTAP_ZSTD_COMPRESSED)
+        return zstd_flush(state);
+#endif
+
+    /* with threads, finish off the current member and write everything */
+    if (state->threads > 1)
+        return state->size == 0 ? 0 : gz_member_drain(state);
+
     /* compress remaining data with Z_SYNC_FLUSH */
     gz_comp(state, Z_SYNC_FLUSH);
     if (state->err != Z_OK)
@@ -1598,6 +2386,49 @@ gzwfile_close(GZWFILE_T state)
 {
     int ret = 0;
 
+#ifdef HAVE_LIBZSTD
+    if (state->type == WTAP_ZSTD_COMPRESSED) {
+        if (state->err != Z_OK || zstd_finish(state) == -1)
+            ret = state->err;
+        zstd_writer_free(state);
+        state->err = Z_OK;
+        if (close(state->fd) == -1 && ret == 0)
+            ret = errno;
+        g_free(state);
+        return ret;
+    }
+#endif
+
+    /* write out all the members, including an empty one if nothing was
+       written, so that the file is still a gzip file, and stop the
+       threads; if they couldn't be started, finish up on this thread */
+    if (state->threads > 1 && state->size == 0)
+        (void)gz_init(state);
+    if (state->threads > 1) {
+        if (state->members == 0 && state->cur == NULL &&
+            state->err == Z_OK) {
+            state->cur = g_try_new0(struct gz_member, 1);
+            if (state->cur != NULL) {
+                state->cur->level = state->level;
+                state->cur->strategy = state->strategy;
+                (void)gz_member_submit(state);
+            } else
+                state->err = ENOMEM;
+        }
+        if (gz_member_drain(state) == -1)
+            ret = state->err;
+        if (state->cur != NULL)
+            gz_member_free(state->cur);
+        g_thread_pool_free(state->pool, FALSE, TRUE);
+        g_async_queue_unref(state->compressed);
+        g_queue_free(state->pending);
+        state->err = Z_OK;
+        if (close(state->fd) == -1 && ret == 0)
+            ret = errno;
+        g_free(state);
+        return ret;
+    }
+
     /* flush, free memory, and close file */
     if (gz_comp(state, Z_FINISH) == -1 && ret == 0)
         ret = state->err;
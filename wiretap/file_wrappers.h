@@ -55,6 +55,8 @@ extern unsigned gzwfile_write(GZWFILE_T state, const void *buf, unsigned len);
 extern int gzwfile_flush(GZWFILE_T state);
 extern int gzwfile_close(GZWFILE_T state);
 extern int gzwfile_geterr(GZWFILE_T state);
+extern void gzwfile_set_threads(int threads);
+extern gboolean gzwfile_set_compression_type(int type);
 #endif /* HAVE_LIBZ */
 
 #endif /* __FILE_H__ */
@@ -67,9 +67,16 @@ static libpcap_try_t libpcap_try(wtap *wth, int *err);
 
 static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
     gint64 *data_offset);
+static int libpcap_read_batch(wtap *wth, struct wtap_batch_rec *recs,
+    int max_recs, int *err, gchar **err_info);
+static gboolean libpcap_read_packet(wtap *wth, struct wtap_pkthdr *phdr,
+    struct Buffer *buf, int *err, gchar **err_info, gint64 *data_offset);
 static gboolean libpcap_seek_read(wtap *wth, gint64 seek_off,
     struct wtap_pkthdr *phdr, guint8 *pd, int length,
     int *err, gchar **err_info);
+static int libpcap_find_record(wtap *wth, gint64 offset, gint64 file_size,
+    gint64 *rec_offset, int *err, gchar **err_info);
+static int libpcap_rec_hdr_size(int file_type);
 static int libpcap_read_header(wtap *wth, int *err, gchar **err_info,
     struct pcaprec_ss990915_hdr *hdr);
 static void adjust_header(wtap *wth, struct pcaprec_hdr *hdr);
@@ -261,6 +268,9 @@ int libpcap_open(wtap *wth, int *err, gchar **err_info)
 	libpcap->version_minor = hdr.version_minor;
 	wth->priv = (void *)libpcap;
 	wth->subtype_read = libpcap_read;
+	wth->subtype_read_batch = libpcap_read_batch;
+	wth->can_skip_data = TRUE;
+	wth->subtype_find_record = libpcap_find_record;
 	wth->subtype_seek_read = libpcap_seek_read;
 	wth->file_encap = file_encap;
 	wth->snapshot_length = hdr.snaplen;
@@ -604,6 +614,33 @@ static libpcap_try_t libpcap_try(wtap *wth, int *err)
 /* Read the next packet */
 static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
     gint64 *data_offset)
+{
+	buffer_clean(wth->frame_buffer);
+	return libpcap_read_packet(wth, &wth->phdr, wth->frame_buffer, err,
+	    err_info, data_offset);
+}
+
+/* Read packets straight into the batch buffer */
+static int libpcap_read_batch(wtap *wth, struct wtap_batch_rec *recs,
+    int max_recs, int *err, gchar **err_info)
+{
+	int n;
+
+	for (n = 0; n < max_recs; ) {
+		memset(&recs[n].phdr, 0, sizeof recs[n].phdr);
+		if (!libpcap_read_packet(wth, &recs[n].phdr, wth->batch_buffer,
+		    err, err_info, &recs[n].data_offset))
+			break;
+		n++;
+		if (buffer_length(wth->batch_buffer) >= WTAP_BATCH_BUFFER_SIZE)
+			break;
+	}
+	return n;
+}
+
+/* Read the next packet, appending its data to a buffer */
+static gboolean libpcap_read_packet(wtap *wth, struct wtap_pkthdr *phdr,
+    struct Buffer *buf, int *err, gchar **err_info, gint64 *data_offset)
 {
 	struct pcaprec_ss990915_hdr hdr;
 	guint packet_size;
@@ -612,6 +649,25 @@ static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
 	guint8 fddi_padding[3];
 	int phdr_len;
 	libpcap_t *libpcap;
+	gint64 pos;
+
+	if (wth->range_end != 0) {
+		/* We're reading a range of the file; stop at its end */
+		pos = file_tell(wth->fh);
+		if (pos > wth->range_end) {
+			/*
+			 * The last record ran past it, so the range doesn't
+			 * end at a record boundary.
+			 */
+			*err = WTAP_ERR_BAD_FILE;
+			*err_info = g_strdup("pcap: record crosses the end of the range being read");
+			return FALSE;
+		}
+		if (pos == wth->range_end) {
+			*err = 0;
+			return FALSE;
+		}
+	}
 
 	bytes_read = libpcap_read_header(wth, err, err_info, &hdr);
 	if (bytes_read == -1) {
@@ -649,9 +705,10 @@ static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
 	*data_offset = file_tell(wth->fh);
 
 	libpcap = (libpcap_t *)wth->priv;
+	phdr->pkt_encap = wth->file_encap;
 	phdr_len = pcap_process_pseudo_header(wth->fh, wth->file_type,
-	    wth->file_encap, packet_size, TRUE, &wth->phdr,
-	    &wth->phdr.pseudo_header, err, err_info);
+	    wth->file_encap, packet_size, TRUE, phdr,
+	    &phdr->pseudo_header, err, err_info);
 	if (phdr_len < 0)
 		return FALSE;	/* error */
 
@@ -661,32 +718,48 @@ static gboolean libpcap_read(wtap *wth, int *err, gchar **err_info,
 	orig_size -= phdr_len;
 	packet_size -= phdr_len;
 
-	buffer_assure_space(wth->frame_buffer, packet_size);
-	if (!libpcap_read_rec_data(wth->fh, buffer_start_ptr(wth->frame_buffer),
-	    packet_size, err, err_info))
-		return FALSE;	/* Read error */
+	if (wth->headers_only) {
+		/*
+		 * Skip the data, making sure the file isn't cut short
+		 * in the middle of them.
+		 */
+		if (file_skip(wth->fh, packet_size, err) == -1)
+			return FALSE;
+		if (file_tell(wth->fh) > wth->headers_only_size) {
+			*err = WTAP_ERR_SHORT_READ;
+			return FALSE;
+		}
+	} else {
+		buffer_assure_space(buf, packet_size);
+		if (!libpcap_read_rec_data(wth->fh, buffer_end_ptr(buf),
+		    packet_size, err, err_info))
+			return FALSE;	/* Read error */
+	}
 
-	wth->phdr.presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
+	phdr->presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
 
 	/* Update the Timestamp, if not already done */
 	if (wth->file_encap != WTAP_ENCAP_ERF) {
-	  wth->phdr.ts.secs = hdr.hdr.ts_sec;
+	  phdr->ts.secs = hdr.hdr.ts_sec;
 	  if(wth->tsprecision == WTAP_FILE_TSPREC_NSEC) {
-	    wth->phdr.ts.nsecs = hdr.hdr.ts_usec;
+	    phdr->ts.nsecs = hdr.hdr.ts_usec;
 	  } else {
-	    wth->phdr.ts.nsecs = hdr.hdr.ts_usec * 1000;
+	    phdr->ts.nsecs = hdr.hdr.ts_usec * 1000;
 	  }
 	} else {
 	  /* Set interface ID for ERF format */
-	  wth->phdr.presence_flags |= WTAP_HAS_INTERFACE_ID;
-	  wth->phdr.interface_id = wth->phdr.pseudo_header.erf.phdr.flags & 0x03;
+	  phdr->presence_flags |= WTAP_HAS_INTERFACE_ID;
+	  phdr->interface_id = phdr->pseudo_header.erf.phdr.flags & 0x03;
+	}
+	phdr->caplen = packet_size;
+	phdr->len = orig_size;
+
+	if (!wth->headers_only) {
+		pcap_read_post_process(wth->file_type, wth->file_encap,
+		    &phdr->pseudo_header, buffer_end_ptr(buf),
+		    phdr->caplen, libpcap->byte_swapped, -1);
+		buffer_increase_length(buf, packet_size);
 	}
-	wth->phdr.caplen = packet_size;
-	wth->phdr.len = orig_size;
-
-	pcap_read_post_process(wth->file_type, wth->file_encap,
-	    &wth->phdr.pseudo_header, buffer_start_ptr(wth->frame_buffer),
-	    wth->phdr.caplen, libpcap->byte_swapped, -1);
 	return TRUE;
 }
 
@@ -719,41 +792,142 @@ libpcap_seek_read(wtap *wth, gint64 seek_off,
 	return TRUE;
 }
 
-/* Read the header of the next packet.
+/*
+ * Number of records that must follow each other, each looking sane,
+ * for us to believe a record starts at some offset when looking for
+ * one in the middle of the file; fewer will do if the last one ends
+ * at the end of the file.
+ */
+#define LIBPCAP_RESYNC_RECORDS	4
 
-   Return -1 on an error, or the number of bytes of header read on success. */
-static int libpcap_read_header(wtap *wth, int *err, gchar **err_info,
-    struct pcaprec_ss990915_hdr *hdr)
+/*
+ * Check whether records that look sane start at an offset and follow
+ * each other.  Returns 1 if they do, 0 if they don't, and -1 on an
+ * I/O error.
+ */
+static int libpcap_check_records(wtap *wth, gint64 offset, gint64 file_size,
+    int *err, gchar **err_info)
 {
-	int	bytes_to_read, bytes_read;
+	struct pcaprec_ss990915_hdr hdr;
+	gchar *rec_err_info = NULL;
+	int hdr_size;
+	guint32 max_usec, prev_secs = 0, prev_usecs = 0;
+	int i;
+
+	hdr_size = libpcap_rec_hdr_size(wth->file_type);
+	max_usec = (wth->tsprecision == WTAP_FILE_TSPREC_NSEC) ?
+	    1000000000U : 1000000U;
+	for (i = 0; i < LIBPCAP_RESYNC_RECORDS; i++) {
+		if (offset == file_size)
+			return 1;	/* the last one ended the file */
+
+		if (file_seek(wth->fh, offset, SEEK_SET, err) == -1)
+			return -1;
+		if (libpcap_read_header(wth, err, &rec_err_info, &hdr) == -1) {
+			if (*err == 0 || *err == WTAP_ERR_SHORT_READ ||
+			    *err == WTAP_ERR_BAD_FILE) {
+				/* Not a sane header */
+				g_free(rec_err_info);
+				*err = 0;
+				return 0;
+			}
+			*err_info = rec_err_info;
+			return -1;
+		}
 
-	/* Read record header. */
-	errno = WTAP_ERR_CANT_READ;
-	switch (wth->file_type) {
+		/*
+		 * On top of the length checks libpcap_read_header()
+		 * does, a record must have some data, no more of it
+		 * than the packet had or than the snapshot length, a
+		 * time stamp that isn't zero and whose fraction is less
+		 * than a second, and time stamps mustn't go backwards.
+		 * Zeroed regions and packet data would otherwise pass.
+		 */
+		if (hdr.hdr.incl_len == 0 ||
+		    hdr.hdr.orig_len < hdr.hdr.incl_len)
+			return 0;
+		if (wth->snapshot_length != 0 &&
+		    hdr.hdr.incl_len > wth->snapshot_length)
+			return 0;
+		if (hdr.hdr.ts_sec == 0 || hdr.hdr.ts_usec >= max_usec)
+			return 0;
+		if (hdr.hdr.ts_sec < prev_secs ||
+		    (hdr.hdr.ts_sec == prev_secs && hdr.hdr.ts_usec < prev_usecs))
+			return 0;
+		prev_secs = hdr.hdr.ts_sec;
+		prev_usecs = hdr.hdr.ts_usec;
+
+		offset += hdr_size + hdr.hdr.incl_len;
+		if (offset > file_size)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * Find the first record at or after an offset.  A record must start
+ * within the size of the biggest record from any offset in the file,
+ * so we look no further than that.
+ */
+static int libpcap_find_record(wtap *wth, gint64 offset, gint64 file_size,
+    gint64 *rec_offset, int *err, gchar **err_info)
+{
+	gint64 limit;
+
+	limit = offset + libpcap_rec_hdr_size(wth->file_type) +
+	    WTAP_MAX_PACKET_SIZE;
+	for (; offset < limit && offset < file_size; offset++) {
+		switch (libpcap_check_records(wth, offset, file_size, err,
+		    err_info)) {
+
+		case -1:
+			return -1;
+
+		case 1:
+			*rec_offset = offset;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Size of the record headers in a file of a given type. */
+static int libpcap_rec_hdr_size(int file_type)
+{
+	switch (file_type) {
 
 	case WTAP_FILE_PCAP:
 	case WTAP_FILE_PCAP_AIX:
 	case WTAP_FILE_PCAP_NSEC:
-		bytes_to_read = sizeof (struct pcaprec_hdr);
-		break;
+		return sizeof (struct pcaprec_hdr);
 
 	case WTAP_FILE_PCAP_SS990417:
 	case WTAP_FILE_PCAP_SS991029:
-		bytes_to_read = sizeof (struct pcaprec_modified_hdr);
-		break;
+		return sizeof (struct pcaprec_modified_hdr);
 
 	case WTAP_FILE_PCAP_SS990915:
-		bytes_to_read = sizeof (struct pcaprec_ss990915_hdr);
-		break;
+		return sizeof (struct pcaprec_ss990915_hdr);
 
 	case WTAP_FILE_PCAP_NOKIA:
-		bytes_to_read = sizeof (struct pcaprec_nokia_hdr);
-		break;
+		return sizeof (struct pcaprec_nokia_hdr);
 
 	default:
 		g_assert_not_reached();
-		bytes_to_read = 0;
+		return 0;
 	}
+}
+
+/* Read the header of the next packet.
+
+   Return -1 on an error, or the number of bytes of header read on success. */
+static int libpcap_read_header(wtap *wth, int *err, gchar **err_info,
+    struct pcaprec_ss990915_hdr *hdr)
+{
+	int	bytes_to_read, bytes_read;
+
+	/* Read record header. */
+	errno = WTAP_ERR_CANT_READ;
+	bytes_to_read = libpcap_rec_hdr_size(wth->file_type);
 	bytes_read = file_read(hdr, bytes_to_read, wth->fh);
 	if (bytes_read != bytes_to_read) {
 		*err = file_error(wth->fh, err_info);
@@ -45,6 +45,23 @@ typedef gboolean (*subtype_read_func)(struct wtap*, int*, char**, gint64*);
 typedef gboolean (*subtype_seek_read_func)(struct wtap*, gint64,
                                            struct wtap_pkthdr *, guint8*,
                                            int, int *, char **);
+/*
+ * Reads records into an array, appending their data to wth->batch_buffer,
+ * until the array is full or the buffer holds at least
+ * WTAP_BATCH_BUFFER_SIZE bytes.  Returns the number of records read, with
+ * *err set if it stopped on an error or at the end of the file.
+ */
+typedef int (*subtype_read_batch_func)(struct wtap*, struct wtap_batch_rec*,
+                                       int, int*, char**);
+/*
+ * Finds the first record at or after an offset, before the given end of
+ * the file; returns 1 and sets the record's offset if it finds one, 0 if
+ * it doesn't, and -1 on an I/O error.
+ */
+typedef int (*subtype_find_record_func)(struct wtap*, gint64, gint64, gint64*,
+                                        int*, char**);
+
+#define WTAP_BATCH_BUFFER_SIZE  (256*1024)
 /**
  * Struct holding data of the currently read file.
  */
@@ -63,6 +80,16 @@ struct wtap {
 
     subtype_read_func           subtype_read;
     subtype_seek_read_func      subtype_seek_read;
+    subtype_read_batch_func     subtype_read_batch;     /**< NULL if records are read one by one */
+    struct Buffer               *batch_buffer;          /**< data of the records read by wtap_read_batch() */
+    int                         batch_err;              /**< error to report on the next wtap_read_batch() */
+    gchar                       *batch_err_info;
+    gboolean                    can_skip_data;          /**< set by the open routine if the reader supports headers_only */
+    gboolean                    headers_only;           /**< skip the data of records */
+    gint64                      headers_only_size;      /**< size of the file, to detect truncated records */
+    subtype_find_record_func    subtype_find_record;    /**< NULL if the file can't be split into ranges */
+    gint64                      first_record_offset;
+    gint64                      range_end;              /**< where reading stops; 0 for the end of the file */
     void                        (*subtype_sequential_close)(struct wtap*);
     void                        (*subtype_close)(struct wtap*);
     int                         file_encap;    /* per-file, for those
@@ -744,6 +744,14 @@ wtap_sequential_close(wtap *wth)
 		g_free(wth->frame_buffer);
 		wth->frame_buffer = NULL;
 	}
+
+	if (wth->batch_buffer) {
+		buffer_free(wth->batch_buffer);
+		g_free(wth->batch_buffer);
+		wth->batch_buffer = NULL;
+	}
+	g_free(wth->batch_err_info);
+	wth->batch_err_info = NULL;
 }
 
 static void
@@ -887,6 +895,157 @@ wtap_read(wtap *wth, int *err, gchar **err_info, gint64 *data_offset)
 	return TRUE;	/* success */
 }
 
+int
+wtap_read_batch(wtap *wth, struct wtap_batch_rec *recs, int max_recs,
+    int *err, gchar **err_info)
+{
+	int n, i;
+	guint8 *data;
+
+	*err = 0;
+	*err_info = NULL;
+	if (wth->batch_err != 0) {
+		/* The previous batch ended with an error; report it now. */
+		*err = wth->batch_err;
+		*err_info = wth->batch_err_info;
+		wth->batch_err = 0;
+		wth->batch_err_info = NULL;
+		return 0;
+	}
+
+	if (wth->subtype_read_batch == NULL) {
+		/*
+		 * Copying records read one by one to a batch would only
+		 * add work; hand over one record, in the frame buffer.
+		 */
+		if (!wtap_read(wth, err, err_info, &recs[0].data_offset))
+			return 0;
+		recs[0].phdr = wth->phdr;
+		recs[0].data = wth->headers_only ? NULL :
+		    buffer_start_ptr(wth->frame_buffer);
+		return 1;
+	}
+
+	if (wth->batch_buffer == NULL) {
+		wth->batch_buffer = (struct Buffer *)g_malloc(sizeof(struct Buffer));
+		buffer_init(wth->batch_buffer, WTAP_BATCH_BUFFER_SIZE);
+	}
+	buffer_clean(wth->batch_buffer);
+
+	n = (*wth->subtype_read_batch)(wth, recs, max_recs, err, err_info);
+
+	/* See wtap_read() for deferred errors. */
+	if (n < max_recs && *err == 0)
+		*err = file_error(wth->fh, err_info);
+
+	data = buffer_start_ptr(wth->batch_buffer);
+	for (i = 0; i < n; i++) {
+		if (wth->headers_only) {
+			recs[i].data = NULL;
+		} else {
+			recs[i].data = data;
+			data += recs[i].phdr.caplen;
+		}
+
+		/* As in wtap_read() */
+		if (recs[i].phdr.caplen > recs[i].phdr.len)
+			recs[i].phdr.caplen = recs[i].phdr.len;
+		g_assert(recs[i].phdr.pkt_encap != WTAP_ENCAP_PER_PACKET);
+	}
+
+	if (n > 0 && *err != 0) {
+		/* Return the records we have; report the error next time. */
+		wth->batch_err = *err;
+		wth->batch_err_info = *err_info;
+		*err = 0;
+		*err_info = NULL;
+	}
+	return n;
+}
+
+gboolean
+wtap_set_headers_only(wtap *wth)
+{
+	int err;
+	gint64 size;
+
+	/*
+	 * Skipping data is only cheap in uncompressed files, and we need
+	 * the size of the file to tell whether the data of a record we
+	 * skipped are all there.
+	 */
+	if (!wth->can_skip_data || wth->fh == NULL ||
+	    file_iscompressed(wth->fh))
+		return FALSE;
+	size = wtap_file_size(wth, &err);
+	if (size == -1)
+		return FALSE;
+
+	wth->headers_only = TRUE;
+	wth->headers_only_size = size;
+	return TRUE;
+}
+
+int
+wtap_find_chunks(wtap *wth, int max_chunks, gint64 *starts,
+    int *err, gchar **err_info)
+{
+	gint64 size, saved_pos, target, rec_offset;
+	int n, i;
+
+	*err = 0;
+	if (wth->subtype_find_record == NULL || wth->fh == NULL ||
+	    file_iscompressed(wth->fh) || max_chunks < 1)
+		return 0;
+	size = wtap_file_size(wth, err);
+	if (size == -1)
+		return -1;
+	saved_pos = file_tell(wth->fh);
+
+	starts[0] = wth->first_record_offset;
+	n = 1;
+	for (i = 1; i < max_chunks; i++) {
+		/* Split the records evenly by size */
+		target = wth->first_record_offset +
+		    (size - wth->first_record_offset) * i / max_chunks;
+		if (target <= starts[n - 1])
+			continue;
+		switch ((*wth->subtype_find_record)(wth, target, size,
+		    &rec_offset, err, err_info)) {
+
+		case -1:
+			file_seek(wth->fh, saved_pos, SEEK_SET, err);
+			return -1;
+
+		case 0:
+			/* Nothing that looks like a record; skip this split */
+			break;
+
+		case 1:
+			if (rec_offset > starts[n - 1] && rec_offset < size)
+				starts[n++] = rec_offset;
+			break;
+		}
+	}
+
+	if (file_seek(wth->fh, saved_pos, SEEK_SET, err) == -1)
+		return -1;
+	return n;
+}
+
+gboolean
+wtap_set_range(wtap *wth, gint64 start, gint64 end, int *err)
+{
+	*err = 0;
+	if (wth->subtype_find_record == NULL || wth->fh == NULL ||
+	    file_iscompressed(wth->fh))
+		return FALSE;
+	if (file_seek(wth->fh, start, SEEK_SET, err) == -1)
+		return FALSE;
+	wth->range_end = end;
+	return TRUE;
+}
+
 /*
  * Return an approximation of the amount of data we've read sequentially
  * from the file so far.  (gint64, in case that's 64 bits.)
@@ -1077,6 +1077,47 @@ void wtap_set_cb_new_ipv6(wtap *wth, wtap_new_ipv6_callback_t add_new_ipv6);
 gboolean wtap_read(wtap *wth, int *err, gchar **err_info,
     gint64 *data_offset);
 
+/** A record read by wtap_read_batch(). */
+struct wtap_batch_rec {
+	struct wtap_pkthdr	phdr;
+	gint64			data_offset;	/**< as set by wtap_read() */
+	guint8			*data;		/**< valid until the next read */
+};
+
+/** Reads up to max_recs records, with their data stored back to back in
+ * a buffer of the wtap, and returns the number of records read.  Returns
+ * 0 at the end of the file, or on an error, with *err set; an error after
+ * reading some records is reported by the next call.  This can be mixed
+ * with wtap_read().  Only some file types (libpcap so far) are read in
+ * batches; for the others, each call returns a single record, whose data
+ * are in the same buffer as wtap_buf_ptr()'s. */
+int wtap_read_batch(wtap *wth, struct wtap_batch_rec *recs, int max_recs,
+    int *err, gchar **err_info);
+
+/** Asks for records to be read with their headers only, skipping their
+ * data, for callers that need nothing else; wtap_buf_ptr() and the data
+ * pointers of batch records are then not valid, and neither are fields
+ * of the pseudo-header guessed from the data.  Returns FALSE, and leaves
+ * the wtap unchanged, if the file can't be read that way. */
+gboolean wtap_set_headers_only(wtap *wth);
+
+/** Finds where to split a file into up to max_chunks ranges of records
+ * that can be read independently, e.g. in separate threads, each with
+ * its own wtap opened with wtap_open_offline() and restricted to its
+ * range with wtap_set_range().  Stores the offsets of the first record
+ * of each range in starts[], each range ending where the next one starts
+ * and the last one at the end of the file, and returns the number of
+ * ranges; returns 0 if the file can't be split, or -1 on an error.
+ * The position of the sequential stream isn't changed. */
+int wtap_find_chunks(wtap *wth, int max_chunks, gint64 *starts,
+    int *err, gchar **err_info);
+
+/** Restricts reading to the records from start up to end, as found by
+ * wtap_find_chunks(); an end of 0 means the end of the file.  Must be
+ * called before reading.  Returns FALSE, with *err set to 0 if the file
+ * can't be read that way, or to an error. */
+gboolean wtap_set_range(wtap *wth, gint64 start, gint64 end, int *err);
+
 gboolean wtap_seek_read (wtap *wth, gint64 seek_off,
 	struct wtap_pkthdr *phdr, guint8 *pd, int len,
 	int *err, gchar **err_info);
@@ -1127,6 +1168,13 @@ int wtap_dump_file_encap_type(const GArray *file_encaps);
 gboolean wtap_dump_can_write_encaps(int ft, const GArray *file_encaps);
 
 gboolean wtap_dump_can_compress(int filetype);
+void wtap_dump_set_compression_threads(int threads);
+
+/* Types of compression for compressed output files */
+#define WTAP_GZIP_COMPRESSED	0	/* gzip, the default */
+#define WTAP_ZSTD_COMPRESSED	1	/* Zstandard, in the seekable format */
+
+gboolean wtap_dump_set_compression_type(int type);
 gboolean wtap_dump_has_name_resolution(int filetype);
 
 wtap_dumper* wtap_dump_open(const char *filename, int filetype, int encap,
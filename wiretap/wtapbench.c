@@ -0,0 +1,186 @@
+/* Standalone program to time opening capture files with Wiretap, and
+ * reading their records at random offsets.
+ *
+ * $Id$
+ *
+ * "wtapbench open <count> <file> ..." opens and closes each file count
+ * times, without reading any records, and prints the time per open;
+ * files that can't be opened are reported, and still timed, since
+ * finding that out goes through every open routine.
+ * "wtapbench seek <count> <file>" reads the file once to find where its
+ * records are, then reads count records at random offsets with
+ * wtap_seek_read() and prints the time per record.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "wtap.h"
+
+/* Seed for picking records, so that runs read the same ones */
+#define SEEK_SEED	1
+
+/* Where a record is, and how much of it to read */
+typedef struct {
+	gint64	offset;
+	int	caplen;
+} rec_loc;
+
+static void
+usage(void)
+{
+	fprintf(stderr, "Usage: wtapbench open <count> <file> ...\n");
+	fprintf(stderr, "       wtapbench seek <count> <file>\n");
+	exit(2);
+}
+
+static void
+open_failed(const char *filename, int err, gchar *err_info)
+{
+	fprintf(stderr, "wtapbench: Can't open %s: %s\n", filename,
+	    wtap_strerror(err));
+	g_free(err_info);
+	exit(1);
+}
+
+static void
+bench_open(int count, int n_files, char **files)
+{
+	wtap *wth;
+	int err;
+	gchar *err_info = NULL;
+	GTimer *timer;
+	int i, j, failed = 0;
+
+	timer = g_timer_new();
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < n_files; j++) {
+			wth = wtap_open_offline(files[j], &err, &err_info, FALSE);
+			if (wth == NULL) {
+				if (i == 0) {
+					fprintf(stderr, "wtapbench: Can't open %s: %s\n",
+					    files[j], wtap_strerror(err));
+					failed++;
+				}
+				g_free(err_info);
+				err_info = NULL;
+				continue;
+			}
+			wtap_close(wth);
+		}
+	}
+	g_timer_stop(timer);
+
+	printf("%d opens (%d of %d files can't be opened): %.9f s per open\n",
+	    count * n_files, failed, n_files,
+	    g_timer_elapsed(timer, NULL) / (count * n_files));
+	g_timer_destroy(timer);
+}
+
+static void
+bench_seek(int count, const char *filename)
+{
+	wtap *wth;
+	int err;
+	gchar *err_info = NULL;
+	gint64 data_offset;
+	GArray *recs;
+	rec_loc loc;
+	struct wtap_pkthdr phdr;
+	guint8 *pd;
+	GRand *rng;
+	GTimer *timer;
+	guint i, rec;
+
+	wth = wtap_open_offline(filename, &err, &err_info, TRUE);
+	if (wth == NULL)
+		open_failed(filename, err, err_info);
+
+	/* Find the records, untimed */
+	recs = g_array_new(FALSE, FALSE, sizeof (rec_loc));
+	while (wtap_read(wth, &err, &err_info, &data_offset)) {
+		loc.offset = data_offset;
+		loc.caplen = wtap_phdr(wth)->caplen;
+		g_array_append_val(recs, loc);
+	}
+	if (err != 0) {
+		fprintf(stderr, "wtapbench: Can't read %s: %s\n", filename,
+		    wtap_strerror(err));
+		g_free(err_info);
+		exit(1);
+	}
+	if (recs->len == 0) {
+		fprintf(stderr, "wtapbench: %s has no records\n", filename);
+		exit(1);
+	}
+
+	pd = (guint8 *)g_malloc(WTAP_MAX_PACKET_SIZE);
+	rng = g_rand_new_with_seed(SEEK_SEED);
+	timer = g_timer_new();
+	for (i = 0; i < (guint)count; i++) {
+		rec = g_rand_int_range(rng, 0, recs->len);
+		loc = g_array_index(recs, rec_loc, rec);
+		memset(&phdr, 0, sizeof phdr);
+		if (!wtap_seek_read(wth, loc.offset, &phdr, pd, loc.caplen,
+		    &err, &err_info)) {
+			fprintf(stderr, "wtapbench: Can't read record %u of %s: %s\n",
+			    rec + 1, filename, wtap_strerror(err));
+			g_free(err_info);
+			exit(1);
+		}
+	}
+	g_timer_stop(timer);
+
+	printf("%d random reads of %u records: %.9f s per read\n", count,
+	    recs->len, g_timer_elapsed(timer, NULL) / count);
+
+	g_timer_destroy(timer);
+	g_rand_free(rng);
+	g_free(pd);
+	g_array_free(recs, TRUE);
+	wtap_close(wth);
+}
+
+int
+main(int argc, char **argv)
+{
+	int count;
+	char *p;
+
+	if (argc < 4)
+		usage();
+	count = (int)strtol(argv[2], &p, 10);
+	if (p == argv[2] || *p != '\0' || count < 1)
+		usage();
+
+	if (strcmp(argv[1], "open") == 0)
+		bench_open(count, argc - 3, argv + 3);
+	else if (strcmp(argv[1], "seek") == 0 && argc == 4)
+		bench_seek(count, argv[3]);
+	else
+		usage();
+	return 0;
+}
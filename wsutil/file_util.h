@@ -94,6 +94,7 @@ extern FILE * ws_stdio_freopen (const gchar *filename, const gchar *mode, FILE *
 #define ws_dup     _dup
 #define ws_fstat64 _fstati64	/* use _fstati64 for 64-bit size support */
 #define ws_lseek64 _lseeki64	/* use _lseeki64 for 64-bit offset support */
+#define ws_fseek64 _fseeki64	/* use _fseeki64 for 64-bit offset support */
 
 /* DLL loading */
 
@@ -149,6 +150,7 @@ extern char *getenv_utf8(const char *varname);
 #define ws_dup     dup
 #define ws_fstat64 fstat	/* AC_SYS_LARGEFILE should make off_t 64-bit */
 #define ws_lseek64 lseek	/* AC_SYS_LARGEFILE should make off_t 64-bit */
+#define ws_fseek64 fseeko	/* AC_SYS_LARGEFILE should make off_t 64-bit */
 #define O_BINARY   0		/* Win32 needs the O_BINARY flag for open() */
 
 #endif /* _WIN32 */